@@ -0,0 +1,278 @@
+/* * ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+ * (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+ * founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+ * 50WM0942, 50WM1042, 50WM1342.
+ * Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+ *
+ * This file is part of ATUS2.
+ *
+ * ATUS2 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ATUS2 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include "fftw3.h"
+#include "huge_alloc.h"
+
+#ifndef __class_CAnderson__
+#define __class_CAnderson__
+
+/** Anderson mixing (DIIS) for fixed point iterations x <- x + beta g(x) of no_wf components
+  *
+  * The last depth differences of the iterates (dX) and of the updates f = beta g (dF) are kept.
+  * The new iterate x + f - sum_j gamma_j (dX_j + dF_j) uses the coefficients gamma which minimize
+  * |f - sum_j gamma_j dF_j|. The inner products run over all components, the functor passed to Step
+  * sums its argument over all processes (MPI_Allreduce) and does nothing for shared memory.
+  * Memory: 2 depth + 2 vectors per component.
+  */
+template <int no_wf>
+class CAnderson
+{
+public:
+  /** Constructor
+    * @param depth Number of stored differences
+    * @param n Number of doubles per component
+    */
+  CAnderson( const int depth, const int64_t n ) : m_depth(depth), m_n(n), m_filled(0), m_pos(0), m_have_old(false)
+  {
+    m_dx.resize(depth);
+    m_df.resize(depth);
+    m_gram.resize(depth*depth,0);
+
+    for ( int i=0; i<no_wf; i++ )
+    {
+      for ( int j=0; j<depth; j++ )
+      {
+        m_dx[j][i] = Huge_Alloc_Real( n );
+        m_df[j][i] = Huge_Alloc_Real( n );
+      }
+      m_x_old[i] = Huge_Alloc_Real( n );
+      m_f_old[i] = Huge_Alloc_Real( n );
+    }
+  }
+
+  ~CAnderson()
+  {
+    for ( int i=0; i<no_wf; i++ )
+    {
+      for ( int j=0; j<m_depth; j++ )
+      {
+        Huge_Free( m_dx[j][i] );
+        Huge_Free( m_df[j][i] );
+      }
+      Huge_Free( m_x_old[i] );
+      Huge_Free( m_f_old[i] );
+    }
+  }
+
+  /// Discards the history, the next step is a plain fixed point step
+  void Reset()
+  {
+    m_filled = 0;
+    m_pos = 0;
+    m_have_old = false;
+  }
+
+  /// Memory of the history in bytes
+  int64_t Get_Memory() const
+  {
+    return int64_t(2*m_depth+2)*no_wf*m_n*int64_t(sizeof(double));
+  }
+
+  int Get_Depth() const
+  {
+    return m_depth;
+  }
+
+  template <class Reduce>
+  bool Step( const std::array<double *,no_wf> &, const std::array<double *,no_wf> &, const double, Reduce );
+
+private:
+  bool Solve( std::vector<double> &, std::vector<double> & );
+
+  int m_depth; /// maximal number of stored differences
+  int64_t m_n; /// doubles per component
+  int m_filled; /// number of stored differences, they occupy the slots 0 ... m_filled-1
+  int m_pos; /// slot of the next difference
+  bool m_have_old; /// whether m_x_old and m_f_old are valid
+
+  std::vector<std::array<double *,no_wf>> m_dx;
+  std::vector<std::array<double *,no_wf>> m_df;
+  std::array<double *,no_wf> m_x_old;
+  std::array<double *,no_wf> m_f_old;
+  std::vector<double> m_gram; /// <dF_i,dF_j>, updated one row per step
+};
+
+/** Replaces x by the extrapolated iterate
+  *
+  * @param x Current iterate, overwritten by the new one
+  * @param g Current residual, the plain update is beta g
+  * @param beta Step length of the plain fixed point iteration
+  * @param reduce Functor reduce(double *buf, int n) summing buf over all processes
+  * @return false if a plain step was taken (empty or singular history)
+  */
+template <int no_wf>
+template <class Reduce>
+bool CAnderson<no_wf>::Step( const std::array<double *,no_wf> &x, const std::array<double *,no_wf> &g, const double beta, Reduce reduce )
+{
+  const int64_t n = m_n;
+
+  int slot = -1;
+  if ( m_have_old )
+  {
+    slot = m_pos;
+    m_pos = (m_pos+1) % m_depth;
+    if ( m_filled < m_depth ) m_filled++;
+  }
+
+  // differences to the last step, then keep the current iterate and update
+  for ( int i=0; i<no_wf; i++ )
+  {
+    double * xi = x[i];
+    double * gi = g[i];
+    double * xo = m_x_old[i];
+    double * fo = m_f_old[i];
+    double * dx = (slot < 0) ? nullptr : m_dx[slot][i];
+    double * df = (slot < 0) ? nullptr : m_df[slot][i];
+
+    #pragma omp parallel for
+    for ( int64_t l=0; l<n; l++ )
+    {
+      const double f = beta*gi[l];
+      if ( dx != nullptr )
+      {
+        dx[l] = xi[l]-xo[l];
+        df[l] = f-fo[l];
+      }
+      xo[l] = xi[l];
+      fo[l] = f;
+    }
+  }
+  m_have_old = true;
+
+  // new row of the Gram matrix and the right hand side <dF_j,f>
+  std::vector<double> buf(2*m_depth,0);
+  for ( int j=0; j<m_filled; j++ )
+  {
+    double s1=0, s2=0;
+    for ( int i=0; i<no_wf; i++ )
+    {
+      const double * dfs = m_df[slot][i];
+      const double * dfj = m_df[j][i];
+      const double * f = m_f_old[i];
+
+      #pragma omp parallel for reduction(+:s1,s2)
+      for ( int64_t l=0; l<n; l++ )
+      {
+        s1 += dfs[l]*dfj[l];
+        s2 += dfj[l]*f[l];
+      }
+    }
+    buf[j] = s1;
+    buf[m_depth+j] = s2;
+  }
+  reduce( buf.data(), 2*m_depth );
+
+  for ( int j=0; j<m_filled; j++ )
+  {
+    m_gram[slot*m_depth+j] = buf[j];
+    m_gram[j*m_depth+slot] = buf[j];
+  }
+
+  std::vector<double> gamma( buf.begin()+m_depth, buf.begin()+m_depth+m_filled );
+  std::vector<double> A( m_filled*m_filled );
+  for ( int j=0; j<m_filled; j++ )
+    for ( int k=0; k<m_filled; k++ )
+      A[k+m_filled*j] = m_gram[k+m_depth*j];
+
+  if ( m_filled == 0 || !Solve( A, gamma ) )
+  {
+    if ( m_filled > 0 ) Reset();
+    for ( int i=0; i<no_wf; i++ )
+    {
+      double * xi = x[i];
+      const double * gi = g[i];
+
+      #pragma omp parallel for
+      for ( int64_t l=0; l<n; l++ )
+        xi[l] += beta*gi[l];
+    }
+    return false;
+  }
+
+  for ( int i=0; i<no_wf; i++ )
+  {
+    double * xi = x[i];
+    const double * f = m_f_old[i];
+
+    #pragma omp parallel for
+    for ( int64_t l=0; l<n; l++ )
+    {
+      double val = xi[l] + f[l];
+      for ( int j=0; j<m_filled; j++ )
+        val -= gamma[j]*(m_dx[j][i][l] + m_df[j][i][l]);
+      xi[l] = val;
+    }
+  }
+  return true;
+}
+
+/** Solves the small normal equations A gamma = b by Gaussian elimination with partial pivoting
+  *
+  * A is regularized by 1e-12 of its trace on the diagonal, returns false if A is (numerically) singular.
+  */
+template <int no_wf>
+bool CAnderson<no_wf>::Solve( std::vector<double> &A, std::vector<double> &b )
+{
+  const int m = b.size();
+
+  double tr=0;
+  for ( int j=0; j<m; j++ )
+    tr += A[j+m*j];
+  if ( !(tr > 0) ) return false;
+  for ( int j=0; j<m; j++ )
+    A[j+m*j] += 1e-12*tr;
+
+  for ( int c=0; c<m; c++ )
+  {
+    int p=c;
+    for ( int r=c+1; r<m; r++ )
+      if ( fabs(A[c+m*r]) > fabs(A[c+m*p]) ) p=r;
+    if ( fabs(A[c+m*p]) < 1e-14*tr ) return false;
+
+    if ( p != c )
+    {
+      for ( int k=0; k<m; k++ ) std::swap( A[k+m*c], A[k+m*p] );
+      std::swap( b[c], b[p] );
+    }
+
+    for ( int r=c+1; r<m; r++ )
+    {
+      const double fak = A[c+m*r]/A[c+m*c];
+      for ( int k=c; k<m; k++ ) A[k+m*r] -= fak*A[k+m*c];
+      b[r] -= fak*b[c];
+    }
+  }
+
+  for ( int c=m-1; c>=0; c-- )
+  {
+    for ( int k=c+1; k<m; k++ ) b[c] -= A[k+m*c]*b[k];
+    b[c] /= A[c+m*c];
+  }
+  return true;
+}
+
+#endif
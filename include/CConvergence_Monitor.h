@@ -0,0 +1,264 @@
+/* * ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+ * (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+ * founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+ * 50WM0942, 50WM1042, 50WM1342.
+ * Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+ *
+ * This file is part of ATUS2.
+ *
+ * ATUS2 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ATUS2 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <array>
+#include <chrono>
+#include <limits>
+
+#include "ParameterHandler.h"
+
+#ifndef __class_CConvergence_Monitor__
+#define __class_CConvergence_Monitor__
+
+/** Convergence records and stopping rules of the ground state solvers
+  *
+  * Every log_stride iterations (CONSTANTS/log_stride, default 1) a record with the level, iteration,
+  * wall time, residuals, particle numbers and chemical potentials is printed in one line and appended
+  * to SIMULATION/CONVERGENCE_LOG if given (CSV, or binary records of doubles for a .bin file name,
+  * preceded by the record length and no_wf as int64). The run stops at the first of
+  * - residual <= epsilon
+  * - relative change of all chemical potentials between two records <= CONSTANTS/epsilon_mu
+  * - no decrease of the residual by 1% within CONSTANTS/stagnation iterations
+  * - ALGORITHM/MAXITER iterations
+  * The chemical potentials are only needed at record steps and only if epsilon_mu or the log is set.
+  */
+template <int no_wf>
+class CConvergence_Monitor
+{
+public:
+  CConvergence_Monitor( ParameterHandler *, const double, const int );
+  ~CConvergence_Monitor();
+
+  bool Is_Record_Step( const int counter ) const { return counter % m_stride == 0; }
+  bool Needs_mu() const { return m_epsilon_mu > 0 || m_file != nullptr; }
+
+  void Update( const int, const double, const std::array<double,no_wf> &, const std::array<double,no_wf> &, const std::array<double,no_wf> *, const double=0 );
+  bool Stop() const { return !m_reason.empty(); }
+  void Summary( const std::array<double,no_wf> & ) const;
+
+protected:
+  void Record( const int, const double, const std::array<double,no_wf> &, const std::array<double,no_wf> &, const std::array<double,no_wf> *, const double );
+
+  double m_epsilon; /// residual tolerance
+  double m_epsilon_mu; /// relative tolerance of the chemical potentials, 0 -> off
+  int m_stride;
+  int m_stagnation; /// stagnation window, 0 -> off
+  int m_max_iter;
+  int m_level;
+  FILE * m_file;
+  bool m_binary;
+
+  int m_counter;
+  double m_res_tot;
+  double m_res_mark; /// residual at the last significant decrease
+  int m_iter_mark;
+  bool m_have_mu;
+  std::array<double,no_wf> m_mu_old;
+  std::string m_reason;
+  std::chrono::steady_clock::time_point m_t0;
+};
+
+/** Constructor
+  * @param params Parameters
+  * @param epsilon Tolerance of the residual
+  * @param level Multigrid level, written into the records
+  */
+template <int no_wf>
+CConvergence_Monitor<no_wf>::CConvergence_Monitor( ParameterHandler *params, const double epsilon, const int level )
+  : m_epsilon(epsilon), m_epsilon_mu(0), m_stride(1), m_stagnation(0), m_level(level), m_file(nullptr), m_binary(false),
+    m_counter(0), m_res_tot(0), m_res_mark(std::numeric_limits<double>::max()), m_iter_mark(0), m_have_mu(false)
+{
+  try
+  {
+    m_stride = std::max( 1, int(params->Get_Constant( "log_stride" )) );
+  }
+  catch (std::string &)
+  {
+  }
+  try
+  {
+    m_epsilon_mu = params->Get_Constant( "epsilon_mu" );
+  }
+  catch (std::string &)
+  {
+  }
+  try
+  {
+    m_stagnation = int(params->Get_Constant( "stagnation" ));
+  }
+  catch (std::string &)
+  {
+  }
+  m_max_iter = params->Get_MaxIter( std::numeric_limits<int>::max() );
+
+  try
+  {
+    const std::string filename = params->Get_simulation( "CONVERGENCE_LOG" );
+    m_binary = filename.size() > 4 && filename.compare( filename.size()-4, 4, ".bin" ) == 0;
+
+    // the first monitor of the process starts a new file, the following levels append
+    static bool first = true;
+    m_file = fopen( filename.c_str(), first ? (m_binary ? "wb" : "w") : (m_binary ? "ab" : "a") );
+    if ( m_file == nullptr ) throw std::string( "Could not open file " + filename + ".\n" );
+
+    if ( first )
+    {
+      if ( m_binary )
+      {
+        const int64_t head[] = { 4+3*no_wf, no_wf };
+        fwrite( head, sizeof(int64_t), 2, m_file );
+      }
+      else
+      {
+        fprintf( m_file, "level,iteration,time,res" );
+        for ( int i=0; i<no_wf; i++ ) fprintf( m_file, ",res_%d", i );
+        for ( int i=0; i<no_wf; i++ ) fprintf( m_file, ",N_%d", i );
+        for ( int i=0; i<no_wf; i++ ) fprintf( m_file, ",mu_%d", i );
+        fprintf( m_file, "\n" );
+      }
+    }
+    first = false;
+  }
+  catch (std::string &)
+  {
+  }
+
+  m_t0 = std::chrono::steady_clock::now();
+}
+
+template <int no_wf>
+CConvergence_Monitor<no_wf>::~CConvergence_Monitor()
+{
+  if ( m_file != nullptr ) fclose( m_file );
+}
+
+/** Registers the state after an iteration and evaluates the stopping rules
+  * @param counter Iteration number starting with 0
+  * @param res_tot Total residual
+  * @param res Residuals of the components
+  * @param N Particle numbers
+  * @param mu Chemical potentials, nullptr if not computed (only needed at record steps if Needs_mu())
+  * @param tau Step length of the line search, 0 for the steepest descent
+  */
+template <int no_wf>
+void CConvergence_Monitor<no_wf>::Update( const int counter, const double res_tot, const std::array<double,no_wf> &res, const std::array<double,no_wf> &N, const std::array<double,no_wf> *mu, const double tau )
+{
+  m_counter = counter;
+  m_res_tot = res_tot;
+
+  if ( Is_Record_Step(counter) ) Record( counter, res_tot, res, N, mu, tau );
+
+  if ( res_tot <= m_epsilon )
+  {
+    m_reason = "residual";
+    return;
+  }
+
+  if ( mu != nullptr && m_epsilon_mu > 0 )
+  {
+    if ( m_have_mu )
+    {
+      bool converged = true;
+      for ( int i=0; i<no_wf; i++ )
+        if ( fabs((*mu)[i]-m_mu_old[i]) > m_epsilon_mu*fabs((*mu)[i]) ) converged = false;
+      if ( converged )
+      {
+        m_reason = "chemical potential";
+        return;
+      }
+    }
+    m_mu_old = *mu;
+    m_have_mu = true;
+  }
+
+  if ( m_stagnation > 0 )
+  {
+    if ( res_tot < 0.99*m_res_mark )
+    {
+      m_res_mark = res_tot;
+      m_iter_mark = counter;
+    }
+    else if ( counter-m_iter_mark >= m_stagnation )
+    {
+      m_reason = "stagnation";
+      return;
+    }
+  }
+
+  if ( counter+1 >= m_max_iter ) m_reason = "MAXITER";
+}
+
+template <int no_wf>
+void CConvergence_Monitor<no_wf>::Record( const int counter, const double res_tot, const std::array<double,no_wf> &res, const std::array<double,no_wf> &N, const std::array<double,no_wf> *mu, const double tau )
+{
+  const double t = std::chrono::duration<double>( std::chrono::steady_clock::now()-m_t0 ).count();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+
+  printf( "%6d res %.6e", counter, res_tot );
+  for ( int i=0; i<no_wf; i++ ) printf( " N[%d] %.10g", i, N[i] );
+  if ( mu != nullptr )
+    for ( int i=0; i<no_wf; i++ ) printf( " mu[%d] %.10g", i, (*mu)[i] );
+  if ( tau != 0 ) printf( " tau %.4e", tau );
+  printf( "\n" );
+
+  if ( m_file == nullptr ) return;
+
+  double rec[4+3*no_wf];
+  rec[0] = m_level;
+  rec[1] = counter;
+  rec[2] = t;
+  rec[3] = res_tot;
+  for ( int i=0; i<no_wf; i++ )
+  {
+    rec[4+i] = res[i];
+    rec[4+no_wf+i] = N[i];
+    rec[4+2*no_wf+i] = (mu != nullptr) ? (*mu)[i] : nan;
+  }
+
+  if ( m_binary )
+  {
+    fwrite( rec, sizeof(double), 4+3*no_wf, m_file );
+  }
+  else
+  {
+    fprintf( m_file, "%d,%d,%.6g", m_level, counter, t );
+    for ( int k=3; k<4+3*no_wf; k++ ) fprintf( m_file, ",%.12g", rec[k] );
+    fprintf( m_file, "\n" );
+  }
+}
+
+/** Prints the number of iterations, the stopping rule, the final residual and the chemical potentials */
+template <int no_wf>
+void CConvergence_Monitor<no_wf>::Summary( const std::array<double,no_wf> &mu ) const
+{
+  const double t = std::chrono::duration<double>( std::chrono::steady_clock::now()-m_t0 ).count();
+
+  printf( "FYI: level %d stopped after %d iterations (%s), res %.6e, %.3f s", m_level, m_counter+1, m_reason.c_str(), m_res_tot, t );
+  for ( int i=0; i<no_wf; i++ ) printf( ", mu[%d] %.12g", i, mu[i] );
+  printf( "\n" );
+  fflush( stdout );
+}
+
+#endif
@@ -30,6 +30,7 @@
 #include "strtk.hpp"
 #include "CRT_shared.h"
 #include "cft_base.h"
+#include "huge_alloc.h"
 #include "ParameterHandler.h"
 
 using namespace std;
@@ -82,6 +83,13 @@ protected:
   void Do_FT_Step_half();
   void Do_NL_Step();
 
+  // imaginary time propagation (sequence imag_time)
+  void run_imag_time( const sequence_item & );
+  void Setup_Imag_Potential( std::array<huge_vector<double>,no_int_states> & );
+  void Do_Imag_FT_Step( const vector<double> &, const std::array<double,no_int_states> & );
+  void Do_Imag_NL_Step( const std::array<huge_vector<double>,no_int_states> &, const double );
+  void Compute_Chemical_Potentials( const std::array<huge_vector<double>,no_int_states> &, std::array<double,no_int_states> & );
+
   /// Object for reading from xml files
   ParameterHandler *m_params;
 
@@ -121,7 +129,7 @@ protected:
   std::array<T *,no_int_states> m_fields;
 
   ///time independent external potentials
-  std::array<vector<double>,no_int_states> m_Potential;
+  std::array<huge_vector<double>,no_int_states> m_Potential;
 
   ///Map between String (name of functions) and StepFunction
   std::map<std::string,StepFunction> m_map_stepfcts;
@@ -180,11 +188,13 @@ CRT_Base<T,dim,no_int_states>::~CRT_Base()
 {
   for ( int i=0; i<no_int_states; i++ )
     delete m_fields[i];
-  fftw_free( m_full_step );
-  fftw_free( m_half_step );
+  Huge_Free( m_full_step );
+  Huge_Free( m_half_step );
 }
 
 /** Allocate m_fields, m_full_step and m_half_step
+  *
+  * The tables are zeroed with the static schedule of the kernels (First_Touch) for NUMA placement.
   */
 template <class T, int dim, int no_int_states>
 void CRT_Base<T,dim,no_int_states>::Allocate()
@@ -195,8 +205,11 @@ void CRT_Base<T,dim,no_int_states>::Allocate()
     m_fields[i]->SetFix(false);
   }
 
-  m_full_step = (fftw_complex *)fftw_malloc( sizeof(fftw_complex)*m_no_of_pts );
-  m_half_step = (fftw_complex *)fftw_malloc( sizeof(fftw_complex)*m_no_of_pts );
+  m_full_step = Huge_Alloc_Complex( m_no_of_pts );
+  m_half_step = Huge_Alloc_Complex( m_no_of_pts );
+  First_Touch( m_full_step, m_no_of_pts );
+  First_Touch( m_half_step, m_no_of_pts );
+  Huge_Pages_Report();
 }
 
 /** Load initial wavefunctions from files
@@ -252,25 +265,18 @@ void CRT_Base<T,dim,no_int_states>::LoadFiles()
 template <class T, int dim, int no_int_states>
 void CRT_Base<T,dim,no_int_states>::Init()
 {
+  const double dt = -m_header.dt;
+
   #pragma omp parallel
+  m_fields[0]->For_k( [&]( const int64_t i, CPoint<dim> &k )
   {
-    const double dt = -m_header.dt;
-    double phi;
-
-    CPoint<dim> k;
+    const double phi = dt*(k.scale(m_alpha)*k);
 
-    #pragma omp for
-    for ( int i=0; i<m_no_of_pts; i++ )
-    {
-      k = m_fields[0]->Get_k(i);
-      phi = dt*(k.scale(m_alpha)*k);
-
-      m_half_step[i][0] = cos(0.5*phi);
-      m_half_step[i][1] = sin(0.5*phi);
-      m_full_step[i][0] = cos(phi);
-      m_full_step[i][1] = sin(phi);
-    }
-  }
+    m_half_step[i][0] = cos(0.5*phi);
+    m_half_step[i][1] = sin(0.5*phi);
+    m_full_step[i][0] = cos(phi);
+    m_full_step[i][1] = sin(phi);
+  } );
 }
 
 template <class T, int dim, int no_int_states>
@@ -440,38 +446,315 @@ void CRT_Base<T,dim,no_int_states>::Do_NL_Step()
   }
 }
 
-/** Add a constant momentum to an internal state.
+/** Imaginary time propagation towards the ground state
   *
-  * @param px Momentum to be added
-  * @param comp Number of the internal state to which the momentum shall be added
+  * The split step scheme of run_sequence() with the real exponentials exp(-dtau T) and exp(-dtau (V+g|Psi|^2)).
+  * After each kinetic step every component is rescaled to the particle number it had at the start of the sequence.
+  * The time step starts at seq.dt and is halved seq.dt_levels-1 times (attribute dt_levels), each dt runs until the
+  * chemical potentials change by less than seq.tol (attribute tol, relative) over Nk steps or the duration is exhausted.
+  * The time m_header.t is not advanced. The kinetic tables are local, m_full_step and m_half_step stay untouched.
+  * @param seq Sequence item of the imag_time sequence
   */
 template <class T, int dim, int no_int_states>
-void CRT_Base<T,dim,no_int_states>::Setup_Momentum( CPoint<dim> px, const int comp )
+void CRT_Base<T,dim,no_int_states>::run_imag_time( const sequence_item &seq )
 {
-  if ( comp<0 || comp>no_int_states ) throw std::string("Error in " + std::string(__func__) + ": comp out of bounds\n");
+  std::array<huge_vector<double>,no_int_states> pot;
+  Setup_Imag_Potential( pot );
+
+  std::array<double,no_int_states> N, mu, mu_old;
+  for ( int i=0; i<no_int_states; i++ )
+    N[i] = Get_Particle_Number(i);
+
+  double max_duration = 0;
+  for ( unsigned i = 0; i < seq.duration.size(); i++)
+    if (seq.duration[i] > max_duration )
+      max_duration = seq.duration[i];
+
+  vector<double> half_step(m_no_of_pts), full_step(m_no_of_pts);
+  const int Nk = seq.Nk;
+  double dt = seq.dt;
+
+  std::cout << "FYI: started new sequence " << seq.name << "\n";
+  std::cout << "FYI: duration    : " << max_duration << "\n";
+  std::cout << "FYI: dt          : " << seq.dt << "\n";
+  std::cout << "FYI: dt_levels   : " << seq.dt_levels << "\n";
+  std::cout << "FYI: tol         : " << seq.tol << "\n";
+
+  for ( int lev=0; lev<seq.dt_levels; lev++, dt *= 0.5 )
+  {
+    #pragma omp parallel
+    m_fields[0]->For_k( [&]( const int64_t l, CPoint<dim> &k )
+    {
+      const double phi = dt*(k.scale(m_alpha)*k);
+      half_step[l] = exp(-0.5*phi);
+      full_step[l] = exp(-phi);
+    } );
+
+    Compute_Chemical_Potentials( pot, mu_old );
+
+    const int Na = std::max( 1, int(max_duration/(dt*Nk)) );
+    bool converged = false;
+    int i=1;
+    for ( ; i<=Na && !converged; i++ )
+    {
+      Do_Imag_FT_Step( half_step, N );    // exp(-T/2)
+      for ( int j=2; j<=Nk; j++ )
+      {
+        Do_Imag_NL_Step( pot, dt );       // exp(-V)
+        Do_Imag_FT_Step( full_step, N );  // exp(-T)
+      }
+      Do_Imag_NL_Step( pot, dt );         // exp(-V)
+      Do_Imag_FT_Step( half_step, N );    // exp(-T/2)
+
+      Compute_Chemical_Potentials( pot, mu );
+
+      converged = true;
+      for ( int c=0; c<no_int_states; c++ )
+      {
+        if ( fabs(mu[c]-mu_old[c]) > seq.tol*fabs(mu[c]) ) converged = false;
+        std::cout << "mu[" << c << "] = " << mu[c] << std::endl;
+      }
+      mu_old = mu;
+    }
+
+    std::cout << "FYI: dt = " << dt << " after " << (i-1)*Nk << " steps " << (converged ? "converged" : "not converged") << "\n";
+  }
+
+  if ( seq.output_freq == freq::last )
+  {
+    char filename[1024];
+    for ( int k=0; k<no_int_states; k++ )
+    {
+      sprintf( filename, "%.3f_%d.bin", this->Get_t(), k+1 );
+      this->Save_Phi( filename, k );
+    }
+  }
+
+  if ( seq.compute_pn_freq == freq::last )
+  {
+    for ( int c=0; c<no_int_states; c++ )
+      std::cout << "N[" << c << "] = " << this->Get_Particle_Number(c) << std::endl;
+  }
+}
+
+/** Potentials for the imaginary time propagation
+  *
+  * m_Potential if initialized, otherwise the expressions POTENTIAL_nD (first component) and POTENTIAL_nD_2, ...
+  * of the SIMULATION section, a missing expression for a component defaults to the first one.
+  * @param pot Receives one potential per internal state
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base<T,dim,no_int_states>::Setup_Imag_Potential( std::array<huge_vector<double>,no_int_states> &pot )
+{
+  if ( m_potenial_initialized )
+  {
+    pot = m_Potential;
+    return;
+  }
+
+  const std::string dimstr = "POTENTIAL_" + std::to_string(dim) + "D";
+  std::array<std::string,no_int_states> expr;
+  expr[0] = m_params->Get_simulation( dimstr );
+  for ( int i=1; i<no_int_states; i++ )
+  {
+    try
+    {
+      expr[i] = m_params->Get_simulation( dimstr + "_" + std::to_string(i+1) );
+    }
+    catch (std::string &)
+    {
+      expr[i] = expr[0];
+    }
+  }
+
+  // one parser per thread; muParser parses on the first Eval, so a bad expression throws here,
+  // outside of the parallel loop, and the caller reports it
+  const int no_of_threads = omp_get_max_threads();
+  std::vector<CPoint<dim>> x( no_of_threads );
+  std::vector<mu::Parser> mup( no_of_threads );
+  for ( int t=0; t<no_of_threads; t++ )
+  {
+    m_params->Setup_muParser( mup[t] );
+    mup[t].DefineVar("x", &x[t][0]);
+    if ( dim > 1 ) mup[t].DefineVar("y", &x[t][1]);
+    if ( dim > 2 ) mup[t].DefineVar("z", &x[t][2]);
+  }
+
+  for ( int i=0; i<no_int_states; i++ )
+  {
+    pot[i].resize(m_no_of_pts);
+
+    for ( int t=0; t<no_of_threads; t++ )
+    {
+      mup[t].SetExpr( expr[i] );
+      mup[t].Eval();
+    }
+
+    #pragma omp parallel
+    {
+      const int t = omp_get_thread_num();
+      m_fields[0]->For_x( [&]( const int64_t l, CPoint<dim> &p )
+      {
+        x[t] = p;
+        pot[i][l] = mup[t].Eval();
+      } );
+    }
+  }
+}
+
+/** Kinetic step in imaginary time followed by the renormalization of all components
+  *
+  * @param kin Real exponential of the kinetic operator in Fourier space
+  * @param N Particle numbers to rescale to, components with N = 0 are left untouched
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base<T,dim,no_int_states>::Do_Imag_FT_Step( const vector<double> &kin, const std::array<double,no_int_states> &N )
+{
+  for ( int c=0; c<no_int_states; c++ )
+    m_fields[c]->ft(-1);
+
+  for ( int i=0; i<no_int_states; i++ )
+  {
+    fftw_complex *Psi = m_fields[i]->Getp2In();
+
+    #pragma omp parallel for
+    for ( int l=0; l<m_no_of_pts; l++ )
+    {
+      Psi[l][0] *= kin[l];
+      Psi[l][1] *= kin[l];
+    }
+  }
+
+  for ( int c=0; c<no_int_states; c++ )
+    m_fields[c]->ft(1);
+
+  for ( int i=0; i<no_int_states; i++ )
+  {
+    if ( N[i] <= 0 ) continue;
+
+    fftw_complex *Psi = m_fields[i]->Getp2In();
+    const double fak = sqrt(N[i]/Get_Particle_Number(i));
 
+    #pragma omp parallel for
+    for ( int l=0; l<m_no_of_pts; l++ )
+    {
+      Psi[l][0] *= fak;
+      Psi[l][1] *= fak;
+    }
+  }
+}
+
+/** Potential and nonlinear step in imaginary time
+  *
+  * @param pot Potentials of the internal states
+  * @param dt Imaginary time step
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base<T,dim,no_int_states>::Do_Imag_NL_Step( const std::array<huge_vector<double>,no_int_states> &pot, const double dt )
+{
   #pragma omp parallel
   {
-    CPoint<dim> x;
-    double re, im, re2, im2;
+    double fak[no_int_states];
 
-    fftw_complex *Psi = m_fields[comp]->Getp2In();
+    vector<fftw_complex *> Psi;
+    for ( int i=0; i<no_int_states; i++ )
+      Psi.push_back(m_fields[i]->Getp2In());
 
     #pragma omp for
     for ( int l=0; l<m_no_of_pts; l++ )
     {
-      x = this->m_fields[comp]->Get_x(l);
-      //exp(p*x)
-      sincos(px*x,&im,&re);
+      for ( int i=0; i<no_int_states; i++ )
+      {
+        double phi = pot[i][l];
+        for ( int j=0; j<no_int_states; j++ )
+          phi += m_gs[j+no_int_states*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
+        fak[i] = exp(-dt*phi);
+      }
+
+      //exp(-V)*Psi
+      for ( int i=0; i<no_int_states; i++ )
+      {
+        Psi[i][l][0] *= fak[i];
+        Psi[i][l][1] *= fak[i];
+      }
+    }
+  }
+}
+
+/** Chemical potentials mu_i = <Psi_i|T+V_i+sum_j g_ij |Psi_j|^2|Psi_i>/N_i
+  *
+  * The kinetic energy is evaluated in Fourier space, components with N = 0 get mu = 0.
+  * @param pot Potentials of the internal states
+  * @param mu Receives the chemical potentials
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base<T,dim,no_int_states>::Compute_Chemical_Potentials( const std::array<huge_vector<double>,no_int_states> &pot, std::array<double,no_int_states> &mu )
+{
+  for ( int i=0; i<no_int_states; i++ )
+  {
+    const double N = Get_Particle_Number(i);
+    if ( N <= 0 )
+    {
+      mu[i] = 0;
+      continue;
+    }
+
+    fftw_complex *Psi = m_fields[i]->Getp2In();
 
-      re2 = Psi[l][0];
-      im2 = Psi[l][1];
-      Psi[l][0] = re2*re-im2*im;
-      Psi[l][1] = re2*im+im2*re;
+    double epot=0;
+    #pragma omp parallel for reduction(+:epot)
+    for ( int l=0; l<m_no_of_pts; l++ )
+    {
+      double phi = pot[i][l];
+      for ( int j=0; j<no_int_states; j++ )
+      {
+        fftw_complex *Psi_j = m_fields[j]->Getp2In();
+        phi += m_gs[j+no_int_states*i]*(Psi_j[l][0]*Psi_j[l][0] + Psi_j[l][1]*Psi_j[l][1]);
+      }
+      epot += phi*(Psi[l][0]*Psi[l][0] + Psi[l][1]*Psi[l][1]);
     }
+
+    m_fields[i]->ft(-1);
+
+    double ekin=0;
+    #pragma omp parallel reduction(+:ekin)
+    m_fields[i]->For_k( [&]( const int64_t l, CPoint<dim> &k )
+    {
+      ekin += (k.scale(m_alpha)*k)*(Psi[l][0]*Psi[l][0] + Psi[l][1]*Psi[l][1]);
+    } );
+
+    m_fields[i]->ft(1);
+
+    mu[i] = (m_ar*epot + m_ar_k*ekin)/N;
   }
 }
 
+/** Add a constant momentum to an internal state.
+  *
+  * @param px Momentum to be added
+  * @param comp Number of the internal state to which the momentum shall be added
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base<T,dim,no_int_states>::Setup_Momentum( CPoint<dim> px, const int comp )
+{
+  if ( comp<0 || comp>no_int_states ) throw std::string("Error in " + std::string(__func__) + ": comp out of bounds\n");
+
+  fftw_complex *Psi = m_fields[comp]->Getp2In();
+
+  #pragma omp parallel
+  m_fields[comp]->For_x( [&]( const int64_t l, CPoint<dim> &x )
+  {
+    double re, im;
+    //exp(p*x)
+    sincos(px*x,&im,&re);
+
+    const double re2 = Psi[l][0];
+    const double im2 = Psi[l][1];
+    Psi[l][0] = re2*re-im2*im;
+    Psi[l][1] = re2*im+im2*re;
+  } );
+}
+
 /** Calculate the expectation value of the postion of an internal state
   *
   * @param retval Reference to a CPoint object in which the expectation value will be saved
@@ -490,7 +773,6 @@ void CRT_Base<T,dim,no_int_states>::Expval_Position( CPoint<dim> &retval, const
     const int ithread = omp_get_thread_num();
 
     double den;
-    CPoint<dim> x;
     fftw_complex *Psi = m_fields[comp]->Getp2In();
 
     #pragma omp single
@@ -499,14 +781,12 @@ void CRT_Base<T,dim,no_int_states>::Expval_Position( CPoint<dim> &retval, const
       for (int i=0; i<(dim*nthreads); i++) tmp[i] = 0;
     }
 
-    #pragma omp for
-    for ( int l=0; l<m_no_of_pts; l++ )
+    m_fields[comp]->For_x( [&]( const int64_t l, CPoint<dim> &x )
     {
-      x = m_fields[comp]->Get_x(l);
       den = (Psi[l][0]*Psi[l][0]+Psi[l][1]*Psi[l][1]);
       for (int i=0; i<dim; i++ )
         tmp[ithread*dim+i] += x[i]*den;
-    }
+    } );
 
     #pragma omp for
     for (int i=0; i<dim; i++)
@@ -543,7 +823,6 @@ void CRT_Base<T,dim,no_int_states>::Expval_Momentum( CPoint<dim> &retval, const
     const int ithread = omp_get_thread_num();
 
     double den;
-    CPoint<dim> k;
     fftw_complex *Psi = m_fields[comp]->Getp2In();
 
     #pragma omp single
@@ -552,14 +831,12 @@ void CRT_Base<T,dim,no_int_states>::Expval_Momentum( CPoint<dim> &retval, const
       for (int i=0; i<(dim*nthreads); i++) tmp[i] = 0;
     }
 
-    #pragma omp for
-    for ( int l=0; l<m_no_of_pts; l++ )
+    m_fields[comp]->For_k( [&]( const int64_t l, CPoint<dim> &k )
     {
-      k = m_fields[comp]->Get_k(l);
       den = (Psi[l][0]*Psi[l][0]+Psi[l][1]*Psi[l][1]);
       for (int i=0; i<dim; i++ )
         tmp[ithread*dim+i] += k[i]*den;
-    }
+    } );
 
     #pragma omp for
     for (int i=0; i<dim; i++)
@@ -715,6 +992,13 @@ void CRT_Base<T,dim,no_int_states>::run_sequence()
   {
     if ( run_custom_sequence(seq) ) continue;
 
+    if ( seq.name == "imag_time" ) //Relax to the ground state
+    {
+      this->run_imag_time( seq );
+      seq_counter++;
+      continue;
+    }
+
     if ( seq.name == "set_momentum" ) //Call Setup_Momentum
     {
       std::vector<std::string> vec;
@@ -29,6 +29,7 @@
 
 #include "CRT_shared.h"
 #include "cft_base.h"
+#include "huge_alloc.h"
 #include "ParameterHandler.h"
 
 using namespace std;
@@ -87,7 +88,7 @@ protected:
 
   std::array<double,no_int_states *no_int_states> m_gs;
   std::array<T *,no_int_states> m_fields;
-  std::array<vector<double>,no_int_states> m_Potential;
+  std::array<huge_vector<double>,no_int_states> m_Potential;
 
   std::map<std::string,StepFunction> m_map_stepfcts;
   StepFunction m_custom_fct;
@@ -136,10 +137,10 @@ CRT_Base_2<T,dim,no_int_states>::~CRT_Base_2()
 {
   for ( int i=0; i<no_int_states; i++ )
     delete m_fields[i];
-  fftw_free( m_full_step );
-  fftw_free( m_half_step );
-  fftw_free( m_full_step2 );
-  fftw_free( m_half_step2 );
+  Huge_Free( m_full_step );
+  Huge_Free( m_half_step );
+  Huge_Free( m_full_step2 );
+  Huge_Free( m_half_step2 );
 }
 
 template <class T,int dim, int no_int_states>
@@ -151,10 +152,15 @@ void CRT_Base_2<T,dim,no_int_states>::Allocate()
     m_fields[i]->SetFix(false);
   }
 
-  m_full_step = (fftw_complex *)fftw_malloc( sizeof(fftw_complex)*m_no_of_pts );
-  m_half_step = (fftw_complex *)fftw_malloc( sizeof(fftw_complex)*m_no_of_pts );
-  m_full_step2 = (fftw_complex *)fftw_malloc( sizeof(fftw_complex)*m_no_of_pts );
-  m_half_step2 = (fftw_complex *)fftw_malloc( sizeof(fftw_complex)*m_no_of_pts );
+  m_full_step = Huge_Alloc_Complex( m_no_of_pts );
+  m_half_step = Huge_Alloc_Complex( m_no_of_pts );
+  m_full_step2 = Huge_Alloc_Complex( m_no_of_pts );
+  m_half_step2 = Huge_Alloc_Complex( m_no_of_pts );
+  First_Touch( m_full_step, m_no_of_pts );
+  First_Touch( m_half_step, m_no_of_pts );
+  First_Touch( m_full_step2, m_no_of_pts );
+  First_Touch( m_half_step2, m_no_of_pts );
+  Huge_Pages_Report();
 }
 
 template <class T, int dim, int no_int_states>
@@ -364,25 +364,7 @@ void CRT_Base_2_mpi<T,dim,no_int_states>::Save_Psi( std::string filename, const
 {
   if ( comp<0 || comp>no_int_states ) throw std::string("Error in " + string(__func__) + ": comp out of bounds\n");
 
-  fftw_complex *Psi = m_fields[comp]->Get_p2_Data();
-
-  double *data = reinterpret_cast<double *>(Psi);
-
-  MPI_Status status;
-  MPI_File   fh;
-
-  int rank;
-  MPI_Comm_rank( MPI_COMM_WORLD, &rank );
-
-  MPI_Offset offset = sizeof(generic_header) + sizeof(fftw_complex)*rank*m_no_of_pts;
-
-  MPI_File_open( MPI_COMM_WORLD, const_cast<char *>(filename.c_str()), MPI_MODE_CREATE|MPI_MODE_WRONLY, MPI_INFO_NULL, &fh );
-
-  if ( rank == 0 )
-    MPI_File_write( fh, &m_header, sizeof(generic_header), MPI_BYTE, &status );
-
-  MPI_File_write_at( fh, offset, data, 2*m_no_of_pts, MPI_DOUBLE, MPI_STATUS_IGNORE );
-  MPI_File_close( &fh );
+  m_fields[comp]->Write_File( filename );
   MPI_Barrier( MPI_COMM_WORLD );
 }
 
@@ -226,7 +226,7 @@ void CRT_Base_IF<T,dim,no_int_states>::compute_rabi_integrals()
     const int nthreads = omp_get_num_threads();
     const int ithread = omp_get_thread_num();
 
-    CPoint<dim> k1, d;
+    CPoint<dim> d;
 
     //size of tmp equals number of threads
     #pragma omp single
@@ -235,10 +235,8 @@ void CRT_Base_IF<T,dim,no_int_states>::compute_rabi_integrals()
       for (int i=0; i<(n*nthreads); i++) tmp[i] = 0;
     }
 
-    #pragma omp for
-    for ( int i=0; i<m_no_of_pts; i++ )
+    m_fields[0]->For_k( [&]( const int64_t i, CPoint<dim> &k1 )
     {
-      k1 = m_fields[0]->Get_k(i);
       int j=0;
       //Loop through all momentum states
       for ( auto k0 : m_rabi_momentum_list )
@@ -253,7 +251,7 @@ void CRT_Base_IF<T,dim,no_int_states>::compute_rabi_integrals()
         }
         j++;
       }
-    }
+    } );
 
     //Sum over all threads
     #pragma omp for
@@ -382,14 +380,12 @@ void CRT_Base_IF<T,dim,no_int_states>::Do_NL_Step()
 {
   const double dt = -m_header.dt;
   double re1, im1, tmp1, phi[no_int_states];
-  CPoint<dim> x;
-
   vector<fftw_complex *> Psi;
   //Vector for the components of the wavefunction
   for ( int i=0; i<no_int_states; i++ )
     Psi.push_back(m_fields[i]->Getp2In());
 
-  for ( int l=0; l<this->m_no_of_pts; l++ )
+  m_fields[0]->For_x( [&]( const int64_t l, CPoint<dim> &x )
   {
     //Loop through column
     for ( int i=0; i<no_int_states; i++ )
@@ -401,7 +397,6 @@ void CRT_Base_IF<T,dim,no_int_states>::Do_NL_Step()
         //For example: gs_11 * Psi_1 + g_12 * Psi_2 + ...
         phi[i] += this->m_gs[j+no_int_states*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
       }
-      x = m_fields[0]->Get_x(l);
       phi[i] += beta[0]*x[0]-DeltaL[i];
       phi[i] *= dt;
     }
@@ -415,7 +410,7 @@ void CRT_Base_IF<T,dim,no_int_states>::Do_NL_Step()
       Psi[i][l][0] = Psi[i][l][0]*re1 - Psi[i][l][1]*im1;
       Psi[i][l][1] = Psi[i][l][1]*re1 + tmp1*im1;
     }
-  }
+  } );
 }
 
 /** Solves the potential part in the presence of light fields with a numerical method
@@ -444,12 +439,10 @@ void CRT_Base_IF<T,dim,no_int_states>::Numerical_Bragg()
     gsl_matrix_complex *evec = gsl_matrix_complex_alloc(no_int_states,no_int_states);
 
     double phi[no_int_states],re1,im1,eta[2];
-    CPoint<dim> x;
     laser_k[1] = -laser_k[0];
     chirp_rate[1] = -chirp_rate[0];
 
-    #pragma omp for
-    for ( int l=0; l<this->m_no_of_pts; l++ )
+    m_fields[0]->For_x( [&]( const int64_t l, CPoint<dim> &x )
     {
       gsl_matrix_complex_set_zero(A);
       gsl_matrix_complex_set_zero(B);
@@ -463,7 +456,6 @@ void CRT_Base_IF<T,dim,no_int_states>::Numerical_Bragg()
         {
           phi[i] += this->m_gs[j+no_int_states*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
         }
-        x = m_fields[0]->Get_x(l);
         phi[i] += beta*x-DeltaL[i];
         gsl_matrix_complex_set(A,i,i, {phi[i],0});
       }
@@ -514,7 +506,7 @@ void CRT_Base_IF<T,dim,no_int_states>::Numerical_Bragg()
         Psi[i][l][0] = gsl_vector_complex_get(Psi_2,i).dat[0];
         Psi[i][l][1] = gsl_vector_complex_get(Psi_2,i).dat[1];
       }
-    }
+    } );
     gsl_matrix_complex_free(A);
     gsl_matrix_complex_free(B);
     gsl_eigen_hermv_free(w);
@@ -550,10 +542,8 @@ void CRT_Base_IF<T,dim,no_int_states>::Numerical_Raman()
     gsl_matrix_complex *evec = gsl_matrix_complex_alloc(no_int_states,no_int_states);
 
     double phi[no_int_states],re1,im1,eta[2];
-    CPoint<dim> x;
 
-    #pragma omp for
-    for ( int l=0; l<this->m_no_of_pts; l++ )
+    m_fields[0]->For_x( [&]( const int64_t l, CPoint<dim> &x )
     {
       gsl_matrix_complex_set_zero(A);
       gsl_matrix_complex_set_zero(B);
@@ -566,7 +556,6 @@ void CRT_Base_IF<T,dim,no_int_states>::Numerical_Raman()
         {
           phi[i] += this->m_gs[j+no_int_states*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
         }
-        x = this->m_fields[0]->Get_x(l);
         phi[i] += beta*x-DeltaL[i];
         gsl_matrix_complex_set(A,i,i, {phi[i],0});
       }
@@ -620,7 +609,7 @@ void CRT_Base_IF<T,dim,no_int_states>::Numerical_Raman()
         Psi[i][l][0] = gsl_vector_complex_get(Psi_2,i).dat[0];
         Psi[i][l][1] = gsl_vector_complex_get(Psi_2,i).dat[1];
       }
-    }
+    } );
     gsl_matrix_complex_free(A);
     gsl_matrix_complex_free(B);
     gsl_eigen_hermv_free(w);
@@ -677,6 +666,13 @@ void CRT_Base_IF<T,dim,no_int_states>::run_sequence()
       continue;
     }
 
+    if ( seq.name == "imag_time" )
+    {
+      this->run_imag_time( seq );
+      seq_counter++;
+      continue;
+    }
+
     if ( seq.name == "set_momentum" )
     {
       std::vector<std::string> vec;
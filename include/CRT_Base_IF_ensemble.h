@@ -0,0 +1,780 @@
+/* * ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+ * (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+ * founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+ * 50WM0942, 50WM1042, 50WM1342.
+ * Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+ *
+ * This file is part of ATUS2.
+ *
+ * ATUS2 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ATUS2 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <array>
+#include <vector>
+
+#include "CRT_Base_IF.h"
+#include "ParameterHandler.h"
+
+using namespace std;
+
+#ifndef __class_CRT_Base_IF_ensemble__
+#define __class_CRT_Base_IF_ensemble__
+
+/** Laser parameters of one member of an ensemble
+  *
+  * Every member starts with the values of the xml file, which are then overwritten
+  * by the lists Ens_laser_domh, Ens_Amp_1, Ens_phase and Ens_chirp (see Get_Ensemble_Size()).
+  */
+struct ensemble_member
+{
+  double laser_domh; ///< Difference between the frequencies of the laser fields
+  double Amp[2]; ///< Amplitude of the light fields
+  double phase; ///< Additional phase
+  double chirp; ///< Chirp of the frequency difference
+  std::vector<double> DeltaL; ///< Detuning of each internal state
+  std::string label; ///< Optional description of the member (e.g. the initial state)
+};
+
+/** Returns the number of ensemble members defined in the xml file
+  *
+  * The ensemble is defined by one or more of the following lists in the VCONSTANTS section:
+  *   - Ens_laser_domh
+  *   - Ens_Amp_1 (one value per member is used for both beams)
+  *   - Ens_phase
+  *   - Ens_chirp
+  *
+  * @retval 0 if no list is found, otherwise the length of the longest list
+  */
+inline int Get_Ensemble_Size( ParameterHandler *params )
+{
+  int retval=0;
+  for ( const std::string str : { "Ens_laser_domh", "Ens_Amp_1", "Ens_phase", "Ens_chirp" } )
+  {
+    try
+    {
+      const int n = params->Get_VConstant(str).size();
+      if ( n > retval ) retval = n;
+    }
+    catch (std::string &)
+    {
+    }
+  }
+  return retval;
+}
+
+/** Template class for the propagation of an ensemble of interferometers in <B>dim</B> dimensions with <B>no_int_states</B> internal states
+  *
+  * All members start with the same initial wave functions and differ only in the laser parameters
+  * stored in #m_members. The wave functions of all members and all internal states are stored in one
+  * array #m_batch (member major) and are transformed with a single fftw_plan_many_dft, so small grids
+  * are propagated with one set of plans and tables instead of one process per parameter set.
+  *
+  * The light-atom interaction is defined in the derived classes. A kernel loops over all members and
+  * reads the parameters of a member from #m_members, the wave functions from Get_p2Member().
+  *
+  * The rabi integrals and particle numbers of all members are written to one table Ensemble_<seq>.txt.
+  */
+template <class T, int dim, int no_int_states>
+class CRT_Base_IF_ensemble : public CRT_Base_IF<T,dim,no_int_states>
+{
+public:
+  CRT_Base_IF_ensemble( ParameterHandler *, const int no_of_members=0 );
+  virtual ~CRT_Base_IF_ensemble();
+
+  void run_sequence();
+
+  /// Number of members of the ensemble
+  int Get_No_Members() const
+  {
+    return m_no_of_members;
+  };
+
+  /// Pointer to internal state comp of member m
+  fftw_complex *Get_p2Member( const int m, const int comp )
+  {
+    return m_batch + (size_t(m)*no_int_states+comp)*m_no_of_pts;
+  };
+
+  double Get_Member_Particle_Number( const int m, const int comp=0 );
+  void Setup_Momentum( CPoint<dim>, const int comp=0 );
+
+protected:
+  using CRT_Base<T,dim,no_int_states>::m_header;
+  using CRT_Base<T,dim,no_int_states>::m_params;
+  using CRT_Base<T,dim,no_int_states>::m_fields;
+  using CRT_Base<T,dim,no_int_states>::m_gs;
+  using CRT_Base<T,dim,no_int_states>::m_alpha;
+  using CRT_Base_IF<T,dim,no_int_states>::beta;
+  using CRT_Base_IF<T,dim,no_int_states>::m_rabi_momentum_list;
+  using CRT_Base_IF<T,dim,no_int_states>::m_rabi_threshold;
+  using CRT_shared::m_no_of_pts;
+
+  static void Do_FT_Step_full_Wrapper(void *,sequence_item &);
+  static void Do_FT_Step_half_Wrapper(void *,sequence_item &);
+  static void Do_NL_Step_Wrapper(void *,sequence_item &);
+
+  void Do_FT_Step( fftw_complex ** );
+  void Do_NL_Step();
+
+  void Init();
+  void UpdateMembers();
+  void Set_Species( const int, const CPoint<dim> &, const CPoint<dim> & );
+  void Save_Members();
+
+  void compute_observables();
+  void Output_ensemble_table( string );
+
+  /// Define custom sequences
+  virtual bool run_custom_sequence( const sequence_item & )=0;
+
+  /// Number of members
+  int m_no_of_members;
+  /// Laser parameters of each member
+  vector<ensemble_member> m_members;
+
+  /// Wave functions of all members, member m and internal state c start at (m*no_int_states+c)*m_no_of_pts
+  fftw_complex *m_batch;
+  /// Forward transform of all wave functions in #m_batch
+  fftw_plan m_plan_forward;
+  /// Backward transform of all wave functions in #m_batch
+  fftw_plan m_plan_backward;
+
+  /// Scaling factor for the kinetic part of each internal state
+  std::array<CPoint<dim>,no_int_states> m_ens_alpha;
+  /// Gravitational potential of each internal state
+  std::array<CPoint<dim>,no_int_states> m_ens_beta;
+  /// Exponential of the whole kinetic operator including the normalisation of the unscaled transforms
+  std::array<fftw_complex *,no_int_states> m_ens_full_step;
+  /// Exponential of half of the kinetic operator including the normalisation of the unscaled transforms
+  std::array<fftw_complex *,no_int_states> m_ens_half_step;
+
+  /** Internal states and their momentum states for the rabi integrals
+    * If empty, the momentum states #m_rabi_momentum_list of the first internal state are used.
+    */
+  vector<pair<int,vector<CPoint<dim>>>> m_rabi_states;
+
+  /** Contains the observables of all members
+    * One row per member and output: member, time, particle number in each momentum state
+    * of #m_rabi_states and the particle number of each internal state.
+    */
+  list<vector<double>> m_ensemble_table;
+};
+
+/** Reads the ensemble from the xml file, allocates #m_batch and sets up the batched plans
+  *
+  * The initial wave functions loaded by CRT_Base are copied to every member.
+  * @param params Pointer to ParameterHandler object to read from xml files
+  * @param no_of_members Number of members, if 0 the size is taken from the xml file (see Get_Ensemble_Size())
+  */
+template <class T, int dim, int no_int_states>
+CRT_Base_IF_ensemble<T,dim,no_int_states>::CRT_Base_IF_ensemble( ParameterHandler *params, const int no_of_members ) : CRT_Base_IF<T,dim,no_int_states>(params)
+{
+  m_no_of_members = ( no_of_members > 0 ) ? no_of_members : Get_Ensemble_Size( params );
+  if ( m_no_of_members == 0 ) m_no_of_members = 1;
+
+  UpdateMembers();
+
+  const size_t total = size_t(m_no_of_members)*no_int_states*m_no_of_pts;
+  m_batch = Huge_Alloc_Complex( total );
+  assert( m_batch != nullptr );
+
+  // one transform per member and internal state, the arrays are contiguous (only the first dim entries of n are used)
+  int n[] = { int(this->Get_dimX()), int(this->Get_dimY()), int(this->Get_dimZ()) };
+
+  const int howmany = m_no_of_members*no_int_states;
+  m_plan_forward  = fftw_plan_many_dft( dim, n, howmany, m_batch, nullptr, 1, m_no_of_pts, m_batch, nullptr, 1, m_no_of_pts, FFTW_FORWARD, FFTW_ESTIMATE );
+  m_plan_backward = fftw_plan_many_dft( dim, n, howmany, m_batch, nullptr, 1, m_no_of_pts, m_batch, nullptr, 1, m_no_of_pts, FFTW_BACKWARD, FFTW_ESTIMATE );
+  assert( m_plan_forward != nullptr );
+  assert( m_plan_backward != nullptr );
+
+  for ( int m=0; m<m_no_of_members; m++ )
+    for ( int c=0; c<no_int_states; c++ )
+      memcpy( Get_p2Member(m,c), m_fields[c]->Getp2In(), sizeof(fftw_complex)*m_no_of_pts );
+
+  for ( int c=0; c<no_int_states; c++ )
+  {
+    m_ens_alpha[c] = m_alpha;
+    m_ens_beta[c] = beta;
+    m_ens_full_step[c] = Huge_Alloc_Complex( m_no_of_pts );
+    m_ens_half_step[c] = Huge_Alloc_Complex( m_no_of_pts );
+  }
+  Init();
+
+  this->m_map_stepfcts["half_step"] = &Do_FT_Step_half_Wrapper;
+  this->m_map_stepfcts["full_step"] = &Do_FT_Step_full_Wrapper;
+  this->m_map_stepfcts["freeprop"] = &Do_NL_Step_Wrapper;
+  this->m_map_stepfcts.erase("bragg");
+  this->m_map_stepfcts.erase("raman");
+}
+
+/// Destructor
+template <class T, int dim, int no_int_states>
+CRT_Base_IF_ensemble<T,dim,no_int_states>::~CRT_Base_IF_ensemble()
+{
+  fftw_destroy_plan( m_plan_forward );
+  fftw_destroy_plan( m_plan_backward );
+  Huge_Free( m_batch );
+  for ( int c=0; c<no_int_states; c++ )
+  {
+    Huge_Free( m_ens_full_step[c] );
+    Huge_Free( m_ens_half_step[c] );
+  }
+}
+
+/** Set the laser parameters of the members
+  *
+  * Lists with a single value are used for all members.
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::UpdateMembers()
+{
+  ensemble_member def;
+  def.laser_domh = this->laser_domh[0];
+  def.Amp[0] = this->Amp[0];
+  def.Amp[1] = this->Amp[1];
+  def.phase = 0;
+  def.chirp = this->chirp;
+  def.DeltaL.assign( this->DeltaL.begin(), this->DeltaL.end() );
+
+  m_members.assign( m_no_of_members, def );
+
+  auto read_list = [&]( const std::string name, std::vector<double> &vec )
+  {
+    try
+    {
+      vec = m_params->Get_VConstant( name );
+    }
+    catch (std::string &)
+    {
+      vec.clear();
+      return;
+    }
+    if ( vec.size() != 1 && int(vec.size()) != m_no_of_members )
+      throw std::string( "Error: " + name + " has " + to_string(vec.size()) + " entries, the ensemble has " + to_string(m_no_of_members) + " members.\n" );
+    vec.resize( m_no_of_members, vec[0] );
+  };
+
+  std::vector<double> vec;
+  read_list( "Ens_laser_domh", vec );
+  for ( size_t m=0; m<vec.size(); m++ ) m_members[m].laser_domh = vec[m];
+  read_list( "Ens_Amp_1", vec );
+  for ( size_t m=0; m<vec.size(); m++ ) m_members[m].Amp[0] = m_members[m].Amp[1] = vec[m];
+  read_list( "Ens_phase", vec );
+  for ( size_t m=0; m<vec.size(); m++ ) m_members[m].phase = vec[m];
+  read_list( "Ens_chirp", vec );
+  for ( size_t m=0; m<vec.size(); m++ ) m_members[m].chirp = vec[m];
+
+  std::cout << "FYI: ensemble with " << m_no_of_members << " members" << std::endl;
+}
+
+/** Change the kinetic scaling factor and the gravitational potential of an internal state (e.g. for a second species)
+  *
+  * @param comp internal state
+  * @param alpha dimensionless scaling factor for the kinetic part
+  * @param b gravitational potential
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::Set_Species( const int comp, const CPoint<dim> &alpha, const CPoint<dim> &b )
+{
+  assert( comp > -1 && comp < no_int_states );
+  m_ens_alpha[comp] = alpha;
+  m_ens_beta[comp] = b;
+  Init();
+}
+
+/** Computes the exponentials of the kinetic operator of every internal state
+  *
+  * The batched transforms are not normalised, the factor 1/m_no_of_pts of a forward and
+  * backward transform is included in the tables.
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::Init()
+{
+  CRT_Base<T,dim,no_int_states>::Init();
+
+  const double dt = -m_header.dt;
+  const double fak = 1.0/double(m_no_of_pts);
+
+  for ( int c=0; c<no_int_states; c++ )
+  {
+    fftw_complex *full = m_ens_full_step[c];
+    fftw_complex *half = m_ens_half_step[c];
+    CPoint<dim> alpha = m_ens_alpha[c];
+
+    #pragma omp parallel for
+    for ( int i=0; i<m_no_of_pts; i++ )
+    {
+      CPoint<dim> k = m_fields[0]->Get_k(i);
+      const double phi = dt*(k.scale(alpha)*k);
+
+      half[i][0] = fak*cos(0.5*phi);
+      half[i][1] = fak*sin(0.5*phi);
+      full[i][0] = fak*cos(phi);
+      full[i][1] = fak*sin(phi);
+    }
+  }
+}
+
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::Do_FT_Step_full_Wrapper ( void *ptr, sequence_item &seq )
+{
+  CRT_Base_IF_ensemble *self = static_cast<CRT_Base_IF_ensemble *>(ptr);
+  self->Do_FT_Step( self->m_ens_full_step.data() );
+  self->m_header.t += self->m_header.dt;
+}
+
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::Do_FT_Step_half_Wrapper ( void *ptr, sequence_item &seq )
+{
+  CRT_Base_IF_ensemble *self = static_cast<CRT_Base_IF_ensemble *>(ptr);
+  self->Do_FT_Step( self->m_ens_half_step.data() );
+  self->m_header.t += 0.5*self->m_header.dt;
+}
+
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::Do_NL_Step_Wrapper ( void *ptr, sequence_item &seq )
+{
+  CRT_Base_IF_ensemble *self = static_cast<CRT_Base_IF_ensemble *>(ptr);
+  self->Do_NL_Step();
+}
+
+/** Kinetic part of all members and internal states
+  *
+  * @param step table of the exponential of the kinetic operator for each internal state
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::Do_FT_Step( fftw_complex **step )
+{
+  fftw_execute( m_plan_forward );
+
+  const int howmany = m_no_of_members*no_int_states;
+
+  #pragma omp parallel for collapse(2)
+  for ( int r=0; r<howmany; r++ )
+  {
+    for ( int l=0; l<m_no_of_pts; l++ )
+    {
+      fftw_complex *Psi = m_batch + size_t(r)*m_no_of_pts;
+      const fftw_complex *S = step[r%no_int_states];
+
+      const double tmp1 = Psi[l][0];
+      Psi[l][0] = Psi[l][0]*S[l][0] - Psi[l][1]*S[l][1];
+      Psi[l][1] = Psi[l][1]*S[l][0] + tmp1*S[l][1];
+    }
+  }
+
+  fftw_execute( m_plan_backward );
+}
+
+/** Solves the potential part without any external fields but gravity for all members
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::Do_NL_Step()
+{
+  const double dt = -m_header.dt;
+
+  #pragma omp parallel
+  {
+    double re1, im1, tmp1, phi[no_int_states];
+    fftw_complex *Psi[no_int_states];
+    CPoint<dim> x;
+
+    #pragma omp for collapse(2)
+    for ( int m=0; m<m_no_of_members; m++ )
+    {
+      for ( int l=0; l<m_no_of_pts; l++ )
+      {
+        for ( int i=0; i<no_int_states; i++ )
+          Psi[i] = Get_p2Member(m,i);
+
+        x = m_fields[0]->Get_x(l);
+
+        for ( int i=0; i<no_int_states; i++ )
+        {
+          phi[i] = 0;
+          for ( int j=0; j<no_int_states; j++ )
+            phi[i] += m_gs[j+no_int_states*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
+          phi[i] += m_ens_beta[i][0]*x[0]-m_members[m].DeltaL[i];
+          phi[i] *= dt;
+        }
+
+        for ( int i=0; i<no_int_states; i++ )
+        {
+          sincos( phi[i], &im1, &re1 );
+
+          tmp1 = Psi[i][l][0];
+          Psi[i][l][0] = Psi[i][l][0]*re1 - Psi[i][l][1]*im1;
+          Psi[i][l][1] = Psi[i][l][1]*re1 + tmp1*im1;
+        }
+      }
+    }
+  }
+}
+
+/** Add a constant momentum to an internal state of all members
+  *
+  * @param px Momentum to be added
+  * @param comp Number of the internal state to which the momentum shall be added
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::Setup_Momentum( CPoint<dim> px, const int comp )
+{
+  if ( comp<0 || comp>=no_int_states ) throw std::string("Error in " + std::string(__func__) + ": comp out of bounds\n");
+
+  #pragma omp parallel
+  {
+    CPoint<dim> x;
+    double re, im, re2, im2;
+
+    #pragma omp for collapse(2)
+    for ( int m=0; m<m_no_of_members; m++ )
+    {
+      for ( int l=0; l<m_no_of_pts; l++ )
+      {
+        fftw_complex *Psi = Get_p2Member(m,comp);
+
+        x = m_fields[0]->Get_x(l);
+        sincos(px*x,&im,&re);
+
+        re2 = Psi[l][0];
+        im2 = Psi[l][1];
+        Psi[l][0] = re2*re-im2*im;
+        Psi[l][1] = re2*im+im2*re;
+      }
+    }
+  }
+}
+
+/** Compute the number of particles of an internal state of a member
+  *
+  * @param m member
+  * @param comp internal state
+  */
+template <class T, int dim, int no_int_states>
+double CRT_Base_IF_ensemble<T,dim,no_int_states>::Get_Member_Particle_Number( const int m, const int comp )
+{
+  if ( comp<0 || comp>=no_int_states ) throw std::string("Error in " + std::string(__func__) + ": comp out of bounds\n");
+
+  fftw_complex *Psi = Get_p2Member(m,comp);
+  double retval=0.0;
+  #pragma omp parallel for reduction(+:retval)
+  for ( int l=0; l<m_no_of_pts; l++ )
+  {
+    retval += (Psi[l][0]*Psi[l][0] + Psi[l][1]*Psi[l][1]);
+  }
+  return this->m_ar*retval;
+}
+
+/** Calculate the observables of all members and append them to #m_ensemble_table
+  *
+  * The number of particles in the momentum states of #m_rabi_states is computed in Fourier space
+  * (one batched transform forth and back) like in CRT_Base_IF::compute_rabi_integrals().
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::compute_observables()
+{
+  if ( m_rabi_states.empty() )
+    m_rabi_states.push_back( make_pair( 0, m_rabi_momentum_list ) );
+
+  const int ns = m_rabi_states.size();
+
+  // area of the momentum states in the order of the unscaled transform, the columns of all states are numbered consecutively
+  vector<vector<int>> idx( ns, vector<int>( m_no_of_pts, -1 ) );
+  int n=0;
+  for ( int s=0; s<ns; s++ )
+  {
+    vector<CPoint<dim>> &list = m_rabi_states[s].second;
+    for ( int i=0; i<m_no_of_pts; i++ )
+    {
+      CPoint<dim> k1 = m_fields[0]->Get_k(i);
+      for ( int j=0; j<int(list.size()); j++ )
+      {
+        CPoint<dim> d = list[j]-k1;
+        if ( sqrt(d*d) < m_rabi_threshold )
+        {
+          idx[s][i] = n+j;
+          break;
+        }
+      }
+    }
+    n += list.size();
+  }
+
+  // |FFT|^2 -> density in momentum space
+  double fak = this->m_ar_k;
+  fak *= m_header.dx*m_header.dx/(2.0*M_PI);
+  if ( dim > 1 ) fak *= m_header.dy*m_header.dy/(2.0*M_PI);
+  if ( dim > 2 ) fak *= m_header.dz*m_header.dz/(2.0*M_PI);
+
+  vector<vector<double>> res( m_no_of_members, vector<double>(n,0) );
+
+  if ( n > 0 )
+  {
+    fftw_execute( m_plan_forward );
+
+    #pragma omp parallel for
+    for ( int m=0; m<m_no_of_members; m++ )
+    {
+      for ( int s=0; s<ns; s++ )
+      {
+        fftw_complex *psik = Get_p2Member(m,m_rabi_states[s].first);
+        for ( int i=0; i<m_no_of_pts; i++ )
+        {
+          if ( idx[s][i] < 0 ) continue;
+          res[m][idx[s][i]] += psik[i][0]*psik[i][0] + psik[i][1]*psik[i][1];
+        }
+      }
+    }
+
+    fftw_execute( m_plan_backward );
+
+    const double fak2 = 1.0/double(m_no_of_pts);
+    const size_t total = size_t(m_no_of_members)*no_int_states*m_no_of_pts;
+    #pragma omp parallel for
+    for ( size_t l=0; l<total; l++ )
+    {
+      m_batch[l][0] *= fak2;
+      m_batch[l][1] *= fak2;
+    }
+  }
+
+  for ( int m=0; m<m_no_of_members; m++ )
+  {
+    vector<double> row;
+    row.push_back(m);
+    row.push_back(this->Get_t());
+    for ( int j=0; j<n; j++ )
+      row.push_back(fak*res[m][j]);
+    for ( int c=0; c<no_int_states; c++ )
+      row.push_back(Get_Member_Particle_Number(m,c));
+    m_ensemble_table.push_back(row);
+  }
+}
+
+/** Write the observables of all members to file
+  *
+  * The parameters of each member are listed in the header.
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::Output_ensemble_table( string filename )
+{
+  ofstream txtfile( filename );
+
+  //header
+  for ( int m=0; m<m_no_of_members; m++ )
+  {
+    txtfile << "# member " << m << ": laser_domh = " << m_members[m].laser_domh
+            << ", Amp = " << m_members[m].Amp[0] << ", " << m_members[m].Amp[1]
+            << ", phase = " << m_members[m].phase
+            << ", chirp = " << m_members[m].chirp << ", Delta_L =";
+    for ( auto d : m_members[m].DeltaL )
+      txtfile << " " << d;
+    if ( !m_members[m].label.empty() )
+      txtfile << ", " << m_members[m].label;
+    txtfile << "\n";
+  }
+  txtfile << "# member \t time \t";
+  for ( auto s : m_rabi_states )
+  {
+    for ( auto i : s.second )
+    {
+      txtfile << i << "(" << s.first << ")\t";
+    }
+  }
+  for ( int c=0; c<no_int_states; c++ )
+  {
+    txtfile << "N[" << c << "]\t";
+  }
+  txtfile << endl;
+
+  //data
+  txtfile.precision(8);
+  for ( auto i : m_ensemble_table )
+  {
+    for ( auto j : i )
+    {
+      txtfile << j << "\t";
+    }
+    txtfile << endl;
+  }
+}
+
+/** Write the wave functions of all members to binary files
+  *
+  * The file name contains the time, the member and the internal state.
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::Save_Members()
+{
+  char filename[1024];
+  for ( int m=0; m<m_no_of_members; m++ )
+  {
+    for ( int k=0; k<no_int_states; k++ )
+    {
+      sprintf( filename, "%.3f_%d_%d.bin", this->Get_t(), m, k+1 );
+      this->Save( Get_p2Member(m,k), filename );
+    }
+  }
+}
+
+/** Run all the sequences defined in the xml file for all members
+  *
+  * Phase scans (no_of_chirps) are replaced by the members of the ensemble and are ignored.
+  */
+template <class T, int dim, int no_int_states>
+void CRT_Base_IF_ensemble<T,dim,no_int_states>::run_sequence()
+{
+  StepFunction step_fct=nullptr;
+  StepFunction half_step_fct=nullptr;
+  StepFunction full_step_fct=nullptr;
+  char filename[1024];
+
+  std::cout << "FYI: Found " << m_params->m_sequence.size() << " sequences." << std::endl;
+  if ( m_rabi_momentum_list.size() == 0 && m_rabi_states.empty() )
+  {
+    std::cerr << "WARNING: Rabi momentum list is empty. Cannot compute rabi frquencies." << endl;
+  }
+
+  try
+  {
+    half_step_fct = this->m_map_stepfcts.at("half_step");
+    full_step_fct = this->m_map_stepfcts.at("full_step");
+  }
+  catch (const std::out_of_range &oor)
+  {
+    std::cerr << "Critical Error: Invalid fct ptr to ft_half_step or ft_full_step ()" << oor.what() << ")\n";
+    exit(EXIT_FAILURE);
+  }
+
+  int seq_counter=1;
+
+  for ( auto seq : m_params->m_sequence )
+  {
+    if ( run_custom_sequence(seq) )
+    {
+      seq_counter++;
+      continue;
+    }
+
+    if ( seq.name == "set_momentum" )
+    {
+      std::vector<std::string> vec;
+      strtk::parse(seq.content,",",vec);
+      CPoint<dim> P;
+
+      assert( vec.size() > dim );
+      assert( seq.comp <= dim );
+
+      for ( int i=0; i<dim; i++ )
+        P[i] = stod(vec[i]);
+
+      this->Setup_Momentum( P, seq.comp );
+
+      std::cout << "FYI: started new sequence " << seq.name << "\n";
+      std::cout << "FYI: momentum set for component " << seq.comp << "\n";
+      continue;
+    }
+
+    double max_duration = 0;
+    for ( int i = 0; i < seq.duration.size(); i++)
+      if (seq.duration[i] > max_duration )
+        max_duration = seq.duration[i];
+
+    int subN = int(max_duration / seq.dt);
+    int Nk = seq.Nk;
+    int Na = subN / seq.Nk;
+
+    std::cout << "FYI: started new sequence " << seq.name << "\n";
+    std::cout << "FYI: sequence no : " << seq_counter << "\n";
+    std::cout << "FYI: duration    : " << max_duration << "\n";
+    std::cout << "FYI: dt          : " << seq.dt << "\n";
+    std::cout << "FYI: Na          : " << Na << "\n";
+    std::cout << "FYI: Nk          : " << Nk << "\n";
+    std::cout << "FYI: Na*Nk*dt    : " << double(Na*Nk)*seq.dt << "\n";
+    std::cout << "FYI: members     : " << m_no_of_members << "\n";
+
+    try
+    {
+      std::cout << "FYI: Amp is      : " << m_params->Get_simulation("AMP_T") << "\n";
+      this->amp_is_t = true;
+    }
+    catch (std::string &str )
+    {
+      std::cout << "FYI: Amp is      : 1" << std::endl;
+      this->amp_is_t = false;
+    }
+
+    if ( seq.no_of_chirps > 1 )
+      std::cout << "FYI: phase scans are ignored in ensemble mode, use Ens_phase or Ens_chirp instead\n";
+
+    if ( double(Na*Nk)*seq.dt != max_duration )
+      std::cout << "FYI: double(Na*Nk)*seq.dt != max_duration\n";
+
+    if ( this->Get_dt() != seq.dt )
+      this->Set_dt(seq.dt);
+
+    try
+    {
+      step_fct = this->m_map_stepfcts.at(seq.name);
+    }
+    catch (const std::out_of_range &oor)
+    {
+      std::cerr << "Critical Error: Invalid squence name " << seq.name << "\n(" << oor.what() << ")\n";
+      exit(EXIT_FAILURE);
+    }
+
+    this->chirp_rate[0] = 0;
+    this->phase[0] = 0;
+    m_ensemble_table.clear();
+
+    for ( int i=1; i<=Na; i++ )
+    {
+      (*half_step_fct)(this,seq);
+      for ( int j=2; j<=Nk; j++ )
+      {
+        (*step_fct)(this,seq);
+        (*full_step_fct)(this,seq);
+      }
+      (*step_fct)(this,seq);
+      (*half_step_fct)(this,seq);
+
+      std::cout << "t = " << to_string(m_header.t) << std::endl;
+
+      if ( seq.output_freq == freq::each )
+        Save_Members();
+
+      if ( seq.rabi_output_freq == freq::each )
+        compute_observables();
+    }
+
+    if ( seq.output_freq == freq::last )
+      Save_Members();
+
+    if ( seq.rabi_output_freq == freq::last )
+      compute_observables();
+
+    if ( m_ensemble_table.size() > 0 )
+    {
+      sprintf( filename, "Ensemble_%d.txt", seq_counter );
+      Output_ensemble_table(filename);
+    }
+
+    seq_counter++;
+  } // end of sequence loop
+}
+#endif
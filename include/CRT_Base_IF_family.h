@@ -0,0 +1,652 @@
+/* * ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+ * (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+ * founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+ * 50WM0942, 50WM1042, 50WM1342.
+ * Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+ *
+ * This file is part of ATUS2.
+ *
+ * ATUS2 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ATUS2 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <array>
+#include <vector>
+
+#include "CRT_Base_IF.h"
+#include "ParameterHandler.h"
+#include "light_coupling.h"
+
+using namespace std;
+
+#ifndef __class_CRT_Base_IF_family__
+#define __class_CRT_Base_IF_family__
+
+/** Returns the highest diffraction order of the momentum family representation
+  *
+  * The representation is switched on by the constant family_order in the CONSTANTS section.
+  * @retval 0 if family_order is not found (full grid)
+  */
+inline int Get_Family_Order( ParameterHandler *params )
+{
+  try
+  {
+    return int(params->Get_Constant("family_order"));
+  }
+  catch (std::string &)
+  {
+  }
+  return 0;
+}
+
+/** Template class for Bragg diffraction in a reduced representation by momentum families
+  *
+  * During Bragg pulses the wave function consists of a few narrow packets around multiples of the
+  * photon momentum \f$ K \f$. The wave function is written as
+  * \f[ \Psi(x) = \sum_{n=-F}^{F} \phi_n(x)\, e^{i n K x} \f]
+  * where the envelope \f$ \phi_n \f$ of family n belongs to the internal state |n| mod 2 and lives on
+  * a coarse grid with family_nx points in x direction (same box, y and z unchanged). The envelopes
+  * need to resolve only the width of a packet in momentum space and not the largest momentum.
+  *
+  *   - kinetic part: exact for each family with the momentum shifted by \f$ nK \f$
+  *   - light field: couples family n with n+1 and n-1 and is solved exactly at each point of the coarse grid
+  *     (see Coupling::chain), the derived class sets up the chain in its step function
+  *   - nonlinear part: the density of an internal state is the sum of the densities of its families
+  *     (interference terms between different families are neglected)
+  *
+  * \f$ K \f$ is the multiple of the momentum grid spacing closest to laser_k, the difference is part of the
+  * coupling. The wave functions in #m_fields (full grid) are only updated for output by To_Full().
+  * Parameters (CONSTANTS section): family_order (F), family_nx (optional, default: largest power of two
+  * not exceeding \f$ K/dk_x \f$).
+  */
+template <class T, int dim>
+class CRT_Base_IF_family : public CRT_Base_IF<T,dim,2>
+{
+public:
+  CRT_Base_IF_family( ParameterHandler * );
+  virtual ~CRT_Base_IF_family();
+
+  void run_sequence();
+
+  /// Pointer to the envelope of family f (momentum (f-F)*K)
+  fftw_complex *Get_p2Family( const int f )
+  {
+    return m_fam + size_t(f)*m_no_of_pts_f;
+  };
+
+  void To_Families();
+  void To_Full();
+
+protected:
+  using CRT_Base<T,dim,2>::m_header;
+  using CRT_Base<T,dim,2>::m_params;
+  using CRT_Base<T,dim,2>::m_fields;
+  using CRT_Base<T,dim,2>::m_gs;
+  using CRT_Base<T,dim,2>::m_alpha;
+  using CRT_Base_IF<T,dim,2>::beta;
+  using CRT_Base_IF<T,dim,2>::DeltaL;
+  using CRT_Base_IF<T,dim,2>::m_rabi_momentum_list;
+  using CRT_Base_IF<T,dim,2>::m_rabi_freq_list;
+  using CRT_shared::m_no_of_pts;
+
+  static void Do_FT_Step_full_Wrapper(void *,sequence_item &);
+  static void Do_FT_Step_half_Wrapper(void *,sequence_item &);
+  static void Do_NL_Step_Wrapper(void *,sequence_item &);
+
+  void Do_FT_Step( fftw_complex * );
+  void Do_NL_Step();
+
+  void Init();
+  void Family_Densities( const int, double * );
+
+  /// Define custom sequences
+  virtual bool run_custom_sequence( const sequence_item & )=0;
+
+  /// Highest order F, the families are n=-F..F
+  int m_order;
+  /// Number of families 2F+1
+  int m_no_of_families;
+  /// Internal state of each family
+  vector<int> m_family_comp;
+  /// K in units of the momentum grid spacing dk_x
+  int m_shift;
+  /// Photon momentum K represented by the families
+  double m_K;
+  /// Number of points of the coarse grid in x direction
+  int m_nx_f;
+  /// Number of points with the same x coordinate
+  int m_nyz;
+  /// Number of points of a family
+  int m_no_of_pts_f;
+  /// x coordinate of each x-line of the coarse grid
+  vector<double> m_x_f;
+
+  /// Envelopes of all families, family f starts at f*m_no_of_pts_f
+  fftw_complex *m_fam;
+  /// Exponential of the whole kinetic operator of each family (incl. normalisation)
+  fftw_complex *m_fam_full_step;
+  /// Exponential of half of the kinetic operator of each family (incl. normalisation)
+  fftw_complex *m_fam_half_step;
+
+  fftw_plan m_plan_forward;
+  fftw_plan m_plan_backward;
+  /// Unscaled transforms of the full grid for To_Families() and To_Full()
+  std::array<fftw_plan,2> m_plan_full_forward;
+  std::array<fftw_plan,2> m_plan_full_backward;
+};
+
+/** Reads the parameters of the representation, allocates the families and converts the initial wave functions
+  *
+  * @param params Pointer to ParameterHandler object to read from xml files
+  */
+template <class T, int dim>
+CRT_Base_IF_family<T,dim>::CRT_Base_IF_family( ParameterHandler *params ) : CRT_Base_IF<T,dim,2>(params)
+{
+  const int nx = this->Get_dimX();
+  m_nyz = this->Get_dimY()*this->Get_dimZ();
+
+  m_order = Get_Family_Order( params );
+  if ( m_order < 1 ) throw std::string( "Error: family_order has to be at least 1\n" );
+
+  m_shift = int(round(this->laser_k[0]/m_header.dkx));
+  m_K = m_shift*m_header.dkx;
+  if ( m_shift < 1 ) throw std::string( "Error: laser_k is smaller than the momentum grid spacing\n" );
+
+  try
+  {
+    m_nx_f = int(params->Get_Constant("family_nx"));
+  }
+  catch (std::string &)
+  {
+    m_nx_f = 1;
+    while ( 2*m_nx_f <= m_shift ) m_nx_f *= 2;
+  }
+
+  if ( m_nx_f > m_shift ) throw std::string( "Error: family_nx = " + to_string(m_nx_f) + " is larger than K/dk_x = " + to_string(m_shift) + ", the families would overlap\n" );
+  if ( m_order*m_shift + m_nx_f/2 > nx/2 ) throw std::string( "Error: the momentum grid is too small for family_order = " + to_string(m_order) + "\n" );
+
+  m_no_of_families = 2*m_order+1;
+  if ( m_no_of_families > Coupling::max_chain ) throw std::string( "Error: family_order is too large\n" );
+  m_no_of_pts_f = m_nx_f*m_nyz;
+
+  for ( int f=0; f<m_no_of_families; f++ )
+    m_family_comp.push_back( abs(f-m_order) % 2 );
+
+  const double x0 = m_fields[0]->Get_x(0)[0];
+  const double dx_f = double(nx)*m_header.dx/double(m_nx_f);
+  for ( int i=0; i<m_nx_f; i++ )
+    m_x_f.push_back( x0 + i*dx_f );
+
+  const size_t total = size_t(m_no_of_families)*m_no_of_pts_f;
+  m_fam = Huge_Alloc_Complex( total );
+  m_fam_full_step = Huge_Alloc_Complex( total );
+  m_fam_half_step = Huge_Alloc_Complex( total );
+  assert( m_fam != nullptr );
+
+  int n[] = { m_nx_f, int(this->Get_dimY()), int(this->Get_dimZ()) };
+  m_plan_forward  = fftw_plan_many_dft( dim, n, m_no_of_families, m_fam, nullptr, 1, m_no_of_pts_f, m_fam, nullptr, 1, m_no_of_pts_f, FFTW_FORWARD, FFTW_ESTIMATE );
+  m_plan_backward = fftw_plan_many_dft( dim, n, m_no_of_families, m_fam, nullptr, 1, m_no_of_pts_f, m_fam, nullptr, 1, m_no_of_pts_f, FFTW_BACKWARD, FFTW_ESTIMATE );
+
+  n[0] = nx;
+  for ( int c=0; c<2; c++ )
+  {
+    fftw_complex *Psi = m_fields[c]->Getp2In();
+    m_plan_full_forward[c]  = fftw_plan_dft( dim, n, Psi, Psi, FFTW_FORWARD, FFTW_ESTIMATE );
+    m_plan_full_backward[c] = fftw_plan_dft( dim, n, Psi, Psi, FFTW_BACKWARD, FFTW_ESTIMATE );
+  }
+
+  Init();
+  To_Families();
+
+  std::cout << "FYI: " << m_no_of_families << " momentum families with " << m_nx_f << " points in x direction (full grid " << nx << ")" << std::endl;
+  std::cout << "FYI: K = " << m_K << " (laser_k = " << this->laser_k[0] << ")" << std::endl;
+
+  this->m_map_stepfcts["half_step"] = &Do_FT_Step_half_Wrapper;
+  this->m_map_stepfcts["full_step"] = &Do_FT_Step_full_Wrapper;
+  this->m_map_stepfcts["freeprop"] = &Do_NL_Step_Wrapper;
+  this->m_map_stepfcts.erase("freeprop_lin");
+  this->m_map_stepfcts.erase("bragg");
+  this->m_map_stepfcts.erase("raman");
+}
+
+/// Destructor
+template <class T, int dim>
+CRT_Base_IF_family<T,dim>::~CRT_Base_IF_family()
+{
+  fftw_destroy_plan( m_plan_forward );
+  fftw_destroy_plan( m_plan_backward );
+  for ( int c=0; c<2; c++ )
+  {
+    fftw_destroy_plan( m_plan_full_forward[c] );
+    fftw_destroy_plan( m_plan_full_backward[c] );
+  }
+  Huge_Free( m_fam );
+  Huge_Free( m_fam_full_step );
+  Huge_Free( m_fam_half_step );
+}
+
+/** Computes the exponentials of the kinetic operator of every family
+  *
+  * The momentum of family n is shifted by nK, the factor 1/m_no_of_pts_f of the unscaled
+  * transforms is included in the tables.
+  */
+template <class T, int dim>
+void CRT_Base_IF_family<T,dim>::Init()
+{
+  CRT_Base<T,dim,2>::Init();
+
+  const double dt = -m_header.dt;
+  const double fak = 1.0/double(m_no_of_pts_f);
+
+  #pragma omp parallel for collapse(2)
+  for ( int f=0; f<m_no_of_families; f++ )
+  {
+    for ( int i=0; i<m_nx_f; i++ )
+    {
+      const int q = ( i < m_nx_f/2 ) ? i : i-m_nx_f;
+      const int n = f-m_order;
+      fftw_complex *full = m_fam_full_step + size_t(f)*m_no_of_pts_f;
+      fftw_complex *half = m_fam_half_step + size_t(f)*m_no_of_pts_f;
+      CPoint<dim> alpha = m_alpha;
+
+      for ( int r=0; r<m_nyz; r++ )
+      {
+        // y and z components from the first x-line of the full grid
+        CPoint<dim> k = m_fields[0]->Get_k(r);
+        k[0] = q*m_header.dkx + n*m_K;
+        const double phi = dt*(k.scale(alpha)*k);
+
+        const int l = i*m_nyz+r;
+        half[l][0] = fak*cos(0.5*phi);
+        half[l][1] = fak*sin(0.5*phi);
+        full[l][0] = fak*cos(phi);
+        full[l][1] = fak*sin(phi);
+      }
+    }
+  }
+}
+
+/** Projects the wave functions of the full grid onto the families
+  *
+  * Momenta outside of the bands of the families are lost, their norm is printed.
+  */
+template <class T, int dim>
+void CRT_Base_IF_family<T,dim>::To_Families()
+{
+  const int nx = this->Get_dimX();
+  const double x0 = m_fields[0]->Get_x(0)[0];
+  const double fak = 1.0/double(m_no_of_pts);
+
+  double N0 = 0;
+  for ( int c=0; c<2; c++ )
+  {
+    N0 += this->Get_Particle_Number(c);
+    fftw_execute( m_plan_full_forward[c] );
+  }
+
+  #pragma omp parallel for collapse(2)
+  for ( int f=0; f<m_no_of_families; f++ )
+  {
+    for ( int i=0; i<m_nx_f; i++ )
+    {
+      const int n = f-m_order;
+      const int q = ( i < m_nx_f/2 ) ? i : i-m_nx_f;
+      const int ix = ((n*m_shift+q) % nx + nx) % nx;
+
+      // the carrier exp(inKx) refers to x=0, the transform to x0
+      const Coupling::cplx ph = std::polar( fak, -n*m_K*x0 );
+
+      const fftw_complex *src = m_fields[m_family_comp[f]]->Getp2In() + size_t(ix)*m_nyz;
+      fftw_complex *dst = Get_p2Family(f) + size_t(i)*m_nyz;
+      for ( int r=0; r<m_nyz; r++ )
+      {
+        const Coupling::cplx tmp = ph*Coupling::cplx(src[r][0],src[r][1]);
+        dst[r][0] = real(tmp);
+        dst[r][1] = imag(tmp);
+      }
+    }
+  }
+
+  fftw_execute( m_plan_backward );
+
+  for ( int c=0; c<2; c++ )
+  {
+    fftw_execute( m_plan_full_backward[c] );
+    fftw_complex *Psi = m_fields[c]->Getp2In();
+    #pragma omp parallel for
+    for ( int l=0; l<m_no_of_pts; l++ )
+    {
+      Psi[l][0] *= fak;
+      Psi[l][1] *= fak;
+    }
+  }
+
+  double N1 = 0;
+  const double ar_f = this->m_ar*double(this->Get_dimX())/double(m_nx_f);
+  for ( int f=0; f<m_no_of_families; f++ )
+  {
+    const fftw_complex *Psi = Get_p2Family(f);
+    double sum = 0;
+    #pragma omp parallel for reduction(+:sum)
+    for ( int l=0; l<m_no_of_pts_f; l++ )
+      sum += Psi[l][0]*Psi[l][0] + Psi[l][1]*Psi[l][1];
+    N1 += ar_f*sum;
+  }
+  std::cout << "FYI: particle number outside of the momentum families: " << N0-N1 << std::endl;
+}
+
+/** Computes the wave functions of the full grid (#m_fields) from the families
+  */
+template <class T, int dim>
+void CRT_Base_IF_family<T,dim>::To_Full()
+{
+  const int nx = this->Get_dimX();
+  const double x0 = m_fields[0]->Get_x(0)[0];
+  const double fak = 1.0/double(m_no_of_pts_f);
+
+  fftw_execute( m_plan_forward );
+
+  for ( int c=0; c<2; c++ )
+    memset( m_fields[c]->Getp2In(), 0, sizeof(fftw_complex)*m_no_of_pts );
+
+  // the bands of the families do not overlap
+  #pragma omp parallel for collapse(2)
+  for ( int f=0; f<m_no_of_families; f++ )
+  {
+    for ( int i=0; i<m_nx_f; i++ )
+    {
+      const int n = f-m_order;
+      const int q = ( i < m_nx_f/2 ) ? i : i-m_nx_f;
+      const int ix = ((n*m_shift+q) % nx + nx) % nx;
+      const Coupling::cplx ph = std::polar( fak, n*m_K*x0 );
+
+      const fftw_complex *src = Get_p2Family(f) + size_t(i)*m_nyz;
+      fftw_complex *dst = m_fields[m_family_comp[f]]->Getp2In() + size_t(ix)*m_nyz;
+      for ( int r=0; r<m_nyz; r++ )
+      {
+        const Coupling::cplx tmp = ph*Coupling::cplx(src[r][0],src[r][1]);
+        dst[r][0] = real(tmp);
+        dst[r][1] = imag(tmp);
+      }
+    }
+  }
+
+  for ( int c=0; c<2; c++ )
+    fftw_execute( m_plan_full_backward[c] );
+
+  // restore the envelopes
+  const size_t total = size_t(m_no_of_families)*m_no_of_pts_f;
+  fftw_execute( m_plan_backward );
+  #pragma omp parallel for
+  for ( size_t l=0; l<total; l++ )
+  {
+    m_fam[l][0] *= fak;
+    m_fam[l][1] *= fak;
+  }
+}
+
+template <class T, int dim>
+void CRT_Base_IF_family<T,dim>::Do_FT_Step_full_Wrapper ( void *ptr, sequence_item &seq )
+{
+  CRT_Base_IF_family *self = static_cast<CRT_Base_IF_family *>(ptr);
+  self->Do_FT_Step( self->m_fam_full_step );
+  self->m_header.t += self->m_header.dt;
+}
+
+template <class T, int dim>
+void CRT_Base_IF_family<T,dim>::Do_FT_Step_half_Wrapper ( void *ptr, sequence_item &seq )
+{
+  CRT_Base_IF_family *self = static_cast<CRT_Base_IF_family *>(ptr);
+  self->Do_FT_Step( self->m_fam_half_step );
+  self->m_header.t += 0.5*self->m_header.dt;
+}
+
+template <class T, int dim>
+void CRT_Base_IF_family<T,dim>::Do_NL_Step_Wrapper ( void *ptr, sequence_item &seq )
+{
+  CRT_Base_IF_family *self = static_cast<CRT_Base_IF_family *>(ptr);
+  self->Do_NL_Step();
+}
+
+/** Kinetic part of all families
+  *
+  * @param step table of the exponential of the kinetic operator of all families
+  */
+template <class T, int dim>
+void CRT_Base_IF_family<T,dim>::Do_FT_Step( fftw_complex *step )
+{
+  fftw_execute( m_plan_forward );
+
+  const size_t total = size_t(m_no_of_families)*m_no_of_pts_f;
+
+  #pragma omp parallel for
+  for ( size_t l=0; l<total; l++ )
+  {
+    const double tmp1 = m_fam[l][0];
+    m_fam[l][0] = m_fam[l][0]*step[l][0] - m_fam[l][1]*step[l][1];
+    m_fam[l][1] = m_fam[l][1]*step[l][0] + tmp1*step[l][1];
+  }
+
+  fftw_execute( m_plan_backward );
+}
+
+/** Densities of both internal states at point l of the coarse grid
+  *
+  * The density of an internal state is the sum of the densities of its families.
+  */
+template <class T, int dim>
+void CRT_Base_IF_family<T,dim>::Family_Densities( const int l, double *rho )
+{
+  rho[0] = 0;
+  rho[1] = 0;
+  for ( int f=0; f<m_no_of_families; f++ )
+  {
+    const fftw_complex *Psi = Get_p2Family(f);
+    rho[m_family_comp[f]] += Psi[l][0]*Psi[l][0] + Psi[l][1]*Psi[l][1];
+  }
+}
+
+/** Solves the potential part without any external fields but gravity for all families
+  */
+template <class T, int dim>
+void CRT_Base_IF_family<T,dim>::Do_NL_Step()
+{
+  const double dt = this->Get_dt();
+
+  #pragma omp parallel
+  {
+    double rho[2], V[2];
+
+    #pragma omp for
+    for ( int i=0; i<m_nx_f; i++ )
+    {
+      const double Vx = beta[0]*m_x_f[i];
+      for ( int l=i*m_nyz; l<(i+1)*m_nyz; l++ )
+      {
+        Family_Densities( l, rho );
+        V[0] = m_gs[0]*rho[0]+m_gs[1]*rho[1]+Vx-DeltaL[0];
+        V[1] = m_gs[2]*rho[0]+m_gs[3]*rho[1]+Vx-DeltaL[1];
+
+        for ( int f=0; f<m_no_of_families; f++ )
+          Coupling::phase( dt, V[m_family_comp[f]], Get_p2Family(f), l );
+      }
+    }
+  }
+}
+
+/** Run all the sequences defined in the xml file in the family representation
+  *
+  * The wave functions of the full grid are computed for the output only. Phase scans (no_of_chirps)
+  * are not supported in this representation and are ignored.
+  */
+template <class T, int dim>
+void CRT_Base_IF_family<T,dim>::run_sequence()
+{
+  StepFunction step_fct=nullptr;
+  StepFunction half_step_fct=nullptr;
+  StepFunction full_step_fct=nullptr;
+  char filename[1024];
+
+  std::cout << "FYI: Found " << m_params->m_sequence.size() << " sequences." << std::endl;
+  if ( m_rabi_momentum_list.size() == 0 )
+  {
+    std::cerr << "WARNING: Rabi momentum list is empty. Cannot compute rabi frquencies." << endl;
+  }
+
+  try
+  {
+    half_step_fct = this->m_map_stepfcts.at("half_step");
+    full_step_fct = this->m_map_stepfcts.at("full_step");
+  }
+  catch (const std::out_of_range &oor)
+  {
+    std::cerr << "Critical Error: Invalid fct ptr to ft_half_step or ft_full_step ()" << oor.what() << ")\n";
+    exit(EXIT_FAILURE);
+  }
+
+  // output of the full grid
+  auto output = [&]( const bool save, const bool pn, const bool rabi )
+  {
+    if ( !save && !pn && !rabi ) return;
+    To_Full();
+    if ( save )
+    {
+      for ( int k=0; k<2; k++ )
+      {
+        sprintf( filename, "%.3f_%d.bin", this->Get_t(), k+1 );
+        this->Save_Phi( filename, k );
+      }
+    }
+    if ( pn )
+    {
+      for ( int c=0; c<2; c++ )
+        std::cout << "N[" << c << "] = " << this->Get_Particle_Number(c) << std::endl;
+    }
+    if ( rabi )
+      this->compute_rabi_integrals();
+  };
+
+  int seq_counter=1;
+
+  for ( auto seq : m_params->m_sequence )
+  {
+    if ( run_custom_sequence(seq) )
+    {
+      seq_counter++;
+      continue;
+    }
+
+    if ( seq.name == "set_momentum" )
+    {
+      std::vector<std::string> vec;
+      strtk::parse(seq.content,",",vec);
+      CPoint<dim> P;
+
+      assert( vec.size() > dim );
+      assert( seq.comp <= dim );
+
+      for ( int i=0; i<dim; i++ )
+        P[i] = stod(vec[i]);
+
+      To_Full();
+      this->Setup_Momentum( P, seq.comp );
+      To_Families();
+
+      std::cout << "FYI: started new sequence " << seq.name << "\n";
+      std::cout << "FYI: momentum set for component " << seq.comp << "\n";
+      continue;
+    }
+
+    double max_duration = 0;
+    for ( int i = 0; i < seq.duration.size(); i++)
+      if (seq.duration[i] > max_duration )
+        max_duration = seq.duration[i];
+
+    int subN = int(max_duration / seq.dt);
+    int Nk = seq.Nk;
+    int Na = subN / seq.Nk;
+
+    std::cout << "FYI: started new sequence " << seq.name << "\n";
+    std::cout << "FYI: sequence no : " << seq_counter << "\n";
+    std::cout << "FYI: duration    : " << max_duration << "\n";
+    std::cout << "FYI: dt          : " << seq.dt << "\n";
+    std::cout << "FYI: Na          : " << Na << "\n";
+    std::cout << "FYI: Nk          : " << Nk << "\n";
+    std::cout << "FYI: Na*Nk*dt    : " << double(Na*Nk)*seq.dt << "\n";
+
+    try
+    {
+      std::cout << "FYI: Amp is      : " << m_params->Get_simulation("AMP_T") << "\n";
+      this->amp_is_t = true;
+    }
+    catch (std::string &str )
+    {
+      std::cout << "FYI: Amp is      : 1" << std::endl;
+      this->amp_is_t = false;
+    }
+
+    if ( seq.no_of_chirps > 1 )
+      std::cout << "FYI: phase scans are ignored in the momentum family representation\n";
+
+    if ( double(Na*Nk)*seq.dt != max_duration )
+      std::cout << "FYI: double(Na*Nk)*seq.dt != max_duration\n";
+
+    if ( this->Get_dt() != seq.dt )
+      this->Set_dt(seq.dt);
+
+    try
+    {
+      step_fct = this->m_map_stepfcts.at(seq.name);
+    }
+    catch (const std::out_of_range &oor)
+    {
+      std::cerr << "Critical Error: Invalid squence name " << seq.name << "\n(" << oor.what() << ")\n";
+      exit(EXIT_FAILURE);
+    }
+
+    this->chirp_rate[0] = 0;
+    this->phase[0] = 0;
+    m_rabi_freq_list.clear();
+
+    for ( int i=1; i<=Na; i++ )
+    {
+      (*half_step_fct)(this,seq);
+      for ( int j=2; j<=Nk; j++ )
+      {
+        (*step_fct)(this,seq);
+        (*full_step_fct)(this,seq);
+      }
+      (*step_fct)(this,seq);
+      (*half_step_fct)(this,seq);
+
+      std::cout << "t = " << to_string(m_header.t) << std::endl;
+
+      output( seq.output_freq == freq::each, seq.compute_pn_freq == freq::each, seq.rabi_output_freq == freq::each );
+    }
+
+    output( seq.output_freq == freq::last, seq.compute_pn_freq == freq::last, seq.rabi_output_freq == freq::last );
+
+    if ( m_rabi_freq_list.size() > 0 )
+    {
+      sprintf( filename, "Rabi_%d_0.txt", seq_counter );
+      this->Output_rabi_freq_list( filename, seq.Nk );
+    }
+
+    seq_counter++;
+  } // end of sequence loop
+}
+#endif
@@ -197,16 +197,15 @@ void CRT_Base_IF_mpi<T,dim,no_int_states>::compute_rabi_integrals()
   //Fourier transform
   m_fields[0]->ft(-1);
 
-  CPoint<dim> k1, d;
+  CPoint<dim> d;
 
   double res[n];
   double allres[n];
   memset( res, 0, sizeof(double)*n );
 
   //Loop over local points in Fourier space
-  for ( ptrdiff_t i=0; i<this->m_no_of_pts_fs; i++ )
+  m_fields[0]->For_k( [&]( const ptrdiff_t i, CPoint<dim> &k1 )
   {
-    k1 = m_fields[0]->Get_k(i);
     int j=0;
     //Loop through all momentum states
     for ( auto k0 : m_rabi_momentum_list )
@@ -221,7 +220,7 @@ void CRT_Base_IF_mpi<T,dim,no_int_states>::compute_rabi_integrals()
       }
       j++;
     }
-  }
+  } );
 
   //Sum over all processes
   MPI_Allreduce( res, allres, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD );
@@ -355,14 +354,13 @@ void CRT_Base_IF_mpi<T,dim,no_int_states>::Do_NL_Step()
   MTime.enter_section("Do_NL_Step");
   const double dt = -m_header.dt;
   double re1, im1, tmp1, phi[no_int_states];
-  CPoint<dim> x;
 
   vector<fftw_complex *> Psi;
   //Vector for the components of the wavefunction
   for ( int i=0; i<no_int_states; i++ )
     Psi.push_back(this->m_fields[i]->Get_p2_Data());
 
-  for ( ptrdiff_t l=0; l<this->m_no_of_pts; l++ )
+  this->m_fields[0]->For_x( [&]( const ptrdiff_t l, CPoint<dim> &x )
   {
     //Loop through column
     for ( int i=0; i<no_int_states; i++ )
@@ -374,7 +372,6 @@ void CRT_Base_IF_mpi<T,dim,no_int_states>::Do_NL_Step()
         //For example: gs_11 * Psi_1 + g_12 * Psi_2 + ...
         phi[i] += this->m_gs[j+no_int_states*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
       }
-      x = this->m_fields[0]->Get_x(l);
       phi[i] += beta*x-DeltaL[i];
       phi[i] *= dt;
     }
@@ -388,7 +385,7 @@ void CRT_Base_IF_mpi<T,dim,no_int_states>::Do_NL_Step()
       Psi[i][l][0] = Psi[i][l][0]*re1 - Psi[i][l][1]*im1;
       Psi[i][l][1] = Psi[i][l][1]*re1 + tmp1*im1;
     }
-  }
+  } );
   MTime.exit_section("Do_NL_Step");
 }
 
@@ -416,11 +413,10 @@ void CRT_Base_IF_mpi<T,dim,no_int_states>::Numerical_Bragg()
   gsl_matrix_complex *evec = gsl_matrix_complex_alloc(no_int_states,no_int_states);
 
   double phi[no_int_states],re1,im1,eta[2];
-  CPoint<dim> x;
   laser_k[1] = -laser_k[0];
   chirp_rate[1] = -chirp_rate[0];
 
-  for ( int l=0; l<this->m_no_of_pts; l++ )
+  this->m_fields[0]->For_x( [&]( const ptrdiff_t l, CPoint<dim> &x )
   {
     gsl_matrix_complex_set_zero(A);
     gsl_matrix_complex_set_zero(B);
@@ -433,7 +429,6 @@ void CRT_Base_IF_mpi<T,dim,no_int_states>::Numerical_Bragg()
       {
         phi[i] += this->m_gs[j+no_int_states*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
       }
-      x = this->m_fields[0]->Get_x(l);
       phi[i] += beta*x-DeltaL[i];
       gsl_matrix_complex_set(A,i,i, {phi[i],0});
     }
@@ -482,7 +477,7 @@ void CRT_Base_IF_mpi<T,dim,no_int_states>::Numerical_Bragg()
       Psi[i][l][0] = gsl_vector_complex_get(Psi_2,i).dat[0];
       Psi[i][l][1] = gsl_vector_complex_get(Psi_2,i).dat[1];
     }
-  }
+  } );
   gsl_matrix_complex_free(A);
   gsl_matrix_complex_free(B);
   gsl_eigen_hermv_free(w);
@@ -516,9 +511,8 @@ void CRT_Base_IF_mpi<T,dim,no_int_states>::Numerical_Raman()
   gsl_matrix_complex *evec = gsl_matrix_complex_alloc(no_int_states,no_int_states);
 
   double phi[no_int_states],re1,im1,eta[2];
-  CPoint<dim> x;
 
-  for ( int l=0; l<this->m_no_of_pts; l++ )
+  this->m_fields[0]->For_x( [&]( const ptrdiff_t l, CPoint<dim> &x )
   {
     gsl_matrix_complex_set_zero(A);
     gsl_matrix_complex_set_zero(B);
@@ -531,7 +525,6 @@ void CRT_Base_IF_mpi<T,dim,no_int_states>::Numerical_Raman()
       {
         phi[i] += this->m_gs[j+no_int_states*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
       }
-      x = this->m_fields[0]->Get_x(l);
       phi[i] += beta*x-DeltaL[i];
       gsl_matrix_complex_set(A,i,i, {phi[i],0});
     }
@@ -582,7 +575,7 @@ void CRT_Base_IF_mpi<T,dim,no_int_states>::Numerical_Raman()
       Psi[i][l][0] = gsl_vector_complex_get(Psi_2,i).dat[0];
       Psi[i][l][1] = gsl_vector_complex_get(Psi_2,i).dat[1];
     }
-  }
+  } );
   gsl_matrix_complex_free(A);
   gsl_matrix_complex_free(B);
   gsl_eigen_hermv_free(w);
@@ -199,18 +199,16 @@ void CRT_Base_mpi<T,dim,no_int_states>::Init()
 {
   const double dt = -m_header.dt;
   double phi;
-  CPoint<dim> k;
 
-  for ( ptrdiff_t i=0; i<m_no_of_pts_fs; i++ )
+  m_fields[0]->For_k( [&]( const ptrdiff_t i, CPoint<dim> &k )
   {
-    k = m_fields[0]->Get_k(i);
     phi = dt*(k.scale(m_alpha)*k);
 
     m_half_step[i][0] = cos(0.5*phi);
     m_half_step[i][1] = sin(0.5*phi);
     m_full_step[i][0] = cos(phi);
     m_full_step[i][1] = sin(phi);
-  }
+  } );
 }
 
 template <class T, int dim, int no_int_states>
@@ -568,15 +566,12 @@ void CRT_Base_mpi<T,dim,no_int_states>::Setup_Momentum( CPoint<dim> px, const in
 {
   if ( comp<0 || comp>no_int_states ) throw std::string("Error in " + std::string(__func__) + ": comp out of bounds\n");
 
-  CPoint<dim> x;
-
   double re, im, re2, im2;
 
   fftw_complex *Psi = m_fields[comp]->Get_p2_Data();
 
-  for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+  m_fields[comp]->For_x( [&]( const ptrdiff_t l, CPoint<dim> &x )
   {
-    x = m_fields[comp]->Get_x(l);
     //exp(p*x)
     sincos(px*x,&im,&re);
 
@@ -584,7 +579,7 @@ void CRT_Base_mpi<T,dim,no_int_states>::Setup_Momentum( CPoint<dim> px, const in
     im2 = Psi[l][1];
     Psi[l][0] = re2*re-im2*im;
     Psi[l][1] = re2*im+im2*re;
-  }
+  } );
 }
 
 /** Calculate the expectation value of the postion of an internal state
@@ -597,20 +592,18 @@ void CRT_Base_mpi<T,dim,no_int_states>::Expval_Position( CPoint<dim> &retval, co
 {
   if ( comp<0 || comp>no_int_states ) throw std::string("Error in " + std::string(__func__) + ": comp out of bounds\n");
 
-  CPoint<dim> x;
   double den;
   double sum[dim] = {};
   double allsum[dim] = {};
 
   fftw_complex *Psi = m_fields[comp]->Get_p2_Data();
 
-  for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+  m_fields[comp]->For_x( [&]( const ptrdiff_t l, CPoint<dim> &x )
   {
-    x = m_fields[comp]->Get_x(l);
     den = x*(Psi[l][0]*Psi[l][0]+Psi[l][1]*Psi[l][1]);
     for (int i=0; i<dim; i++ )
       sum[i] += x[i]*den;
-  }
+  } );
 
   MPI_Allreduce(sum,allsum,dim,MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
 
@@ -628,7 +621,6 @@ void CRT_Base_mpi<T,dim,no_int_states>::Expval_Momentum( CPoint<dim> &retval, co
 {
   if ( comp<0 || comp>no_int_states ) throw std::string("Error in " + std::string(__func__) + ": comp out of bounds\n");
 
-  CPoint<dim> k;
   double den;
   double sum[dim] = {};
   double allsum[dim] = {};
@@ -636,16 +628,14 @@ void CRT_Base_mpi<T,dim,no_int_states>::Expval_Momentum( CPoint<dim> &retval, co
   fftw_complex *Psi = m_fields[comp]->Get_p2_Data();
 
   m_fields[comp]->ft(-1);
-  for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+  m_fields[comp]->For_k( [&]( const ptrdiff_t l, CPoint<dim> &k )
   {
-    k = m_fields[comp]->Get_k(l);
-
     den = (Psi[l][0]*Psi[l][0]+Psi[l][1]*Psi[l][1]);
     for ( int i=0; i<dim; i++ )
     {
       sum[i] += k[i]*den;
     }
-  }
+  } );
   m_fields[comp]->ft(1);
 
   MPI_Allreduce(sum,allsum,dim,MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
@@ -35,6 +35,7 @@
 #include "my_structs.h"
 #include "CPoint.h"
 #include "fftw3-mpi.h"
+#include "cft_3d_MPI.h"
 #include <cmath>
 #include <fstream>
 #include <cassert>
@@ -158,9 +159,7 @@ protected:
       m_ar = m_header.dx*m_header.dy*m_header.dz;
       m_ar_k = m_header.dkx*m_header.dky*m_header.dkz;
       // Get local data size
-      m_alloc = fftw_mpi_local_size_3d_transposed( Get_dimX(), Get_dimY(), Get_dimZ(), MPI_COMM_WORLD, &m_loc_dimX, &m_loc_start_dimX, &m_loc_dimY, &m_loc_start_dimY );
-      m_no_of_pts = m_loc_dimX*Get_dimY()*Get_dimZ();
-      m_no_of_pts_fs = m_loc_dimY*Get_dimX()*Get_dimZ();
+      m_alloc = MPI::Fourier::cft_3d_MPI::Local_Size( Get_dimX(), Get_dimY(), Get_dimZ(), m_no_of_pts, m_no_of_pts_fs, m_loc_dimX, m_loc_start_dimX, m_loc_dimY, m_loc_start_dimY );
       m_shift_x = m_header.nDimX/2;
       m_shift_y = m_header.nDimY/2;
       m_shift_z = m_header.nDimZ/2;
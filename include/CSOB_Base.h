@@ -29,26 +29,60 @@
 #include <string>
 #include <cstring>
 #include <array>
+#include <algorithm>
+#include <memory>
 
 #include "CRT_shared.h"
 #include "cft_base.h"
+#include "huge_alloc.h"
+#include "rft_1d.h"
+#include "rft_2d.h"
+#include "rft_3d.h"
 #include "ParameterHandler.h"
+#include "CAnderson.h"
+#include "gs_cache.h"
+#include "CConvergence_Monitor.h"
 
 using namespace std;
 
 #ifndef __class_CSOB_Base__
 #define __class_CSOB_Base__
 
+/** Value type of the wave functions for the Fourier transform class T
+  *
+  * The complex transforms (cft_1d, cft_2d, cft_3d) work on fftw_complex, the r2c transforms
+  * (rft_1d, rft_2d, rft_3d) on double. Get_Buffer returns the real space array of a transform object.
+  */
+template <class T>
+struct SOB_Field
+{
+  typedef fftw_complex value_t;
+  static value_t * Get_Buffer( T *f ) { return f->Getp2In(); }
+};
+
+template <class T>
+struct SOB_Field_Real
+{
+  typedef double value_t;
+  static value_t * Get_Buffer( T *f ) { return f->Getp2InReal(); }
+};
+
+template <> struct SOB_Field<Fourier::rft_1d> : SOB_Field_Real<Fourier::rft_1d> {};
+template <> struct SOB_Field<Fourier::rft_2d> : SOB_Field_Real<Fourier::rft_2d> {};
+template <> struct SOB_Field<Fourier::rft_3d> : SOB_Field_Real<Fourier::rft_3d> {};
+
 template <class T, int dim, int no_wf>
 class CSOB_Base : public CRT_shared
 {
 public:
-  CSOB_Base( ParameterHandler * );
+  CSOB_Base( ParameterHandler *, const int=0 );
   virtual ~CSOB_Base();
 
   double Get_Particle_Number(const int comp=0);
 
   void run();
+  void Interpolate_From( CSOB_Base<T,dim,no_wf> & );
+  bool Warm_Start( CGS_Cache & );
 
   void Save( double *, std::string );
   void Save( fftw_complex *, std::string );
@@ -56,19 +90,46 @@ public:
   void Save_Zero();
   void Dump_2( ofstream & );
 protected:
+  typedef typename SOB_Field<T>::value_t value_t;
+  static const int m_nc = sizeof(value_t)/sizeof(double); /// doubles per sampling point, 2 complex, 1 real
+
   double m_res_tot;
   double m_epsilon;
   double m_stepsize;
+  int m_level;
+  int64_t m_no_of_pts_fs; /// number of Fourier coefficients, m_no_of_pts_red for real fields
+
+  // nonlinear conjugate gradients (SIMULATION/MINIMIZER = cg)
+  bool m_use_cg;
+  double m_tau;
+  double m_rg_old;
+
+  // Anderson acceleration of the steepest descent (CONSTANTS/anderson_depth > 0)
+  std::unique_ptr<CAnderson<no_wf>> m_anderson;
+  double m_aa_res_min;
 
   void Init_Potential();
   void Compute_Laplace();
   void Compute_Sobolev_Gradient();
   void Compute_Sobolev_Psi();
+  void Compute_Laplace_and_Sobolev_Psi();
+  void Compute_L2_Gradient( std::array<double,no_wf> & );
+  void Apply_Sobolev_Operator( const int, value_t * );
+  void Project_and_Update( const std::array<double,no_wf> &, const std::array<double,no_wf> &, const double );
+  bool Fused_Step( const double );
   void Project_Sobolev_Gradient();
   void Compute_mu();
   void Compute_res();
   void Renormalize_All_Psi();
 
+  void run_cg();
+  void Compute_CG_Direction( bool );
+  double Line_Search();
+
+  void Set_Psi( const int, const int64_t, const double );
+  double Density( const int, const int64_t );
+  static double * Flat( value_t *p ) { return reinterpret_cast<double *>(p); }
+
   ParameterHandler *m_params;
 
   std::array<double,no_wf> m_mu;
@@ -78,11 +139,16 @@ protected:
   std::array<double *,no_wf> m_Laplace_operator_fs;
   std::array<double *,no_wf> m_Potential;
 
-  std::array<fftw_complex *,no_wf> m_Psi;
-  std::array<fftw_complex *,no_wf> m_Laplace_Psi;
-  std::array<fftw_complex *,no_wf> m_Psi_sob;
+  std::array<value_t *,no_wf> m_Psi;
+  std::array<value_t *,no_wf> m_Laplace_Psi;
+  std::array<value_t *,no_wf> m_Psi_sob;
+  std::array<value_t *,no_wf> m_L2_grad;
+  std::array<value_t *,no_wf> m_grad_old;
+  std::array<value_t *,no_wf> m_dir;
+  std::array<value_t *,no_wf> m_grad; /// Sobolev gradient, real space array of m_fields[i]
+  fftw_complex * m_ks; /// k space scratch array
 
-  std::array<double,dim> m_res;
+  std::array<double,no_wf> m_res;
   std::array<double,no_wf *no_wf> m_gs;
   std::array<T *,no_wf> m_fields;
 
@@ -92,11 +158,17 @@ protected:
 
 /** Constructor
   * @params Pointer to a ParameterHandler object
+  * @level The grid is coarsened by 2^level in each direction (multilevel mode)
   */
 template <class T, int dim, int no_wf>
-CSOB_Base<T,dim,no_wf>::CSOB_Base( ParameterHandler *params )
+CSOB_Base<T,dim,no_wf>::CSOB_Base( ParameterHandler *params, const int level )
 {
   m_params = params;
+  m_level = level;
+
+  const int fak = 1 << level;
+  if ( params->Get_NX() % fak != 0 || (dim > 1 && params->Get_NY() % fak != 0) || (dim > 2 && params->Get_NZ() % fak != 0) )
+    throw std::string( "Error: the number of grid points is not divisible by 2^" + to_string(level) + "\n" );
 
   m_header = {};
   m_header.nself = sizeof(generic_header);
@@ -109,7 +181,7 @@ CSOB_Base<T,dim,no_wf>::CSOB_Base( ParameterHandler *params )
   switch ( dim )
   {
   case 1:
-    m_header.nDimX = params->Get_NX();
+    m_header.nDimX = params->Get_NX()/fak;
     m_header.nDimY = 1;
     m_header.nDimZ = 1;
     m_header.xMax = params->Get_xMax();
@@ -123,8 +195,8 @@ CSOB_Base<T,dim,no_wf>::CSOB_Base( ParameterHandler *params )
     m_no_of_pts_red = m_shift_x+1;
     break;
   case 2:
-    m_header.nDimX = params->Get_NX();
-    m_header.nDimY = params->Get_NY();
+    m_header.nDimX = params->Get_NX()/fak;
+    m_header.nDimY = params->Get_NY()/fak;
     m_header.nDimZ = 1;
     m_header.xMax = params->Get_xMax();
     m_header.xMin = params->Get_xMin();
@@ -142,9 +214,9 @@ CSOB_Base<T,dim,no_wf>::CSOB_Base( ParameterHandler *params )
     m_no_of_pts_red = m_header.nDimX*(m_shift_y+1);
     break;
   case 3:
-    m_header.nDimX = params->Get_NX();
-    m_header.nDimY = params->Get_NY();
-    m_header.nDimZ = params->Get_NZ();
+    m_header.nDimX = params->Get_NX()/fak;
+    m_header.nDimY = params->Get_NY()/fak;
+    m_header.nDimZ = params->Get_NZ()/fak;
     m_header.xMax = params->Get_xMax();
     m_header.xMin = params->Get_xMin();
     m_header.yMax = params->Get_yMax();
@@ -166,6 +238,7 @@ CSOB_Base<T,dim,no_wf>::CSOB_Base( ParameterHandler *params )
     m_no_of_pts_red = m_header.nDimX*m_header.nDimY*(m_shift_z+1);
     break;
   }
+  m_no_of_pts_fs = (m_nc == 1) ? m_no_of_pts_red : m_no_of_pts;
 
   string tmpstr;
 
@@ -186,10 +259,48 @@ CSOB_Base<T,dim,no_wf>::CSOB_Base( ParameterHandler *params )
   m_header.dt = params->Get_dt();
 
   m_epsilon = m_params->Get_Constant( "epsilon" );
+  if ( level > 0 )
+  {
+    // tolerances of the coarse levels, starting with level 1
+    try
+    {
+      std::vector<double> eps = m_params->Get_VConstant( "epsilon_levels" );
+      if ( int(eps.size()) >= level ) m_epsilon = eps[level-1];
+    }
+    catch (std::string &)
+    {
+    }
+  }
   m_stepsize = m_params->Get_Constant( "stepsize" );
-  
+
+  m_use_cg = false;
+  try
+  {
+    m_use_cg = (m_params->Get_simulation( "MINIMIZER" ) == "cg");
+  }
+  catch (std::string &)
+  {
+  }
+  m_tau = m_stepsize;
+  m_rg_old = 0;
+
   Allocate();
   Init();
+
+  int depth = 0;
+  try
+  {
+    depth = int(m_params->Get_Constant( "anderson_depth" ));
+  }
+  catch (std::string &)
+  {
+  }
+  m_aa_res_min = 0;
+  if ( depth > 0 && !m_use_cg )
+  {
+    m_anderson.reset( new CAnderson<no_wf>( depth, m_nc*int64_t(m_no_of_pts) ) );
+    printf( "FYI: Anderson history depth %d, %g MB\n", depth, double(m_anderson->Get_Memory())/1048576.0 );
+  }
 }
 
 template <class T, int dim, int no_wf>
@@ -198,31 +309,63 @@ CSOB_Base<T,dim,no_wf>::~CSOB_Base()
   for ( int i=0; i<no_wf; i++ )
   {
     delete m_fields[i];
-    delete m_operator_fs[i];
-    delete m_Laplace_operator_fs[i];
-    delete m_Potential[i];
-    delete m_Psi[i];
-    delete m_Laplace_Psi[i];
-    delete m_Psi_sob[i];
+    Huge_Free( m_operator_fs[i] );
+    Huge_Free( m_Laplace_operator_fs[i] );
+    Huge_Free( m_Potential[i] );
+    Huge_Free( m_Psi[i] );
+    Huge_Free( m_Laplace_Psi[i] );
+    Huge_Free( m_Psi_sob[i] );
+    if ( m_use_cg )
+    {
+      Huge_Free( m_L2_grad[i] );
+      Huge_Free( m_grad_old[i] );
+      Huge_Free( m_dir[i] );
+    }
   }
+  Huge_Free( m_ks );
 }
 
 template <class T, int dim, int no_wf>
 void CSOB_Base<T,dim,no_wf>::Allocate()
 {
+  const size_t sz = m_no_of_pts*sizeof(value_t);
+
   for ( int i=0; i<no_wf; i++ )
   {
-    m_operator_fs[i] = fftw_alloc_real( m_no_of_pts );
-    m_Laplace_operator_fs[i] = fftw_alloc_real( m_no_of_pts );
-    m_Potential[i] = fftw_alloc_real( m_no_of_pts );
-
-    m_Psi[i] = fftw_alloc_complex( m_no_of_pts );
-    m_Laplace_Psi[i] = fftw_alloc_complex( m_no_of_pts );
-    m_Psi_sob[i] = fftw_alloc_complex( m_no_of_pts );
+    m_operator_fs[i] = Huge_Alloc_Real( m_no_of_pts_fs );
+    m_Laplace_operator_fs[i] = Huge_Alloc_Real( m_no_of_pts_fs );
+    m_Potential[i] = Huge_Alloc_Real( m_no_of_pts );
+
+    m_Psi[i] = static_cast<value_t *>(Huge_Alloc( sz ));
+    m_Laplace_Psi[i] = static_cast<value_t *>(Huge_Alloc( sz ));
+    m_Psi_sob[i] = static_cast<value_t *>(Huge_Alloc( sz ));
+    First_Touch( m_operator_fs[i], m_no_of_pts_fs );
+    First_Touch( m_Laplace_operator_fs[i], m_no_of_pts_fs );
+    First_Touch( m_Potential[i], m_no_of_pts );
+    First_Touch( m_Psi[i], m_no_of_pts );
+    First_Touch( m_Laplace_Psi[i], m_no_of_pts );
+    First_Touch( m_Psi_sob[i], m_no_of_pts );
+
+    m_L2_grad[i] = nullptr;
+    m_grad_old[i] = nullptr;
+    m_dir[i] = nullptr;
+    if ( m_use_cg )
+    {
+      m_L2_grad[i] = static_cast<value_t *>(Huge_Alloc( sz ));
+      m_grad_old[i] = static_cast<value_t *>(Huge_Alloc( sz ));
+      m_dir[i] = static_cast<value_t *>(Huge_Alloc( sz ));
+      First_Touch( m_L2_grad[i], m_no_of_pts );
+      First_Touch( m_grad_old[i], m_no_of_pts );
+      First_Touch( m_dir[i], m_no_of_pts );
+    }
 
     m_fields[i] = new T(m_header);
     m_fields[i]->SetFix(false);
+    m_grad[i] = SOB_Field<T>::Get_Buffer( m_fields[i] );
   }
+  m_ks = Huge_Alloc_Complex( m_no_of_pts_fs );
+  First_Touch( m_ks, m_no_of_pts_fs );
+  Huge_Pages_Report();
 }
 
 template <class T, int dim, int no_wf>
@@ -231,45 +374,68 @@ void CSOB_Base<T,dim,no_wf>::Init()
   CPoint<dim> k;
   double phi;
 
+  // the operators include the factor 1/N of the unnormalized transforms (ft_raw)
+  const double fak = 1.0/double(m_no_of_pts);
+
+  // Get_k of the r2c transforms maps the Nyquist frequency of the last axis to 0
+  const int64_t red = m_fields[0]->Get_red_Dim();
+  const double dk_last[] = {m_header.dkx, m_header.dky, m_header.dkz};
+
   #pragma omp parallel for private(k,phi)
   for ( int j=0; j<no_wf; j++ )
   {
     double *op = m_operator_fs[j];
     double *op2 = m_Laplace_operator_fs[j];
-    for ( int i=0; i<m_no_of_pts; i++ )
+    for ( int i=0; i<m_no_of_pts_fs; i++ )
     {
       k = m_fields[0]->Get_k(i);
+      if ( red > 1 && i % red == red-1 ) k[dim-1] = dk_last[dim-1]*double(red-1);
       phi = k.scale(m_alpha[j])*k;
-      op[i] = 1.0/(1.0+phi);
-      op2[i] = -phi;
-      
+      op[i] = fak/(1.0+phi);
+      op2[i] = -fak*phi;
     }
   }
 }
 
+/** Sets component i of the wave function at the point l to the real value val */
+template <class T, int dim, int no_wf>
+void CSOB_Base<T,dim,no_wf>::Set_Psi( const int i, const int64_t l, const double val )
+{
+  double * Psi = Flat(m_Psi[i]) + m_nc*l;
+  Psi[0] = val;
+  for ( int c=1; c<m_nc; c++ )
+    Psi[c] = 0;
+}
+
+/** Returns the density |Psi_i|^2 at the point l */
+template <class T, int dim, int no_wf>
+inline double CSOB_Base<T,dim,no_wf>::Density( const int i, const int64_t l )
+{
+  const double * Psi = Flat(m_Psi[i]) + m_nc*l;
+  double retval = 0;
+  for ( int c=0; c<m_nc; c++ )
+    retval += Psi[c]*Psi[c];
+  return retval;
+}
+
 template <class T, int dim, int no_wf>
 void CSOB_Base<T,dim,no_wf>::Compute_Laplace()
 {
   for ( int i=0; i<no_wf; i++ )
   {
-    fftw_complex * Psi = m_Psi[i];
-    fftw_complex * Laplace_Psi = m_Laplace_Psi[i];
-    fftw_complex * in = m_fields[i]->Getp2In();
     fftw_complex * out = m_fields[i]->Getp2Out();
     double * op =  m_Laplace_operator_fs[i];
 
-    memcpy( (void *)(in), (void *)(Psi), m_no_of_pts*sizeof(fftw_complex) );
-    m_fields[i]->ft(-1);
+    m_fields[i]->ft_raw( -1, m_Psi[i], out );
 
     #pragma omp parallel for
-    for ( int l=0; l<m_no_of_pts; l++ )
+    for ( int l=0; l<m_no_of_pts_fs; l++ )
     {
       out[l][0] *= op[l];
       out[l][1] *= op[l];
     }
 
-    m_fields[i]->ft(1);
-    memcpy( (void *)(Laplace_Psi), (void *)(in), m_no_of_pts*sizeof(fftw_complex) );
+    m_fields[i]->ft_raw( 1, out, m_Laplace_Psi[i] );
   }
 }
 
@@ -279,24 +445,46 @@ void CSOB_Base<T,dim,no_wf>::Compute_Sobolev_Psi()
   // solves (1-Laplace) Psi_sob = Psi
   for ( int i=0; i<no_wf; i++ )
   {
-    fftw_complex * Psi = m_Psi[i];
-    fftw_complex * Psi_sob = m_Psi_sob[i];
-    fftw_complex * in = m_fields[i]->Getp2In();
     fftw_complex * out = m_fields[i]->Getp2Out();
     double * op = m_operator_fs[i];
 
-    memcpy( (void *)(in), (void *)(Psi), m_no_of_pts*sizeof(fftw_complex) );
-    m_fields[i]->ft(-1);
+    m_fields[i]->ft_raw( -1, m_Psi[i], out );
 
     #pragma omp parallel for
-    for ( int l=0; l<m_no_of_pts; l++ )
+    for ( int l=0; l<m_no_of_pts_fs; l++ )
     {
       out[l][0] *= op[l];
       out[l][1] *= op[l];
     }
 
-    m_fields[i]->ft(1);
-    memcpy( (void *)(Psi_sob), (void *)(in), m_no_of_pts*sizeof(fftw_complex) );
+    m_fields[i]->ft_raw( 1, out, m_Psi_sob[i] );
+  }
+}
+
+template <class T, int dim, int no_wf>
+void CSOB_Base<T,dim,no_wf>::Compute_Laplace_and_Sobolev_Psi()
+{
+  // Laplace Psi and (1-Laplace)^-1 Psi from one forward transform
+  for ( int i=0; i<no_wf; i++ )
+  {
+    fftw_complex * ks = m_ks;
+    fftw_complex * out = m_fields[i]->Getp2Out();
+    double * op = m_operator_fs[i];
+    double * op2 = m_Laplace_operator_fs[i];
+
+    m_fields[i]->ft_raw( -1, m_Psi[i], out );
+
+    #pragma omp parallel for
+    for ( int l=0; l<m_no_of_pts_fs; l++ )
+    {
+      ks[l][0] = op[l]*out[l][0];
+      ks[l][1] = op[l]*out[l][1];
+      out[l][0] *= op2[l];
+      out[l][1] *= op2[l];
+    }
+
+    m_fields[i]->ft_raw( 1, out, m_Laplace_Psi[i] );
+    m_fields[i]->ft_raw( 1, ks, m_Psi_sob[i] );
   }
 }
 
@@ -307,61 +495,178 @@ void CSOB_Base<T,dim,no_wf>::Compute_Sobolev_Gradient()
   for ( int i=0; i<no_wf; i++ )
   {
     // assemble the L2 gradient
-    fftw_complex * Psi = m_Psi[i];
-    fftw_complex * Laplace_Psi = m_Laplace_Psi[i];
-    fftw_complex * in = m_fields[i]->Getp2In();
-    fftw_complex * out = m_fields[i]->Getp2Out();
-    double * op =  m_operator_fs[i];
+    double * Psi = Flat(m_Psi[i]);
+    double * Laplace_Psi = Flat(m_Laplace_Psi[i]);
     double * pot = m_Potential[i];
 
+    // H Psi is kept in m_L2_grad for the conjugate gradient coefficients
+    value_t * L2_grad = m_use_cg ? m_L2_grad[i] : m_grad[i];
+    double * g = Flat(L2_grad);
+
     #pragma omp parallel for
     for ( int l=0; l<m_no_of_pts; l++ )
     {
       double NLpot=0;
       for ( int j=0; j<no_wf; j++ )
-        NLpot += m_gs[j+i*no_wf]*(m_Psi[j][l][0]*m_Psi[j][l][0] + m_Psi[j][l][1]*m_Psi[j][l][1]);
+        NLpot += m_gs[j+i*no_wf]*Density(j,l);
 
-      in[l][0] = -Laplace_Psi[l][0] + (pot[l]+NLpot)*Psi[l][0];
-      in[l][1] = -Laplace_Psi[l][1] + (pot[l]+NLpot)*Psi[l][1];
+      for ( int c=0; c<m_nc; c++ )
+        g[m_nc*l+c] = -Laplace_Psi[m_nc*l+c] + (pot[l]+NLpot)*Psi[m_nc*l+c];
     }
 
     // compute the Sobolev gradient
-    m_fields[i]->ft(-1);
-    for ( int l=0; l<m_no_of_pts; l++ )
+    Apply_Sobolev_Operator( i, L2_grad );
+  }
+}
+
+/** Sobolev gradient m_grad[i] = (1-Laplace)^-1 in, in may be m_grad[i] itself */
+template <class T, int dim, int no_wf>
+void CSOB_Base<T,dim,no_wf>::Apply_Sobolev_Operator( const int i, value_t * in )
+{
+  fftw_complex * out = m_fields[i]->Getp2Out();
+  double * op = m_operator_fs[i];
+
+  m_fields[i]->ft_raw( -1, in, out );
+
+  #pragma omp parallel for
+  for ( int l=0; l<m_no_of_pts_fs; l++ )
+  {
+    out[l][0] *= op[l];
+    out[l][1] *= op[l];
+  }
+
+  m_fields[i]->ft_raw( 1, out, m_grad[i] );
+}
+
+/** L2 gradients H Psi_i of all components in m_grad in one sweep
+  *
+  * The sweep also accumulates the particle numbers m_N and the projection coefficients
+  * fak_i = <Psi_i,(1-Laplace)^-1 H Psi_i>/<Psi_i,Psi_sob_i>, which equal <Psi_sob_i,H Psi_i>/<Psi_i,Psi_sob_i>
+  * since (1-Laplace)^-1 is self adjoint. Needs Compute_Laplace_and_Sobolev_Psi().
+  */
+template <class T, int dim, int no_wf>
+void CSOB_Base<T,dim,no_wf>::Compute_L2_Gradient( std::array<double,no_wf> &fak )
+{
+  const int nc = m_nc;
+  std::array<double *,no_wf> Psi, Laplace_Psi, Psi_sob, g;
+  for ( int i=0; i<no_wf; i++ )
+  {
+    Psi[i] = Flat(m_Psi[i]);
+    Laplace_Psi[i] = Flat(m_Laplace_Psi[i]);
+    Psi_sob[i] = Flat(m_Psi_sob[i]);
+    g[i] = Flat(m_grad[i]);
+  }
+
+  // per component: <Psi,Psi>, <Psi_sob,H Psi>, <Psi,Psi_sob>
+  double sums[3*no_wf] = {};
+
+  #pragma omp parallel for reduction(+:sums[:3*no_wf])
+  for ( int64_t l=0; l<m_no_of_pts; l++ )
+  {
+    double dens[no_wf];
+    for ( int j=0; j<no_wf; j++ )
+      dens[j] = Density(j,l);
+
+    for ( int i=0; i<no_wf; i++ )
     {
-      out[l][0] *= op[l];
-      out[l][1] *= op[l];
+      double V = m_Potential[i][l];
+      for ( int j=0; j<no_wf; j++ )
+        V += m_gs[j+i*no_wf]*dens[j];
+
+      sums[3*i] += dens[i];
+      for ( int64_t c=nc*l; c<nc*l+nc; c++ )
+      {
+        const double val = -Laplace_Psi[i][c] + V*Psi[i][c];
+        g[i][c] = val;
+        sums[3*i+1] += Psi_sob[i][c]*val;
+        sums[3*i+2] += Psi[i][c]*Psi_sob[i][c];
+      }
+    }
+  }
+
+  for ( int i=0; i<no_wf; i++ )
+  {
+    m_N[i] = m_ar*sums[3*i];
+    fak[i] = sums[3*i+1]/sums[3*i+2];
+  }
+}
+
+/** Projects the Sobolev gradients, computes the residuals and updates the wave functions in one sweep
+  *
+  * grad_i -= fak_i Psi_sob_i, Psi_i = scale_i Psi_i - step grad_i. Psi is left untouched for step = 0 and scale = 1.
+  */
+template <class T, int dim, int no_wf>
+void CSOB_Base<T,dim,no_wf>::Project_and_Update( const std::array<double,no_wf> &fak, const std::array<double,no_wf> &scale, const double step )
+{
+  const int64_t nf = m_nc*int64_t(m_no_of_pts);
+  std::array<double *,no_wf> Psi, Psi_sob, g;
+  bool update = (step != 0);
+  for ( int i=0; i<no_wf; i++ )
+  {
+    Psi[i] = Flat(m_Psi[i]);
+    Psi_sob[i] = Flat(m_Psi_sob[i]);
+    g[i] = Flat(m_grad[i]);
+    if ( scale[i] != 1 ) update = true;
+  }
+
+  double res[no_wf] = {};
+
+  #pragma omp parallel for reduction(+:res[:no_wf])
+  for ( int64_t l=0; l<nf; l++ )
+  {
+    for ( int i=0; i<no_wf; i++ )
+    {
+      const double val = g[i][l] - fak[i]*Psi_sob[i][l];
+      g[i][l] = val;
+      res[i] += val*val;
+      if ( update ) Psi[i][l] = scale[i]*Psi[i][l] - step*val;
     }
-    m_fields[i]->ft(1);
   }
+
+  m_res_tot=0;
+  for ( int i=0; i<no_wf; i++ )
+  {
+    m_res[i] = m_ar*res[i];
+    m_res_tot += m_res[i]*m_res[i];
+  }
+  m_res_tot = sqrt(m_res_tot);
 }
 
 template <class T, int dim, int no_wf>
 void CSOB_Base<T,dim,no_wf>::Project_Sobolev_Gradient()
 {
+  const int64_t nf = m_nc*int64_t(m_no_of_pts);
+
   for ( int i=0; i<no_wf; i++ )
   {
-    fftw_complex * Sob_grad = m_fields[i]->Getp2In();
-    fftw_complex * Psi = m_Psi[i];
-    fftw_complex * Psi_sob = m_Psi_sob[i];
+    double * Sob_grad = Flat(m_grad[i]);
+    double * Psi = Flat(m_Psi[i]);
+    double * Psi_sob = Flat(m_Psi_sob[i]);
 
     double tmp1=0;
     double tmp2=0;
 
     #pragma omp parallel for reduction(+:tmp1,tmp2)
-    for ( int l=0; l<m_no_of_pts; l++ )
+    for ( int64_t l=0; l<nf; l++ )
     {
-      tmp1 += (Psi[l][0]*Sob_grad[l][0] + Psi[l][1]*Sob_grad[l][1]);
-      tmp2 += (Psi[l][0]*Psi_sob[l][0] + Psi[l][1]*Psi_sob[l][1]);
+      tmp1 += Psi[l]*Sob_grad[l];
+      tmp2 += Psi[l]*Psi_sob[l];
     }
 
     double fak = tmp1/tmp2;
 
     #pragma omp parallel for
-    for ( int l=0; l<m_no_of_pts; l++ )
+    for ( int64_t l=0; l<nf; l++ )
+      Sob_grad[l] -= fak*Psi_sob[l];
+
+    // (1-Laplace) of the projected gradient: H Psi - fak Psi
+    if ( m_use_cg )
     {
-      Sob_grad[l][0] -= fak*Psi_sob[l][0];
-      Sob_grad[l][1] -= fak*Psi_sob[l][1];
+      double * L2_grad = Flat(m_L2_grad[i]);
+
+      #pragma omp parallel for
+      for ( int64_t l=0; l<nf; l++ )
+        L2_grad[l] -= fak*Psi[l];
     }
   }
 }
@@ -369,17 +674,17 @@ void CSOB_Base<T,dim,no_wf>::Project_Sobolev_Gradient()
 template <class T, int dim, int no_wf>
 void CSOB_Base<T,dim,no_wf>::Compute_res()
 {
-  fftw_complex *Sob_grad = nullptr;
+  const int64_t nf = m_nc*int64_t(m_no_of_pts);
 
   for ( int i=0; i<no_wf; i++ )
   {
-    Sob_grad = m_fields[i]->Getp2In();
+    double * Sob_grad = Flat(m_grad[i]);
 
     double tmp=0;
     #pragma omp parallel for reduction(+:tmp)
-    for ( int l=0; l<m_no_of_pts; l++ )
+    for ( int64_t l=0; l<nf; l++ )
     {
-      tmp += (Sob_grad[l][0]*Sob_grad[l][0] + Sob_grad[l][1]*Sob_grad[l][1]);
+      tmp += Sob_grad[l]*Sob_grad[l];
     }
     m_res[i]=tmp;
   }
@@ -405,8 +710,8 @@ void CSOB_Base<T,dim,no_wf>::Compute_mu()
   {
     double mu=0;
 
-    fftw_complex * Psi = m_Psi[i];
-    fftw_complex * Laplace_Psi = m_Laplace_Psi[i];
+    double * Psi = Flat(m_Psi[i]);
+    double * Laplace_Psi = Flat(m_Laplace_Psi[i]);
     double * pot = m_Potential[i];
 
     #pragma omp parallel for reduction(+:mu)
@@ -414,94 +719,492 @@ void CSOB_Base<T,dim,no_wf>::Compute_mu()
     {
       double NLpot=0;
       for ( int j=0; j<no_wf; j++ )
-        NLpot += m_gs[j+i*no_wf]*(m_Psi[j][l][0]*m_Psi[j][l][0] + m_Psi[j][l][1]*m_Psi[j][l][1]);
+        NLpot += m_gs[j+i*no_wf]*Density(j,l);
 
-      mu += -(Psi[l][0]*Laplace_Psi[l][0]+Psi[l][1]*Laplace_Psi[l][1]) + (pot[l]+NLpot)*(Psi[l][0]*Psi[l][0]+Psi[l][1]*Psi[l][1]);
+      for ( int c=0; c<m_nc; c++ )
+        mu += -Psi[m_nc*l+c]*Laplace_Psi[m_nc*l+c] + (pot[l]+NLpot)*Psi[m_nc*l+c]*Psi[m_nc*l+c];
     }
 
-    m_mu[i] = m_fields[i]->Get_Ar()*mu;
+    m_mu[i] = m_ar*mu;
   }
 }
 
+/** One steepest descent iteration Psi -= step * projected Sobolev gradient
+  *
+  * The point wise work between the transforms is fused into two sweeps over all components,
+  * Compute_L2_Gradient (L2 gradients, particle numbers, projection coefficients) and
+  * Project_and_Update (projection, residuals, renormalization and descent step).
+  * Psi is renormalized if a particle number deviates by more than 1e-5, m_N holds the numbers before.
+  * @return whether Psi was renormalized
+  */
+template <class T, int dim, int no_wf>
+bool CSOB_Base<T,dim,no_wf>::Fused_Step( const double step )
+{
+  std::array<double,no_wf> fak, scale;
+
+  Compute_Laplace_and_Sobolev_Psi();
+  Compute_L2_Gradient( fak );
+
+  for ( int i=0; i<no_wf; i++ )
+    Apply_Sobolev_Operator( i, m_grad[i] );
+
+  bool brenorm=false;
+  for ( int i=0; i<no_wf; i++ )
+    if ( fabs(m_N[i]-1) > 1e-5 ) brenorm = true;
+
+  for ( int i=0; i<no_wf; i++ )
+    scale[i] = brenorm ? 1.0/sqrt(m_N[i]) : 1.0;
+
+  Project_and_Update( fak, scale, step );
+  return brenorm;
+}
+
 template <class T, int dim, int no_wf>
 void CSOB_Base<T,dim,no_wf>::run()
 {
+  if ( m_use_cg )
+  {
+    run_cg();
+    return;
+  }
+
   Renormalize_All_Psi();
 
+  CConvergence_Monitor<no_wf> monitor( m_params, m_epsilon, m_level );
+
   int counter=0;
   do
   {
-    Compute_Sobolev_Psi();
+    const bool brenorm = Fused_Step( m_anderson ? 0.0 : m_stepsize );
+    const std::array<double,no_wf> N = m_N;
 
-//     for( int i=0; i<no_wf; i++ )
-//     {
-//       string filename = "sob_psi_" + to_string(i)+ "_" + to_string(counter) + ".bin";
-//       Save( m_Psi_sob[i], filename );
-//     }
+    if ( brenorm )
+      for ( int i=0; i<no_wf; i++ )
+        m_N[i] = 1;
+
+    if ( m_anderson )
+    {
+      // restart if the extrapolation went astray, the history is rebuilt from plain steps
+      if ( counter > 0 && m_res_tot > 10*m_aa_res_min )
+      {
+        m_anderson->Reset();
+        cout << "Anderson restart" << endl;
+      }
+      if ( counter == 0 || m_res_tot < m_aa_res_min ) m_aa_res_min = m_res_tot;
 
-    Compute_Laplace();
+      std::array<double *,no_wf> x, g;
+      for ( int i=0; i<no_wf; i++ )
+      {
+        x[i] = Flat(m_Psi[i]);
+        g[i] = Flat(m_grad[i]);
+      }
+      m_anderson->Step( x, g, -m_stepsize, []( double *, int ) {} );
+      // the mixed iterate leaves the constraint manifold
+      Renormalize_All_Psi();
+    }
 
 //     for( int i=0; i<no_wf; i++ )
 //     {
-//        string filename = "lap_psi_" + to_string(i) + "_" + to_string(counter) + ".bin";
-//        Save( m_Laplace_Psi[i], filename );
+//       string filename = "psi_" + to_string(i) + "_" + to_string(counter) + ".bin";
+//       Save( m_Psi[i], filename );
 //     }
 
-    Compute_Sobolev_Gradient();
+    const bool with_mu = monitor.Is_Record_Step(counter) && monitor.Needs_mu();
+    if ( with_mu ) Compute_mu();
+    monitor.Update( counter, m_res_tot, m_res, N, with_mu ? &m_mu : nullptr );
+    counter++;
+  }
+  while ( !monitor.Stop() );
 
-//     for( int i=0; i<no_wf; i++ )
-//     {
-//        string filename = "sob_grad_" + to_string(i) + "_" + to_string(counter) + ".bin";
-//        Save(  m_fields[i]->Getp2In(), filename );
-//     }
+  Compute_mu();
+  monitor.Summary( m_mu );
+}
 
-    Project_Sobolev_Gradient();
+/** Nonlinear conjugate gradient version of run()
+  *
+  * Polak-Ribiere (PR+) directions built from the projected Sobolev gradients,
+  * the step length is determined by an exact line search on the energy along
+  * the normalized path (Psi+tau*d)/|Psi+tau*d|.
+  */
+template <class T, int dim, int no_wf>
+void CSOB_Base<T,dim,no_wf>::run_cg()
+{
+  Renormalize_All_Psi();
 
-//     for( int i=0; i<no_wf; i++ )
-//     {
-//        string filename = "Psob_grad_" + to_string(i) + "_" + to_string(counter) + ".bin";
-//        Save( m_fields[i]->Getp2In(), filename );
-//     }
+  CConvergence_Monitor<no_wf> monitor( m_params, m_epsilon, m_level );
 
+  int counter=0;
+  bool restart=true;
+  do
+  {
+    Compute_Laplace_and_Sobolev_Psi();
+    Compute_Sobolev_Gradient();
+    Project_Sobolev_Gradient();
     Compute_res();
+    Compute_CG_Direction( restart );
 
-    bool brenorm=false;
-    for ( int i=0; i<no_wf; i++ )
+    const double tau = Line_Search();
+    restart = (tau == 0);
+
+    const bool with_mu = monitor.Is_Record_Step(counter) && monitor.Needs_mu();
+    if ( with_mu ) Compute_mu();
+    monitor.Update( counter, m_res_tot, m_res, m_N, with_mu ? &m_mu : nullptr, tau );
+    counter++;
+  }
+  while ( !monitor.Stop() );
+
+  Compute_mu();
+  monitor.Summary( m_mu );
+}
+
+/** Computes the new search direction d = -g + beta d_old
+  *
+  * g is the projected Sobolev gradient in m_grad, r = (1-Laplace) g is in m_L2_grad.
+  * The old direction is projected onto the tangent space of the current Psi before it is reused.
+  * Falls back to steepest descent if beta < 0 or d is not a descent direction.
+  */
+template <class T, int dim, int no_wf>
+void CSOB_Base<T,dim,no_wf>::Compute_CG_Direction( bool restart )
+{
+  const int64_t nf = m_nc*int64_t(m_no_of_pts);
+
+  double rg=0, rg_old=0;
+  for ( int i=0; i<no_wf; i++ )
+  {
+    double * r = Flat(m_L2_grad[i]);
+    double * g = Flat(m_grad[i]);
+    double * g_old = Flat(m_grad_old[i]);
+
+    double tmp1=0, tmp2=0;
+    #pragma omp parallel for reduction(+:tmp1,tmp2)
+    for ( int64_t l=0; l<nf; l++ )
     {
-      m_N[i] = Get_Particle_Number(i);
-      if ( fabs(m_N[i]-1) > 1e-5 ) brenorm = brenorm || true;
-      cout << "N[" << i << "] = " << m_N[i] << endl;
+      tmp1 += r[l]*g[l];
+      tmp2 += r[l]*g_old[l];
     }
+    rg += tmp1;
+    rg_old += tmp2;
+  }
 
-    printf( "brenorm = %s\n", brenorm ? "true" : "false");
+  double beta = 0;
+  if ( !restart && m_rg_old > 0 ) beta = std::max( 0.0, (rg-rg_old)/m_rg_old );
 
-    if ( brenorm )
-      Renormalize_All_Psi();
+  double rd=0;
+  for ( int i=0; i<no_wf; i++ )
+  {
+    double * r = Flat(m_L2_grad[i]);
+    double * g = Flat(m_grad[i]);
+    double * d = Flat(m_dir[i]);
+    double * Psi = Flat(m_Psi[i]);
+    double * Psi_sob = Flat(m_Psi_sob[i]);
+
+    double fak=0;
+    if ( beta > 0 )
+    {
+      double tmp1=0, tmp2=0;
+      #pragma omp parallel for reduction(+:tmp1,tmp2)
+      for ( int64_t l=0; l<nf; l++ )
+      {
+        tmp1 += Psi[l]*d[l];
+        tmp2 += Psi[l]*Psi_sob[l];
+      }
+      fak = tmp1/tmp2;
+    }
+
+    double tmp=0;
+    #pragma omp parallel for reduction(+:tmp)
+    for ( int64_t l=0; l<nf; l++ )
+    {
+      d[l] = -g[l] + beta*(d[l]-fak*Psi_sob[l]);
+      tmp += r[l]*d[l];
+    }
+    rd += tmp;
+  }
 
+  if ( beta > 0 && rd >= 0 )
+  {
     for ( int i=0; i<no_wf; i++ )
     {
-      fftw_complex *sobgrad = m_fields[i]->Getp2In();
-      fftw_complex *Psi = m_Psi[i];
+      double * g = Flat(m_grad[i]);
+      double * d = Flat(m_dir[i]);
 
       #pragma omp parallel for
+      for ( int64_t l=0; l<nf; l++ )
+        d[l] = -g[l];
+    }
+  }
+
+  for ( int i=0; i<no_wf; i++ )
+    memcpy( (void *)(m_grad_old[i]), (void *)(m_grad[i]), m_no_of_pts*sizeof(value_t) );
+  m_rg_old = rg;
+}
+
+/** Exact line search along m_dir
+  *
+  * With Psi_i(tau) = (Psi_i+tau d_i)/sqrt(m_ar S_i(tau)) the energy is a rational function of tau,
+  * whose coefficients are computed once. Its minimum is bracketed starting from the last step length
+  * and refined by golden section search. Updates m_Psi and returns the step length (0 if no decrease was found).
+  */
+template <class T, int dim, int no_wf>
+double CSOB_Base<T,dim,no_wf>::Line_Search()
+{
+  // q: <.,-Laplace+V .>, n: norms, rho: densities of Psi, d in powers of tau
+  std::array<std::array<double,3>,no_wf> q, n;
+  std::array<std::array<double,5>,no_wf*no_wf> P;
+
+  for ( int i=0; i<no_wf; i++ )
+  {
+    double * Psi = Flat(m_Psi[i]);
+    double * Laplace_Psi = Flat(m_Laplace_Psi[i]);
+    double * d = Flat(m_dir[i]);
+    double * Laplace_d = Flat(m_grad[i]);
+    fftw_complex * out = m_fields[i]->Getp2Out();
+    double * op = m_Laplace_operator_fs[i];
+    double * pot = m_Potential[i];
+
+    // Laplace d
+    m_fields[i]->ft_raw( -1, m_dir[i], out );
+
+    #pragma omp parallel for
+    for ( int l=0; l<m_no_of_pts_fs; l++ )
+    {
+      out[l][0] *= op[l];
+      out[l][1] *= op[l];
+    }
+
+    m_fields[i]->ft_raw( 1, out, m_grad[i] );
+
+    double q0=0, q1=0, q2=0, n0=0, n1=0, n2=0;
+    #pragma omp parallel for reduction(+:q0,q1,q2,n0,n1,n2)
+    for ( int l=0; l<m_no_of_pts; l++ )
+    {
+      double pp=0, pd=0, dd=0;
+      for ( int c=0; c<m_nc; c++ )
+      {
+        const int64_t m = m_nc*l+c;
+        pp += Psi[m]*Psi[m];
+        pd += Psi[m]*d[m];
+        dd += d[m]*d[m];
+        q0 -= Psi[m]*Laplace_Psi[m];
+        q1 -= d[m]*Laplace_Psi[m];
+        q2 -= d[m]*Laplace_d[m];
+      }
+      q0 += pot[l]*pp;
+      q1 += pot[l]*pd;
+      q2 += pot[l]*dd;
+      n0 += pp;
+      n1 += pd;
+      n2 += dd;
+    }
+    q[i] = {q0,q1,q2};
+    n[i] = {n0,n1,n2};
+  }
+
+  for ( int i=0; i<no_wf; i++ )
+  {
+    double * Psi_i = Flat(m_Psi[i]);
+    double * d_i = Flat(m_dir[i]);
+
+    for ( int j=i; j<no_wf; j++ )
+    {
+      double * Psi_j = Flat(m_Psi[j]);
+      double * d_j = Flat(m_dir[j]);
+
+      double p0=0, p1=0, p2=0, p3=0, p4=0;
+      #pragma omp parallel for reduction(+:p0,p1,p2,p3,p4)
       for ( int l=0; l<m_no_of_pts; l++ )
       {
-        Psi[l][0] -= m_stepsize*sobgrad[l][0];
-        Psi[l][1] -= m_stepsize*sobgrad[l][1];
+        // rho = a + 2 tau b + tau^2 c
+        double ai=0, bi=0, ci=0, aj=0, bj=0, cj=0;
+        for ( int c=0; c<m_nc; c++ )
+        {
+          const int64_t m = m_nc*l+c;
+          ai += Psi_i[m]*Psi_i[m];
+          bi += Psi_i[m]*d_i[m];
+          ci += d_i[m]*d_i[m];
+          aj += Psi_j[m]*Psi_j[m];
+          bj += Psi_j[m]*d_j[m];
+          cj += d_j[m]*d_j[m];
+        }
+        p0 += ai*aj;
+        p1 += 2*(ai*bj+bi*aj);
+        p2 += ai*cj+ci*aj+4*bi*bj;
+        p3 += 2*(bi*cj+ci*bj);
+        p4 += ci*cj;
       }
+      P[j+no_wf*i] = {p0,p1,p2,p3,p4};
+      P[i+no_wf*j] = P[j+no_wf*i];
     }
+  }
 
-//     for( int i=0; i<no_wf; i++ )
-//     {
-//       string filename = "psi_" + to_string(i) + "_" + to_string(counter) + ".bin";
-//       Save( m_Psi[i], filename );
-//     }
+  auto energy = [&]( const double tau )
+  {
+    std::array<double,no_wf> S;
+    double E=0;
+    for ( int i=0; i<no_wf; i++ )
+    {
+      S[i] = n[i][0] + tau*(2*n[i][1] + tau*n[i][2]);
+      E += (q[i][0] + tau*(2*q[i][1] + tau*q[i][2]))/S[i];
+    }
+    for ( int i=0; i<no_wf; i++ )
+      for ( int j=0; j<no_wf; j++ )
+      {
+        const std::array<double,5> &p = P[j+no_wf*i];
+        E += 0.5*m_gs[j+no_wf*i]*(p[0]+tau*(p[1]+tau*(p[2]+tau*(p[3]+tau*p[4]))))/(m_ar*S[i]*S[j]);
+      }
+    return E;
+  };
+
+  // bracket the minimum in (0,2 tau)
+  const double E0 = energy(0);
+  double tau = m_tau;
+  double E1 = energy(tau);
+  int k=0;
+  for ( ; E1 >= E0 && k<60; k++ )
+  {
+    tau *= 0.5;
+    E1 = energy(tau);
+  }
+  if ( E1 >= E0 ) return 0;
 
-    cout << "--- " << counter << endl;
-    cout << "res " << m_res_tot << endl;
-    counter++;
+  if ( k == 0 )
+  {
+    double E2 = energy(2*tau);
+    for ( ; E2 < E1 && k<60; k++ )
+    {
+      tau *= 2;
+      E1 = E2;
+      E2 = energy(2*tau);
+    }
+  }
+
+  // golden section search
+  const double gr = 0.5*(sqrt(5.0)-1);
+  double a=0, b=2*tau;
+  double x1 = b-gr*(b-a), x2 = a+gr*(b-a);
+  double f1 = energy(x1), f2 = energy(x2);
+  for ( int it=0; it<60 && (b-a) > 1e-10*tau; it++ )
+  {
+    if ( f1 < f2 )
+    {
+      b = x2;
+      x2 = x1;
+      f2 = f1;
+      x1 = b-gr*(b-a);
+      f1 = energy(x1);
+    }
+    else
+    {
+      a = x1;
+      x1 = x2;
+      f1 = f2;
+      x2 = a+gr*(b-a);
+      f2 = energy(x2);
+    }
   }
-  while ( m_res_tot > m_epsilon );
+  tau = (f1 < f2) ? x1 : x2;
+  if ( energy(tau) >= E0 ) return 0;
+
+  // Psi <- (Psi + tau d)/|Psi + tau d|
+  const int64_t nf = m_nc*int64_t(m_no_of_pts);
+  for ( int i=0; i<no_wf; i++ )
+  {
+    double * Psi = Flat(m_Psi[i]);
+    double * d = Flat(m_dir[i]);
+    const double fak = 1.0/sqrt(m_ar*(n[i][0] + tau*(2*n[i][1] + tau*n[i][2])));
+
+    #pragma omp parallel for
+    for ( int64_t l=0; l<nf; l++ )
+    {
+      Psi[l] = fak*(Psi[l]+tau*d[l]);
+    }
+    m_N[i] = 1;
+  }
+
+  m_tau = tau;
+  return tau;
+}
+
+/** Spectral interpolation of the wave functions of a coarser grid
+  *
+  * The Fourier coefficients of the coarse solution are copied into the fine k grid, all other
+  * modes (including the Nyquist modes of the coarse grid) are set to zero. Both grids share
+  * the same domain, hence the same dk and the same x origin. For real fields only the
+  * non negative frequencies of the last axis are stored.
+  */
+template <class T, int dim, int no_wf>
+void CSOB_Base<T,dim,no_wf>::Interpolate_From( CSOB_Base<T,dim,no_wf> &coarse )
+{
+  const int64_t n[] = {coarse.m_header.nDimX, coarse.m_header.nDimY, coarse.m_header.nDimZ};
+  const int64_t N[] = {m_header.nDimX, m_header.nDimY, m_header.nDimZ};
+  int64_t nf[] = {n[0], n[1], n[2]};
+  int64_t Nf[] = {N[0], N[1], N[2]};
+  if ( m_nc == 1 )
+  {
+    nf[dim-1] = n[dim-1]/2+1;
+    Nf[dim-1] = N[dim-1]/2+1;
+  }
+
+  // ft_raw is unnormalized, the forward transform on the coarse grid leaves a factor n
+  const double fak = 1.0/double(coarse.m_no_of_pts);
+
+  for ( int i=0; i<no_wf; i++ )
+  {
+    fftw_complex * out_c = coarse.m_ks;
+    fftw_complex * out = m_ks;
+
+    coarse.m_fields[i]->ft_raw( -1, coarse.m_Psi[i], out_c );
+
+    memset( (void *)(out), 0, m_no_of_pts_fs*sizeof(fftw_complex) );
+
+    #pragma omp parallel for
+    for ( int64_t l=0; l<coarse.m_no_of_pts_fs; l++ )
+    {
+      int64_t idx[] = { l/(nf[1]*nf[2]), (l/nf[2])%nf[1], l%nf[2] };
+
+      bool nyquist = false;
+      for ( int d=0; d<3; d++ )
+      {
+        if ( n[d] > 1 && 2*idx[d] == n[d] ) nyquist = true;
+        if ( 2*idx[d] > n[d] ) idx[d] += N[d]-n[d]; // negative frequencies
+      }
+      if ( nyquist ) continue;
+
+      const int64_t L = idx[2]+Nf[2]*(idx[1]+Nf[1]*idx[0]);
+      out[L][0] = fak*out_c[l][0];
+      out[L][1] = fak*out_c[l][1];
+    }
+
+    m_fields[i]->ft_raw( 1, out, m_Psi[i] );
+  }
+}
+
+/** Replaces the initial guess by the nearest ground state of the cache
+  *
+  * The entry is interpolated onto the grid of this solver, run() renormalizes it.
+  * @return false if the cache holds no compatible entry, the guess is left untouched
+  */
+template <class T, int dim, int no_wf>
+bool CSOB_Base<T,dim,no_wf>::Warm_Start( CGS_Cache &cache )
+{
+  std::vector<std::string> files;
+  if ( !cache.Find( files ) ) return false;
+
+  fftw_complex * tmp = fftw_alloc_complex( m_no_of_pts );
+  for ( int i=0; i<no_wf; i++ )
+  {
+    CGS_Cache::Interpolate( files[i], m_header, tmp );
+    double *Psi = Flat(m_Psi[i]);
+
+    #pragma omp parallel for
+    for ( int64_t l=0; l<m_no_of_pts; l++ )
+    {
+      for ( int c=0; c<m_nc; c++ )
+        Psi[m_nc*l+c] = tmp[l][c];
+    }
+  }
+  fftw_free( tmp );
+  return true;
 }
 
 template <class T, int dim, int no_wf>
@@ -509,12 +1212,13 @@ double CSOB_Base<T,dim,no_wf>::Get_Particle_Number( const int comp )
 {
   if ( comp<0 || comp>no_wf ) throw std::string("Error in " + std::string(__func__) + ": comp out of bounds\n");
 
-  fftw_complex *Psi = m_Psi[comp];
+  const int64_t nf = m_nc*int64_t(m_no_of_pts);
+  double *Psi = Flat(m_Psi[comp]);
   double retval=0.0;
   #pragma omp parallel for reduction(+:retval)
-  for ( int l=0; l<m_no_of_pts; l++ )
+  for ( int64_t l=0; l<nf; l++ )
   {
-    retval += (Psi[l][0]*Psi[l][0] + Psi[l][1]*Psi[l][1]);
+    retval += Psi[l]*Psi[l];
   }
   return m_ar*retval;
 }
@@ -525,16 +1229,16 @@ void CSOB_Base<T,dim,no_wf>::Renormalize_All_Psi()
   for ( int i=0; i<no_wf; i++ )
     m_N[i] = Get_Particle_Number( i );
 
+  const int64_t nf = m_nc*int64_t(m_no_of_pts);
   for ( int i=0; i<no_wf; i++ )
   {
     const double fak = 1.0/sqrt(m_N[i]);
-    fftw_complex *Psi = m_Psi[i];
+    double *Psi = Flat(m_Psi[i]);
 
     #pragma omp parallel for
-    for ( int l=0; l<m_no_of_pts; l++ )
+    for ( int64_t l=0; l<nf; l++ )
     {
-      Psi[l][0] *= fak;
-      Psi[l][1] *= fak;
+      Psi[l] *= fak;
     }
   }
 
@@ -554,7 +1258,7 @@ void CSOB_Base<T,dim,no_wf>::Save( double *data, std::string filename )
 
   ofstream file1( filename, ofstream::binary );
   file1.write( header, sizeof(generic_header) );
-  file1.write( Psi, m_no_of_pts*sizeof(fftw_complex) );
+  file1.write( Psi, m_no_of_pts*sizeof(double) );
   file1.close();
 }
 
@@ -572,33 +1276,59 @@ void CSOB_Base<T,dim,no_wf>::Save( fftw_complex *data, std::string filename )
   file1.close();
 }
 
+/** Saves the wave functions as complex fields, real fields are converted on the fly
+  * @filenames One file name per component
+  * @rescale Whether the wave functions are scaled to the particle numbers VCONSTANTS/N first
+  */
 template <class T, int dim, int no_wf>
 void CSOB_Base<T,dim,no_wf>::Save( std::vector<std::string> filenames, bool rescale )
 {
+  const int64_t nf = m_nc*int64_t(m_no_of_pts);
   if ( rescale )
   {
     for ( int i=0; i<no_wf; i++ )
     {
-      fftw_complex *Psi = m_Psi[i];
+      double *Psi = Flat(m_Psi[i]);
       const double fak = sqrt(m_params->Get_VConstant("N",i));
 
       #pragma omp parallel for
-      for ( int l=0; l<m_no_of_pts; l++ )
+      for ( int64_t l=0; l<nf; l++ )
       {
-        Psi[l][0] *= fak;
-        Psi[l][1] *= fak;
+        Psi[l] *= fak;
       }
     }
   }
+
+  if ( m_nc == 2 )
+  {
+    for ( int i=0; i<no_wf; i++ )
+      Save( reinterpret_cast<fftw_complex *>(m_Psi[i]), filenames[i] );
+    return;
+  }
+
+  fftw_complex * tmp = fftw_alloc_complex( m_no_of_pts );
   for ( int i=0; i<no_wf; i++ )
-    Save( m_Psi[i], filenames[i] );
+  {
+    double *Psi = Flat(m_Psi[i]);
+
+    #pragma omp parallel for
+    for ( int l=0; l<m_no_of_pts; l++ )
+    {
+      tmp[l][0] = Psi[l];
+      tmp[l][1] = 0;
+    }
+    Save( tmp, filenames[i] );
+  }
+  fftw_free( tmp );
 }
 
 template <class T, int dim, int no_wf>
 void CSOB_Base<T,dim,no_wf>::Save_Zero()
 {
-  memset( m_Psi_sob[0], 0, m_no_of_pts*sizeof(fftw_complex) );
-  Save( m_Psi_sob[0], "zero.bin" );
+  fftw_complex * tmp = fftw_alloc_complex( m_no_of_pts );
+  memset( tmp, 0, m_no_of_pts*sizeof(fftw_complex) );
+  Save( tmp, "zero.bin" );
+  fftw_free( tmp );
 }
 
 template <class T, int dim, int no_wf>
@@ -608,6 +1338,44 @@ void CSOB_Base<T,dim,no_wf>::Dump_2( ofstream &stream )
   //stream << Get_N() << "\t";
 }
 
+/** Coarse to fine ground state computation
+  *
+  * Converges first on the grid coarsened by 2^levels (CONSTANTS/levels), then interpolates the
+  * result spectrally to the next finer grid as starting point, down to sol which lives on the
+  * requested grid. The tolerances of the coarse levels are set by VCONSTANTS/epsilon_levels
+  * (level 1 first), missing entries default to epsilon.
+  * S is derived from CSOB_Base and has a constructor S( ParameterHandler *, int level ).
+  */
+template <class S>
+void Run_Coarse_To_Fine( S &sol, ParameterHandler *params )
+{
+  int levels = 0;
+  try
+  {
+    levels = int(params->Get_Constant( "levels" ));
+  }
+  catch (std::string &)
+  {
+  }
+
+  std::unique_ptr<S> coarse;
+  for ( int lev=levels; lev>0; lev-- )
+  {
+    std::unique_ptr<S> next( new S( params, lev ) );
+    if ( coarse ) next->Interpolate_From( *coarse );
+
+    cout << "=== level " << lev << endl;
+    next->run();
+    coarse = std::move(next);
+  }
+
+  if ( coarse ) sol.Interpolate_From( *coarse );
+  coarse.reset();
+
+  if ( levels > 0 ) cout << "=== level 0" << endl;
+  sol.run();
+}
+
 template<class T, int dim, int no_wf>
 ofstream &operator<<( ofstream &stream, CSOB_Base<T,dim,no_wf> &obj )
 {
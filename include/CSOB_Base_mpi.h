@@ -29,9 +29,12 @@
 #include <string>
 #include <cstring>
 #include <array>
+#include <algorithm>
+#include <memory>
 
 #include "CRT_shared_mpi.h"
 #include "ParameterHandler.h"
+#include "CAnderson.h"
 
 using namespace std;
 
@@ -56,6 +59,15 @@ protected:
   double m_epsilon;
   double m_stepsize;
 
+  // nonlinear conjugate gradients (SIMULATION/MINIMIZER = cg)
+  bool m_use_cg;
+  double m_tau;
+  double m_rg_old;
+
+  // Anderson acceleration of the steepest descent (CONSTANTS/anderson_depth > 0)
+  std::unique_ptr<CAnderson<no_wf>> m_anderson;
+  double m_aa_res_min;
+
   void Compute_Laplace();
   void Compute_Sobolev_Gradient();
   void Compute_Sobolev_Psi();
@@ -64,6 +76,13 @@ protected:
   void Compute_res();
   void Renormalize_All_Psi();
 
+  void run_cg();
+  void Compute_CG_Direction( bool );
+  double Line_Search();
+
+  void Copy( fftw_complex *, const fftw_complex * );
+  void Compute_Particle_Numbers();
+
   ParameterHandler *m_params;
 
   std::array<double,no_wf> m_mu;
@@ -76,8 +95,11 @@ protected:
   std::array<fftw_complex *,no_wf> m_Psi;
   std::array<fftw_complex *,no_wf> m_Laplace_Psi;
   std::array<fftw_complex *,no_wf> m_Psi_sob;
+  std::array<fftw_complex *,no_wf> m_L2_grad;
+  std::array<fftw_complex *,no_wf> m_grad_old;
+  std::array<fftw_complex *,no_wf> m_dir;
 
-  std::array<double,dim> m_res;
+  std::array<double,no_wf> m_res;
   std::array<double,no_wf *no_wf> m_gs;
   std::array<T *,no_wf> m_fields;
 
@@ -139,9 +161,7 @@ CSOB_Base_MPI<T,dim,no_wf>::CSOB_Base_MPI( ParameterHandler *params )
     m_header.dkz  = 2*M_PI/fabs(m_header.zMax-m_header.zMin);
     m_ar = m_header.dx*m_header.dy*m_header.dz;
     m_ar_k = m_header.dkx*m_header.dky*m_header.dkz;
-    m_alloc = fftw_mpi_local_size_3d_transposed( m_header.nDimX, m_header.nDimY, m_header.nDimZ, MPI_COMM_WORLD, &m_loc_dimX, &m_loc_start_dimX, &m_loc_dimY, &m_loc_start_dimY );
-    m_no_of_pts = m_loc_dimX*Get_dimY()*Get_dimZ();
-    m_no_of_pts_fs = m_loc_dimY*Get_dimX()*Get_dimZ();
+    m_alloc = MPI::Fourier::cft_3d_MPI::Local_Size( m_header.nDimX, m_header.nDimY, m_header.nDimZ, m_no_of_pts, m_no_of_pts_fs, m_loc_dimX, m_loc_start_dimX, m_loc_dimY, m_loc_start_dimY );
     m_shift_x = m_header.nDimX/2;
     m_shift_y = m_header.nDimY/2;
     m_shift_z = m_header.nDimZ/2;
@@ -168,9 +188,35 @@ CSOB_Base_MPI<T,dim,no_wf>::CSOB_Base_MPI( ParameterHandler *params )
 
   m_epsilon = m_params->Get_Constant( "epsilon" );
   m_stepsize = m_params->Get_Constant( "stepsize" );
-  
+
+  m_use_cg = false;
+  try
+  {
+    m_use_cg = (m_params->Get_simulation( "MINIMIZER" ) == "cg");
+  }
+  catch (std::string &)
+  {
+  }
+  m_tau = m_stepsize;
+  m_rg_old = 0;
+
   Allocate();
   Init();  
+
+  int depth = 0;
+  try
+  {
+    depth = int(m_params->Get_Constant( "anderson_depth" ));
+  }
+  catch (std::string &)
+  {
+  }
+  m_aa_res_min = 0;
+  if ( depth > 0 && !m_use_cg )
+  {
+    m_anderson.reset( new CAnderson<no_wf>( depth, 2*int64_t(m_no_of_pts) ) );
+    if ( m_myrank == 0 ) printf( "FYI: Anderson history depth %d, %g MB per process\n", depth, double(m_anderson->Get_Memory())/1048576.0 );
+  }
 }
 
 template <class T, int dim, int no_wf>
@@ -185,6 +231,12 @@ CSOB_Base_MPI<T,dim,no_wf>::~CSOB_Base_MPI()
     delete m_Psi[i];
     delete m_Laplace_Psi[i];
     delete m_Psi_sob[i];
+    if ( m_use_cg )
+    {
+      fftw_free( m_L2_grad[i] );
+      fftw_free( m_grad_old[i] );
+      fftw_free( m_dir[i] );
+    }
   }
 }
 
@@ -201,6 +253,18 @@ void CSOB_Base_MPI<T,dim,no_wf>::Allocate()
     m_Laplace_Psi[i] = fftw_alloc_complex( m_alloc );
     m_Psi_sob[i] = fftw_alloc_complex( m_alloc );
 
+    m_L2_grad[i] = nullptr;
+    m_grad_old[i] = nullptr;
+    m_dir[i] = nullptr;
+    if ( m_use_cg )
+    {
+      m_L2_grad[i] = fftw_alloc_complex( m_alloc );
+      m_grad_old[i] = fftw_alloc_complex( m_alloc );
+      m_dir[i] = fftw_alloc_complex( m_alloc );
+      memset( m_grad_old[i], 0, m_alloc*sizeof(fftw_complex) );
+      memset( m_dir[i], 0, m_alloc*sizeof(fftw_complex) );
+    }
+
     m_fields[i] = new T(&m_header);
   }
 }
@@ -208,24 +272,34 @@ void CSOB_Base_MPI<T,dim,no_wf>::Allocate()
 template <class T, int dim, int no_wf>
 void CSOB_Base_MPI<T,dim,no_wf>::Init()
 {
-  CPoint<dim> k;
-  double phi;
-
-  #pragma omp parallel for private(k,phi)
   for ( int j=0; j<no_wf; j++ )
   {
     double *op = m_operator_fs[j];
     double *op2 = m_Laplace_operator_fs[j];
+
+    #pragma omp parallel for
     for ( ptrdiff_t i=0; i<m_no_of_pts_fs; i++ )
     {
-      k = m_fields[0]->Get_k(i);
-      phi = k.scale(m_alpha[j])*k;
+      CPoint<dim> k = m_fields[0]->Get_k(i);
+      const double phi = k.scale(m_alpha[j])*k;
       op[i] = 1.0/(1.0+phi);
       op2[i] = -phi;
     }
   }
 }
 
+/** Threaded copy of the local slab, memcpy is bound to one core */
+template <class T, int dim, int no_wf>
+void CSOB_Base_MPI<T,dim,no_wf>::Copy( fftw_complex *dst, const fftw_complex *src )
+{
+  #pragma omp parallel for
+  for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+  {
+    dst[l][0] = src[l][0];
+    dst[l][1] = src[l][1];
+  }
+}
+
 template <class T, int dim, int no_wf>
 void CSOB_Base_MPI<T,dim,no_wf>::Compute_Laplace()
 {
@@ -238,9 +312,10 @@ void CSOB_Base_MPI<T,dim,no_wf>::Compute_Laplace()
     fftw_complex * out = m_fields[i]->Get_p2_Data();
     double * op =  m_Laplace_operator_fs[i];
 
-    memcpy( (void *)(in), (void *)(Psi), m_no_of_pts*sizeof(fftw_complex) );
+    Copy( in, Psi );
     m_fields[i]->ft(-1);
 
+    #pragma omp parallel for
     for ( ptrdiff_t l=0; l<m_no_of_pts_fs; l++ )
     {
       out[l][0] *= op[l];
@@ -248,7 +323,7 @@ void CSOB_Base_MPI<T,dim,no_wf>::Compute_Laplace()
     }
 
     m_fields[i]->ft(1);
-    memcpy( (void *)(Laplace_Psi), (void *)(in), m_no_of_pts*sizeof(fftw_complex) );
+    Copy( Laplace_Psi, in );
   }
 }
 
@@ -264,9 +339,10 @@ void CSOB_Base_MPI<T,dim,no_wf>::Compute_Sobolev_Psi()
     fftw_complex * out = m_fields[i]->Get_p2_Data();
     double * op = m_operator_fs[i];
 
-    memcpy( (void *)(in), (void *)(Psi), m_no_of_pts*sizeof(fftw_complex) );
+    Copy( in, Psi );
     m_fields[i]->ft(-1);
 
+    #pragma omp parallel for
     for ( ptrdiff_t l=0; l<m_no_of_pts_fs; l++ )
     {
       out[l][0] *= op[l];
@@ -274,7 +350,7 @@ void CSOB_Base_MPI<T,dim,no_wf>::Compute_Sobolev_Psi()
     }
 
     m_fields[i]->ft(1);
-    memcpy( (void *)(Psi_sob), (void *)(in), m_no_of_pts*sizeof(fftw_complex) );
+    Copy( Psi_sob, in );
   }
 }
 
@@ -292,6 +368,7 @@ void CSOB_Base_MPI<T,dim,no_wf>::Compute_Sobolev_Gradient()
     double * op =  m_operator_fs[i];
     double * pot = m_Potential[i];
 
+    #pragma omp parallel for
     for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
     {
       double NLpot=0;
@@ -302,8 +379,13 @@ void CSOB_Base_MPI<T,dim,no_wf>::Compute_Sobolev_Gradient()
       in[l][1] = -Laplace_Psi[l][1] + (pot[l]+NLpot)*Psi[l][1];
     }
 
+    // keep H Psi for the conjugate gradient coefficients
+    if ( m_use_cg ) Copy( m_L2_grad[i], in );
+
     // compute the Sobolev gradient
     m_fields[i]->ft(-1);
+
+    #pragma omp parallel for
     for ( ptrdiff_t l=0; l<m_no_of_pts_fs; l++ )
     {
       out[l][0] *= op[l];
@@ -316,47 +398,75 @@ void CSOB_Base_MPI<T,dim,no_wf>::Compute_Sobolev_Gradient()
 template <class T, int dim, int no_wf>
 void CSOB_Base_MPI<T,dim,no_wf>::Project_Sobolev_Gradient()
 {
+  // thread local sums of all components, then one MPI_Allreduce
+  double loc_tmp[2*no_wf] = {};
+  double red_tmp[2*no_wf] = {};
+
   for ( int i=0; i<no_wf; i++ )
   {
     fftw_complex * Sob_grad = m_fields[i]->Get_p2_Data();
     fftw_complex * Psi = m_Psi[i];
     fftw_complex * Psi_sob = m_Psi_sob[i];
 
-    double loc_tmp[] = {0,0};
-    double red_tmp[] = {0,0};
+    double tmp1=0, tmp2=0;
 
+    #pragma omp parallel for reduction(+:tmp1,tmp2)
     for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
     {
-      loc_tmp[0] += (Psi[l][0]*Sob_grad[l][0] + Psi[l][1]*Sob_grad[l][1]);
-      loc_tmp[1] += (Psi[l][0]*Psi_sob[l][0] + Psi[l][1]*Psi_sob[l][1]);
+      tmp1 += (Psi[l][0]*Sob_grad[l][0] + Psi[l][1]*Sob_grad[l][1]);
+      tmp2 += (Psi[l][0]*Psi_sob[l][0] + Psi[l][1]*Psi_sob[l][1]);
     }
+    loc_tmp[2*i] = tmp1;
+    loc_tmp[2*i+1] = tmp2;
+  }
+
+  MPI_Allreduce(loc_tmp,red_tmp,2*no_wf,MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  for ( int i=0; i<no_wf; i++ )
+  {
+    fftw_complex * Sob_grad = m_fields[i]->Get_p2_Data();
+    fftw_complex * Psi = m_Psi[i];
+    fftw_complex * Psi_sob = m_Psi_sob[i];
 
-    MPI_Allreduce(loc_tmp,red_tmp,2,MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-      
-    double fak = red_tmp[0]/red_tmp[1];
+    const double fak = red_tmp[2*i]/red_tmp[2*i+1];
 
+    #pragma omp parallel for
     for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
     {
       Sob_grad[l][0] -= fak*Psi_sob[l][0];
       Sob_grad[l][1] -= fak*Psi_sob[l][1];
     }
+
+    // (1-Laplace) of the projected gradient: H Psi - fak Psi
+    if ( m_use_cg )
+    {
+      fftw_complex * L2_grad = m_L2_grad[i];
+
+      #pragma omp parallel for
+      for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+      {
+        L2_grad[l][0] -= fak*Psi[l][0];
+        L2_grad[l][1] -= fak*Psi[l][1];
+      }
+    }
   }
 }
 
 template <class T, int dim, int no_wf>
 void CSOB_Base_MPI<T,dim,no_wf>::Compute_res()
 {
-  fftw_complex *Sob_grad = nullptr;
-
   double locres[no_wf] = {};
   for ( int i=0; i<no_wf; i++ )
   {
-    Sob_grad = m_fields[i]->Get_p2_Data();
+    fftw_complex *Sob_grad = m_fields[i]->Get_p2_Data();
 
-    for ( int l=0; l<m_no_of_pts; l++ )
+    double tmp=0;
+    #pragma omp parallel for reduction(+:tmp)
+    for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
     {
-      locres[i] += (Sob_grad[l][0]*Sob_grad[l][0] + Sob_grad[l][1]*Sob_grad[l][1]);
+      tmp += (Sob_grad[l][0]*Sob_grad[l][0] + Sob_grad[l][1]*Sob_grad[l][1]);
     }
+    locres[i] = tmp;
   }
 
   for ( int i=0; i<no_wf; i++ )
@@ -378,33 +488,43 @@ void CSOB_Base_MPI<T,dim,no_wf>::Compute_mu()
 {
   Compute_Laplace();
 
+  double loc_mu[no_wf] = {};
+  double red_mu[no_wf] = {};
+
   for ( int i=0; i<no_wf; i++ )
   {
-    double loc_mu=0;
-    double red_mu=0;
-
     fftw_complex * Psi = m_Psi[i];
     fftw_complex * Laplace_Psi = m_Laplace_Psi[i];
     double * pot = m_Potential[i];
 
+    double tmp=0;
+    #pragma omp parallel for reduction(+:tmp)
     for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
     {
       double NLpot=0;
       for ( int j=0; j<no_wf; j++ )
         NLpot += m_gs[j+i*no_wf]*(m_Psi[j][l][0]*m_Psi[j][l][0] + m_Psi[j][l][1]*m_Psi[j][l][1]);
 
-      loc_mu += -(Psi[l][0]*Laplace_Psi[l][0]+Psi[l][1]*Laplace_Psi[l][1]) + (pot[l]+NLpot)*(Psi[l][0]*Psi[l][0]+Psi[l][1]*Psi[l][1]);
+      tmp += -(Psi[l][0]*Laplace_Psi[l][0]+Psi[l][1]*Laplace_Psi[l][1]) + (pot[l]+NLpot)*(Psi[l][0]*Psi[l][0]+Psi[l][1]*Psi[l][1]);
     }
-
-    MPI_Allreduce(&loc_mu,&red_mu,1,MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    
-    m_mu[i] = m_fields[i]->Get_Ar()*red_mu;
+    loc_mu[i] = tmp;
   }
+
+  MPI_Allreduce(loc_mu,red_mu,no_wf,MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  for ( int i=0; i<no_wf; i++ )
+    m_mu[i] = m_fields[i]->Get_Ar()*red_mu[i];
 }
 
 template <class T, int dim, int no_wf>
 void CSOB_Base_MPI<T,dim,no_wf>::run()
 {
+  if ( m_use_cg )
+  {
+    run_cg();
+    return;
+  }
+
   Renormalize_All_Psi();
 
   int counter=0;
@@ -416,37 +536,356 @@ void CSOB_Base_MPI<T,dim,no_wf>::run()
     Project_Sobolev_Gradient();
     Compute_res();
 
+    Compute_Particle_Numbers();
+
     bool brenorm=false;
     for ( int i=0; i<no_wf; i++ )
     {
-      m_N[i] = Get_Particle_Number(i);
       if ( fabs(m_N[i]-1) > 1e-5 ) brenorm = brenorm || true;
-      cout << "N[" << i << "] = " << m_N[i] << endl;
+      if ( m_myrank == 0 ) cout << "N[" << i << "] = " << m_N[i] << endl;
     }
 
-    printf( "brenorm = %s\n", brenorm ? "true" : "false");
+    if ( m_myrank == 0 ) printf( "brenorm = %s\n", brenorm ? "true" : "false");
 
     if ( brenorm )
       Renormalize_All_Psi();
 
+    if ( m_anderson )
+    {
+      // restart if the extrapolation went astray, the history is rebuilt from plain steps
+      if ( counter > 0 && m_res_tot > 10*m_aa_res_min )
+      {
+        m_anderson->Reset();
+        if ( m_myrank == 0 ) cout << "Anderson restart" << endl;
+      }
+      if ( counter == 0 || m_res_tot < m_aa_res_min ) m_aa_res_min = m_res_tot;
+
+      std::array<double *,no_wf> x, g;
+      for ( int i=0; i<no_wf; i++ )
+      {
+        x[i] = reinterpret_cast<double *>(m_Psi[i]);
+        g[i] = reinterpret_cast<double *>(m_fields[i]->Get_p2_Data());
+      }
+      // inner products of the history are summed over all processes
+      m_anderson->Step( x, g, -m_stepsize, []( double *buf, int n )
+      {
+        MPI_Allreduce( MPI_IN_PLACE, buf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD );
+      } );
+      // the mixed iterate leaves the constraint manifold
+      Renormalize_All_Psi();
+    }
+    else
+    {
+      for ( int i=0; i<no_wf; i++ )
+      {
+        fftw_complex * sobgrad = m_fields[i]->Get_p2_Data();
+        fftw_complex * Psi = m_Psi[i];
+
+        #pragma omp parallel for
+        for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+        {
+          Psi[l][0] -= m_stepsize*sobgrad[l][0];
+          Psi[l][1] -= m_stepsize*sobgrad[l][1];
+        }
+      }
+    }
+
+    if ( m_myrank == 0 )
+    {
+      cout << "--- " << counter << endl;
+      cout << "res " << m_res_tot << endl;
+    }
+    counter++;
+  }
+  while ( m_res_tot > m_epsilon );
+}
+
+/** Nonlinear conjugate gradient version of run(), see CSOB_Base::run_cg()
+  */
+template <class T, int dim, int no_wf>
+void CSOB_Base_MPI<T,dim,no_wf>::run_cg()
+{
+  Renormalize_All_Psi();
+
+  int counter=0;
+  bool restart=true;
+  do
+  {
+    Compute_Sobolev_Psi();
+    Compute_Laplace();
+    Compute_Sobolev_Gradient();
+    Project_Sobolev_Gradient();
+    Compute_res();
+    Compute_CG_Direction( restart );
+
+    const double tau = Line_Search();
+    restart = (tau == 0);
+
+    if ( m_myrank == 0 )
+    {
+      cout << "--- " << counter << endl;
+      cout << "res " << m_res_tot << endl;
+      cout << "tau " << tau << endl;
+    }
+    counter++;
+  }
+  while ( m_res_tot > m_epsilon );
+}
+
+template <class T, int dim, int no_wf>
+void CSOB_Base_MPI<T,dim,no_wf>::Compute_CG_Direction( bool restart )
+{
+  double loc_tmp[] = {0,0};
+  double red_tmp[] = {0,0};
+
+  for ( int i=0; i<no_wf; i++ )
+  {
+    fftw_complex * r = m_L2_grad[i];
+    fftw_complex * g = m_fields[i]->Get_p2_Data();
+    fftw_complex * g_old = m_grad_old[i];
+
+    #pragma omp parallel for reduction(+:loc_tmp[:2])
+    for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+    {
+      loc_tmp[0] += r[l][0]*g[l][0] + r[l][1]*g[l][1];
+      loc_tmp[1] += r[l][0]*g_old[l][0] + r[l][1]*g_old[l][1];
+    }
+  }
+
+  MPI_Allreduce(loc_tmp,red_tmp,2,MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  const double rg = red_tmp[0];
+  double beta = 0;
+  if ( !restart && m_rg_old > 0 ) beta = std::max( 0.0, (rg-red_tmp[1])/m_rg_old );
+
+  double loc_rd=0, red_rd=0;
+  for ( int i=0; i<no_wf; i++ )
+  {
+    fftw_complex * r = m_L2_grad[i];
+    fftw_complex * g = m_fields[i]->Get_p2_Data();
+    fftw_complex * d = m_dir[i];
+    fftw_complex * Psi = m_Psi[i];
+    fftw_complex * Psi_sob = m_Psi_sob[i];
+
+    double fak=0;
+    if ( beta > 0 )
+    {
+      loc_tmp[0] = 0;
+      loc_tmp[1] = 0;
+      #pragma omp parallel for reduction(+:loc_tmp[:2])
+      for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+      {
+        loc_tmp[0] += Psi[l][0]*d[l][0] + Psi[l][1]*d[l][1];
+        loc_tmp[1] += Psi[l][0]*Psi_sob[l][0] + Psi[l][1]*Psi_sob[l][1];
+      }
+      MPI_Allreduce(loc_tmp,red_tmp,2,MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+      fak = red_tmp[0]/red_tmp[1];
+    }
+
+    #pragma omp parallel for reduction(+:loc_rd)
+    for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+    {
+      d[l][0] = -g[l][0] + beta*(d[l][0]-fak*Psi_sob[l][0]);
+      d[l][1] = -g[l][1] + beta*(d[l][1]-fak*Psi_sob[l][1]);
+      loc_rd += r[l][0]*d[l][0] + r[l][1]*d[l][1];
+    }
+  }
+
+  MPI_Allreduce(&loc_rd,&red_rd,1,MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  if ( beta > 0 && red_rd >= 0 )
+  {
     for ( int i=0; i<no_wf; i++ )
     {
-      fftw_complex * sobgrad = m_fields[i]->Get_p2_Data();
-      fftw_complex * Psi = m_Psi[i];
+      fftw_complex * g = m_fields[i]->Get_p2_Data();
+      fftw_complex * d = m_dir[i];
 
       #pragma omp parallel for
       for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
       {
-        Psi[l][0] -= m_stepsize*sobgrad[l][0];
-        Psi[l][1] -= m_stepsize*sobgrad[l][1];
+        d[l][0] = -g[l][0];
+        d[l][1] = -g[l][1];
       }
     }
+  }
 
-    cout << "--- " << counter << endl;
-    cout << "res " << m_res_tot << endl;
-    counter++;
+  for ( int i=0; i<no_wf; i++ )
+    Copy( m_grad_old[i], m_fields[i]->Get_p2_Data() );
+  m_rg_old = rg;
+}
+
+template <class T, int dim, int no_wf>
+double CSOB_Base_MPI<T,dim,no_wf>::Line_Search()
+{
+  // per wave function: q0,q1,q2,n0,n1,n2 followed by the density products p0..p4 for each pair
+  const int nq = 6*no_wf;
+  double loc_c[6*no_wf+5*no_wf*no_wf] = {};
+  double red_c[6*no_wf+5*no_wf*no_wf] = {};
+
+  for ( int i=0; i<no_wf; i++ )
+  {
+    fftw_complex * Psi = m_Psi[i];
+    fftw_complex * Laplace_Psi = m_Laplace_Psi[i];
+    fftw_complex * d = m_dir[i];
+    fftw_complex * in = m_fields[i]->Get_p2_Data();
+    fftw_complex * out = m_fields[i]->Get_p2_Data();
+    double * op = m_Laplace_operator_fs[i];
+    double * pot = m_Potential[i];
+
+    // Laplace d
+    Copy( in, d );
+    m_fields[i]->ft(-1);
+
+    #pragma omp parallel for
+    for ( ptrdiff_t l=0; l<m_no_of_pts_fs; l++ )
+    {
+      out[l][0] *= op[l];
+      out[l][1] *= op[l];
+    }
+
+    m_fields[i]->ft(1);
+
+    double * c = loc_c + 6*i;
+    #pragma omp parallel for reduction(+:c[:6])
+    for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+    {
+      const double pp = Psi[l][0]*Psi[l][0] + Psi[l][1]*Psi[l][1];
+      const double pd = Psi[l][0]*d[l][0] + Psi[l][1]*d[l][1];
+      const double dd = d[l][0]*d[l][0] + d[l][1]*d[l][1];
+      c[0] += -(Psi[l][0]*Laplace_Psi[l][0] + Psi[l][1]*Laplace_Psi[l][1]) + pot[l]*pp;
+      c[1] += -(d[l][0]*Laplace_Psi[l][0] + d[l][1]*Laplace_Psi[l][1]) + pot[l]*pd;
+      c[2] += -(d[l][0]*in[l][0] + d[l][1]*in[l][1]) + pot[l]*dd;
+      c[3] += pp;
+      c[4] += pd;
+      c[5] += dd;
+    }
   }
-  while ( m_res_tot > m_epsilon );
+
+  for ( int i=0; i<no_wf; i++ )
+  {
+    fftw_complex * Psi_i = m_Psi[i];
+    fftw_complex * d_i = m_dir[i];
+
+    for ( int j=i; j<no_wf; j++ )
+    {
+      fftw_complex * Psi_j = m_Psi[j];
+      fftw_complex * d_j = m_dir[j];
+
+      double * p = loc_c + nq + 5*(j+no_wf*i);
+      #pragma omp parallel for reduction(+:p[:5])
+      for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+      {
+        // rho = a + 2 tau b + tau^2 c
+        const double ai = Psi_i[l][0]*Psi_i[l][0] + Psi_i[l][1]*Psi_i[l][1];
+        const double bi = Psi_i[l][0]*d_i[l][0] + Psi_i[l][1]*d_i[l][1];
+        const double ci = d_i[l][0]*d_i[l][0] + d_i[l][1]*d_i[l][1];
+        const double aj = Psi_j[l][0]*Psi_j[l][0] + Psi_j[l][1]*Psi_j[l][1];
+        const double bj = Psi_j[l][0]*d_j[l][0] + Psi_j[l][1]*d_j[l][1];
+        const double cj = d_j[l][0]*d_j[l][0] + d_j[l][1]*d_j[l][1];
+        p[0] += ai*aj;
+        p[1] += 2*(ai*bj+bi*aj);
+        p[2] += ai*cj+ci*aj+4*bi*bj;
+        p[3] += 2*(bi*cj+ci*bj);
+        p[4] += ci*cj;
+      }
+    }
+  }
+
+  MPI_Allreduce(loc_c,red_c,6*no_wf+5*no_wf*no_wf,MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  for ( int i=0; i<no_wf; i++ )
+    for ( int j=0; j<i; j++ )
+      for ( int s=0; s<5; s++ )
+        red_c[nq+5*(j+no_wf*i)+s] = red_c[nq+5*(i+no_wf*j)+s];
+
+  auto energy = [&]( const double tau )
+  {
+    std::array<double,no_wf> S;
+    double E=0;
+    for ( int i=0; i<no_wf; i++ )
+    {
+      const double * c = red_c + 6*i;
+      S[i] = c[3] + tau*(2*c[4] + tau*c[5]);
+      E += (c[0] + tau*(2*c[1] + tau*c[2]))/S[i];
+    }
+    for ( int i=0; i<no_wf; i++ )
+      for ( int j=0; j<no_wf; j++ )
+      {
+        const double * p = red_c + nq + 5*(j+no_wf*i);
+        E += 0.5*m_gs[j+no_wf*i]*(p[0]+tau*(p[1]+tau*(p[2]+tau*(p[3]+tau*p[4]))))/(m_ar*S[i]*S[j]);
+      }
+    return E;
+  };
+
+  // bracket the minimum in (0,2 tau)
+  const double E0 = energy(0);
+  double tau = m_tau;
+  double E1 = energy(tau);
+  int k=0;
+  for ( ; E1 >= E0 && k<60; k++ )
+  {
+    tau *= 0.5;
+    E1 = energy(tau);
+  }
+  if ( E1 >= E0 ) return 0;
+
+  if ( k == 0 )
+  {
+    double E2 = energy(2*tau);
+    for ( ; E2 < E1 && k<60; k++ )
+    {
+      tau *= 2;
+      E1 = E2;
+      E2 = energy(2*tau);
+    }
+  }
+
+  // golden section search
+  const double gr = 0.5*(sqrt(5.0)-1);
+  double a=0, b=2*tau;
+  double x1 = b-gr*(b-a), x2 = a+gr*(b-a);
+  double f1 = energy(x1), f2 = energy(x2);
+  for ( int it=0; it<60 && (b-a) > 1e-10*tau; it++ )
+  {
+    if ( f1 < f2 )
+    {
+      b = x2;
+      x2 = x1;
+      f2 = f1;
+      x1 = b-gr*(b-a);
+      f1 = energy(x1);
+    }
+    else
+    {
+      a = x1;
+      x1 = x2;
+      f1 = f2;
+      x2 = a+gr*(b-a);
+      f2 = energy(x2);
+    }
+  }
+  tau = (f1 < f2) ? x1 : x2;
+  if ( energy(tau) >= E0 ) return 0;
+
+  // Psi <- (Psi + tau d)/|Psi + tau d|
+  for ( int i=0; i<no_wf; i++ )
+  {
+    fftw_complex * Psi = m_Psi[i];
+    fftw_complex * d = m_dir[i];
+    const double * c = red_c + 6*i;
+    const double fak = 1.0/sqrt(m_ar*(c[3] + tau*(2*c[4] + tau*c[5])));
+
+    #pragma omp parallel for
+    for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+    {
+      Psi[l][0] = fak*(Psi[l][0]+tau*d[l][0]);
+      Psi[l][1] = fak*(Psi[l][1]+tau*d[l][1]);
+    }
+    m_N[i] = 1;
+  }
+
+  m_tau = tau;
+  return tau;
 }
 
 template <class T, int dim, int no_wf>
@@ -456,7 +895,7 @@ double CSOB_Base_MPI<T,dim,no_wf>::Get_Particle_Number( const int comp )
 
   fftw_complex *Psi = m_Psi[comp];
   double retval=0, tmp=0;
-  #pragma omp parallel for reduction(+:retval)
+  #pragma omp parallel for reduction(+:tmp)
   for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
   {
     tmp += (Psi[l][0]*Psi[l][0] + Psi[l][1]*Psi[l][1]);
@@ -465,11 +904,35 @@ double CSOB_Base_MPI<T,dim,no_wf>::Get_Particle_Number( const int comp )
   return m_ar*retval;
 }
 
+/** Particle numbers of all components with a single MPI_Allreduce */
 template <class T, int dim, int no_wf>
-void CSOB_Base_MPI<T,dim,no_wf>::Renormalize_All_Psi()
+void CSOB_Base_MPI<T,dim,no_wf>::Compute_Particle_Numbers()
 {
+  double loc_N[no_wf] = {};
+  double red_N[no_wf] = {};
+
   for ( int i=0; i<no_wf; i++ )
-    m_N[i] = Get_Particle_Number( i );
+  {
+    fftw_complex *Psi = m_Psi[i];
+    double tmp=0;
+    #pragma omp parallel for reduction(+:tmp)
+    for ( ptrdiff_t l=0; l<m_no_of_pts; l++ )
+    {
+      tmp += (Psi[l][0]*Psi[l][0] + Psi[l][1]*Psi[l][1]);
+    }
+    loc_N[i] = tmp;
+  }
+
+  MPI_Allreduce(loc_N,red_N,no_wf,MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  for ( int i=0; i<no_wf; i++ )
+    m_N[i] = m_ar*red_N[i];
+}
+
+template <class T, int dim, int no_wf>
+void CSOB_Base_MPI<T,dim,no_wf>::Renormalize_All_Psi()
+{
+  Compute_Particle_Numbers();
 
   for ( int i=0; i<no_wf; i++ )
   {
@@ -0,0 +1,389 @@
+/* * ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+ * (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+ * founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+ * 50WM0942, 50WM1042, 50WM1342.
+ * Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+ *
+ * This file is part of ATUS2.
+ *
+ * ATUS2 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ATUS2 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __light_coupling_h__
+#define __light_coupling_h__
+
+#include <cassert>
+#include <complex>
+#include <cmath>
+#include "fftw3.h"
+
+/** Closed form propagators for the light-atom interaction
+  *
+  * A kernel computes \f$ \Psi \rightarrow \exp(-i\,dt\,H)\Psi \f$ at a single grid point for a
+  * small hermitian matrix \f$ H \f$. Which levels are coupled is fixed at compile time by the
+  * level structure, the matrix entries are passed per grid point:
+  *
+  * - V : diagonal entries (the layout is given by the structure, see no_of_diag)
+  * - w : off diagonal entries \f$ H_{j0} \f$ of the levels coupled to level 0 (no_of_offdiag)
+  * - Psi : pointers to the wave functions, Psi[0] is level 0 of the structure
+  *
+  * The kernels are header only and meant to be inlined in the loops of the OpenMP and the MPI solvers.
+  */
+namespace Coupling
+{
+  typedef std::complex<double> cplx;
+
+  /** Level 0 is coupled to the levels 1..N-1 which have the same diagonal entry
+    *
+    * Examples are single Bragg (N=2) or double Bragg (N=3) diffraction. The update is done in the
+    * basis of the bright state \f$ \sum_j w_j |j\rangle \f$ and the dark states, so only a 2x2 problem
+    * has to be solved for every N. Diagonal entries: V[0] level 0, V[1] levels 1..N-1.
+    */
+  template<int N>
+  struct Star
+  {
+    static_assert( N > 1, "A star needs at least two levels" );
+    static constexpr int no_of_levels = N;
+    static constexpr int no_of_diag = 2;
+    static constexpr int no_of_offdiag = N-1;
+  };
+
+  /** Level 0 is coupled to the levels 1 and 2 with different diagonal entries (e.g. Raman)
+    *
+    * Diagonal entries: V[0], V[1], V[2] for the levels 0, 1, 2.
+    */
+  struct Lambda
+  {
+    static constexpr int no_of_levels = 3;
+    static constexpr int no_of_diag = 3;
+    static constexpr int no_of_offdiag = 2;
+  };
+
+  /** Independent blocks, e.g. two species each driven by its own light field
+    *
+    * The entries of V, w and Psi are the concatenated entries of the blocks.
+    */
+  template<class... B>
+  struct Blocks;
+
+  template<class B>
+  struct Blocks<B>
+  {
+    static constexpr int no_of_levels = B::no_of_levels;
+    static constexpr int no_of_diag = B::no_of_diag;
+    static constexpr int no_of_offdiag = B::no_of_offdiag;
+  };
+
+  template<class B, class... R>
+  struct Blocks<B,R...>
+  {
+    static constexpr int no_of_levels = B::no_of_levels + Blocks<R...>::no_of_levels;
+    static constexpr int no_of_diag = B::no_of_diag + Blocks<R...>::no_of_diag;
+    static constexpr int no_of_offdiag = B::no_of_offdiag + Blocks<R...>::no_of_offdiag;
+  };
+
+  template<class S>
+  struct Kernel;
+
+  /** Psi[l] *= exp(-i dt V) */
+  inline void phase( const double dt, const double V, fftw_complex *Psi, const ptrdiff_t l )
+  {
+    double re1, im1, tmp1;
+    sincos( -dt*V, &im1, &re1 );
+    tmp1 = Psi[l][0];
+    Psi[l][0] = tmp1*re1-Psi[l][1]*im1;
+    Psi[l][1] = tmp1*im1+Psi[l][1]*re1;
+  }
+
+  template<int N>
+  struct Kernel<Star<N>>
+  {
+    static inline void apply( const double dt, const double *V, const cplx *w, fftw_complex * const *Psi, const ptrdiff_t l )
+    {
+      const double V11 = V[0];
+      const double V22 = V[1];
+
+      double Omega2 = 0;
+      for ( int j=0; j<N-1; j++ )
+        Omega2 += std::norm(w[j]);
+
+      // no light field: only diagonal phases
+      if ( Omega2 == 0.0 )
+      {
+        phase( dt, V11, Psi[0], l );
+        for ( int j=1; j<N; j++ )
+          phase( dt, V22, Psi[j], l );
+        return;
+      }
+
+      // Eigenvalues Ep and Em of the 2x2 problem (level 0, bright state)
+      const double tmp1 = sqrt((V11-V22)*(V11-V22)+4.0*Omega2);
+      const double Ep = 0.5*(V11+V22+tmp1);
+      const double Em = 0.5*(V11+V22-tmp1);
+      const double dp = V11-Ep;
+      const double dm = V11-Em;
+
+      // exp(-i*dt*E)/Norm
+      const cplx gamma_p = std::polar( 1.0/fabs(dp*dp+Omega2), -dt*Ep );
+      const cplx gamma_m = std::polar( 1.0/fabs(dm*dm+Omega2), -dt*Em );
+      const cplx dark = std::polar( 1.0, -dt*V22 );
+
+      // u00, u01/Omega, (u11-dark)/Omega^2 of the 2x2 propagator
+      const cplx u00 = Omega2*(gamma_p+gamma_m);
+      const cplx u01 = -(dp*gamma_p+dm*gamma_m);
+      const cplx u11 = (dp*dp*gamma_p+dm*dm*gamma_m-dark)/Omega2;
+
+      cplx Psi_alt[N];
+      for ( int j=0; j<N; j++ )
+        Psi_alt[j] = cplx(Psi[j][l][0],Psi[j][l][1]);
+
+      // projection onto the bright state (times Omega)
+      cplx b = 0;
+      for ( int j=1; j<N; j++ )
+        b += std::conj(w[j-1])*Psi_alt[j];
+
+      const cplx Psi_neu = u00*Psi_alt[0] + u01*b;
+      Psi[0][l][0] = real(Psi_neu);
+      Psi[0][l][1] = imag(Psi_neu);
+
+      const cplx c = u01*Psi_alt[0] + u11*b;
+      for ( int j=1; j<N; j++ )
+      {
+        const cplx tmp = dark*Psi_alt[j] + w[j-1]*c;
+        Psi[j][l][0] = real(tmp);
+        Psi[j][l][1] = imag(tmp);
+      }
+    }
+  };
+
+  template<>
+  struct Kernel<Lambda>
+  {
+    static inline void apply( const double dt, const double *V, const cplx *w, fftw_complex * const *Psi, const ptrdiff_t l )
+    {
+      const double a = V[0];
+      const double b1 = V[1];
+      const double b2 = V[2];
+      const double W1 = std::norm(w[0]);
+      const double W2 = std::norm(w[1]);
+
+      // degenerate cases are handled by the star kernel
+      if ( W2 == 0.0 )
+      {
+        const double Vs[] = {a, b1};
+        Kernel<Star<2>>::apply( dt, Vs, w, Psi, l );
+        phase( dt, b2, Psi[2], l );
+        return;
+      }
+      if ( W1 == 0.0 )
+      {
+        const double Vs[] = {a, b2};
+        fftw_complex * const Ps[] = {Psi[0], Psi[2]};
+        Kernel<Star<2>>::apply( dt, Vs, w+1, Ps, l );
+        phase( dt, b1, Psi[1], l );
+        return;
+      }
+      if ( b1 == b2 )
+      {
+        const double Vs[] = {a, b1};
+        Kernel<Star<3>>::apply( dt, Vs, w, Psi, l );
+        return;
+      }
+
+      // eigenvalues of the arrow matrix (trigonometric solution of the characteristic polynomial)
+      const double q = (a+b1+b2)/3.0;
+      const double a_ = a-q, b1_ = b1-q, b2_ = b2-q;
+      const double p = sqrt( (a_*a_+b1_*b1_+b2_*b2_+2.0*(W1+W2))/6.0 );
+      double r = 0.5*(a_*b1_*b2_-W1*b2_-W2*b1_)/(p*p*p);
+      if ( r > 1 ) r = 1;
+      if ( r < -1 ) r = -1;
+      const double phi = acos(r)/3.0;
+
+      double E[3];
+      E[0] = q+2.0*p*cos(phi);
+      E[1] = q+2.0*p*cos(phi+2.0*M_PI/3.0);
+      E[2] = 3.0*q-E[0]-E[1];
+
+      cplx Psi_alt[3], Psi_neu[3];
+      for ( int j=0; j<3; j++ )
+        Psi_alt[j] = cplx(Psi[j][l][0],Psi[j][l][1]);
+
+      // sum over the eigenvectors v = ((E-b1)(E-b2), w1(E-b2), w2(E-b1))
+      for ( int k=0; k<3; k++ )
+      {
+        const double d1 = E[k]-b1;
+        const double d2 = E[k]-b2;
+        const cplx v[] = {d1*d2, w[0]*d2, w[1]*d1};
+        const double norm = d1*d1*d2*d2 + W1*d2*d2 + W2*d1*d1;
+
+        const cplx c = std::polar( 1.0/norm, -dt*E[k] ) * (v[0]*Psi_alt[0] + std::conj(v[1])*Psi_alt[1] + std::conj(v[2])*Psi_alt[2]);
+        for ( int j=0; j<3; j++ )
+          Psi_neu[j] += c*v[j];
+      }
+
+      for ( int j=0; j<3; j++ )
+      {
+        Psi[j][l][0] = real(Psi_neu[j]);
+        Psi[j][l][1] = imag(Psi_neu[j]);
+      }
+    }
+  };
+
+  template<class B>
+  struct Kernel<Blocks<B>>
+  {
+    static inline void apply( const double dt, const double *V, const cplx *w, fftw_complex * const *Psi, const ptrdiff_t l )
+    {
+      Kernel<B>::apply( dt, V, w, Psi, l );
+    }
+  };
+
+  template<class B, class... R>
+  struct Kernel<Blocks<B,R...>>
+  {
+    static inline void apply( const double dt, const double *V, const cplx *w, fftw_complex * const *Psi, const ptrdiff_t l )
+    {
+      Kernel<B>::apply( dt, V, w, Psi, l );
+      Kernel<Blocks<R...>>::apply( dt, V+B::no_of_diag, w+B::no_of_offdiag, Psi+B::no_of_levels, l );
+    }
+  };
+
+  /** Propagates the grid point l with the kernel of the level structure S */
+  template<class S>
+  inline void apply( const double dt, const double *V, const cplx *w, fftw_complex * const *Psi, const ptrdiff_t l )
+  {
+    Kernel<S>::apply( dt, V, w, Psi, l );
+  }
+
+  /// Maximal number of levels of a chain
+  constexpr int max_chain = 64;
+
+  /** Eigenvalues d and eigenvectors z (columns, row major n x n) of a real symmetric tridiagonal matrix
+    *
+    * Implicit QL algorithm. d holds the diagonal, e[0..n-2] the off diagonal entries (e is destroyed),
+    * z has to be the identity on input.
+    */
+  inline void tridiag_ql( const int n, double *d, double *e, double *z )
+  {
+    e[n-1] = 0;
+    for ( int l=0; l<n; l++ )
+    {
+      int iter=0, m;
+      do
+      {
+        for ( m=l; m<n-1; m++ )
+        {
+          const double dd = fabs(d[m])+fabs(d[m+1]);
+          if ( fabs(e[m]) <= 1e-15*dd ) break;
+        }
+        if ( m != l )
+        {
+          if ( iter++ == 60 ) break;
+          double g = (d[l+1]-d[l])/(2.0*e[l]);
+          double r = hypot(g,1.0);
+          g = d[m]-d[l]+e[l]/(g+copysign(r,g));
+          double s=1, c=1, p=0;
+          int i;
+          for ( i=m-1; i>=l; i-- )
+          {
+            double f = s*e[i];
+            const double b = c*e[i];
+            e[i+1] = (r = hypot(f,g));
+            if ( r == 0.0 )
+            {
+              d[i+1] -= p;
+              e[m] = 0;
+              break;
+            }
+            s = f/r;
+            c = g/r;
+            g = d[i+1]-p;
+            r = (d[i]-g)*s+2.0*c*b;
+            d[i+1] = g+(p=s*r);
+            g = c*r-b;
+            for ( int k=0; k<n; k++ )
+            {
+              f = z[k*n+i+1];
+              z[k*n+i+1] = s*z[k*n+i]+c*f;
+              z[k*n+i] = c*z[k*n+i]-s*f;
+            }
+          }
+          if ( r == 0.0 && i >= l ) continue;
+          d[l] -= p;
+          e[l] = g;
+          e[m] = 0;
+        }
+      }
+      while ( m != l );
+    }
+  }
+
+  /** Levels 0..n-1 where each level is coupled to its neighbours, e.g. the momentum families of Bragg diffraction
+    *
+    * In contrast to the kernels above the number of levels is only known at run time and the
+    * propagator is computed by a numerical diagonalisation. The complex off diagonal entries are
+    * removed by a diagonal phase transformation, the remaining real symmetric tridiagonal matrix
+    * is diagonalised with tridiag_ql().
+    *
+    * @param n number of levels (at most #max_chain)
+    * @param V diagonal entries V[0..n-1]
+    * @param w off diagonal entries \f$ w_j = H_{j+1,j} \f$, j=0..n-2
+    */
+  inline void chain( const double dt, const int n, const double *V, const cplx *w, fftw_complex * const *Psi, const ptrdiff_t l )
+  {
+    assert( n > 0 && n <= max_chain );
+
+    double d[max_chain], e[max_chain], z[max_chain*max_chain];
+    cplx gauge[max_chain], c[max_chain];
+
+    // H = D T D^+ with D = diag(gauge) and T real
+    gauge[0] = 1;
+    for ( int j=0; j<n-1; j++ )
+    {
+      const double a = std::abs(w[j]);
+      e[j] = a;
+      gauge[j+1] = ( a > 0 ) ? gauge[j]*w[j]/a : gauge[j];
+    }
+    for ( int j=0; j<n; j++ )
+    {
+      d[j] = V[j];
+      for ( int k=0; k<n; k++ )
+        z[j*n+k] = ( j == k ) ? 1 : 0;
+    }
+
+    tridiag_ql( n, d, e, z );
+
+    // c = exp(-i dt E) Z^T D^+ Psi
+    for ( int k=0; k<n; k++ )
+    {
+      cplx sum = 0;
+      for ( int j=0; j<n; j++ )
+        sum += z[j*n+k]*std::conj(gauge[j])*cplx(Psi[j][l][0],Psi[j][l][1]);
+      c[k] = std::polar( 1.0, -dt*d[k] )*sum;
+    }
+
+    // Psi = D Z c
+    for ( int j=0; j<n; j++ )
+    {
+      cplx sum = 0;
+      for ( int k=0; k<n; k++ )
+        sum += z[j*n+k]*c[k];
+      sum *= gauge[j];
+      Psi[j][l][0] = real(sum);
+      Psi[j][l][1] = imag(sum);
+    }
+  }
+}
+
+#endif
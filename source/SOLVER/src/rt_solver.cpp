@@ -37,6 +37,7 @@
 #include "muParser.h"
 #include "ParameterHandler.h"
 #include "CRT_Base.h"
+#include "thread_setup.h"
 
 using namespace std;
 
@@ -156,13 +157,12 @@ int main( int argc, char *argv[] )
     cout << "Errc:     " << e.GetCode() << "\n";
   }
 
-  int no_of_threads = 4;
-  char *envstr = getenv( "MY_NO_OF_THREADS" );
-  if ( envstr != nullptr ) no_of_threads = atoi( envstr );
+  int no_of_threads = Get_No_Of_Threads();
 
   fftw_init_threads();
   fftw_plan_with_nthreads( no_of_threads );
   omp_set_num_threads( no_of_threads );
+  Place_Threads();
 
   try
   {
@@ -0,0 +1,247 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/** Memory traffic of one steepest descent iteration of CSOB_Base
+  *
+  * Compares the separate point wise passes (Compute_Sobolev_Gradient, Project_Sobolev_Gradient,
+  * Compute_res, Get_Particle_Number and the update loop) with the fused sweeps of CSOB_Base::Fused_Step.
+  * The bytes moved are counted per pass (every array read or written once), the transforms are the
+  * same for both and not counted. Potential and initial guess are those of a harmonic trap, the grid and
+  * the nonlinearities are read from the xml file.
+  *
+  * sob_bench file.xml [iterations]
+  */
+
+#include <cstdio>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <chrono>
+#include <omp.h>
+#include "cft_1d.h"
+#include "cft_2d.h"
+#include "cft_3d.h"
+#include "rft_1d.h"
+#include "rft_2d.h"
+#include "rft_3d.h"
+#include "ParameterHandler.h"
+#include "CSOB_Base.h"
+#include "thread_setup.h"
+
+using namespace std;
+
+namespace SOB_Bench
+{
+  template<class T,int dim,int no_wf>
+  class CSOB_Bench : public CSOB_Base<T,dim,no_wf>
+  {
+  public:
+    CSOB_Bench( ParameterHandler * );
+
+    void Step_Unfused();
+    void Step_Fused() { this->Fused_Step( m_stepsize ); }
+
+    double Bytes_Unfused() const;
+    double Bytes_Fused() const;
+    double Get_res() const { return m_res_tot; }
+  protected:
+    using CSOB_Base<T,dim,no_wf>::m_no_of_pts;
+    using CSOB_Base<T,dim,no_wf>::m_no_of_pts_fs;
+    using CSOB_Base<T,dim,no_wf>::m_nc;
+    using CSOB_Base<T,dim,no_wf>::m_fields;
+    using CSOB_Base<T,dim,no_wf>::m_Potential;
+    using CSOB_Base<T,dim,no_wf>::m_Psi;
+    using CSOB_Base<T,dim,no_wf>::m_grad;
+    using CSOB_Base<T,dim,no_wf>::m_N;
+    using CSOB_Base<T,dim,no_wf>::m_stepsize;
+    using CSOB_Base<T,dim,no_wf>::m_res_tot;
+  };
+
+  template<class T,int dim,int no_wf>
+  CSOB_Bench<T,dim,no_wf>::CSOB_Bench( ParameterHandler *p ) : CSOB_Base<T,dim,no_wf>( p )
+  {
+    #pragma omp parallel for
+    for ( int l=0; l<m_no_of_pts; l++ )
+    {
+      CPoint<dim> x = m_fields[0]->Get_x(l);
+      const double r2 = x*x;
+      for ( int i=0; i<no_wf; i++ )
+      {
+        m_Potential[i][l] = 0.5*r2;
+        this->Set_Psi( i, l, exp(-0.5*r2) );
+      }
+    }
+    this->Renormalize_All_Psi();
+  }
+
+  /// the sequence of passes of CSOB_Base::run() before the fusion
+  template<class T,int dim,int no_wf>
+  void CSOB_Bench<T,dim,no_wf>::Step_Unfused()
+  {
+    this->Compute_Laplace_and_Sobolev_Psi();
+    this->Compute_Sobolev_Gradient();
+    this->Project_Sobolev_Gradient();
+    this->Compute_res();
+
+    bool brenorm=false;
+    for ( int i=0; i<no_wf; i++ )
+    {
+      m_N[i] = this->Get_Particle_Number(i);
+      if ( fabs(m_N[i]-1) > 1e-5 ) brenorm = true;
+    }
+    if ( brenorm ) this->Renormalize_All_Psi();
+
+    const int64_t nf = m_nc*int64_t(m_no_of_pts);
+    for ( int i=0; i<no_wf; i++ )
+    {
+      double *sobgrad = this->Flat(m_grad[i]);
+      double *Psi = this->Flat(m_Psi[i]);
+
+      #pragma omp parallel for
+      for ( int64_t l=0; l<nf; l++ )
+        Psi[l] -= m_stepsize*sobgrad[l];
+    }
+  }
+
+  /** Bytes moved by the point wise passes of Step_Unfused per iteration
+    *
+    * Per component: k space loop of Compute_Laplace_and_Sobolev_Psi (K: out, ks, two operators),
+    * L2 gradient (no_wf Psi, Laplace Psi, potential, gradient), k space loop of the gradient,
+    * projection (3 reads, then 2 reads 1 write), residual, particle number, update (2 reads 1 write).
+    */
+  template<class T,int dim,int no_wf>
+  double CSOB_Bench<T,dim,no_wf>::Bytes_Unfused() const
+  {
+    const double F = double(m_nc)*m_no_of_pts*sizeof(double);
+    const double K = double(m_no_of_pts_fs)*sizeof(fftw_complex);
+    const double V = double(m_no_of_pts)*sizeof(double);
+    return no_wf*( (3*K + K) + ((no_wf+2)*F + V) + (2*K + K/2) + 6*F + F + F + 3*F );
+  }
+
+  /** Bytes moved by the point wise passes of CSOB_Base::Fused_Step per iteration
+    *
+    * Per component: k space loop of Compute_Laplace_and_Sobolev_Psi, Compute_L2_Gradient
+    * (Psi, Laplace Psi, Psi_sob, potential, gradient), k space loop of the gradient and
+    * Project_and_Update (Psi, Psi_sob and the gradient read, Psi and gradient written).
+    */
+  template<class T,int dim,int no_wf>
+  double CSOB_Bench<T,dim,no_wf>::Bytes_Fused() const
+  {
+    const double F = double(m_nc)*m_no_of_pts*sizeof(double);
+    const double K = double(m_no_of_pts_fs)*sizeof(fftw_complex);
+    const double V = double(m_no_of_pts)*sizeof(double);
+    return no_wf*( (3*K + K) + (4*F + V) + (2*K + K/2) + 5*F );
+  }
+
+  template<class T,int dim,int no_wf>
+  void Run_Bench( ParameterHandler &params, const int iter )
+  {
+    for ( int fused=0; fused<2; fused++ )
+    {
+      CSOB_Bench<T,dim,no_wf> sol( &params );
+
+      auto t0 = std::chrono::steady_clock::now();
+      for ( int k=0; k<iter; k++ )
+      {
+        if ( fused )
+          sol.Step_Fused();
+        else
+          sol.Step_Unfused();
+      }
+      auto t1 = std::chrono::steady_clock::now();
+      const double t = std::chrono::duration<double>(t1-t0).count()/iter;
+
+      const double bytes = fused ? sol.Bytes_Fused() : sol.Bytes_Unfused();
+      printf( "%d component(s), %-8s %10.3f MB/iteration %10.3f ms/iteration res = %g\n", no_wf, fused ? "fused" : "unfused", bytes/1048576.0, 1e3*t, sol.Get_res() );
+    }
+  }
+
+  template<class T,int dim>
+  void Run_Bench( ParameterHandler &params, const int iter )
+  {
+    Run_Bench<T,dim,1>( params, iter );
+    Run_Bench<T,dim,2>( params, iter );
+  }
+}
+
+int main( int argc, char *argv[] )
+{
+  if ( argc < 2 )
+  {
+    printf( "No parameter xml file specified.\n" );
+    return EXIT_FAILURE;
+  }
+
+  ParameterHandler params(argv[1]);
+  const int iter = (argc > 2) ? atoi(argv[2]) : 20;
+  const int dim = std::stod(params.Get_simulation("DIM"));
+
+  int no_of_threads = Get_No_Of_Threads();
+
+  fftw_init_threads();
+  fftw_plan_with_nthreads( no_of_threads );
+  omp_set_num_threads( no_of_threads );
+  Place_Threads();
+
+  bool real_field = true;
+  try
+  {
+    real_field = (params.Get_simulation("FIELD") != "complex");
+  }
+  catch (std::string &)
+  {
+  }
+
+  try
+  {
+    if ( dim == 1 )
+    {
+      if ( real_field )
+        SOB_Bench::Run_Bench<Fourier::rft_1d,1>( params, iter );
+      else
+        SOB_Bench::Run_Bench<Fourier::cft_1d,1>( params, iter );
+    }
+    else if ( dim == 2 )
+    {
+      if ( real_field )
+        SOB_Bench::Run_Bench<Fourier::rft_2d,2>( params, iter );
+      else
+        SOB_Bench::Run_Bench<Fourier::cft_2d,2>( params, iter );
+    }
+    else if ( dim == 3 )
+    {
+      if ( real_field )
+        SOB_Bench::Run_Bench<Fourier::rft_3d,3>( params, iter );
+      else
+        SOB_Bench::Run_Bench<Fourier::cft_3d,3>( params, iter );
+    }
+  }
+  catch (std::string &str)
+  {
+    cout << str << endl;
+  }
+
+  fftw_cleanup_threads();
+  return EXIT_SUCCESS;
+}
@@ -29,9 +29,13 @@
 #include "cft_1d.h"
 #include "cft_2d.h"
 #include "cft_3d.h"
+#include "rft_1d.h"
+#include "rft_2d.h"
+#include "rft_3d.h"
 #include "muParser.h"
 #include "ParameterHandler.h"
 #include "CSOB_Base.h"
+#include "thread_setup.h"
 
 using namespace std;
 
@@ -41,7 +45,7 @@ namespace SOB_Solver
   class CSOB_Min : public CSOB_Base<T,dim,1>
   {
   public:
-    CSOB_Min( ParameterHandler * );
+    CSOB_Min( ParameterHandler *, const int=0 );
 
     void Setup_Guess();
     void Setup_Potential();
@@ -51,10 +55,11 @@ namespace SOB_Solver
     using CSOB_Base<T,dim,1>::m_fields;
     using CSOB_Base<T,dim,1>::m_Psi;
     using CSOB_Base<T,dim,1>::m_Potential;
+    using CSOB_Base<T,dim,1>::Set_Psi;
   };
 
   template<class T,int dim>
-  CSOB_Min<T,dim>::CSOB_Min( ParameterHandler *p ) : CSOB_Base<T,dim,1>( p )
+  CSOB_Min<T,dim>::CSOB_Min( ParameterHandler *p, const int level ) : CSOB_Base<T,dim,1>( p, level )
   {
     Setup_Guess();
     Setup_Potential();
@@ -134,8 +139,7 @@ namespace SOB_Solver
         for ( int l=0; l<m_no_of_pts; l++ )
         {
           x = m_fields[0]->Get_x(l);
-          m_Psi[0][l][0] = loc_mup.Eval();
-          m_Psi[0][l][1] = 0;
+          Set_Psi( 0, l, loc_mup.Eval() );
         }
       }
       catch (mu::Parser::exception_type &e)
@@ -148,6 +152,44 @@ namespace SOB_Solver
       }
     }
   }
+
+  /** Computes the ground state on the field type T and saves it
+    *
+    * The real transforms (rft_*) halve memory and transform work, potentials and guesses are real
+    * hence so is the ground state. SIMULATION/FIELD = complex selects the complex transforms (cft_*).
+    *
+    * With SIMULATION/GS_CACHE = directory the run starts from the nearest cached ground state
+    * (see CGS_Cache) instead of the guess and the coarse levels, the result is added to the cache.
+    */
+  template<class T,int dim>
+  void Run_Solver( ParameterHandler &params, std::vector<std::string> &filenames )
+  {
+    CSOB_Min<T,dim> sol( &params );
+
+    // SIMULATION/GS_CACHE: start from the nearest converged state of earlier runs
+    std::unique_ptr<CGS_Cache> cache;
+    try
+    {
+      cache.reset( new CGS_Cache( params.Get_simulation("GS_CACHE"), &params, dim, 1 ) );
+    }
+    catch (std::string &)
+    {
+    }
+
+    if ( cache && sol.Warm_Start( *cache ) )
+      sol.run();
+    else
+      Run_Coarse_To_Fine( sol, &params );
+
+    sol.Save(filenames,true); // true -> scale the wavefunction to N
+    sol.Save_Zero();
+
+    if ( cache )
+    {
+      sol.Save( cache->Entry_Files() );
+      cache->Commit();
+    }
+  }
 }
 
 int main( int argc, char *argv[] )
@@ -175,39 +217,47 @@ int main( int argc, char *argv[] )
     cout << "Errc:     " << e.GetCode() << "\n";
   }
 
-  int no_of_threads = 4;
-  char *envstr = getenv( "MY_NO_OF_THREADS" );
-  if ( envstr != nullptr ) no_of_threads = atoi( envstr );
+  int no_of_threads = Get_No_Of_Threads();
 
   fftw_init_threads();
   fftw_plan_with_nthreads( no_of_threads );
   omp_set_num_threads( no_of_threads );
+  Place_Threads();
 
   vector<string> filenames;
   filenames.push_back(params.Get_simulation("FILENAME"));
 
+  bool real_field = true;
+  try
+  {
+    real_field = (params.Get_simulation("FIELD") != "complex");
+  }
+  catch (std::string &)
+  {
+  }
+
   try
   {
     if ( dim == 1 )
     {
-      SOB_Solver::CSOB_Min<Fourier::cft_1d,1> sol( &params );
-      sol.run();
-      sol.Save(filenames,true); // true -> scale the wavefunction to N
-      sol.Save_Zero();
+      if ( real_field )
+        SOB_Solver::Run_Solver<Fourier::rft_1d,1>( params, filenames );
+      else
+        SOB_Solver::Run_Solver<Fourier::cft_1d,1>( params, filenames );
     }
     else if ( dim == 2 )
     {
-      SOB_Solver::CSOB_Min<Fourier::cft_2d,2> sol( &params );
-      sol.run();
-      sol.Save(filenames,true); // true -> scale the wavefunction to N
-      sol.Save_Zero();
+      if ( real_field )
+        SOB_Solver::Run_Solver<Fourier::rft_2d,2>( params, filenames );
+      else
+        SOB_Solver::Run_Solver<Fourier::cft_2d,2>( params, filenames );
     }
     else if ( dim == 3 )
     {
-      SOB_Solver::CSOB_Min<Fourier::cft_3d,3> sol( &params );
-      sol.run();
-      sol.Save(filenames,true); // true -> scale the wavefunction to N
-      sol.Save_Zero();
+      if ( real_field )
+        SOB_Solver::Run_Solver<Fourier::rft_3d,3>( params, filenames );
+      else
+        SOB_Solver::Run_Solver<Fourier::cft_3d,3>( params, filenames );
     }
     else
     {
@@ -23,11 +23,13 @@
 
 #include <cstdio>
 #include <cmath>
+#include <omp.h>
 #include "cft_2d_MPI.h"
 #include "cft_3d_MPI.h"
 #include "muParser.h"
 #include "ParameterHandler.h"
 #include "CSOB_Base_mpi.h"
+#include "thread_setup.h"
 
 using namespace std;
 
@@ -154,8 +156,21 @@ int main( int argc, char *argv[] )
     cout << "Errc:     " << e.GetCode() << "\n";
   }
 
-  MPI_Init(&argc, &argv);
+  // hybrid mode: a few ranks per node, each with MY_NO_OF_THREADS threads;
+  // only the master thread calls MPI
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+
+  int no_of_threads = Get_No_Of_Threads();
+
+  if ( provided < MPI_THREAD_FUNNELED ) no_of_threads = 1;
+
+  // the threaded fftw has to be initialised before the fftw_mpi plans are created
+  fftw_init_threads();
   fftw_mpi_init();
+  fftw_plan_with_nthreads( no_of_threads );
+  omp_set_num_threads( no_of_threads );
+  Place_Threads();
 
   vector<string> filenames;
   filenames.push_back(params.Get_simulation("FILENAME"));
@@ -192,6 +207,8 @@ int main( int argc, char *argv[] )
     cout << str << endl;
   }
 
+  fftw_mpi_cleanup();
+  fftw_cleanup_threads();
   MPI_Finalize();
   return EXIT_SUCCESS;
 }
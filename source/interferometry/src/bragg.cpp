@@ -36,6 +36,10 @@
 #include "muParser.h"
 #include "ParameterHandler.h"
 #include "CRT_Base_IF.h"
+#include "CRT_Base_IF_ensemble.h"
+#include "CRT_Base_IF_family.h"
+#include "light_coupling.h"
+#include "thread_setup.h"
 
 using namespace std;
 
@@ -193,11 +197,9 @@ namespace RT_Solver
       const double t1 = this->Get_t()+0.5*dt;
 
       //Pointer to m_fields
-      fftw_complex *Psi_1 = this->m_fields[0]->Getp2In();
-      fftw_complex *Psi_2 = this->m_fields[1]->Getp2In();
+      fftw_complex * const Psi[] = { this->m_fields[0]->Getp2In(), this->m_fields[1]->Getp2In() };
 
-      fftw_complex O11, O12, O21, O22, gamma_p, gamma_m, eta;
-      double re1, im1, tmp1, tmp2, V11, V22, Ep, Em, Omega;
+      double tmp1, tmp2, Omega, V[2];
 
       //x coordinate
       CPoint<dim> x;
@@ -205,100 +207,43 @@ namespace RT_Solver
       // Pulseshapes in time
       double F = this->Amplitude_at_time();
 
-      //Loop over all grid points
+      //Number of points with the same x coordinate (one x-line)
+      const int nyz = this->Get_dimY()*this->Get_dimZ();
+      const int nx = this->m_no_of_pts/nyz;
+
+      //Loop over all x-lines
       #pragma omp for
-      for ( int l=0; l<this->m_no_of_pts; l++ )
+      for ( int i=0; i<nx; i++ )
       {
-        //Get x position
-        x = this->m_fields[0]->Get_x(l);
+        const int l0 = i*nyz;
 
-        //Calculate density at point x
-        tmp1 = Psi_1[l][0]*Psi_1[l][0]+Psi_1[l][1]*Psi_1[l][1];
-        tmp2 = Psi_2[l][0]*Psi_2[l][0]+Psi_2[l][1]*Psi_2[l][1];
+        //Get x position of this line
+        x = this->m_fields[0]->Get_x(l0);
 
-        //Compute self interaction (nonlinear terms)
-        V11 = this->m_gs[0]*tmp1+this->m_gs[1]*tmp2+beta[0]*x[0];
-        V22 = this->m_gs[2]*tmp1+this->m_gs[3]*tmp2-DeltaL[1]+beta[0]*x[0];
+        //Gravitation and light field only depend on x[0]
+        //and are therefore evaluated once per line
+        const double Vx = beta[0]*x[0];
 
         //Compute light field
         Omega = F*Amp[0]*cos(laser_k[0]*x[0]-(laser_domh[0]+chirp*t1+chirp_rate[0]*t1)*t1+phase[0]/2);
 
-        //Problem: If Omega = 0 division by 0.
-        //Therefore compute case without light field (Omega=0) seperately
-        if ( Omega == 0.0 )
-        {
-          sincos( -dt*V11, &im1, &re1 );
-          tmp1 = Psi_1[l][0];
-          Psi_1[l][0] = tmp1*re1-Psi_1[l][1]*im1;
-          Psi_1[l][1] = tmp1*im1+Psi_1[l][1]*re1;
-
-          sincos( -dt*V22, &im1, &re1 );
-          tmp1 = Psi_2[l][0];
-          Psi_2[l][0] = tmp1*re1-Psi_2[l][1]*im1;
-          Psi_2[l][1] = tmp1*im1+Psi_2[l][1]*re1;
-          continue;
-        }
-
-        //exp(-0.5*i(dk*x+phi))
-        sincos( -0.5*(laser_dk[0]*x[0]), &im1, &re1 );
-        eta[0] = re1;
-        eta[1] = im1;
-
-        //Eigenvalues Ep and Em
-        tmp1 = sqrt((V11-V22)*(V11-V22)+4.0*Omega*Omega);
-        Ep = 0.5*(V11+V22+tmp1);
-        Em = 0.5*(V11+V22-tmp1);
-
-        //exp(-i*(dt*Ep))/Norm
-        sincos( -dt*Ep, &im1, &re1 );
-        tmp1 = 1.0/fabs((V11-Ep)*(V11-Ep)+Omega*Omega);
-        gamma_p[0] = tmp1*re1;
-        gamma_p[1] = tmp1*im1;
-
-        //exp(-i*(dt*Em))/Norm
-        sincos( -dt*Em, &im1, &re1 );
-        tmp1 = 1.0/fabs((V11-Em)*(V11-Em)+Omega*Omega);
-        gamma_m[0] = tmp1*re1;
-        gamma_m[1] = tmp1*im1;
+        //H_21 = Omega*exp(0.5*i*dk*x)
+        const Coupling::cplx w[] = { Omega*std::polar( 1.0, 0.5*laser_dk[0]*x[0] ) };
 
-        //H_11 element
-        tmp1 = Omega*Omega;
-        O11[0] = tmp1*(gamma_p[0]+gamma_m[0]);
-        O11[1] = tmp1*(gamma_p[1]+gamma_m[1]);
-
-        tmp1 = V11-Ep;
-        tmp2 = V11-Em;
-
-        //H_22 element
-        O22[0] = tmp1*tmp1*gamma_p[0]+tmp2*tmp2*gamma_m[0];
-        O22[1] = tmp1*tmp1*gamma_p[1]+tmp2*tmp2*gamma_m[1];
-
-        //H_12 and H_21 element
-        O12[0] = -Omega*(tmp1*gamma_p[0]+tmp2*gamma_m[0]);
-        O12[1] = -Omega*(tmp1*gamma_p[1]+tmp2*gamma_m[1]);
-
-        O21[0] = O12[0];
-        O21[1] = O12[1];
-
-        tmp1 = O12[0];
-        O12[0] = eta[0]*tmp1-eta[1]*O12[1];
-        O12[1] = eta[1]*tmp1+eta[0]*O12[1];
-
-        tmp1 = O21[0];
-        O21[0] = eta[0]*tmp1+eta[1]*O21[1];
-        O21[1] = eta[0]*O21[1]-eta[1]*tmp1;
-
-        //H*Psi (matrix * vector)
-        gamma_p[0] = Psi_1[l][0];
-        gamma_p[1] = Psi_1[l][1];
-        gamma_m[0] = Psi_2[l][0];
-        gamma_m[1] = Psi_2[l][1];
+        //Loop over all grid points of the line
+        for ( int l=l0; l<l0+nyz; l++ )
+        {
+          //Calculate density at point x
+          tmp1 = Psi[0][l][0]*Psi[0][l][0]+Psi[0][l][1]*Psi[0][l][1];
+          tmp2 = Psi[1][l][0]*Psi[1][l][0]+Psi[1][l][1]*Psi[1][l][1];
 
-        Psi_1[l][0] = (O11[0]*gamma_p[0]-O11[1]*gamma_p[1]) + (O12[0]*gamma_m[0]-O12[1]*gamma_m[1]);
-        Psi_1[l][1] = (O11[0]*gamma_p[1]+O11[1]*gamma_p[0]) + (O12[0]*gamma_m[1]+O12[1]*gamma_m[0]);
+          //Compute self interaction (nonlinear terms)
+          V[0] = this->m_gs[0]*tmp1+this->m_gs[1]*tmp2+Vx;
+          V[1] = this->m_gs[2]*tmp1+this->m_gs[3]*tmp2-DeltaL[1]+Vx;
 
-        Psi_2[l][0] = (O21[0]*gamma_p[0]-O21[1]*gamma_p[1]) + (O22[0]*gamma_m[0]-O22[1]*gamma_m[1]);
-        Psi_2[l][1] = (O21[0]*gamma_p[1]+O21[1]*gamma_p[0]) + (O22[0]*gamma_m[1]+O22[1]*gamma_m[0]);
+          //exp(-i*dt*H)*Psi
+          Coupling::apply<Coupling::Star<2>>( dt, V, w, Psi, l );
+        }
       }
     }
   }
@@ -369,6 +314,235 @@ namespace RT_Solver
       }
     }
   }
+
+  /** Class for an ensemble of bragg-beamsplitters
+    *
+    * The members differ in the laser parameters, see CRT_Base_IF_ensemble.
+    */
+  template<class T, int dim>
+  class Bragg_ensemble : public CRT_Base_IF_ensemble<T,dim,2>
+  {
+  public:
+    Bragg_ensemble( ParameterHandler * );
+    virtual ~Bragg_ensemble() {};
+  protected:
+    void Do_Bragg_ad();
+    static void Do_Bragg_ad_Wrapper(void *, sequence_item &seq);
+
+    bool run_custom_sequence( const sequence_item &item );
+
+    using CRT_Base_IF<T,dim,2>::laser_k;
+    using CRT_Base_IF<T,dim,2>::laser_dk;
+    using CRT_Base_IF<T,dim,2>::chirp_rate;
+    using CRT_Base_IF<T,dim,2>::beta;
+    using CRT_Base_IF_ensemble<T,dim,2>::m_members;
+  };
+
+  template<class T, int dim>
+  Bragg_ensemble<T,dim>::Bragg_ensemble( ParameterHandler *p ) : CRT_Base_IF_ensemble<T,dim,2>( p )
+  {
+    this->m_map_stepfcts["bragg_ad"] = &Do_Bragg_ad_Wrapper;
+
+    CPoint<dim> pt1;
+    CPoint<dim> pt2;
+    pt2[0] = 2*this->laser_k[0];
+    CPoint<dim> pt3;
+    pt3[0] = -2*this->laser_k[0];
+
+    this->m_rabi_momentum_list.push_back(pt1);
+    this->m_rabi_momentum_list.push_back(pt2);
+    this->m_rabi_momentum_list.push_back(pt3);
+  }
+
+  template<class T, int dim>
+  bool Bragg_ensemble<T,dim>::run_custom_sequence( const sequence_item & item )
+  {
+    return false;
+  }
+
+  template<class T, int dim>
+  void Bragg_ensemble<T,dim>::Do_Bragg_ad_Wrapper ( void *ptr, sequence_item &seq )
+  {
+    Bragg_ensemble *self = static_cast<Bragg_ensemble *>(ptr);
+    self->Do_Bragg_ad();
+  }
+
+  /** Same as Bragg_single::Do_Bragg_ad() for all members of the ensemble
+    */
+  template<class T, int dim>
+  void Bragg_ensemble<T,dim>::Do_Bragg_ad()
+  {
+    #pragma omp parallel
+    {
+      // Size of timesteps
+      const double dt = this->Get_dt();
+      // Current time + 0.5*dt
+      const double t1 = this->Get_t()+0.5*dt;
+
+      double tmp1, tmp2, Omega, V[2];
+
+      //x coordinate
+      CPoint<dim> x;
+
+      // Pulseshapes in time
+      double F = this->Amplitude_at_time();
+
+      //Number of points with the same x coordinate (one x-line)
+      const int nyz = this->Get_dimY()*this->Get_dimZ();
+      const int nx = this->m_no_of_pts/nyz;
+      const int M = this->Get_No_Members();
+
+      //Loop over all members and x-lines
+      #pragma omp for collapse(2)
+      for ( int m=0; m<M; m++ )
+      {
+        for ( int i=0; i<nx; i++ )
+        {
+          const ensemble_member &p = m_members[m];
+          fftw_complex * const Psi[] = { this->Get_p2Member(m,0), this->Get_p2Member(m,1) };
+
+          const int l0 = i*nyz;
+          x = this->m_fields[0]->Get_x(l0);
+
+          const double Vx = beta[0]*x[0];
+
+          //Compute light field with the parameters of member m
+          Omega = F*p.Amp[0]*cos(laser_k[0]*x[0]-(p.laser_domh+p.chirp*t1+chirp_rate[0]*t1)*t1+p.phase/2);
+
+          //H_21 = Omega*exp(0.5*i*dk*x)
+          const Coupling::cplx w[] = { Omega*std::polar( 1.0, 0.5*laser_dk[0]*x[0] ) };
+
+          for ( int l=l0; l<l0+nyz; l++ )
+          {
+            tmp1 = Psi[0][l][0]*Psi[0][l][0]+Psi[0][l][1]*Psi[0][l][1];
+            tmp2 = Psi[1][l][0]*Psi[1][l][0]+Psi[1][l][1]*Psi[1][l][1];
+
+            V[0] = this->m_gs[0]*tmp1+this->m_gs[1]*tmp2+Vx;
+            V[1] = this->m_gs[2]*tmp1+this->m_gs[3]*tmp2-p.DeltaL[1]+Vx;
+
+            Coupling::apply<Coupling::Star<2>>( dt, V, w, Psi, l );
+          }
+        }
+      }
+    }
+  }
+
+  /** Class for bragg-beamsplitters in the momentum family representation
+    *
+    * See CRT_Base_IF_family, the light field couples the families n and n+1.
+    */
+  template<class T, int dim>
+  class Bragg_family : public CRT_Base_IF_family<T,dim>
+  {
+  public:
+    Bragg_family( ParameterHandler * );
+    virtual ~Bragg_family() {};
+  protected:
+    void Do_Bragg_ad();
+    static void Do_Bragg_ad_Wrapper(void *, sequence_item &seq);
+
+    bool run_custom_sequence( const sequence_item &item );
+
+    using CRT_Base_IF<T,dim,2>::DeltaL;
+    using CRT_Base_IF<T,dim,2>::Amp;
+    using CRT_Base_IF<T,dim,2>::laser_k;
+    using CRT_Base_IF<T,dim,2>::laser_dk;
+    using CRT_Base_IF<T,dim,2>::chirp;
+    using CRT_Base_IF<T,dim,2>::chirp_rate;
+    using CRT_Base_IF<T,dim,2>::laser_domh;
+    using CRT_Base_IF<T,dim,2>::beta;
+    using CRT_Base_IF<T,dim,2>::phase;
+  };
+
+  template<class T, int dim>
+  Bragg_family<T,dim>::Bragg_family( ParameterHandler *p ) : CRT_Base_IF_family<T,dim>( p )
+  {
+    this->m_map_stepfcts["bragg_ad"] = &Do_Bragg_ad_Wrapper;
+
+    CPoint<dim> pt1;
+    CPoint<dim> pt2;
+    pt2[0] = 2*this->laser_k[0];
+    CPoint<dim> pt3;
+    pt3[0] = -2*this->laser_k[0];
+
+    this->m_rabi_momentum_list.push_back(pt1);
+    this->m_rabi_momentum_list.push_back(pt2);
+    this->m_rabi_momentum_list.push_back(pt3);
+  }
+
+  template<class T, int dim>
+  bool Bragg_family<T,dim>::run_custom_sequence( const sequence_item & item )
+  {
+    return false;
+  }
+
+  template<class T, int dim>
+  void Bragg_family<T,dim>::Do_Bragg_ad_Wrapper ( void *ptr, sequence_item &seq )
+  {
+    Bragg_family *self = static_cast<Bragg_family *>(ptr);
+    self->Do_Bragg_ad();
+  }
+
+  /** Same as Bragg_single::Do_Bragg_ad() in the momentum family representation
+    *
+    * With \f$ \cos(kx-\theta) = (e^{i(kx-\theta)}+e^{-i(kx-\theta)})/2 \f$ the light field moves the
+    * ground state family n to the excited state families n+1 and n-1. The chain of all families is
+    * propagated exactly at each point of the coarse grid.
+    */
+  template<class T, int dim>
+  void Bragg_family<T,dim>::Do_Bragg_ad()
+  {
+    #pragma omp parallel
+    {
+      // Size of timesteps
+      const double dt = this->Get_dt();
+      // Current time + 0.5*dt
+      const double t1 = this->Get_t()+0.5*dt;
+
+      const int nf = this->m_no_of_families;
+      const int nyz = this->m_nyz;
+
+      fftw_complex *Psi[Coupling::max_chain];
+      for ( int f=0; f<nf; f++ )
+        Psi[f] = this->Get_p2Family(f);
+
+      double rho[2], V[Coupling::max_chain];
+      Coupling::cplx w[Coupling::max_chain];
+
+      // Pulseshapes in time
+      double F = this->Amplitude_at_time();
+
+      const double theta = (laser_domh[0]+chirp*t1+chirp_rate[0]*t1)*t1-phase[0]/2;
+
+      //Loop over all x-lines of the coarse grid
+      #pragma omp for
+      for ( int i=0; i<this->m_nx_f; i++ )
+      {
+        const double x = this->m_x_f[i];
+        const double Vx = beta[0]*x;
+
+        //H_21 = a*(exp(i(kx-theta))+exp(-i(kx-theta))), the part exp(i(k-K)x) is not carried by the families
+        const Coupling::cplx a = std::polar( 0.5*F*Amp[0], 0.5*laser_dk[0]*x );
+        const Coupling::cplx up = std::polar( 1.0, (laser_k[0]-this->m_K)*x-theta );
+
+        //H_{f+1,f}: ground state n -> excited state n+1 or excited state n -> ground state n+1
+        for ( int f=0; f<nf-1; f++ )
+          w[f] = ( this->m_family_comp[f] == 0 ) ? a*up : std::conj(a)*up;
+
+        for ( int l=i*nyz; l<(i+1)*nyz; l++ )
+        {
+          this->Family_Densities( l, rho );
+
+          const double V0 = this->m_gs[0]*rho[0]+this->m_gs[1]*rho[1]+Vx-DeltaL[0];
+          const double V1 = this->m_gs[2]*rho[0]+this->m_gs[3]*rho[1]+Vx-DeltaL[1];
+          for ( int f=0; f<nf; f++ )
+            V[f] = ( this->m_family_comp[f] == 0 ) ? V0 : V1;
+
+          Coupling::chain( dt, nf, V, w, Psi, l );
+        }
+      }
+    }
+  }
 }
 
 int main( int argc, char *argv[] )
@@ -397,18 +571,53 @@ int main( int argc, char *argv[] )
     cout << "Errc:     " << e.GetCode() << "\n";
   }
 
-  int no_of_threads = 4;
-  char *envstr = getenv( "MY_NO_OF_THREADS" );
-  if ( envstr != nullptr ) no_of_threads = atoi( envstr );
+  int no_of_threads = Get_No_Of_Threads();
 
   fftw_init_threads();
   fftw_plan_with_nthreads( no_of_threads );
   omp_set_num_threads( no_of_threads );
+  Place_Threads();
 
   // Create RT_Solver object and call run_sequence to start the interferometer sequence
   try
   {
-    if ( dim == 1 )
+    if ( Get_Ensemble_Size( &params ) > 0 )
+    {
+      if ( dim == 1 )
+      {
+        RT_Solver::Bragg_ensemble<Fourier::cft_1d,1> rtsol( &params );
+        rtsol.run_sequence();
+      }
+      else if ( dim == 2 )
+      {
+        RT_Solver::Bragg_ensemble<Fourier::cft_2d,2> rtsol( &params );
+        rtsol.run_sequence();
+      }
+      else if ( dim == 3 )
+      {
+        RT_Solver::Bragg_ensemble<Fourier::cft_3d,3> rtsol( &params );
+        rtsol.run_sequence();
+      }
+    }
+    else if ( Get_Family_Order( &params ) > 0 )
+    {
+      if ( dim == 1 )
+      {
+        RT_Solver::Bragg_family<Fourier::cft_1d,1> rtsol( &params );
+        rtsol.run_sequence();
+      }
+      else if ( dim == 2 )
+      {
+        RT_Solver::Bragg_family<Fourier::cft_2d,2> rtsol( &params );
+        rtsol.run_sequence();
+      }
+      else if ( dim == 3 )
+      {
+        RT_Solver::Bragg_family<Fourier::cft_3d,3> rtsol( &params );
+        rtsol.run_sequence();
+      }
+    }
+    else if ( dim == 1 )
     {
       RT_Solver::Bragg_single<Fourier::cft_1d,1> rtsol( &params );
       rtsol.run_sequence();
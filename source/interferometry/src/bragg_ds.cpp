@@ -36,6 +36,8 @@
 #include "muParser.h"
 #include "ParameterHandler.h"
 #include "CRT_Base_IF_2.h"
+#include "light_coupling.h"
+#include "thread_setup.h"
 
 using namespace std;
 
@@ -111,9 +113,9 @@ namespace RT_Solver_2
   template<class T, int dim>
   void Bragg_single<T,dim>::Do_Bragg_ad(sequence_item &seq) // ad -> analytic diagonalization
   {
-    vector<fftw_complex *> Psi;
+    fftw_complex * Psi[4];
     for ( int i=0; i<4; i++ )
-      Psi.push_back(this->m_fields[i]->Getp2In());
+      Psi[i] = this->m_fields[i]->Getp2In();
 
     const double dt = this->Get_dt();
     const double t1 = this->Get_t()+0.5*dt;
@@ -127,195 +129,48 @@ namespace RT_Solver_2
     if ( time > seq.duration[1] )
       mode2 = 0;
 
+    // number of points with the same x coordinate (one x-line)
+    const int nyz = this->Get_dimY()*this->Get_dimZ();
+    const int nx = this->m_no_of_pts/nyz;
+
     #pragma omp parallel
     {
       CPoint<dim> x;
-      complex<double> M00, M01, M10, M11, eta, Psi_neu_0, Psi_neu_1, Psi_alt_0, Psi_alt_1, tmp, d0, d1;
-      array<complex<double>,2> gamma;
-      array<double,4> phi;
-      double Ep, Em, Omega, Omega2, tmp1, V11, V22, re1, im1;
+      array<double,4> phi, Vx;
+      double Omega, Omega2;
 
       #pragma omp for
-      for ( int l=0; l<this->m_no_of_pts; l++ )
+      for ( int ix=0; ix<nx; ix++ )
       {
-        x = this->m_fields[0]->Get_x(l);
+        const int l0 = ix*nyz;
+        x = this->m_fields[0]->Get_x(l0);
 
+        // everything depending only on x[0] is evaluated once per line
         for ( int i=0; i<2; i++ )
-        {
-          phi[i]=0;
-          for ( int j=0; j<4; j++ )
-            phi[i] += this->m_gs[j+4*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
-          phi[i] += beta[0]*x[0]-DeltaL[i];
-        }
-
+          Vx[i] = beta[0]*x[0]-DeltaL[i];
         for ( int i=2; i<4; i++ )
-        {
-          phi[i]=0;
-          for ( int j=0; j<4; j++ )
-            phi[i] += this->m_gs[j+4*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
-          phi[i] += beta2[0]*x[0]-DeltaL[i];
-        }
+          Vx[i] = beta2[0]*x[0]-DeltaL[i];
 
         Omega  = mode1*Amp[0]*cos(laser_k[0]*x[0]-(laser_domh[0]+this->chirp_rate[0]*t1)*t1+phase[0]/2);
         Omega2 = mode2*Amp2[0]*cos(laser_k2[0]*x[0]-(laser_domh2[0]+this->chirp_rate2[0]*t1)*t1+phase2[0]/2);
 
-        if ( Omega == 0 && Omega2 == 0 )
-        {
-          for ( int i=0; i<4; i++)
-          {
-            sincos( -phi[i]*dt, &im1, &re1 );
-            tmp1 = Psi[i][l][0];
-            Psi[i][l][0] = tmp1*re1-Psi[i][l][1]*im1;
-            Psi[i][l][1] = tmp1*im1+Psi[i][l][1]*re1;
-          }
-          continue;
-        }
-        else if ( Omega == 0.0 )
-        {
-          for ( int i=0; i<2; i++)
-          {
-            sincos( -phi[i]*dt, &im1, &re1 );
-            tmp1 = Psi[i][l][0];
-            Psi[i][l][0] = tmp1*re1-Psi[i][l][1]*im1;
-            Psi[i][l][1] = tmp1*im1+Psi[i][l][1]*re1;
-          }
-
-          V11 = phi[2];
-          V22 = phi[3];
+        // one two level system per species, H_10 = Omega*exp(0.5*i*(dk*x+phase))
+        const Coupling::cplx w[] = { Omega*std::polar( 1.0, 0.5*(laser_dk[0]*x[0]+phase[0]) ),
+                                     Omega2*std::polar( 1.0, 0.5*(laser_dk2[0]*x[0]+phase2[0]) )
+                                   };
 
-          eta = exp(complex<double>( 0, -0.5*(laser_dk2[0]*x[0]+phase2[0]) ));
-
-          tmp1 = sqrt((V11-V22)*(V11-V22)+4.0*Omega2*Omega2);
-          Ep = 0.5*(V11+V22+tmp1);
-          Em = 0.5*(V11+V22-tmp1);
-          d0 = V11-Ep;
-          d1 = V11-Em;
-          gamma[0] = exp(complex<double>( 0, -dt*Ep )) / fabs(d0*d0+Omega2*Omega2);
-          gamma[1] = exp(complex<double>( 0, -dt*Em )) / fabs(d1*d1+Omega2*Omega2);
-
-          tmp = d0*gamma[0]+d1*gamma[1];
-          M00 = Omega2*Omega2*(gamma[0]+gamma[1]);
-          M01 = -Omega2*eta*tmp;
-          M10 = -Omega2*conj(eta)*tmp;
-          M11 = d0*d0*gamma[0] + d1*d1*gamma[1];
-
-          Psi_alt_0 = complex<double>(Psi[2][l][0], Psi[2][l][1]);
-          Psi_alt_1 = complex<double>(Psi[3][l][0], Psi[3][l][1]);
-
-          Psi_neu_0 = M00*Psi_alt_0 + M01*Psi_alt_1;
-          Psi_neu_1 = M10*Psi_alt_0 + M11*Psi_alt_1;
-
-          Psi[2][l][0] = real(Psi_neu_0);
-          Psi[2][l][1] = imag(Psi_neu_0);
-          Psi[3][l][0] = real(Psi_neu_1);
-          Psi[3][l][1] = imag(Psi_neu_1);
-          continue;
-        }
-        else if ( Omega2 == 0.0)
+        for ( int l=l0; l<l0+nyz; l++ )
         {
-          for ( int i=2; i<4; i++)
+          for ( int i=0; i<4; i++ )
           {
-            sincos( -phi[i]*dt, &im1, &re1 );
-            tmp1 = Psi[i][l][0];
-            Psi[i][l][0] = tmp1*re1-Psi[i][l][1]*im1;
-            Psi[i][l][1] = tmp1*im1+Psi[i][l][1]*re1;
+            phi[i]=0;
+            for ( int j=0; j<4; j++ )
+              phi[i] += this->m_gs[j+4*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
+            phi[i] += Vx[i];
           }
 
-          V11 = phi[0];
-          V22 = phi[1];
-
-          eta = exp(complex<double>( 0, -0.5*(laser_dk[0]*x[0]+phase[0]) ));
-
-          tmp1 = sqrt((V11-V22)*(V11-V22)+4.0*Omega*Omega);
-          Ep = 0.5*(V11+V22+tmp1);
-          Em = 0.5*(V11+V22-tmp1);
-          d0 = V11-Ep;
-          d1 = V11-Em;
-          gamma[0] = exp(complex<double>( 0, -dt*Ep )) / fabs(d0*d0+Omega*Omega);
-          gamma[1] = exp(complex<double>( 0, -dt*Em )) / fabs(d1*d1+Omega*Omega);
-
-          tmp = d0*gamma[0] + d1*gamma[1];
-          M00 = Omega*Omega*(gamma[0]+gamma[1]);
-          M01 = -Omega*eta*tmp;
-          M10 = -Omega*conj(eta)*tmp;
-          M11 = d0*d0*gamma[0] + d1*d1*gamma[1];
-
-          Psi_alt_0 = complex<double>(Psi[0][l][0], Psi[0][l][1]);
-          Psi_alt_1 = complex<double>(Psi[1][l][0], Psi[1][l][1]);
-
-          Psi_neu_0 = M00*Psi_alt_0 + M01*Psi_alt_1;
-          Psi_neu_1 = M10*Psi_alt_0 + M11*Psi_alt_1;
-
-          Psi[0][l][0] = real(Psi_neu_0);
-          Psi[0][l][1] = imag(Psi_neu_0);
-          Psi[1][l][0] = real(Psi_neu_1);
-          Psi[1][l][1] = imag(Psi_neu_1);
-          continue;
+          Coupling::apply<Coupling::Blocks<Coupling::Star<2>,Coupling::Star<2>>>( dt, phi.data(), w, Psi, l );
         }
-
-        // first species
-        V11 = phi[0];
-        V22 = phi[1];
-
-        eta = exp(complex<double>( 0, -0.5*(laser_dk[0]*x[0]+phase[0]) ));
-
-        tmp1 = sqrt((V11-V22)*(V11-V22)+4.0*Omega*Omega);
-        Ep = 0.5*(V11+V22+tmp1);
-        Em = 0.5*(V11+V22-tmp1);
-        d0 = V11-Ep;
-        d1 = V11-Em;
-        gamma[0] = exp(complex<double>( 0, -dt*Ep )) / fabs(d0*d0+Omega*Omega);
-        gamma[1] = exp(complex<double>( 0, -dt*Em )) / fabs(d1*d1+Omega*Omega);
-
-        //cout << "o " <<  << sqrt((V11-Ep)*(V11-Ep)+4.0*Omega*Omega) << ", " << sqrt((V11-Ep)*(V11-Ep)+4.0*Omega*Omega) << endl;
-
-        tmp = d0*gamma[0]+d1*gamma[1];
-        M00 = Omega*Omega*(gamma[0]+gamma[1]);
-        M01 = -Omega*eta*tmp;
-        M10 = -Omega*conj(eta)*tmp;
-        M11 = d0*d0*gamma[0] + d1*d1*gamma[1];
-
-        Psi_alt_0 = complex<double>(Psi[0][l][0], Psi[0][l][1]);
-        Psi_alt_1 = complex<double>(Psi[1][l][0], Psi[1][l][1]);
-
-        Psi_neu_0 = M00*Psi_alt_0 + M01*Psi_alt_1;
-        Psi_neu_1 = M10*Psi_alt_0 + M11*Psi_alt_1;
-
-        Psi[0][l][0] = real(Psi_neu_0);
-        Psi[0][l][1] = imag(Psi_neu_0);
-        Psi[1][l][0] = real(Psi_neu_1);
-        Psi[1][l][1] = imag(Psi_neu_1);
-
-        // second species
-        V11 = phi[2];
-        V22 = phi[3];
-
-        eta = exp(complex<double>( 0, -0.5*(laser_dk2[0]*x[0]+phase2[0]) ));
-
-        tmp1 = sqrt((V11-V22)*(V11-V22)+4.0*Omega2*Omega2);
-        Ep = 0.5*(V11+V22+tmp1);
-        Em = 0.5*(V11+V22-tmp1);
-        d0 = V11-Ep;
-        d1 = V11-Em;
-        gamma[0] = exp(complex<double>( 0, -dt*Ep )) / fabs(d0*d0+Omega2*Omega2);
-        gamma[1] = exp(complex<double>( 0, -dt*Em )) / fabs(d1*d1+Omega2*Omega2);
-
-        tmp = d0*gamma[0]+d1*gamma[1];
-        M00 = Omega2*Omega2*(gamma[0]+gamma[1]);
-        M01 = -Omega2*eta*tmp;
-        M10 = -Omega2*conj(eta)*tmp;
-        M11 = d0*d0*gamma[0] + d1*d1*gamma[1];
-
-        Psi_alt_0 = complex<double>(Psi[2][l][0], Psi[2][l][1]);
-        Psi_alt_1 = complex<double>(Psi[3][l][0], Psi[3][l][1]);
-
-        Psi_neu_0 = M00*Psi_alt_0 + M01*Psi_alt_1;
-        Psi_neu_1 = M10*Psi_alt_0 + M11*Psi_alt_1;
-
-        Psi[2][l][0] = real(Psi_neu_0);
-        Psi[2][l][1] = imag(Psi_neu_0);
-        Psi[3][l][0] = real(Psi_neu_1);
-        Psi[3][l][1] = imag(Psi_neu_1);
       }
     }
   }
@@ -346,13 +201,12 @@ int main( int argc, char *argv[] )
     cout << "Errc:     " << e.GetCode() << "\n";
   }
 
-  int no_of_threads = 4;
-  char *envstr = getenv( "MY_NO_OF_THREADS" );
-  if ( envstr != nullptr ) no_of_threads = atoi( envstr );
+  int no_of_threads = Get_No_Of_Threads();
 
   fftw_init_threads();
   fftw_plan_with_nthreads( no_of_threads );
   omp_set_num_threads( no_of_threads );
+  Place_Threads();
 
   try
   {
@@ -0,0 +1,374 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+/*  Sweep of the two species bragg beamsplitter (bragg_ds) in one process
+ *
+ *  Every case of the sweep is a member of an ensemble (see CRT_Base_IF_ensemble.h):
+ *    - SWEEP_FILES (SIMULATION section): text file with one set of initial states per line
+ *        label file_1 file_2 file_3 file_4
+ *      for example the ground states for different particle numbers N1, N2.
+ *      Without SWEEP_FILES the files FILENAME, ..., FILENAME_4 are used.
+ *    - Sweep_Delta_L (VCONSTANTS section): values of Delta_L for the second internal state.
+ *  All combinations are propagated together with one batched FFT plan, the results of all cases
+ *  are written to Ensemble_<seq>.txt (case = set*no_of_detunings + detuning).
+ */
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <omp.h>
+#include "cft_1d.h"
+#include "cft_2d.h"
+#include "cft_3d.h"
+#include "muParser.h"
+#include "ParameterHandler.h"
+#include "CRT_Base_IF_ensemble.h"
+#include "light_coupling.h"
+#include "thread_setup.h"
+
+using namespace std;
+
+namespace RT_Solver
+{
+  /// Set of initial wave functions of a sweep
+  struct sweep_files
+  {
+    std::string label;
+    std::array<std::string,4> filename;
+  };
+
+  /** Read the sets of initial wave functions from the file SWEEP_FILES
+    *
+    * Empty lines and lines starting with # are skipped.
+    */
+  std::vector<sweep_files> Read_Sweep_Files( ParameterHandler *params )
+  {
+    std::vector<sweep_files> retval;
+    std::string filename;
+
+    try
+    {
+      filename = params->Get_simulation("SWEEP_FILES");
+    }
+    catch (std::string &)
+    {
+      sweep_files item;
+      item.filename[0] = params->Get_simulation("FILENAME");
+      for ( int i=1; i<4; i++ )
+        item.filename[i] = params->Get_simulation("FILENAME_" + to_string(i+1));
+      retval.push_back(item);
+      return retval;
+    }
+
+    ifstream in( filename );
+    if ( !in.is_open() ) throw std::string( "Could not open file " + filename + "\n" );
+
+    std::string line;
+    while ( getline( in, line ) )
+    {
+      if ( line.empty() || line[0] == '#' ) continue;
+
+      std::istringstream iss(line);
+      sweep_files item;
+      iss >> item.label;
+      for ( int i=0; i<4; i++ )
+        iss >> item.filename[i];
+
+      if ( iss.fail() ) throw std::string( "Error in " + filename + ": expected label and 4 file names in line\n" + line + "\n" );
+      retval.push_back(item);
+    }
+    return retval;
+  }
+
+  /** Class for a sweep of two species bragg beamsplitters
+    *
+    * The members differ in the initial wave functions and in the detuning of the second internal state.
+    */
+  template<class T, int dim>
+  class Bragg_ds_sweep : public CRT_Base_IF_ensemble<T,dim,4>
+  {
+  public:
+    Bragg_ds_sweep( ParameterHandler *, const std::vector<sweep_files> &, const std::vector<double> & );
+    virtual ~Bragg_ds_sweep() {};
+
+  protected:
+    void Do_Bragg_ad(sequence_item &seq);
+    static void Do_Bragg_ad_Wrapper(void *, sequence_item &seq);
+
+    bool run_custom_sequence( const sequence_item &item );
+
+    void Load_Member( const int, const sweep_files & );
+
+    using CRT_Base_IF<T,dim,4>::Amp;
+    using CRT_Base_IF<T,dim,4>::laser_k;
+    using CRT_Base_IF<T,dim,4>::laser_dk;
+    using CRT_Base_IF<T,dim,4>::beta;
+    using CRT_Base_IF_ensemble<T,dim,4>::m_members;
+
+    // second species
+    CPoint<dim> alpha2, beta2;
+    double Amp2, laser_k2, laser_dk2, laser_domh2;
+  };
+
+  template<class T, int dim>
+  Bragg_ds_sweep<T,dim>::Bragg_ds_sweep( ParameterHandler *p, const std::vector<sweep_files> &files, const std::vector<double> &detuning ) : CRT_Base_IF_ensemble<T,dim,4>( p, files.size()*detuning.size() )
+  {
+    this->m_map_stepfcts["bragg_ad"] = &Do_Bragg_ad_Wrapper;
+
+    try
+    {
+      for ( int i=0; i<dim; i++ )
+      {
+        alpha2[i] = p->Get_VConstant("Alpha_2",i);
+        beta2[i] = p->Get_VConstant("Beta_2",i);
+      }
+      Amp2 = p->Get_VConstant("Amp_2",0);
+      laser_k2 = p->Get_Constant("laser_k_2");
+      laser_dk2 = p->Get_Constant("laser_dk_2");
+      laser_domh2 = p->Get_Constant("laser_domh_2");
+    }
+    catch (std::string &str )
+    {
+      cout << str << endl;
+      exit(EXIT_FAILURE);
+    }
+
+    // internal states 3 and 4 belong to the second species
+    this->Set_Species( 2, alpha2, beta2 );
+    this->Set_Species( 3, alpha2, beta2 );
+
+    // case m = f*no_of_detunings + d
+    const int nd = detuning.size();
+    for ( int f=0; f<int(files.size()); f++ )
+    {
+      Load_Member( f*nd, files[f] );
+      for ( int d=0; d<nd; d++ )
+      {
+        const int m = f*nd+d;
+        if ( d > 0 )
+          for ( int c=0; c<4; c++ )
+            memcpy( this->Get_p2Member(m,c), this->Get_p2Member(f*nd,c), sizeof(fftw_complex)*this->m_no_of_pts );
+
+        m_members[m].DeltaL[1] = detuning[d];
+        m_members[m].label = files[f].label;
+      }
+    }
+
+    CPoint<dim> pt1;
+    CPoint<dim> pt2;
+    pt2[0] = 2*laser_k[0];
+    CPoint<dim> pt3;
+    pt3[0] = -2*laser_k[0];
+    this->m_rabi_states.push_back( make_pair( 0, vector<CPoint<dim>> {pt1, pt2, pt3} ) );
+
+    pt2[0] = 2*laser_k2;
+    pt3[0] = -2*laser_k2;
+    this->m_rabi_states.push_back( make_pair( 2, vector<CPoint<dim>> {pt1, pt2, pt3} ) );
+  }
+
+  /** Read a set of initial wave functions into member m
+    *
+    * The files must have the same grid as FILENAME (nDims, nDimX/Y/Z and dx/dy/dz) and hold all points.
+    */
+  template<class T, int dim>
+  void Bragg_ds_sweep<T,dim>::Load_Member( const int m, const sweep_files &item )
+  {
+    const generic_header &ref = this->m_header;
+    const std::streamsize size = sizeof(fftw_complex)*this->m_no_of_pts;
+
+    for ( int c=0; c<4; c++ )
+    {
+      generic_header header;
+      ifstream in( item.filename[c], ifstream::binary );
+      if ( !in.is_open() ) throw std::string( "Could not open file " + item.filename[c] + "\n" );
+
+      in.read( (char *)&header, sizeof(generic_header) );
+      if ( !in || header.nDims != ref.nDims || header.nDimX != ref.nDimX || header.nDimY != ref.nDimY || header.nDimZ != ref.nDimZ
+           || header.dx != ref.dx || header.dy != ref.dy || header.dz != ref.dz )
+        throw std::string( "Error: grid of " + item.filename[c] + " does not match FILENAME\n" );
+
+      in.read( (char *)this->Get_p2Member(m,c), size );
+      if ( in.gcount() != size )
+        throw std::string( "Error: " + item.filename[c] + " is too short for the grid of FILENAME\n" );
+    }
+  }
+
+  template<class T, int dim>
+  bool Bragg_ds_sweep<T,dim>::run_custom_sequence( const sequence_item &item )
+  {
+    return false;
+  }
+
+  template<class T, int dim>
+  void Bragg_ds_sweep<T,dim>::Do_Bragg_ad_Wrapper ( void *ptr, sequence_item &seq )
+  {
+    Bragg_ds_sweep *self = static_cast<Bragg_ds_sweep *>(ptr);
+    self->Do_Bragg_ad(seq);
+  }
+
+  /** Same as Bragg_single::Do_Bragg_ad() of bragg_ds for all cases of the sweep
+    */
+  template<class T, int dim>
+  void Bragg_ds_sweep<T,dim>::Do_Bragg_ad(sequence_item &seq)
+  {
+    const double dt = this->Get_dt();
+    const double t1 = this->Get_t()+0.5*dt;
+    int mode1=1, mode2=1;
+
+    double time = t1-seq.time;
+
+    if ( time > seq.duration[0] )
+      mode1 = 0;
+    if ( time > seq.duration[1] )
+      mode2 = 0;
+
+    // number of points with the same x coordinate (one x-line)
+    const int nyz = this->Get_dimY()*this->Get_dimZ();
+    const int nx = this->m_no_of_pts/nyz;
+    const int M = this->Get_No_Members();
+
+    #pragma omp parallel
+    {
+      CPoint<dim> x;
+      array<double,4> phi, Vx;
+      double Omega, Omega2;
+
+      #pragma omp for collapse(2)
+      for ( int m=0; m<M; m++ )
+      {
+        for ( int ix=0; ix<nx; ix++ )
+        {
+          const ensemble_member &p = m_members[m];
+          fftw_complex * const Psi[] = { this->Get_p2Member(m,0), this->Get_p2Member(m,1), this->Get_p2Member(m,2), this->Get_p2Member(m,3) };
+
+          const int l0 = ix*nyz;
+          x = this->m_fields[0]->Get_x(l0);
+
+          for ( int i=0; i<2; i++ )
+            Vx[i] = beta[0]*x[0]-p.DeltaL[i];
+          for ( int i=2; i<4; i++ )
+            Vx[i] = beta2[0]*x[0]-p.DeltaL[i];
+
+          Omega  = mode1*p.Amp[0]*cos(laser_k[0]*x[0]-(p.laser_domh+p.chirp*t1)*t1+p.phase/2);
+          Omega2 = mode2*Amp2*cos(laser_k2*x[0]-laser_domh2*t1);
+
+          const Coupling::cplx w[] = { Omega*std::polar( 1.0, 0.5*(laser_dk[0]*x[0]+p.phase) ),
+                                       Omega2*std::polar( 1.0, 0.5*laser_dk2*x[0] )
+                                     };
+
+          for ( int l=l0; l<l0+nyz; l++ )
+          {
+            for ( int i=0; i<4; i++ )
+            {
+              phi[i]=0;
+              for ( int j=0; j<4; j++ )
+                phi[i] += this->m_gs[j+4*i]*(Psi[j][l][0]*Psi[j][l][0] + Psi[j][l][1]*Psi[j][l][1]);
+              phi[i] += Vx[i];
+            }
+
+            Coupling::apply<Coupling::Blocks<Coupling::Star<2>,Coupling::Star<2>>>( dt, phi.data(), w, Psi, l );
+          }
+        }
+      }
+    }
+  }
+}
+
+int main( int argc, char *argv[] )
+{
+  if ( argc != 2 )
+  {
+    printf( "No parameter xml file specified.\n" );
+    return EXIT_FAILURE;
+  }
+
+  ParameterHandler params(argv[1]);
+  int dim=0;
+
+  try
+  {
+    std::string tmp = params.Get_simulation("DIM");
+    dim = std::stod(tmp);
+  }
+  catch (mu::Parser::exception_type &e)
+  {
+    cout << "Message:  " << e.GetMsg() << "\n";
+    cout << "Formula:  " << e.GetExpr() << "\n";
+    cout << "Token:    " << e.GetToken() << "\n";
+    cout << "Position: " << e.GetPos() << "\n";
+    cout << "Errc:     " << e.GetCode() << "\n";
+  }
+
+  int no_of_threads = Get_No_Of_Threads();
+
+  fftw_init_threads();
+  fftw_plan_with_nthreads( no_of_threads );
+  omp_set_num_threads( no_of_threads );
+  Place_Threads();
+
+  try
+  {
+    std::vector<RT_Solver::sweep_files> files = RT_Solver::Read_Sweep_Files( &params );
+    std::vector<double> detuning;
+    try
+    {
+      detuning = params.Get_VConstant("Sweep_Delta_L");
+    }
+    catch (std::string &)
+    {
+      detuning.push_back( params.Get_VConstant("Delta_L",1) );
+    }
+
+    std::cout << "FYI: sweep over " << files.size() << " initial states and " << detuning.size() << " detunings" << std::endl;
+
+    if ( dim == 1 )
+    {
+      RT_Solver::Bragg_ds_sweep<Fourier::cft_1d,1> rtsol( &params, files, detuning );
+      rtsol.run_sequence();
+    }
+    else if ( dim == 2 )
+    {
+      RT_Solver::Bragg_ds_sweep<Fourier::cft_2d,2> rtsol( &params, files, detuning );
+      rtsol.run_sequence();
+    }
+    else if ( dim == 3 )
+    {
+      RT_Solver::Bragg_ds_sweep<Fourier::cft_3d,3> rtsol( &params, files, detuning );
+      rtsol.run_sequence();
+    }
+  }
+  catch (mu::Parser::exception_type &e)
+  {
+    cout << "Message:  " << e.GetMsg() << "\n";
+    cout << "Formula:  " << e.GetExpr() << "\n";
+    cout << "Token:    " << e.GetToken() << "\n";
+    cout << "Position: " << e.GetPos() << "\n";
+    cout << "Errc:     " << e.GetCode() << "\n";
+  }
+  catch (std::string &str)
+  {
+    cout << str << endl;
+  }
+  fftw_cleanup_threads();
+  return EXIT_SUCCESS;
+}
@@ -36,6 +36,9 @@
 #include "muParser.h"
 #include "ParameterHandler.h"
 #include "CRT_Base_IF.h"
+#include "CRT_Base_IF_ensemble.h"
+#include "light_coupling.h"
+#include "thread_setup.h"
 
 using namespace std;
 
@@ -100,11 +103,21 @@ namespace RT_Solver
   template<class T, int dim>
   void Bragg_double<T,dim>::Do_Double_Bragg_ad()
   {
+    //Number of points with the same x coordinate (one x-line)
+    const int nyz = this->Get_dimY()*this->Get_dimZ();
+    const int nx = this->m_no_of_pts/nyz;
+
+    //Transversal part of beta*x, identical for all x-lines
+    vector<double> Vyz(nyz);
+    for ( int l=0; l<nyz; l++ )
+    {
+      CPoint<dim> x = this->m_fields[0]->Get_x(l);
+      Vyz[l] = beta*x-beta[0]*x[0];
+    }
+
     #pragma omp parallel
     {
-      fftw_complex *Psi_1 = this->m_fields[0]->Getp2In();
-      fftw_complex *Psi_2 = this->m_fields[1]->Getp2In();
-      fftw_complex *Psi_3 = this->m_fields[2]->Getp2In();
+      fftw_complex * const Psi[] = { this->m_fields[0]->Getp2In(), this->m_fields[1]->Getp2In(), this->m_fields[2]->Getp2In() };
 
       const double dt = this->Get_dt();
       const double t1 = this->Get_t()+0.5*dt;
@@ -114,144 +127,157 @@ namespace RT_Solver
       double F = this->Amplitude_at_time();
       if( F < 0 ) F = 0;
 
-      fftw_complex O11, O12, O21, O22, O13, O31, O33, O32, O23, gamma_1, gamma_2, gamma_3, eta;
-      double re1, im1, tmp1, tmp2, tmp3, V11, V22, E1, E2, Omega_p, Omega_m, test, dw;
-      int I, J;
-      int i,j;
+      double tmp1, tmp2, tmp3, Omega_p, Omega_m, dw, V[2];
 
       std::cout << F << std::endl;
       #pragma omp for
-      for ( int l=0; l<this->m_no_of_pts; l++ )
+      for ( int i=0; i<nx; i++ )
       {
-        x = this->m_fields[0]->Get_x(l);
-
-        tmp1 = Psi_1[l][0]*Psi_1[l][0]+Psi_1[l][1]*Psi_1[l][1];
-        tmp2 = Psi_2[l][0]*Psi_2[l][0]+Psi_2[l][1]*Psi_2[l][1];
-        tmp3 = Psi_3[l][0]*Psi_3[l][0]+Psi_3[l][1]*Psi_3[l][1];
+        const int l0 = i*nyz;
+        x = this->m_fields[0]->Get_x(l0);
 
-        V11 = m_gs[0]*tmp1+m_gs[1]*tmp2+m_gs[2]*tmp3+beta*x;
-        V22 = m_gs[3]*tmp1+m_gs[4]*tmp2+m_gs[5]*tmp3-DeltaL[1]+beta*x;
+        //Light fields and beta[0]*x[0] are constant along the line
+        const double Vx = beta[0]*x[0];
 
-        double phase_error = phase[0];//+m_Mirror[jk];
         dw = laser_domh[0]+(chirp_rate[0])*t1;
         Omega_p = F*Amp[0]*cos(laser_k[0]*x[0]-dw*t1-phase[0]/2);
         dw = laser_domh[0]-(chirp_rate[0])*t1;
         Omega_m = F*Amp[0]*cos(-laser_k[0]*x[0]-dw*t1-phase[0]/2);
 
-        if ((Omega_m == 0.0 ) && ( Omega_p == 0.0 ))
-        {
-          sincos( -dt*V11, &im1, &re1 );
-          tmp1 = Psi_1[l][0];
-          Psi_1[l][0] = tmp1*re1-Psi_1[l][1]*im1;
-          Psi_1[l][1] = tmp1*im1+Psi_1[l][1]*re1;
-
-          sincos( -dt*V22, &im1, &re1 );
-          tmp1 = Psi_2[l][0];
-          Psi_2[l][0] = tmp1*re1-Psi_2[l][1]*im1;
-          Psi_2[l][1] = tmp1*im1+Psi_2[l][1]*re1;
-          tmp1 = Psi_3[l][0];
-          Psi_3[l][0] = tmp1*re1-Psi_3[l][1]*im1;
-          Psi_3[l][1] = tmp1*im1+Psi_3[l][1]*re1;
-          continue;
-        }
-
-        sincos( -0.5*laser_dk[0]*x[0], &im1, &re1 );
-        eta[0] = re1;
-        eta[1] = im1;
-
-        tmp1 = sqrt((V11-V22)*(V11-V22)+4.0*(Omega_p*Omega_p+Omega_m*Omega_m));
-        E1 = 0.5*(V11+V22+tmp1);
-        E2 = 0.5*(V11+V22-tmp1);
+        //H_21 = Omega_p*exp(0.5*i*dk*x), H_31 = Omega_m*exp(-0.5*i*dk*x)
+        const Coupling::cplx eta = std::polar( 1.0, 0.5*laser_dk[0]*x[0] );
+        const Coupling::cplx w[] = { Omega_p*eta, Omega_m*conj(eta) };
 
-        sincos( -dt*E1, &im1, &re1 );
-        tmp1 = 1.0/fabs((V22-E1)*(V22-E1)+Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_1[0] = tmp1*re1;
-        gamma_1[1] = tmp1*im1;
+        for ( int l=l0; l<l0+nyz; l++ )
+        {
+          tmp1 = Psi[0][l][0]*Psi[0][l][0]+Psi[0][l][1]*Psi[0][l][1];
+          tmp2 = Psi[1][l][0]*Psi[1][l][0]+Psi[1][l][1]*Psi[1][l][1];
+          tmp3 = Psi[2][l][0]*Psi[2][l][0]+Psi[2][l][1]*Psi[2][l][1];
 
-        sincos( -dt*E2, &im1, &re1 );
-        tmp1 = 1.0/fabs((V22-E2)*(V22-E2)+Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_2[0] = tmp1*re1;
-        gamma_2[1] = tmp1*im1;
+          V[0] = m_gs[0]*tmp1+m_gs[1]*tmp2+m_gs[2]*tmp3+Vx+Vyz[l-l0];
+          V[1] = m_gs[3]*tmp1+m_gs[4]*tmp2+m_gs[5]*tmp3-DeltaL[1]+Vx+Vyz[l-l0];
 
-        sincos( -dt*V22, &im1, &re1);
-        tmp1 = 1.0/fabs(Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_3[0] = tmp1*re1;
-        gamma_3[1] = tmp1*im1;
+          Coupling::apply<Coupling::Star<3>>( dt, V, w, Psi, l );
+        }
+      }
+    }
+  }
 
-        tmp1 = (V22-E2)*(V22-E2);
-        tmp2 = (V22-E1)*(V22-E1);
-        O11[0] = tmp1*gamma_2[0] + tmp2*gamma_1[0];
-        O11[1] = tmp1*gamma_2[1] + tmp2*gamma_1[1];
+  /** Ensemble of double bragg beamsplitters, the members differ in the laser parameters
+    */
+  template<class T, int dim>
+  class Bragg_double_ensemble : public CRT_Base_IF_ensemble<T,dim,3>
+  {
+  public:
+    Bragg_double_ensemble( ParameterHandler * );
+    virtual ~Bragg_double_ensemble() {};
 
-        tmp1 = (V22-E2)*gamma_2[0] + (V22-E1)*gamma_1[0];
-        tmp2 = (V22-E2)*gamma_2[1] + (V22-E1)*gamma_1[1];
+  protected:
+    static void Do_Double_Bragg_ad_Wrapper(void *, sequence_item &seq);
+    void Do_Double_Bragg_ad();
 
-        O12[0] = -Omega_p*tmp1;
-        O12[1] = -Omega_p*tmp2;
+    bool run_custom_sequence( const sequence_item & );
 
-        O13[0] = -Omega_m*tmp1;
-        O13[1] = -Omega_m*tmp2;
+    using CRT_Base<T,dim,3>::m_map_stepfcts;
+    using CRT_Base<T,dim,3>::m_gs;
+    using CRT_Base_IF<T,dim,3>::laser_k;
+    using CRT_Base_IF<T,dim,3>::laser_dk;
+    using CRT_Base_IF<T,dim,3>::chirp_rate;
+    using CRT_Base_IF<T,dim,3>::beta;
+    using CRT_Base_IF_ensemble<T,dim,3>::m_members;
+  };
 
-        O21[0] = O12[0];
-        O21[1] = O12[1];
+  template<class T, int dim>
+  Bragg_double_ensemble<T,dim>::Bragg_double_ensemble( ParameterHandler *p ) : CRT_Base_IF_ensemble<T,dim,3>( p )
+  {
+    m_map_stepfcts["bragg_ad"] = &Do_Double_Bragg_ad_Wrapper;
 
-        O31[0] = O13[0];
-        O31[1] = O13[1];
+    CPoint<dim> pt1;
+    CPoint<dim> pt2;
+    pt2[0] = 2*this->laser_k[0];
+    CPoint<dim> pt3;
+    pt3[0] = -2*this->laser_k[0];
+    this->m_rabi_momentum_list.push_back(pt1);
+    this->m_rabi_momentum_list.push_back(pt2);
+    this->m_rabi_momentum_list.push_back(pt3);
+  }
 
-        tmp1 = O12[0];
-        O12[0] = eta[0]*tmp1-eta[1]*O12[1];
-        O12[1] = eta[1]*tmp1+eta[0]*O12[1];
+  template<class T, int dim>
+  bool Bragg_double_ensemble<T,dim>::run_custom_sequence( const sequence_item &item )
+  {
+    return false;
+  }
 
-        tmp1 = O21[0];
-        O21[0] = eta[0]*tmp1+eta[1]*O21[1];
-        O21[1] = eta[0]*O21[1]-eta[1]*tmp1;
+  template<class T, int dim>
+  void Bragg_double_ensemble<T,dim>::Do_Double_Bragg_ad_Wrapper( void *ptr, sequence_item &seq )
+  {
+    Bragg_double_ensemble *self = static_cast<Bragg_double_ensemble *>(ptr);
+    self->Do_Double_Bragg_ad();
+  }
 
-        tmp1 = O31[0];
-        O31[0] = eta[0]*tmp1-eta[1]*O31[1];
-        O31[1] = eta[1]*tmp1+eta[0]*O31[1];
+  /** Same as Bragg_double::Do_Double_Bragg_ad() for all members of the ensemble
+    */
+  template<class T, int dim>
+  void Bragg_double_ensemble<T,dim>::Do_Double_Bragg_ad()
+  {
+    //Number of points with the same x coordinate (one x-line)
+    const int nyz = this->Get_dimY()*this->Get_dimZ();
+    const int nx = this->m_no_of_pts/nyz;
+    const int M = this->Get_No_Members();
+
+    //Transversal part of beta*x, identical for all x-lines
+    vector<double> Vyz(nyz);
+    for ( int l=0; l<nyz; l++ )
+    {
+      CPoint<dim> x = this->m_fields[0]->Get_x(l);
+      Vyz[l] = beta*x-beta[0]*x[0];
+    }
 
-        tmp1 = O13[0];
-        O13[0] = eta[0]*tmp1+eta[1]*O13[1];
-        O13[1] = eta[0]*O13[1]-eta[1]*tmp1;
+    #pragma omp parallel
+    {
+      const double dt = this->Get_dt();
+      const double t1 = this->Get_t()+0.5*dt;
+      CPoint<dim> x;
 
-        tmp1 = Omega_p*Omega_p;
-        tmp2 = Omega_m*Omega_m;
-        O22[0] = tmp1*(gamma_2[0]+gamma_1[0]) + tmp2*gamma_3[0];
-        O22[1] = tmp1*(gamma_2[1]+gamma_1[1]) + tmp2*gamma_3[1];
+      // Pulseshapes in time
+      double F = this->Amplitude_at_time();
+      if( F < 0 ) F = 0;
 
-        O33[0] = tmp2*(gamma_2[0]+gamma_1[0]) + tmp1*gamma_3[0];
-        O33[1] = tmp2*(gamma_2[1]+gamma_1[1]) + tmp1*gamma_3[1];
+      double tmp1, tmp2, tmp3, Omega_p, Omega_m, dw, V[2];
 
-        tmp1 = Omega_m*Omega_p;
-        O23[0] = tmp1*(gamma_1[0]+gamma_2[0]-gamma_3[0]);
-        O23[1] = tmp1*(gamma_1[1]+gamma_2[1]-gamma_3[1]);
+      #pragma omp for collapse(2)
+      for ( int m=0; m<M; m++ )
+      {
+        for ( int i=0; i<nx; i++ )
+        {
+          const ensemble_member &p = m_members[m];
+          fftw_complex * const Psi[] = { this->Get_p2Member(m,0), this->Get_p2Member(m,1), this->Get_p2Member(m,2) };
 
-        O32[0] = O23[0];
-        O32[1] = O23[1];
+          const int l0 = i*nyz;
+          x = this->m_fields[0]->Get_x(l0);
 
-        tmp1 = O23[0];
-        O23[0] = (eta[0]*eta[0]+eta[1]*eta[1])*tmp1+2*eta[0]*eta[1]*O23[1];
-        O23[1] = (eta[0]*eta[0]+eta[1]*eta[1])*O23[1]-2*eta[0]*eta[1]*tmp1;
+          const double Vx = beta[0]*x[0];
 
-        tmp1 = O32[0];
-        O32[0] = (eta[0]*eta[0]-eta[1]*eta[1])*tmp1-2*eta[0]*eta[1]*O32[1];
-        O32[1] = (eta[0]*eta[0]-eta[1]*eta[1])*O23[1]+2*eta[0]*eta[1]*tmp1;
+          dw = p.laser_domh+(chirp_rate[0])*t1;
+          Omega_p = F*p.Amp[0]*cos(laser_k[0]*x[0]-dw*t1-p.phase/2);
+          dw = p.laser_domh-(chirp_rate[0])*t1;
+          Omega_m = F*p.Amp[0]*cos(-laser_k[0]*x[0]-dw*t1-p.phase/2);
 
-        gamma_1[0] = Psi_1[l][0];
-        gamma_1[1] = Psi_1[l][1];
-        gamma_2[0] = Psi_2[l][0];
-        gamma_2[1] = Psi_2[l][1];
-        gamma_3[0] = Psi_3[l][0];
-        gamma_3[1] = Psi_3[l][1];
+          const Coupling::cplx eta = std::polar( 1.0, 0.5*laser_dk[0]*x[0] );
+          const Coupling::cplx w[] = { Omega_p*eta, Omega_m*conj(eta) };
 
-        Psi_1[l][0] = (O11[0]*gamma_1[0]-O11[1]*gamma_1[1]) + (O12[0]*gamma_2[0]-O12[1]*gamma_2[1]) + (O13[0]*gamma_3[0]-O13[1]*gamma_3[1]);
-        Psi_1[l][1] = (O11[0]*gamma_1[1]+O11[1]*gamma_1[0]) + (O12[0]*gamma_2[1]+O12[1]*gamma_2[0]) + (O13[0]*gamma_3[1]+O13[1]*gamma_3[0]);
+          for ( int l=l0; l<l0+nyz; l++ )
+          {
+            tmp1 = Psi[0][l][0]*Psi[0][l][0]+Psi[0][l][1]*Psi[0][l][1];
+            tmp2 = Psi[1][l][0]*Psi[1][l][0]+Psi[1][l][1]*Psi[1][l][1];
+            tmp3 = Psi[2][l][0]*Psi[2][l][0]+Psi[2][l][1]*Psi[2][l][1];
 
-        Psi_2[l][0] = (O21[0]*gamma_1[0]-O21[1]*gamma_1[1]) + (O22[0]*gamma_2[0]-O22[1]*gamma_2[1]) + (O23[0]*gamma_3[0]-O23[1]*gamma_3[1]);
-        Psi_2[l][1] = (O21[0]*gamma_1[1]+O21[1]*gamma_1[0]) + (O22[0]*gamma_2[1]+O22[1]*gamma_2[0]) + (O23[0]*gamma_3[1]+O23[1]*gamma_3[0]);
+            V[0] = m_gs[0]*tmp1+m_gs[1]*tmp2+m_gs[2]*tmp3+Vx+Vyz[l-l0];
+            V[1] = m_gs[3]*tmp1+m_gs[4]*tmp2+m_gs[5]*tmp3-p.DeltaL[1]+Vx+Vyz[l-l0];
 
-        Psi_3[l][0] = (O31[0]*gamma_1[0]-O31[1]*gamma_1[1]) + (O32[0]*gamma_2[0]-O32[1]*gamma_2[1]) + (O33[0]*gamma_3[0]-O33[1]*gamma_3[1]);
-        Psi_3[l][1] = (O31[0]*gamma_1[1]+O31[1]*gamma_1[0]) + (O32[0]*gamma_2[1]+O32[1]*gamma_2[0]) + (O33[0]*gamma_3[1]+O33[1]*gamma_3[0]);
+            Coupling::apply<Coupling::Star<3>>( dt, V, w, Psi, l );
+          }
+        }
       }
     }
   }
@@ -282,17 +308,34 @@ int main( int argc, char *argv[] )
     cout << "Errc:     " << e.GetCode() << "\n";
   }
 
-  int no_of_threads = 10;
-  char *envstr = getenv( "MY_NO_OF_THREADS" );
-  if ( envstr != nullptr ) no_of_threads = atoi( envstr );
+  int no_of_threads = Get_No_Of_Threads();
 
   fftw_init_threads();
   fftw_plan_with_nthreads( no_of_threads );
   omp_set_num_threads( no_of_threads );
+  Place_Threads();
 
   try
   {
-    if ( dim == 1 )
+    if ( Get_Ensemble_Size( &params ) > 0 )
+    {
+      if ( dim == 1 )
+      {
+        RT_Solver::Bragg_double_ensemble<Fourier::cft_1d,1> rtsol( &params );
+        rtsol.run_sequence();
+      }
+      else if ( dim == 2 )
+      {
+        RT_Solver::Bragg_double_ensemble<Fourier::cft_2d,2> rtsol( &params );
+        rtsol.run_sequence();
+      }
+      else if ( dim == 3 )
+      {
+        RT_Solver::Bragg_double_ensemble<Fourier::cft_3d,3> rtsol( &params );
+        rtsol.run_sequence();
+      }
+    }
+    else if ( dim == 1 )
     {
       RT_Solver::Bragg_double<Fourier::cft_1d,1> rtsol( &params );
       rtsol.run_sequence();
@@ -36,6 +36,8 @@
 #include "muParser.h"
 #include "ParameterHandler.h"
 #include "CRT_Base_IF.h"
+#include "light_coupling.h"
+#include "thread_setup.h"
 
 using namespace std;
 
@@ -49,6 +51,9 @@ namespace RT_Solver
     virtual ~Raman_single() {};
 
   protected:
+    void Do_Raman_ad();
+    static void Do_Raman_ad_Wrapper(void *,sequence_item &);
+
     bool run_custom_sequence( const sequence_item & );
   };
 
@@ -64,6 +69,8 @@ namespace RT_Solver
    this->m_rabi_momentum_list.push_back(pt1);
     this->m_rabi_momentum_list.push_back(pt2);
     this->m_rabi_momentum_list.push_back(pt3);
+
+    this->m_map_stepfcts["raman_ad"] = &Do_Raman_ad_Wrapper;
   }
 
   template<class T, int dim>
@@ -72,6 +79,75 @@ namespace RT_Solver
     // return true if a custom sequence is found or else
     return false;
   }
+
+  template<class T, int dim>
+  void Raman_single<T,dim>::Do_Raman_ad_Wrapper ( void *ptr, sequence_item & /*item*/ )
+  {
+    Raman_single *self = static_cast<Raman_single *>(ptr);
+    self->Do_Raman_ad();
+  }
+
+  /** Same Hamiltonian as Numerical_Raman() but with the closed form Lambda kernel
+    *
+    * The excited state 2 is coupled to the ground states 0 and 1.
+    */
+  template<class T, int dim>
+  void Raman_single<T,dim>::Do_Raman_ad()
+  {
+    const int nyz = this->Get_dimY()*this->Get_dimZ();
+    const int nx = this->m_no_of_pts/nyz;
+
+    // transversal part of beta*x, identical for all x-lines
+    vector<double> Vyz(nyz);
+    for ( int l=0; l<nyz; l++ )
+    {
+      CPoint<dim> x = this->m_fields[0]->Get_x(l);
+      Vyz[l] = this->beta*x-this->beta[0]*x[0];
+    }
+
+    #pragma omp parallel
+    {
+      const double dt = this->Get_dt();
+
+      // level 0 of the kernel is the excited state
+      fftw_complex * const Psi[] = { this->m_fields[2]->Getp2In(), this->m_fields[0]->Getp2In(), this->m_fields[1]->Getp2In() };
+      fftw_complex * const Psi_in[] = { Psi[1], Psi[2], Psi[0] };
+
+      double phi[3], V[3];
+      CPoint<dim> x;
+
+      #pragma omp for
+      for ( int i=0; i<nx; i++ )
+      {
+        const int l0 = i*nyz;
+        x = this->m_fields[0]->Get_x(l0);
+
+        const double Vx = this->beta[0]*x[0];
+
+        // H_02 = Amp[0]/2*exp(i*k*x), H_12 = Amp[1]/2*exp(-i*k*x)
+        const Coupling::cplx eta = std::polar( 1.0, this->laser_k[0]*x[0] );
+        const Coupling::cplx w[] = { 0.5*this->Amp[0]*eta, 0.5*this->Amp[1]*conj(eta) };
+
+        for ( int l=l0; l<l0+nyz; l++ )
+        {
+          //Diagonal elements + Nonlinear part: \Delta+g|\Phi|^2+\beta*x
+          for ( int k=0; k<3; k++ )
+          {
+            phi[k] = 0;
+            for ( int j=0; j<3; j++ )
+              phi[k] += this->m_gs[j+3*k]*(Psi_in[j][l][0]*Psi_in[j][l][0] + Psi_in[j][l][1]*Psi_in[j][l][1]);
+            phi[k] += Vx+Vyz[l-l0]-this->DeltaL[k];
+          }
+
+          V[0] = phi[2]+this->laser_domh[0];
+          V[1] = phi[0];
+          V[2] = phi[1];
+
+          Coupling::apply<Coupling::Lambda>( dt, V, w, Psi, l );
+        }
+      }
+    }
+  }
 }
 
 int main( int argc, char *argv[] )
@@ -99,13 +175,12 @@ int main( int argc, char *argv[] )
     cout << "Errc:     " << e.GetCode() << "\n";
   }
 
-  int no_of_threads = 4;
-  char *envstr = getenv( "MY_NO_OF_THREADS" );
-  if ( envstr != nullptr ) no_of_threads = atoi( envstr );
+  int no_of_threads = Get_No_Of_Threads();
 
   fftw_init_threads();
   fftw_plan_with_nthreads( no_of_threads );
   omp_set_num_threads( no_of_threads );
+  Place_Threads();
 
   try
   {
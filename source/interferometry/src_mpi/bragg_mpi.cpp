@@ -28,6 +28,7 @@
 #include "muParser.h"
 #include "ParameterHandler.h"
 #include "CRT_Base_IF_mpi.h"
+#include "light_coupling.h"
 
 using namespace std;
 
@@ -64,6 +65,9 @@ namespace MPI
     template<class T, int dim>
     Bragg_single<T,dim>::Bragg_single( ParameterHandler *p ) : CRT_Base_IF_mpi<T,dim,2>( p )
     {
+      // the x-line caching of the light fields and the xy output assume complete yz-planes per rank
+      if ( this->m_fields[0]->Is_Pencil() ) throw std::string("Error in " + string(__func__) + ": the slab decomposition is required, unset MY_MPI_PGRID\n");
+
       this->m_fields[0]->Read_File( p->Get_simulation("FILENAME") );
       this->m_fields[1]->Read_File( p->Get_simulation("FILENAME_2") );
 
@@ -98,96 +102,50 @@ namespace MPI
     {
       MTime.enter_section(__FUNCTION__);
 
-      fftw_complex *Psi_1 = this->m_fields[0]->Get_p2_Data();
-      fftw_complex *Psi_2 = this->m_fields[1]->Get_p2_Data();
+      fftw_complex * const Psi[] = { this->m_fields[0]->Get_p2_Data(), this->m_fields[1]->Get_p2_Data() };
 
       const double dt = this->Get_dt();
       const double t1 = this->Get_t();
-      fftw_complex O11, O12, O21, O22, gamma_p, gamma_m, eta;
-      double re1, im1, tmp1, tmp2, V11, V22, Ep, Em, Omega, test;
-      FILE *fh = nullptr;
+      double tmp1, tmp2, Omega, V[2];
       CPoint<dim> x;
 
       double dw = laser_domh[0]+chirp_rate[0]*t1;
 
-      for ( int l=0; l<this->m_no_of_pts; l++ )
+      // the local slab consists of complete x-lines of length nyz
+      const int nyz = this->Get_dimY()*this->Get_dimZ();
+      const int nx = this->m_no_of_pts/nyz;
+
+      // transversal part of beta*x, identical for all x-lines
+      vector<double> Vyz(nyz);
+      for ( int l=0; l<nyz; l++ )
       {
         x = this->m_fields[0]->Get_x(l);
+        Vyz[l] = (beta*x)-beta[0]*x[0];
+      }
 
-        tmp1 = Psi_1[l][0]*Psi_1[l][0]+Psi_1[l][1]*Psi_1[l][1];
-        tmp2 = Psi_2[l][0]*Psi_2[l][0]+Psi_2[l][1]*Psi_2[l][1];
+      for ( int i=0; i<nx; i++ )
+      {
+        const int l0 = i*nyz;
+        x = this->m_fields[0]->Get_x(l0);
 
-        V11 = this->m_gs[0]*tmp1+this->m_gs[1]*tmp2+(beta*x);
-        V22 = this->m_gs[2]*tmp1+this->m_gs[3]*tmp2-DeltaL[1]+(beta*x);
+        // light field and beta[0]*x[0] are constant along the line
+        const double Vx = beta[0]*x[0];
 
         Omega = Amp[0]*cos(laser_k[0]*x[0]-dw*t1+phase[0]/2);
 
-        if ( Omega == 0.0 )
-        {
-          sincos( -dt*V11, &im1, &re1 );
-          tmp1 = Psi_1[l][0];
-          Psi_1[l][0] = tmp1*re1-Psi_1[l][1]*im1;
-          Psi_1[l][1] = tmp1*im1+Psi_1[l][1]*re1;
-
-          sincos( -dt*V22, &im1, &re1 );
-          tmp1 = Psi_2[l][0];
-          Psi_2[l][0] = tmp1*re1-Psi_2[l][1]*im1;
-          Psi_2[l][1] = tmp1*im1+Psi_2[l][1]*re1;
-          continue;
-        }
-
-        sincos( -0.5*(laser_dk[0]*x[0]+phase[0]), &im1, &re1 );
-        eta[0] = re1;
-        eta[1] = im1;
-
-        tmp1 = sqrt((V11-V22)*(V11-V22)+4.0*Omega*Omega);
-        Ep = 0.5*(V11+V22+tmp1);
-        Em = 0.5*(V11+V22-tmp1);
-
-        sincos( -dt*Ep, &im1, &re1 );
-        tmp1 = 1.0/fabs((V11-Ep)*(V11-Ep)+Omega*Omega);
-        gamma_p[0] = tmp1*re1;
-        gamma_p[1] = tmp1*im1;
-
-        sincos( -dt*Em, &im1, &re1 );
-        tmp1 = 1.0/fabs((V11-Em)*(V11-Em)+Omega*Omega);
-        gamma_m[0] = tmp1*re1;
-        gamma_m[1] = tmp1*im1;
+        // H_21 = Omega*exp(0.5*i*(dk*x+phase))
+        const Coupling::cplx w[] = { Omega*std::polar( 1.0, 0.5*(laser_dk[0]*x[0]+phase[0]) ) };
 
-        tmp1 = Omega*Omega;
-        O11[0] = tmp1*(gamma_p[0]+gamma_m[0]);
-        O11[1] = tmp1*(gamma_p[1]+gamma_m[1]);
-
-        tmp1 = V11-Ep;
-        tmp2 = V11-Em;
-
-        O22[0] = tmp1*tmp1*gamma_p[0]+tmp2*tmp2*gamma_m[0];
-        O22[1] = tmp1*tmp1*gamma_p[1]+tmp2*tmp2*gamma_m[1];
-
-        O12[0] = -Omega*(tmp1*gamma_p[0]+tmp2*gamma_m[0]);
-        O12[1] = -Omega*(tmp1*gamma_p[1]+tmp2*gamma_m[1]);
-
-        O21[0] = O12[0];
-        O21[1] = O12[1];
-
-        tmp1 = O12[0];
-        O12[0] = eta[0]*tmp1-eta[1]*O12[1];
-        O12[1] = eta[1]*tmp1+eta[0]*O12[1];
-
-        tmp1 = O21[0];
-        O21[0] = eta[0]*tmp1+eta[1]*O21[1];
-        O21[1] = eta[0]*O21[1]-eta[1]*tmp1;
-
-        gamma_p[0] = Psi_1[l][0];
-        gamma_p[1] = Psi_1[l][1];
-        gamma_m[0] = Psi_2[l][0];
-        gamma_m[1] = Psi_2[l][1];
+        for ( int l=l0; l<l0+nyz; l++ )
+        {
+          tmp1 = Psi[0][l][0]*Psi[0][l][0]+Psi[0][l][1]*Psi[0][l][1];
+          tmp2 = Psi[1][l][0]*Psi[1][l][0]+Psi[1][l][1]*Psi[1][l][1];
 
-        Psi_1[l][0] = (O11[0]*gamma_p[0]-O11[1]*gamma_p[1]) + (O12[0]*gamma_m[0]-O12[1]*gamma_m[1]);
-        Psi_1[l][1] = (O11[0]*gamma_p[1]+O11[1]*gamma_p[0]) + (O12[0]*gamma_m[1]+O12[1]*gamma_m[0]);
+          V[0] = this->m_gs[0]*tmp1+this->m_gs[1]*tmp2+Vx+Vyz[l-l0];
+          V[1] = this->m_gs[2]*tmp1+this->m_gs[3]*tmp2-DeltaL[1]+Vx+Vyz[l-l0];
 
-        Psi_2[l][0] = (O21[0]*gamma_p[0]-O21[1]*gamma_p[1]) + (O22[0]*gamma_m[0]-O22[1]*gamma_m[1]);
-        Psi_2[l][1] = (O21[0]*gamma_p[1]+O21[1]*gamma_p[0]) + (O22[0]*gamma_m[1]+O22[1]*gamma_m[0]);
+          Coupling::apply<Coupling::Star<2>>( dt, V, w, Psi, l );
+        }
       }
       MTime.exit_section(__FUNCTION__);
     }
@@ -29,6 +29,7 @@
 #include "muParser.h"
 #include "ParameterHandler.h"
 #include "CRT_Base_IF_2_mpi.h"
+#include "light_coupling.h"
 
 using namespace std;
 
@@ -78,6 +79,9 @@ namespace MPI
     template<class T,int dim>
     Bragg_double<T,dim>::Bragg_double( ParameterHandler *p ) : CRT_Base_IF_2_mpi<T,dim,6>( p )
     {
+      // the x-line caching of the light fields and the xy output assume complete yz-planes per rank
+      if ( this->m_fields[0]->Is_Pencil() ) throw std::string("Error in " + string(__func__) + ": the slab decomposition is required, unset MY_MPI_PGRID\n");
+
       m_map_stepfcts["bragg_ad"] = &Do_Bragg_ad_Wrapper;
 
       CPoint<dim> pt1;
@@ -242,37 +246,29 @@ namespace MPI
       const double dt = this->Get_dt();
       const double t1 = this->Get_t()+0.5*dt;
       CPoint<dim> x;
-      vector<ptrdiff_t> global_idx(3);
 
-      fftw_complex O11, O12, O21, O22, O13, O31, O33, O32, O23, gamma_1, gamma_2, gamma_3, eta;
-      double re1, im1, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, V11, V22, E1, E2, Omega_p, Omega_m;
-      ptrdiff_t jk;
+      fftw_complex *Psi[] = { Psi_1, Psi_2, Psi_3 };
+      double tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, Omega_p, Omega_m, V[2];
 
-      for ( ptrdiff_t l=0; l<this->m_no_of_pts; l++ )
-      {
-        x = ft->Get_x(l);
+      // the local slab consists of complete x-lines of length nyz
+      const ptrdiff_t nyz = this->Get_dimY()*this->Get_dimZ();
+      const ptrdiff_t nx = this->m_no_of_pts/nyz;
 
-        switch ( dim )
-        {
-        case 2:
-          ft->local_to_global_rs( l, global_idx );
-          jk = global_idx[1];
-          break;
-        case 3:
-          ft->local_to_global_rs( l, global_idx );
-          jk = global_idx[2]+this->Get_dimY()*global_idx[1];
-          break;
-        }
+      // transversal part of beta*x, identical for all x-lines
+      vector<double> Vyz(nyz);
+      for ( ptrdiff_t jk=0; jk<nyz; jk++ )
+      {
+        x = ft->Get_x(jk);
+        Vyz[jk] = beta*x-beta[0]*x[0];
+      }
 
-        tmp1 = Psi_1[l][0]*Psi_1[l][0]+Psi_1[l][1]*Psi_1[l][1];
-        tmp2 = Psi_2[l][0]*Psi_2[l][0]+Psi_2[l][1]*Psi_2[l][1];
-        tmp3 = Psi_3[l][0]*Psi_3[l][0]+Psi_3[l][1]*Psi_3[l][1];
-        tmp4 = Psi_4[l][0]*Psi_4[l][0]+Psi_4[l][1]*Psi_4[l][1];
-        tmp5 = Psi_5[l][0]*Psi_5[l][0]+Psi_5[l][1]*Psi_5[l][1];
-        tmp6 = Psi_6[l][0]*Psi_6[l][0]+Psi_6[l][1]*Psi_6[l][1];
+      for ( ptrdiff_t i=0; i<nx; i++ )
+      {
+        const ptrdiff_t l0 = i*nyz;
+        x = ft->Get_x(l0);
 
-        V11 = m_gs[0]*tmp1 + m_gs[1]*tmp2 + m_gs[2]*tmp3 + m_gs[3]*tmp4 + m_gs[4]*tmp5 + m_gs[5]*tmp6 + beta*x;
-        V22 = m_gs[6]*tmp1 + m_gs[7]*tmp2 + m_gs[8]*tmp3 + m_gs[9]*tmp4 + m_gs[10]*tmp5 + m_gs[11]*tmp6 - DeltaL[1]+beta*x;
+        // light fields, phase factor and beta[0]*x[0] are constant along the line
+        const double Vx = beta[0]*x[0];
 
         Omega_p = Amp[0]*cos(laser_k[0]*x[0]-(laser_domh[0]+chirp_rate[0]*t1)*t1);
         Omega_m = Amp[0]*cos(-laser_k[0]*x[0]-(laser_domh[0]-chirp_rate[0]*t1)*t1);
@@ -281,120 +277,24 @@ namespace MPI
         //Omega_p = Amp[0]*cos(laser_k[0]*x[0]-(laser_domh[0])*t1);
         //Omega_p = Amp[0]*cos(-laser_k[0]*x[0]-(laser_domh[0])*t1);
 
-        if ((Omega_m == 0.0 ) && ( Omega_p == 0.0 ))
-        {
-          sincos( -dt*V11, &im1, &re1 );
-          tmp1 = Psi_1[l][0];
-          Psi_1[l][0] = tmp1*re1-Psi_1[l][1]*im1;
-          Psi_1[l][1] = tmp1*im1+Psi_1[l][1]*re1;
-
-          sincos( -dt*V22, &im1, &re1 );
-          tmp1 = Psi_2[l][0];
-          Psi_2[l][0] = tmp1*re1-Psi_2[l][1]*im1;
-          Psi_2[l][1] = tmp1*im1+Psi_2[l][1]*re1;
-          tmp1 = Psi_3[l][0];
-          Psi_3[l][0] = tmp1*re1-Psi_3[l][1]*im1;
-          Psi_3[l][1] = tmp1*im1+Psi_3[l][1]*re1;
-          continue;
-        }
-
-        sincos( -0.5*laser_dk[0]*x[0], &im1, &re1 );
-        eta[0] = re1;
-        eta[1] = im1;
-
-        tmp1 = sqrt((V11-V22)*(V11-V22)+4.0*(Omega_p*Omega_p+Omega_m*Omega_m));
-        E1 = 0.5*(V11+V22+tmp1);
-        E2 = 0.5*(V11+V22-tmp1);
-
-        sincos( -dt*E1, &im1, &re1 );
-        tmp1 = 1.0/fabs((V22-E1)*(V22-E1)+Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_1[0] = tmp1*re1;
-        gamma_1[1] = tmp1*im1;
-
-        sincos( -dt*E2, &im1, &re1 );
-        tmp1 = 1.0/fabs((V22-E2)*(V22-E2)+Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_2[0] = tmp1*re1;
-        gamma_2[1] = tmp1*im1;
-
-        sincos( -dt*V22, &im1, &re1);
-        tmp1 = 1.0/fabs(Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_3[0] = tmp1*re1;
-        gamma_3[1] = tmp1*im1;
-
-        tmp1 = (V22-E2)*(V22-E2);
-        tmp2 = (V22-E1)*(V22-E1);
-        O11[0] = tmp1*gamma_2[0] + tmp2*gamma_1[0];
-        O11[1] = tmp1*gamma_2[1] + tmp2*gamma_1[1];
-
-        tmp1 = (V22-E2)*gamma_2[0] + (V22-E1)*gamma_1[0];
-        tmp2 = (V22-E2)*gamma_2[1] + (V22-E1)*gamma_1[1];
+        // H_21 = Omega_p*exp(0.5*i*dk*x), H_31 = Omega_m*exp(-0.5*i*dk*x)
+        const Coupling::cplx eta = std::polar( 1.0, 0.5*laser_dk[0]*x[0] );
+        const Coupling::cplx w[] = { Omega_p*eta, Omega_m*conj(eta) };
 
-        O12[0] = -Omega_p*tmp1;
-        O12[1] = -Omega_p*tmp2;
-
-        O13[0] = -Omega_m*tmp1;
-        O13[1] = -Omega_m*tmp2;
-
-        O21[0] = O12[0];
-        O21[1] = O12[1];
-
-        O31[0] = O13[0];
-        O31[1] = O13[1];
-
-        tmp1 = O12[0];
-        O12[0] = eta[0]*tmp1-eta[1]*O12[1];
-        O12[1] = eta[1]*tmp1+eta[0]*O12[1];
-
-        tmp1 = O21[0];
-        O21[0] = eta[0]*tmp1+eta[1]*O21[1];
-        O21[1] = eta[0]*O21[1]-eta[1]*tmp1;
-
-        tmp1 = O31[0];
-        O31[0] = eta[0]*tmp1-eta[1]*O31[1];
-        O31[1] = eta[1]*tmp1+eta[0]*O31[1];
-
-        tmp1 = O13[0];
-        O13[0] = eta[0]*tmp1+eta[1]*O13[1];
-        O13[1] = eta[0]*O13[1]-eta[1]*tmp1;
-
-        tmp1 = Omega_p*Omega_p;
-        tmp2 = Omega_m*Omega_m;
-        O22[0] = tmp1*(gamma_2[0]+gamma_1[0]) + tmp2*gamma_3[0];
-        O22[1] = tmp1*(gamma_2[1]+gamma_1[1]) + tmp2*gamma_3[1];
-
-        O33[0] = tmp2*(gamma_2[0]+gamma_1[0]) + tmp1*gamma_3[0];
-        O33[1] = tmp2*(gamma_2[1]+gamma_1[1]) + tmp1*gamma_3[1];
-
-        tmp1 = Omega_m*Omega_p;
-        O23[0] = tmp1*(gamma_1[0]+gamma_2[0]-gamma_3[0]);
-        O23[1] = tmp1*(gamma_1[1]+gamma_2[1]-gamma_3[1]);
-
-        O32[0] = O23[0];
-        O32[1] = O23[1];
-
-        tmp1 = O23[0];
-        O23[0] = (eta[0]*eta[0]+eta[1]*eta[1])*tmp1+2*eta[0]*eta[1]*O23[1];
-        O23[1] = (eta[0]*eta[0]+eta[1]*eta[1])*O23[1]-2*eta[0]*eta[1]*tmp1;
-
-        tmp1 = O32[0];
-        O32[0] = (eta[0]*eta[0]-eta[1]*eta[1])*tmp1-2*eta[0]*eta[1]*O32[1];
-        O32[1] = (eta[0]*eta[0]-eta[1]*eta[1])*O23[1]+2*eta[0]*eta[1]*tmp1;
-
-        gamma_1[0] = Psi_1[l][0];
-        gamma_1[1] = Psi_1[l][1];
-        gamma_2[0] = Psi_2[l][0];
-        gamma_2[1] = Psi_2[l][1];
-        gamma_3[0] = Psi_3[l][0];
-        gamma_3[1] = Psi_3[l][1];
-
-        Psi_1[l][0] = (O11[0]*gamma_1[0]-O11[1]*gamma_1[1]) + (O12[0]*gamma_2[0]-O12[1]*gamma_2[1]) + (O13[0]*gamma_3[0]-O13[1]*gamma_3[1]);
-        Psi_1[l][1] = (O11[0]*gamma_1[1]+O11[1]*gamma_1[0]) + (O12[0]*gamma_2[1]+O12[1]*gamma_2[0]) + (O13[0]*gamma_3[1]+O13[1]*gamma_3[0]);
+        for ( ptrdiff_t l=l0; l<l0+nyz; l++ )
+        {
+          tmp1 = Psi_1[l][0]*Psi_1[l][0]+Psi_1[l][1]*Psi_1[l][1];
+          tmp2 = Psi_2[l][0]*Psi_2[l][0]+Psi_2[l][1]*Psi_2[l][1];
+          tmp3 = Psi_3[l][0]*Psi_3[l][0]+Psi_3[l][1]*Psi_3[l][1];
+          tmp4 = Psi_4[l][0]*Psi_4[l][0]+Psi_4[l][1]*Psi_4[l][1];
+          tmp5 = Psi_5[l][0]*Psi_5[l][0]+Psi_5[l][1]*Psi_5[l][1];
+          tmp6 = Psi_6[l][0]*Psi_6[l][0]+Psi_6[l][1]*Psi_6[l][1];
 
-        Psi_2[l][0] = (O21[0]*gamma_1[0]-O21[1]*gamma_1[1]) + (O22[0]*gamma_2[0]-O22[1]*gamma_2[1]) + (O23[0]*gamma_3[0]-O23[1]*gamma_3[1]);
-        Psi_2[l][1] = (O21[0]*gamma_1[1]+O21[1]*gamma_1[0]) + (O22[0]*gamma_2[1]+O22[1]*gamma_2[0]) + (O23[0]*gamma_3[1]+O23[1]*gamma_3[0]);
+          V[0] = m_gs[0]*tmp1 + m_gs[1]*tmp2 + m_gs[2]*tmp3 + m_gs[3]*tmp4 + m_gs[4]*tmp5 + m_gs[5]*tmp6 + Vx+Vyz[l-l0];
+          V[1] = m_gs[6]*tmp1 + m_gs[7]*tmp2 + m_gs[8]*tmp3 + m_gs[9]*tmp4 + m_gs[10]*tmp5 + m_gs[11]*tmp6 - DeltaL[1]+Vx+Vyz[l-l0];
 
-        Psi_3[l][0] = (O31[0]*gamma_1[0]-O31[1]*gamma_1[1]) + (O32[0]*gamma_2[0]-O32[1]*gamma_2[1]) + (O33[0]*gamma_3[0]-O33[1]*gamma_3[1]);
-        Psi_3[l][1] = (O31[0]*gamma_1[1]+O31[1]*gamma_1[0]) + (O32[0]*gamma_2[1]+O32[1]*gamma_2[0]) + (O33[0]*gamma_3[1]+O33[1]*gamma_3[0]);
+          Coupling::apply<Coupling::Star<3>>( dt, V, w, Psi, l );
+        }
       }
 
       // second species
@@ -404,32 +304,17 @@ namespace MPI
       Psi_4 = this->m_fields[0]->Get_p2_Data();
       Psi_5 = this->m_fields[1]->Get_p2_Data();
       Psi_6 = this->m_fields[2]->Get_p2_Data();
+      Psi[0] = Psi_1;
+      Psi[1] = Psi_2;
+      Psi[2] = Psi_3;
 
-      for ( ptrdiff_t l=0; l<this->m_no_of_pts; l++ )
+      for ( ptrdiff_t i=0; i<nx; i++ )
       {
-        x = ft->Get_x(l);
-
-        switch ( dim )
-        {
-        case 2:
-          ft->local_to_global_rs( l, global_idx );
-          jk = global_idx[1];
-          break;
-        case 3:
-          ft->local_to_global_rs( l, global_idx );
-          jk = global_idx[2]+this->Get_dimY()*global_idx[1];
-          break;
-        }
+        const ptrdiff_t l0 = i*nyz;
+        x = ft->Get_x(l0);
 
-        tmp1 = Psi_1[l][0]*Psi_1[l][0]+Psi_1[l][1]*Psi_1[l][1];
-        tmp2 = Psi_2[l][0]*Psi_2[l][0]+Psi_2[l][1]*Psi_2[l][1];
-        tmp3 = Psi_3[l][0]*Psi_3[l][0]+Psi_3[l][1]*Psi_3[l][1];
-        tmp4 = Psi_4[l][0]*Psi_4[l][0]+Psi_4[l][1]*Psi_4[l][1];
-        tmp5 = Psi_5[l][0]*Psi_5[l][0]+Psi_5[l][1]*Psi_5[l][1];
-        tmp6 = Psi_6[l][0]*Psi_6[l][0]+Psi_6[l][1]*Psi_6[l][1];
-
-        V11 = m_gs[43]*tmp1 + m_gs[44]*tmp2 + m_gs[45]*tmp3 + m_gs[3]*tmp4 + m_gs[4]*tmp5 + m_gs[5]*tmp6 + beta*x;
-        V22 = m_gs[53]*tmp1 + m_gs[54]*tmp2 + m_gs[55]*tmp3 + m_gs[9]*tmp4 + m_gs[10]*tmp5 + m_gs[11]*tmp6 - DeltaL[1]+beta*x;
+        // light fields, phase factor and beta[0]*x[0] are constant along the line
+        const double Vx = beta[0]*x[0];
 
         Omega_p = Amp2[0]*cos(laser_k2[0]*x[0]-(laser_domh2[0]+chirp_rate[0]*t1)*t1);
         Omega_m = Amp2[0]*cos(-laser_k2[0]*x[0]-(laser_domh2[0]-chirp_rate[0]*t1)*t1);
@@ -438,120 +323,24 @@ namespace MPI
         //Omega_p = Amp[0]*cos(laser_k[0]*x[0]-(laser_domh[0])*t1);
         //Omega_p = Amp[0]*cos(-laser_k[0]*x[0]-(laser_domh[0])*t1);
 
-        if ((Omega_m == 0.0 ) && ( Omega_p == 0.0 ))
-        {
-          sincos( -dt*V11, &im1, &re1 );
-          tmp1 = Psi_1[l][0];
-          Psi_1[l][0] = tmp1*re1-Psi_1[l][1]*im1;
-          Psi_1[l][1] = tmp1*im1+Psi_1[l][1]*re1;
-
-          sincos( -dt*V22, &im1, &re1 );
-          tmp1 = Psi_2[l][0];
-          Psi_2[l][0] = tmp1*re1-Psi_2[l][1]*im1;
-          Psi_2[l][1] = tmp1*im1+Psi_2[l][1]*re1;
-          tmp1 = Psi_3[l][0];
-          Psi_3[l][0] = tmp1*re1-Psi_3[l][1]*im1;
-          Psi_3[l][1] = tmp1*im1+Psi_3[l][1]*re1;
-          continue;
-        }
-
-        sincos( -0.5*laser_dk[0]*x[0], &im1, &re1 );
-        eta[0] = re1;
-        eta[1] = im1;
-
-        tmp1 = sqrt((V11-V22)*(V11-V22)+4.0*(Omega_p*Omega_p+Omega_m*Omega_m));
-        E1 = 0.5*(V11+V22+tmp1);
-        E2 = 0.5*(V11+V22-tmp1);
-
-        sincos( -dt*E1, &im1, &re1 );
-        tmp1 = 1.0/fabs((V22-E1)*(V22-E1)+Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_1[0] = tmp1*re1;
-        gamma_1[1] = tmp1*im1;
-
-        sincos( -dt*E2, &im1, &re1 );
-        tmp1 = 1.0/fabs((V22-E2)*(V22-E2)+Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_2[0] = tmp1*re1;
-        gamma_2[1] = tmp1*im1;
-
-        sincos( -dt*V22, &im1, &re1);
-        tmp1 = 1.0/fabs(Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_3[0] = tmp1*re1;
-        gamma_3[1] = tmp1*im1;
-
-        tmp1 = (V22-E2)*(V22-E2);
-        tmp2 = (V22-E1)*(V22-E1);
-        O11[0] = tmp1*gamma_2[0] + tmp2*gamma_1[0];
-        O11[1] = tmp1*gamma_2[1] + tmp2*gamma_1[1];
-
-        tmp1 = (V22-E2)*gamma_2[0] + (V22-E1)*gamma_1[0];
-        tmp2 = (V22-E2)*gamma_2[1] + (V22-E1)*gamma_1[1];
-
-        O12[0] = -Omega_p*tmp1;
-        O12[1] = -Omega_p*tmp2;
-
-        O13[0] = -Omega_m*tmp1;
-        O13[1] = -Omega_m*tmp2;
+        // H_21 = Omega_p*exp(0.5*i*dk*x), H_31 = Omega_m*exp(-0.5*i*dk*x)
+        const Coupling::cplx eta = std::polar( 1.0, 0.5*laser_dk[0]*x[0] );
+        const Coupling::cplx w[] = { Omega_p*eta, Omega_m*conj(eta) };
 
-        O21[0] = O12[0];
-        O21[1] = O12[1];
-
-        O31[0] = O13[0];
-        O31[1] = O13[1];
-
-        tmp1 = O12[0];
-        O12[0] = eta[0]*tmp1-eta[1]*O12[1];
-        O12[1] = eta[1]*tmp1+eta[0]*O12[1];
-
-        tmp1 = O21[0];
-        O21[0] = eta[0]*tmp1+eta[1]*O21[1];
-        O21[1] = eta[0]*O21[1]-eta[1]*tmp1;
-
-        tmp1 = O31[0];
-        O31[0] = eta[0]*tmp1-eta[1]*O31[1];
-        O31[1] = eta[1]*tmp1+eta[0]*O31[1];
-
-        tmp1 = O13[0];
-        O13[0] = eta[0]*tmp1+eta[1]*O13[1];
-        O13[1] = eta[0]*O13[1]-eta[1]*tmp1;
-
-        tmp1 = Omega_p*Omega_p;
-        tmp2 = Omega_m*Omega_m;
-        O22[0] = tmp1*(gamma_2[0]+gamma_1[0]) + tmp2*gamma_3[0];
-        O22[1] = tmp1*(gamma_2[1]+gamma_1[1]) + tmp2*gamma_3[1];
-
-        O33[0] = tmp2*(gamma_2[0]+gamma_1[0]) + tmp1*gamma_3[0];
-        O33[1] = tmp2*(gamma_2[1]+gamma_1[1]) + tmp1*gamma_3[1];
-
-        tmp1 = Omega_m*Omega_p;
-        O23[0] = tmp1*(gamma_1[0]+gamma_2[0]-gamma_3[0]);
-        O23[1] = tmp1*(gamma_1[1]+gamma_2[1]-gamma_3[1]);
-
-        O32[0] = O23[0];
-        O32[1] = O23[1];
-
-        tmp1 = O23[0];
-        O23[0] = (eta[0]*eta[0]+eta[1]*eta[1])*tmp1+2*eta[0]*eta[1]*O23[1];
-        O23[1] = (eta[0]*eta[0]+eta[1]*eta[1])*O23[1]-2*eta[0]*eta[1]*tmp1;
-
-        tmp1 = O32[0];
-        O32[0] = (eta[0]*eta[0]-eta[1]*eta[1])*tmp1-2*eta[0]*eta[1]*O32[1];
-        O32[1] = (eta[0]*eta[0]-eta[1]*eta[1])*O23[1]+2*eta[0]*eta[1]*tmp1;
-
-        gamma_1[0] = Psi_1[l][0];
-        gamma_1[1] = Psi_1[l][1];
-        gamma_2[0] = Psi_2[l][0];
-        gamma_2[1] = Psi_2[l][1];
-        gamma_3[0] = Psi_3[l][0];
-        gamma_3[1] = Psi_3[l][1];
-
-        Psi_1[l][0] = (O11[0]*gamma_1[0]-O11[1]*gamma_1[1]) + (O12[0]*gamma_2[0]-O12[1]*gamma_2[1]) + (O13[0]*gamma_3[0]-O13[1]*gamma_3[1]);
-        Psi_1[l][1] = (O11[0]*gamma_1[1]+O11[1]*gamma_1[0]) + (O12[0]*gamma_2[1]+O12[1]*gamma_2[0]) + (O13[0]*gamma_3[1]+O13[1]*gamma_3[0]);
+        for ( ptrdiff_t l=l0; l<l0+nyz; l++ )
+        {
+          tmp1 = Psi_1[l][0]*Psi_1[l][0]+Psi_1[l][1]*Psi_1[l][1];
+          tmp2 = Psi_2[l][0]*Psi_2[l][0]+Psi_2[l][1]*Psi_2[l][1];
+          tmp3 = Psi_3[l][0]*Psi_3[l][0]+Psi_3[l][1]*Psi_3[l][1];
+          tmp4 = Psi_4[l][0]*Psi_4[l][0]+Psi_4[l][1]*Psi_4[l][1];
+          tmp5 = Psi_5[l][0]*Psi_5[l][0]+Psi_5[l][1]*Psi_5[l][1];
+          tmp6 = Psi_6[l][0]*Psi_6[l][0]+Psi_6[l][1]*Psi_6[l][1];
 
-        Psi_2[l][0] = (O21[0]*gamma_1[0]-O21[1]*gamma_1[1]) + (O22[0]*gamma_2[0]-O22[1]*gamma_2[1]) + (O23[0]*gamma_3[0]-O23[1]*gamma_3[1]);
-        Psi_2[l][1] = (O21[0]*gamma_1[1]+O21[1]*gamma_1[0]) + (O22[0]*gamma_2[1]+O22[1]*gamma_2[0]) + (O23[0]*gamma_3[1]+O23[1]*gamma_3[0]);
+          V[0] = m_gs[43]*tmp1 + m_gs[44]*tmp2 + m_gs[45]*tmp3 + m_gs[3]*tmp4 + m_gs[4]*tmp5 + m_gs[5]*tmp6 + Vx+Vyz[l-l0];
+          V[1] = m_gs[53]*tmp1 + m_gs[54]*tmp2 + m_gs[55]*tmp3 + m_gs[9]*tmp4 + m_gs[10]*tmp5 + m_gs[11]*tmp6 - DeltaL[1]+Vx+Vyz[l-l0];
 
-        Psi_3[l][0] = (O31[0]*gamma_1[0]-O31[1]*gamma_1[1]) + (O32[0]*gamma_2[0]-O32[1]*gamma_2[1]) + (O33[0]*gamma_3[0]-O33[1]*gamma_3[1]);
-        Psi_3[l][1] = (O31[0]*gamma_1[1]+O31[1]*gamma_1[0]) + (O32[0]*gamma_2[1]+O32[1]*gamma_2[0]) + (O33[0]*gamma_3[1]+O33[1]*gamma_3[0]);
+          Coupling::apply<Coupling::Star<3>>( dt, V, w, Psi, l );
+        }
       }
 
       //MTime.exit_section("Do_NL_Step_light_ana");
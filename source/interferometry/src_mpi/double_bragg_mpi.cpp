@@ -27,6 +27,7 @@
 #include "muParser.h"
 #include "ParameterHandler.h"
 #include "CRT_Base_IF_mpi.h"
+#include "light_coupling.h"
 
 using namespace std;
 
@@ -73,6 +74,9 @@ namespace MPI
     template<class T,int dim>
     Bragg_double<T,dim>::Bragg_double( ParameterHandler *p ) : CRT_Base_IF_mpi<T,dim,3>( p )
     {
+      // the x-line caching of the light fields and the xy output assume complete yz-planes per rank
+      if ( this->m_fields[0]->Is_Pencil() ) throw std::string("Error in " + string(__func__) + ": the slab decomposition is required, unset MY_MPI_PGRID\n");
+
       m_map_stepfcts["bragg_ad"] = &Do_Bragg_ad_Wrapper;
 
       CPoint<dim> pt1;
@@ -86,10 +90,10 @@ namespace MPI
 
       switch (dim)
       {
-      case 1:
+      case 2:
         m_no_of_Mirror_pts = this->Get_dimY();
         break;
-      case 2:
+      case 3:
         m_no_of_Mirror_pts = this->Get_dimY()*this->Get_dimZ();
         this->m_custom_fct=&Save_Psi_xy_Wrapper;
         break;
@@ -217,162 +221,61 @@ namespace MPI
     {
       MTime.enter_section("Do_NL_Step_light_ana");
 
-      fftw_complex *Psi_1 = this->m_fields[0]->Get_p2_Data();
-      fftw_complex *Psi_2 = this->m_fields[1]->Get_p2_Data();
-      fftw_complex *Psi_3 = this->m_fields[2]->Get_p2_Data();
+      fftw_complex * const Psi[] = { this->m_fields[0]->Get_p2_Data(), this->m_fields[1]->Get_p2_Data(), this->m_fields[2]->Get_p2_Data() };
       T *ft = reinterpret_cast<T *>(this->m_fields[0]);
 
       const double dt = this->Get_dt();
       const double t1 = this->Get_t()+0.5*dt;
       CPoint<dim> x;
-      vector<ptrdiff_t> global_idx(3);
 
-      fftw_complex O11, O12, O21, O22, O13, O31, O33, O32, O23, gamma_1, gamma_2, gamma_3, eta;
-      double re1, im1, tmp1, tmp2, tmp3, V11, V22, E1, E2, Omega_p, Omega_m;
-      ptrdiff_t jk;
+      double tmp1, tmp2, tmp3, Omega_p, Omega_m, cos_p, sin_p, cos_m, sin_m, V[2];
 
-      for ( ptrdiff_t l=0; l<this->m_no_of_pts; l++ )
-      {
-        x = ft->Get_x(l);
+      // the local slab consists of complete x-lines of length nyz
+      const ptrdiff_t nyz = this->Get_dimY()*this->Get_dimZ();
+      const ptrdiff_t nx = this->m_no_of_pts/nyz;
 
-        switch ( dim )
-        {
-        case 2:
-          ft->local_to_global_rs( l, global_idx );
-          jk = global_idx[1];
-          break;
-        case 3:
-          ft->local_to_global_rs( l, global_idx );
-          jk = global_idx[2]+this->Get_dimY()*global_idx[1];
-          break;
-        }
+      // transversal part of beta*x and the mirror phase factors are identical for all x-lines
+      // (the mirror is stored as a dimY x dimZ array, i.e. with the same layout as one x-line)
+      vector<double> Vyz(nyz), cos_mirror(nyz), sin_mirror(nyz);
+      for ( ptrdiff_t jk=0; jk<nyz; jk++ )
+      {
+        x = ft->Get_x(jk);
+        Vyz[jk] = beta*x-beta[0]*x[0];
+        sincos( 0.5*m_Mirror[jk], &sin_mirror[jk], &cos_mirror[jk] );
+      }
 
-        tmp1 = Psi_1[l][0]*Psi_1[l][0]+Psi_1[l][1]*Psi_1[l][1];
-        tmp2 = Psi_2[l][0]*Psi_2[l][0]+Psi_2[l][1]*Psi_2[l][1];
-        tmp3 = Psi_3[l][0]*Psi_3[l][0]+Psi_3[l][1]*Psi_3[l][1];
+      for ( ptrdiff_t i=0; i<nx; i++ )
+      {
+        const ptrdiff_t l0 = i*nyz;
+        x = ft->Get_x(l0);
 
-        V11 = m_gs[0]*tmp1+m_gs[1]*tmp2+m_gs[2]*tmp3+beta*x;
-        V22 = m_gs[3]*tmp1+m_gs[4]*tmp2+m_gs[5]*tmp3-DeltaL[1]+beta*x;
+        // x-only parts of the light fields and the phase factor are evaluated once per line,
+        // the mirror phase is added via cos(a-b) = cos(a)cos(b)+sin(a)sin(b)
+        const double Vx = beta[0]*x[0];
+        sincos( laser_k[0]*x[0]-(laser_domh[0]+chirp_rate[0]*t1)*t1-0.5*phase[0], &sin_p, &cos_p );
+        sincos( -laser_k[0]*x[0]-(laser_domh[0]-chirp_rate[0]*t1)*t1-0.5*phase[0], &sin_m, &cos_m );
 
-        Omega_p = Amp[0]*cos(laser_k[0]*x[0]-(laser_domh[0]+chirp_rate[0]*t1)*t1-0.5*(phase[0]+m_Mirror[jk]));
-        Omega_m = Amp[0]*cos(-laser_k[0]*x[0]-(laser_domh[0]-chirp_rate[0]*t1)*t1-0.5*(phase[0]-m_Mirror[jk]));
-        //Omega_p = Amp[0]*cos(laser_k[0]*x[0]-(laser_domh[0])*t1);
-        //Omega_p = Amp[0]*cos(-laser_k[0]*x[0]-(laser_domh[0])*t1);
+        const Coupling::cplx eta = std::polar( 1.0, 0.5*laser_dk[0]*x[0] );
 
-        if ((Omega_m == 0.0 ) && ( Omega_p == 0.0 ))
+        for ( ptrdiff_t l=l0; l<l0+nyz; l++ )
         {
-          sincos( -dt*V11, &im1, &re1 );
-          tmp1 = Psi_1[l][0];
-          Psi_1[l][0] = tmp1*re1-Psi_1[l][1]*im1;
-          Psi_1[l][1] = tmp1*im1+Psi_1[l][1]*re1;
-
-          sincos( -dt*V22, &im1, &re1 );
-          tmp1 = Psi_2[l][0];
-          Psi_2[l][0] = tmp1*re1-Psi_2[l][1]*im1;
-          Psi_2[l][1] = tmp1*im1+Psi_2[l][1]*re1;
-          tmp1 = Psi_3[l][0];
-          Psi_3[l][0] = tmp1*re1-Psi_3[l][1]*im1;
-          Psi_3[l][1] = tmp1*im1+Psi_3[l][1]*re1;
-          continue;
-        }
-
-        sincos( -0.5*laser_dk[0]*x[0], &im1, &re1 );
-        eta[0] = re1;
-        eta[1] = im1;
-
-        tmp1 = sqrt((V11-V22)*(V11-V22)+4.0*(Omega_p*Omega_p+Omega_m*Omega_m));
-        E1 = 0.5*(V11+V22+tmp1);
-        E2 = 0.5*(V11+V22-tmp1);
-
-        sincos( -dt*E1, &im1, &re1 );
-        tmp1 = 1.0/fabs((V22-E1)*(V22-E1)+Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_1[0] = tmp1*re1;
-        gamma_1[1] = tmp1*im1;
-
-        sincos( -dt*E2, &im1, &re1 );
-        tmp1 = 1.0/fabs((V22-E2)*(V22-E2)+Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_2[0] = tmp1*re1;
-        gamma_2[1] = tmp1*im1;
-
-        sincos( -dt*V22, &im1, &re1);
-        tmp1 = 1.0/fabs(Omega_p*Omega_p+Omega_m*Omega_m);
-        gamma_3[0] = tmp1*re1;
-        gamma_3[1] = tmp1*im1;
+          const ptrdiff_t jk = l-l0;
 
-        tmp1 = (V22-E2)*(V22-E2);
-        tmp2 = (V22-E1)*(V22-E1);
-        O11[0] = tmp1*gamma_2[0] + tmp2*gamma_1[0];
-        O11[1] = tmp1*gamma_2[1] + tmp2*gamma_1[1];
+          tmp1 = Psi[0][l][0]*Psi[0][l][0]+Psi[0][l][1]*Psi[0][l][1];
+          tmp2 = Psi[1][l][0]*Psi[1][l][0]+Psi[1][l][1]*Psi[1][l][1];
+          tmp3 = Psi[2][l][0]*Psi[2][l][0]+Psi[2][l][1]*Psi[2][l][1];
 
-        tmp1 = (V22-E2)*gamma_2[0] + (V22-E1)*gamma_1[0];
-        tmp2 = (V22-E2)*gamma_2[1] + (V22-E1)*gamma_1[1];
+          V[0] = m_gs[0]*tmp1+m_gs[1]*tmp2+m_gs[2]*tmp3+Vx+Vyz[jk];
+          V[1] = m_gs[3]*tmp1+m_gs[4]*tmp2+m_gs[5]*tmp3-DeltaL[1]+Vx+Vyz[jk];
 
-        O12[0] = -Omega_p*tmp1;
-        O12[1] = -Omega_p*tmp2;
+          Omega_p = Amp[0]*(cos_p*cos_mirror[jk]+sin_p*sin_mirror[jk]);
+          Omega_m = Amp[0]*(cos_m*cos_mirror[jk]-sin_m*sin_mirror[jk]);
 
-        O13[0] = -Omega_m*tmp1;
-        O13[1] = -Omega_m*tmp2;
+          // H_21 = Omega_p*exp(0.5*i*dk*x), H_31 = Omega_m*exp(-0.5*i*dk*x)
+          const Coupling::cplx w[] = { Omega_p*eta, Omega_m*conj(eta) };
 
-        O21[0] = O12[0];
-        O21[1] = O12[1];
-
-        O31[0] = O13[0];
-        O31[1] = O13[1];
-
-        tmp1 = O12[0];
-        O12[0] = eta[0]*tmp1-eta[1]*O12[1];
-        O12[1] = eta[1]*tmp1+eta[0]*O12[1];
-
-        tmp1 = O21[0];
-        O21[0] = eta[0]*tmp1+eta[1]*O21[1];
-        O21[1] = eta[0]*O21[1]-eta[1]*tmp1;
-
-        tmp1 = O31[0];
-        O31[0] = eta[0]*tmp1-eta[1]*O31[1];
-        O31[1] = eta[1]*tmp1+eta[0]*O31[1];
-
-        tmp1 = O13[0];
-        O13[0] = eta[0]*tmp1+eta[1]*O13[1];
-        O13[1] = eta[0]*O13[1]-eta[1]*tmp1;
-
-        tmp1 = Omega_p*Omega_p;
-        tmp2 = Omega_m*Omega_m;
-        O22[0] = tmp1*(gamma_2[0]+gamma_1[0]) + tmp2*gamma_3[0];
-        O22[1] = tmp1*(gamma_2[1]+gamma_1[1]) + tmp2*gamma_3[1];
-
-        O33[0] = tmp2*(gamma_2[0]+gamma_1[0]) + tmp1*gamma_3[0];
-        O33[1] = tmp2*(gamma_2[1]+gamma_1[1]) + tmp1*gamma_3[1];
-
-        tmp1 = Omega_m*Omega_p;
-        O23[0] = tmp1*(gamma_1[0]+gamma_2[0]-gamma_3[0]);
-        O23[1] = tmp1*(gamma_1[1]+gamma_2[1]-gamma_3[1]);
-
-        O32[0] = O23[0];
-        O32[1] = O23[1];
-
-        tmp1 = O23[0];
-        O23[0] = (eta[0]*eta[0]+eta[1]*eta[1])*tmp1+2*eta[0]*eta[1]*O23[1];
-        O23[1] = (eta[0]*eta[0]+eta[1]*eta[1])*O23[1]-2*eta[0]*eta[1]*tmp1;
-
-        tmp1 = O32[0];
-        O32[0] = (eta[0]*eta[0]-eta[1]*eta[1])*tmp1-2*eta[0]*eta[1]*O32[1];
-        O32[1] = (eta[0]*eta[0]-eta[1]*eta[1])*O23[1]+2*eta[0]*eta[1]*tmp1;
-
-        gamma_1[0] = Psi_1[l][0];
-        gamma_1[1] = Psi_1[l][1];
-        gamma_2[0] = Psi_2[l][0];
-        gamma_2[1] = Psi_2[l][1];
-        gamma_3[0] = Psi_3[l][0];
-        gamma_3[1] = Psi_3[l][1];
-
-        Psi_1[l][0] = (O11[0]*gamma_1[0]-O11[1]*gamma_1[1]) + (O12[0]*gamma_2[0]-O12[1]*gamma_2[1]) + (O13[0]*gamma_3[0]-O13[1]*gamma_3[1]);
-        Psi_1[l][1] = (O11[0]*gamma_1[1]+O11[1]*gamma_1[0]) + (O12[0]*gamma_2[1]+O12[1]*gamma_2[0]) + (O13[0]*gamma_3[1]+O13[1]*gamma_3[0]);
-
-        Psi_2[l][0] = (O21[0]*gamma_1[0]-O21[1]*gamma_1[1]) + (O22[0]*gamma_2[0]-O22[1]*gamma_2[1]) + (O23[0]*gamma_3[0]-O23[1]*gamma_3[1]);
-        Psi_2[l][1] = (O21[0]*gamma_1[1]+O21[1]*gamma_1[0]) + (O22[0]*gamma_2[1]+O22[1]*gamma_2[0]) + (O23[0]*gamma_3[1]+O23[1]*gamma_3[0]);
-
-        Psi_3[l][0] = (O31[0]*gamma_1[0]-O31[1]*gamma_1[1]) + (O32[0]*gamma_2[0]-O32[1]*gamma_2[1]) + (O33[0]*gamma_3[0]-O33[1]*gamma_3[1]);
-        Psi_3[l][1] = (O31[0]*gamma_1[1]+O31[1]*gamma_1[0]) + (O32[0]*gamma_2[1]+O32[1]*gamma_2[0]) + (O33[0]*gamma_3[1]+O33[1]*gamma_3[0]);
+          Coupling::apply<Coupling::Star<3>>( dt, V, w, Psi, l );
+        }
       }
 
       MTime.exit_section("Do_NL_Step_light_ana");
@@ -68,6 +68,8 @@ void ParameterHandler::populate_sequence()
     item.dt = node.node().attribute("dt").as_double(0.001);
     item.Nk =  node.node().attribute("Nk").as_int(100);;
     item.comp = node.node().attribute("comp").as_int(0);
+    item.tol = node.node().attribute("tol").as_double(1e-8);
+    item.dt_levels = node.node().attribute("dt_levels").as_int(3);
 
     tmpstr = node.node().attribute("output_freq").as_string("none");
     item.output_freq = m_map_freq[tmpstr];
@@ -477,9 +479,10 @@ int ParameterHandler::Get_NK()
   return retval;
 }
 
-int ParameterHandler::Get_MaxIter()
+/** Returns ALGORITHM/MAXITER, def if it is not set */
+int ParameterHandler::Get_MaxIter( const int def )
 {
-  int retval=10;
+  int retval=def;
   auto it = m_map_algorithm.find("MAXITER");
   if ( it != m_map_algorithm.end() ) retval = stoi((*it).second);
   return retval;
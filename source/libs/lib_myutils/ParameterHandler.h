@@ -31,6 +31,8 @@ struct sequence_item
   int compute_pn_freq; ///< set frequency for computing particle numbers
   int analyze; ///< output frequency for analyzing tools
   int Nk; ///< number of intermediate steps
+  double tol; ///< relative tolerance of the chemical potentials (imag_time)
+  int dt_levels; ///< number of halvings of dt (imag_time)
   double time;
 };
 
@@ -59,6 +61,10 @@ public:
   double Get_VConstant( const std::string, const int );
   /** Returns values as a vector of a tag <string> in the VConstant section of the xml file */
   std::vector<double> Get_VConstant( const std::string );
+  /** Returns all tags of the Constant section */
+  const std::map<std::string,double> & Get_Constants() const { return m_map_constants; }
+  /** Returns all tags of the VConstant section */
+  const std::map<std::string,std::vector<double>> & Get_VConstants() const { return m_map_vconstants; }
   /** Returns all momentum states in a vector */
   bool Get_MomentumStates( std::vector<double>&, const int );
 
@@ -78,7 +84,7 @@ public:
   int Get_NZ();
   int Get_NA();
   int Get_NK();
-  int Get_MaxIter();
+  int Get_MaxIter( const int=10 );
 
   void Setup_muParser( mu::Parser& );
 
@@ -41,11 +41,9 @@ namespace Fourier
   {
     m_bfix = true;
 
-    m_forwardPlan  = fftw_plan_dft_1d( m_dim, m_in, m_out, FFTW_FORWARD, FFTW_ESTIMATE );
-    m_backwardPlan = fftw_plan_dft_1d( m_dim, m_out, m_in, FFTW_BACKWARD, FFTW_ESTIMATE );
-
-    assert( m_forwardPlan != nullptr );
-    assert( m_backwardPlan != nullptr );
+    const int n[] = {m_dim_x};
+    m_forwardPlan  = m_backend->Shared_c2c( 1, n, m_in, m_out, FFTW_FORWARD );
+    m_backwardPlan = m_backend->Shared_c2c( 1, n, m_out, m_in, FFTW_BACKWARD );
   }
 
   /**
@@ -64,13 +62,16 @@ namespace Fourier
     if ( abs(isign) != 1 ) return;
     if ( isign == -1 )
     {
-      fftw_execute( m_forwardPlan );
+      // even grids: checkerboard modulation instead of the octant swap of fix()
+      if ( m_bfix && ft_centered( isign, m_dx / sqrt(2.0*M_PI) ) ) return;
+      m_forwardPlan->Execute( m_in, m_out );
       if ( m_bfix ) fix( m_out, m_dx );
       else scale( m_out, m_dx );
     }
     else
     {
-      fftw_execute( m_backwardPlan );
+      if ( m_bfix && ft_centered( isign, m_dkx / sqrt(2.0*M_PI) ) ) return;
+      m_backwardPlan->Execute( m_out, m_in );
       if ( m_bfix ) fix( m_in, m_dkx );
       else scale( m_in, m_dkx );
     }
@@ -153,6 +154,8 @@ namespace Fourier
   /**
    * \brief Performs reordering and rescaling for fourier transformation.
    *
+   * Only used for odd grids, even grids are handled by cft_base::ft_centered().
+   *
    * @param data Pointer to data to be reordered and rescaled
    * @param d Stepsize
    */
@@ -38,11 +38,9 @@ namespace Fourier
    */
   cft_2d::cft_2d( const generic_header &header, bool b, bool f ) : cft_base( header, b, f )
   {
-    m_forwardPlan  = fftw_plan_dft_2d( m_dim_x, m_dim_y, m_in, m_out, FFTW_FORWARD, FFTW_ESTIMATE );
-    m_backwardPlan = fftw_plan_dft_2d( m_dim_x, m_dim_y, m_out, m_in, FFTW_BACKWARD, FFTW_ESTIMATE );
-
-    assert( m_forwardPlan != nullptr );
-    assert( m_backwardPlan != nullptr );
+    const int n[] = {m_dim_x, m_dim_y};
+    m_forwardPlan  = m_backend->Shared_c2c( 2, n, m_in, m_out, FFTW_FORWARD );
+    m_backwardPlan = m_backend->Shared_c2c( 2, n, m_out, m_in, FFTW_BACKWARD );
   }
 
   /**
@@ -61,13 +59,16 @@ namespace Fourier
     if ( abs(isign) != 1 ) return;
     if ( isign == -1 )
     {
-      fftw_execute( m_forwardPlan );
+      // even grids: checkerboard modulation instead of the octant swap of fix()
+      if ( m_bfix && ft_centered( isign, 0.5 * m_dx * m_dy / M_PI ) ) return;
+      m_forwardPlan->Execute( m_in, m_out );
       if ( m_bfix ) fix( m_out, m_dx, m_dy );
       else scale( m_out, m_dx, m_dy );
     }
     else
     {
-      fftw_execute( m_backwardPlan );
+      if ( m_bfix && ft_centered( isign, 0.5 * m_dkx * m_dky / M_PI ) ) return;
+      m_backwardPlan->Execute( m_out, m_in );
       if ( m_bfix ) fix( m_in, m_dkx, m_dky );
       else scale( m_in, m_dkx, m_dky );
     }
@@ -234,7 +235,7 @@ namespace Fourier
     double kx, tmp1;
 
     bool b_oldval = m_bfix;
-    m_bfix = true;
+    m_bfix = false;
 
     this->ft(-1);
     #pragma omp parallel for schedule(dynamic,1) collapse(2) private(ij,i2,kx,tmp1)
@@ -358,7 +359,7 @@ namespace Fourier
     double kx, ky, tmp1;
 
     bool b_oldval = m_bfix;
-    m_bfix = true;
+    m_bfix = false;
 
     this->ft(-1);
     #pragma omp parallel for schedule(dynamic,1) collapse(2) private(i2,j2,kx,ky,tmp1)
@@ -381,6 +382,8 @@ namespace Fourier
   /**
    * \brief Performs reordering and rescaling after fourier transformation.
    *
+   * Only used for odd grids, even grids are handled by cft_base::ft_centered().
+   *
    * @param data Pointer to data to be reordered and rescaled
    * @param sx Stepsize in x direction
    * @param sy Stepsize in y direction
@@ -25,6 +25,9 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 #include <omp.h>
 #include "CPoint.h"
 #include "cft_2d.h"
@@ -53,6 +56,65 @@ void fkt1( Fourier::cft_2d &cft )
   }
 }
 
+/**
+ * \brief Compares Derivatives with the Diff_* and Laplace members on complex data
+ *
+ * @return Largest deviation relative to the largest value of each derivative
+ */
+double check_derivatives( const int nx, const int ny )
+{
+  generic_header header = {};
+  header.nDims = 2;
+  header.nDimX = nx;
+  header.nDimY = ny;
+  header.nDimZ = 1;
+  header.xMin = -10.0;
+  header.xMax = 10.0;
+  header.yMin = -8.0;
+  header.yMax = 8.0;
+  header.dx = 20.0/nx;
+  header.dkx = 2*M_PI/20.0;
+  header.dy = 16.0/ny;
+  header.dky = 2*M_PI/16.0;
+
+  Fourier::cft_2d cft( header );
+  const int64_t N = cft.Get_Dim_RS();
+  fftw_complex *data = cft.Getp2In();
+
+  std::vector<double> src( 2*N );
+  for ( int64_t l=0; l<N; l++ )
+  {
+    src[2*l] = data[l][0] = sin(0.37*l) + cos(0.011*l*l);
+    src[2*l+1] = data[l][1] = cos(1.3*l) - 0.5*sin(0.07*l);
+  }
+
+  const std::vector<Fourier::DERIV> which = { Fourier::DX, Fourier::DY, Fourier::DXX, Fourier::DYY, Fourier::LAPLACE };
+  void (Fourier::cft_2d::*diff[])() = { &Fourier::cft_2d::Diff_x, &Fourier::cft_2d::Diff_y, &Fourier::cft_2d::Diff_xx, &Fourier::cft_2d::Diff_yy, &Fourier::cft_2d::Laplace };
+  std::vector<fftw_complex *> out( which.size() );
+  for ( auto &o : out ) o = fftw_alloc_complex( N );
+
+  cft.Derivatives( which, out.data() );
+
+  double err = 0;
+  for ( size_t d=0; d<which.size(); d++ )
+  {
+    memcpy( data, src.data(), N*sizeof(fftw_complex) );
+    (cft.*diff[d])();
+
+    double dev = 0, norm = 0;
+    for ( int64_t l=0; l<N; l++ )
+    {
+      dev = std::max( dev, hypot( data[l][0]-out[d][l][0], data[l][1]-out[d][l][1] ) );
+      norm = std::max( norm, hypot( data[l][0], data[l][1] ) );
+    }
+    err = std::max( err, dev/norm );
+  }
+  for ( auto o : out ) fftw_free( o );
+
+  printf( "Derivatives vs Diff_* %3d x %3d: max deviation %g\n", nx, ny, err );
+  return err;
+}
+
 int main(int argc, char *argv[])
 {
   generic_header header = {};
@@ -89,6 +151,17 @@ int main(int argc, char *argv[])
   printf( "dkx                  == %g\n", header.dkx );
   printf( "dky                  == %g\n", header.dky );
 
+  // even and odd grids
+  const int dv_sizes[][2] = { {32,24}, {31,25}, {32,25} };
+  bool bdv = true;
+  for ( auto n : dv_sizes )
+    bdv = (check_derivatives( n[0], n[1] ) < 1e-12) && bdv;
+  if ( !bdv )
+  {
+    printf( "Derivatives differs from the Diff_* members\n" );
+    return EXIT_FAILURE;
+  }
+
   Fourier::cft_2d cft( header );
 
   fkt1( cft );
@@ -38,11 +38,9 @@ namespace Fourier
    */
   cft_3d::cft_3d( const generic_header &header, bool b, bool f ) : cft_base( header, b, f )
   {
-    m_forwardPlan  = fftw_plan_dft_3d( m_dim_x, m_dim_y, m_dim_z, m_in, m_out, FFTW_FORWARD, FFTW_ESTIMATE );
-    m_backwardPlan = fftw_plan_dft_3d( m_dim_x, m_dim_y, m_dim_z, m_out, m_in, FFTW_BACKWARD, FFTW_ESTIMATE );
-
-    assert( m_forwardPlan != nullptr );
-    assert( m_backwardPlan != nullptr );
+    const int n[] = {m_dim_x, m_dim_y, m_dim_z};
+    m_forwardPlan  = m_backend->Shared_c2c( 3, n, m_in, m_out, FFTW_FORWARD );
+    m_backwardPlan = m_backend->Shared_c2c( 3, n, m_out, m_in, FFTW_BACKWARD );
   }
 
   /**
@@ -61,13 +59,16 @@ namespace Fourier
     if ( abs(isign) != 1 ) return;
     if ( isign == -1 )
     {
-      fftw_execute( m_forwardPlan );
+      // even grids: checkerboard modulation instead of the octant swap of fix()
+      if ( m_bfix && ft_centered( isign, m_dx * m_dy * m_dz / pow(2*M_PI,1.5) ) ) return;
+      m_forwardPlan->Execute( m_in, m_out );
       if ( m_bfix ) fix( m_out, m_dx, m_dy, m_dz );
       else scale( m_out, m_dx, m_dy, m_dz );
     }
     else
     {
-      fftw_execute( m_backwardPlan );
+      if ( m_bfix && ft_centered( isign, m_dkx * m_dky * m_dkz / pow(2*M_PI,1.5) ) ) return;
+      m_backwardPlan->Execute( m_out, m_in );
       if ( m_bfix ) fix( m_in, m_dkx, m_dky, m_dkz );
       else scale( m_in, m_dkx, m_dky, m_dkz );
     }
@@ -265,35 +266,66 @@ namespace Fourier
   }
 
   /**
-   * \brief Calculate 1st derivative with respect to x of data in m_in
+   * \brief Multiplies the transformed data in m_out by a function of k
    *
-   *  Differentiation is done via fourier transformation method.
+   * The k components are taken from the axis tables in FFTW order. The threads get static
+   * blocks of (i,j) rows, the innermost loop runs contiguously along z.
+   *
+   * @param cx factor of kx^2 resp. kx
+   * @param cy factor of ky^2 resp. ky
+   * @param cz factor of kz^2 resp. kz
+   * @param first true: i (cx kx + cy ky + cz kz), false: -(cx kx^2 + cy ky^2 + cz kz^2)
    */
-  void cft_3d::Diff_x()
+  void cft_3d::Multiply_k( const double cx, const double cy, const double cz, const bool first )
   {
-    int ijk, i2;
-    double kx, tmp1;
-
-    bool b_oldval = m_bfix;
-    m_bfix = false;
+    const double *kx = m_k_axis[0].data();
+    const double *ky = m_k_axis[1].data();
+    const double *kz = m_k_axis[2].data();
 
-    this->ft(-1);
-    #pragma omp parallel for schedule(dynamic,1) collapse(3) private(ijk,i2,kx,tmp1)
+    #pragma omp parallel for collapse(2) schedule(static)
     for ( int i=0; i<m_dim_x; i++ )
     {
       for ( int j=0; j<m_dim_y; j++ )
       {
-        for ( int k=0; k<m_dim_z; k++ )
-        {
-          this->Get_kx( i, i2, kx );
-          ijk = k+m_dim_z*(j+m_dim_y*i);
+        fftw_complex *row = m_out + int64_t(m_dim_z)*(j+int64_t(m_dim_y)*i);
 
-          tmp1 = m_out[ijk][0];
-          m_out[ijk][0] = -kx*m_out[ijk][1];
-          m_out[ijk][1] = kx*tmp1;
+        if ( first )
+        {
+          const double kxy = cx*kx[i] + cy*ky[j];
+          for ( int k=0; k<m_dim_z; k++ )
+          {
+            const double kk = kxy + cz*kz[k];
+            const double tmp = row[k][0];
+            row[k][0] = -kk*row[k][1];
+            row[k][1] = kk*tmp;
+          }
+        }
+        else
+        {
+          const double kxy = -cx*kx[i]*kx[i] - cy*ky[j]*ky[j];
+          for ( int k=0; k<m_dim_z; k++ )
+          {
+            const double kk = kxy - cz*kz[k]*kz[k];
+            row[k][0] *= kk;
+            row[k][1] *= kk;
+          }
         }
       }
     }
+  }
+
+  /**
+   * \brief Calculate 1st derivative with respect to x of data in m_in
+   *
+   *  Differentiation is done via fourier transformation method.
+   */
+  void cft_3d::Diff_x()
+  {
+    bool b_oldval = m_bfix;
+    m_bfix = false;
+
+    this->ft(-1);
+    Multiply_k( 1, 0, 0, true );
     this->ft(1);
     m_bfix = b_oldval;
   }
@@ -305,29 +337,11 @@ namespace Fourier
    */
   void cft_3d::Diff_y()
   {
-    int ijk, j2;
-    double ky, tmp1;
-
     bool b_oldval = m_bfix;
     m_bfix = false;
 
     this->ft(-1);
-    #pragma omp parallel for schedule(dynamic,1) collapse(3) private(ijk,j2,ky,tmp1)
-    for ( int i=0; i<m_dim_x; i++ )
-    {
-      for ( int j=0; j<m_dim_y; j++ )
-      {
-        for ( int k=0; k<m_dim_z; k++ )
-        {
-          this->Get_ky( j, j2, ky );
-          ijk = k+m_dim_z*(j+m_dim_y*i);
-
-          tmp1 = m_out[ijk][0];
-          m_out[ijk][0] = -ky*m_out[ijk][1];
-          m_out[ijk][1] = ky*tmp1;
-        }
-      }
-    }
+    Multiply_k( 0, 1, 0, true );
     this->ft(1);
     m_bfix = b_oldval;
   }
@@ -339,29 +353,11 @@ namespace Fourier
    */
   void cft_3d::Diff_z()
   {
-    int ijk, k2;
-    double kz, tmp1;
-
     bool b_oldval = m_bfix;
     m_bfix = false;
 
     this->ft(-1);
-    #pragma omp parallel for schedule(dynamic,1) collapse(3) private(ijk,k2,kz,tmp1)
-    for ( int i=0; i<m_dim_x; i++ )
-    {
-      for ( int j=0; j<m_dim_y; j++ )
-      {
-        for ( int k=0; k<m_dim_z; k++ )
-        {
-          this->Get_kz( k, k2, kz );
-          ijk = k+m_dim_z*(j+m_dim_y*i);
-
-          tmp1 = m_out[ijk][0];
-          m_out[ijk][0] = -kz*m_out[ijk][1];
-          m_out[ijk][1] = kz*tmp1;
-        }
-      }
-    }
+    Multiply_k( 0, 0, 1, true );
     this->ft(1);
     m_bfix = b_oldval;
   }
@@ -373,29 +369,11 @@ namespace Fourier
    */
   void cft_3d::Diff_xx()
   {
-    int ijk, i2;
-    double kx;
-
     bool b_oldval = m_bfix;
     m_bfix = false;
 
     this->ft(-1);
-    #pragma omp parallel for schedule(dynamic,1) collapse(3) private(ijk,i2,kx)
-    for ( int i=0; i<m_dim_x; i++ )
-    {
-      for ( int j=0; j<m_dim_y; j++ )
-      {
-        for ( int k=0; k<m_dim_z; k++ )
-        {
-          this->Get_kx( i, i2, kx );
-          kx = -kx*kx;
-          ijk = k+m_dim_z*(j+m_dim_y*i);
-
-          m_out[ijk][0] *= kx;
-          m_out[ijk][1] *= kx;
-        }
-      }
-    }
+    Multiply_k( 1, 0, 0, false );
     this->ft(1);
     m_bfix = b_oldval;
   }
@@ -407,29 +385,11 @@ namespace Fourier
    */
   void cft_3d::Diff_yy()
   {
-    int ijk, j2;
-    double ky;
-
     bool b_oldval = m_bfix;
     m_bfix = false;
 
     this->ft(-1);
-    #pragma omp parallel for schedule(dynamic,1) collapse(3) private(ijk,j2,ky)
-    for ( int i=0; i<m_dim_x; i++ )
-    {
-      for ( int j=0; j<m_dim_y; j++ )
-      {
-        for ( int k=0; k<m_dim_z; k++ )
-        {
-          this->Get_ky( j, j2, ky );
-          ky = -ky*ky;
-          ijk = k+m_dim_z*(j+m_dim_y*i);
-
-          m_out[ijk][0] *= ky;
-          m_out[ijk][1] *= ky;
-        }
-      }
-    }
+    Multiply_k( 0, 1, 0, false );
     this->ft(1);
     m_bfix = b_oldval;
   }
@@ -441,29 +401,11 @@ namespace Fourier
    */
   void cft_3d::Diff_zz()
   {
-    int ijk, k2;
-    double kz;
-
     bool b_oldval = m_bfix;
     m_bfix = false;
 
     this->ft(-1);
-    #pragma omp parallel for schedule(dynamic,1) collapse(3) private(ijk,k2,kz)
-    for ( int i=0; i<m_dim_x; i++ )
-    {
-      for ( int j=0; j<m_dim_y; j++ )
-      {
-        for ( int k=0; k<m_dim_z; k++ )
-        {
-          this->Get_kz( k, k2, kz );
-          kz = -kz*kz;
-          ijk = k+m_dim_z*(j+m_dim_y*i);
-
-          m_out[ijk][0] *= kz;
-          m_out[ijk][1] *= kz;
-        }
-      }
-    }
+    Multiply_k( 0, 0, 1, false );
     this->ft(1);
     m_bfix = b_oldval;
   }
@@ -475,30 +417,11 @@ namespace Fourier
    */
   void cft_3d::Laplace()
   {
-    int ijk, i2, j2, k2;
-    double kx, ky, kz, tmp1;
-
     bool b_oldval = m_bfix;
     m_bfix = false;
 
     this->ft(-1);
-    #pragma omp parallel for schedule(dynamic,1) collapse(3) private(i2,j2,k2,kx,ky,kz,tmp1)
-    for ( int i=0; i<m_dim_x; i++ )
-    {
-      for ( int j=0; j<m_dim_y; j++ )
-      {
-        for ( int k=0; k<m_dim_z; k++ )
-        {
-          this->Get_k( i, j, k, i2, j2, k2, kx, ky, kz );
-          ijk = k+m_dim_z*(j+m_dim_y*i);
-
-          tmp1 = -kx*kx-ky*ky-kz*kz;
-
-          m_out[ijk][0] *= tmp1;
-          m_out[ijk][1] *= tmp1;
-        }
-      }
-    }
+    Multiply_k( 1, 1, 1, false );
     this->ft(1);
     m_bfix = b_oldval;
   }
@@ -506,6 +429,8 @@ namespace Fourier
   /**
    * \brief Performs reordering and rescaling after fourier transformation.
    *
+   * Only used for odd grids, even grids are handled by cft_base::ft_centered().
+   *
    * @param data Pointer to data to be reordered and rescaled
    * @param sx Stepsize in x direction
    * @param sy Stepsize in y direction
@@ -513,102 +438,39 @@ namespace Fourier
    */
   void cft_3d::fix( fftw_complex *data, const double sx, const double sy, const double sz )
   {
-    int ijk_1, ijk_2;
-    double fak2, tmp;
     const double fak = sx * sy * sz / pow(2*M_PI,1.5);
 
-    #pragma omp parallel for schedule(dynamic,1) collapse(3) private(ijk_1,ijk_2,fak2,tmp)
-    for ( int i=0; i<m_shift_x; i++ )
-    {
-      for ( int j=0; j<m_shift_y; j++ )
-      {
-        for ( int k=0; k<m_shift_z; k++ )
-        {
-          ijk_1 = k+m_dim_z*(j+m_dim_y*i);
-          ijk_2 = (k+m_shift_z)+m_dim_z*((j+m_shift_y)+m_dim_y*(i+m_shift_x));
-
-          if ( (i+j+k)%2 == 1 ) fak2 = -fak;
-          else fak2 = fak;
-
-          tmp            = data[ijk_1][0];
-          data[ijk_1][0] = data[ijk_2][0] * fak2;
-          data[ijk_2][0] = tmp * fak2;
-
-          tmp            = data[ijk_1][1];
-          data[ijk_1][1] = data[ijk_2][1] * fak2;
-          data[ijk_2][1] = tmp * fak2;
-        }
-      }
-    }
-
-    #pragma omp parallel for schedule(dynamic,1) collapse(3) private(ijk_1,ijk_2,fak2,tmp)
-    for ( int i=m_shift_x; i<m_dim_x; i++ )
+    // every row (i,j) swaps its lower z half with the upper z half of row (i+shift_x,j+shift_y)
+    #pragma omp parallel for collapse(2) schedule(static)
+    for ( int i=0; i<m_dim_x; i++ )
     {
-      for ( int j=0; j<m_shift_y; j++ )
+      for ( int j=0; j<m_dim_y; j++ )
       {
-        for ( int k=0; k<m_shift_z; k++ )
-        {
-          ijk_1 = k+m_dim_z*(j+m_dim_y*i);
-          ijk_2 = (k+m_shift_z)+m_dim_z*((j+m_shift_y)+m_dim_y*(i-m_shift_x));
-
-          if ( (i+j+k)%2 == 1 ) fak2 = -fak;
-          else fak2 = fak;
-
-          tmp            = data[ijk_1][0];
-          data[ijk_1][0] = data[ijk_2][0] * fak2;
-          data[ijk_2][0] = tmp * fak2;
+        const int i2 = (i+m_shift_x) % m_dim_x;
+        const int j2 = (j+m_shift_y) % m_dim_y;
+        fftw_complex *row_1 = data + int64_t(m_dim_z)*(j+int64_t(m_dim_y)*i);
+        fftw_complex *row_2 = data + int64_t(m_dim_z)*(j2+int64_t(m_dim_y)*i2) + m_shift_z;
+        const double fak_ij = ((i+j)%2 == 1) ? -fak : fak;
 
-          tmp            = data[ijk_1][1];
-          data[ijk_1][1] = data[ijk_2][1] * fak2;
-          data[ijk_2][1] = tmp * fak2;
-        }
-      }
-    }
-
-    #pragma omp parallel for schedule(dynamic,1) collapse(3) private(ijk_1,ijk_2,fak2,tmp)
-    for ( int i=0; i<m_shift_x; i++ )
-    {
-      for ( int j=m_shift_y; j<m_dim_y; j++ )
-      {
         for ( int k=0; k<m_shift_z; k++ )
         {
-          ijk_1 = k+m_dim_z*(j+m_dim_y*i);
-          ijk_2 = (k+m_shift_z)+m_dim_z*((j-m_shift_y)+m_dim_y*(i+m_shift_x));
+          const double fak2 = (k%2 == 1) ? -fak_ij : fak_ij;
+          double tmp;
 
-          if ( (i+j+k)%2 == 1 ) fak2 = -fak;
-          else fak2 = fak;
+          tmp          = row_1[k][0];
+          row_1[k][0]  = row_2[k][0] * fak2;
+          row_2[k][0]  = tmp * fak2;
 
-          tmp            = data[ijk_1][0];
-          data[ijk_1][0] = data[ijk_2][0] * fak2;
-          data[ijk_2][0] = tmp * fak2;
-
-          tmp            = data[ijk_1][1];
-          data[ijk_1][1] = data[ijk_2][1] * fak2;
-          data[ijk_2][1] = tmp * fak2;
+          tmp          = row_1[k][1];
+          row_1[k][1]  = row_2[k][1] * fak2;
+          row_2[k][1]  = tmp * fak2;
         }
-      }
-    }
 
-    #pragma omp parallel for schedule(dynamic,1) collapse(3) private(ijk_1,ijk_2,fak2,tmp)
-    for ( int i=m_shift_x; i<m_dim_x; i++ )
-    {
-      for ( int j=m_shift_y; j<m_dim_y; j++ )
-      {
-        for ( int k=0; k<m_shift_z; k++ )
+        // odd m_dim_z: the last element of the row has no partner, it is only normalised
+        if ( m_dim_z % 2 == 1 )
         {
-          ijk_1 = k+m_dim_z*(j+m_dim_y*i);
-          ijk_2 = (k+m_shift_z)+m_dim_z*((j-m_shift_y)+m_dim_y*(i-m_shift_x));
-
-          if ( (i+j+k)%2 == 1 ) fak2 = -fak;
-          else fak2 = fak;
-
-          tmp            = data[ijk_1][0];
-          data[ijk_1][0] = data[ijk_2][0] * fak2;
-          data[ijk_2][0] = tmp * fak2;
-
-          tmp            = data[ijk_1][1];
-          data[ijk_1][1] = data[ijk_2][1] * fak2;
-          data[ijk_2][1] = tmp * fak2;
+          row_1[m_dim_z-1][0] *= fak;
+          row_1[m_dim_z-1][1] *= fak;
         }
       }
     }
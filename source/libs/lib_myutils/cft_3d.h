@@ -24,6 +24,7 @@
 #ifndef CFT_3D_H
 #define CFT_3D_H
 
+#include <vector>
 #include "cft_base.h"
 
 namespace Fourier
@@ -48,6 +49,10 @@ namespace Fourier
     
     CPoint<3> Get_k(const int64_t) final;
     CPoint<3> Get_x(const int64_t) final;
+  protected:
+    void fix( fftw_complex* data, const double sx, const double sy, const double sz );
+    void scale( fftw_complex* data, const double sx, const double sy, const double sz );
+    void Multiply_k( const double cx, const double cy, const double cz, const bool first );
   private:
 
     void Get_k( int i, int j, int k, double & k_x, double & k_y, double & k_z );
@@ -59,9 +64,6 @@ namespace Fourier
     double Get_ky( const int j );
     double Get_kz( const int k );
 
-    void fix( fftw_complex* data, const double sx, const double sy, const double sz );
-    void scale( fftw_complex* data, const double sx, const double sy, const double sz );
-
     bool m_bFs;
   };
 }
@@ -24,6 +24,9 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <vector>
+#include <cstring>
+#include <algorithm>
 #include <omp.h>
 #include "CPoint.h"
 #include "cft_3d.h"
@@ -60,9 +63,160 @@ void fkt1( Fourier::cft_3d &cft )
   }
 }
 
+/**
+ * \brief Octant shift of the unfixed, scaled transform in data, the reordering SetFix(true) stood for before ft_centered
+ *
+ * Every row (i,j) swaps its lower z half with the upper z half of row (i+nx/2,j+ny/2), the signs alternate with i+j+k.
+ */
+void octant_shift( fftw_complex *data, const int nx, const int ny, const int nz )
+{
+  for ( int i=0; i<nx; i++ )
+    for ( int j=0; j<ny; j++ )
+      for ( int k=0; k<nz/2; k++ )
+      {
+        const int64_t ijk_1 = k+int64_t(nz)*(j+int64_t(ny)*i);
+        const int64_t ijk_2 = (k+nz/2)+int64_t(nz)*((j+ny/2)%ny+int64_t(ny)*((i+nx/2)%nx));
+        const double s = ((i+j+k)%2 == 1) ? -1 : 1;
+
+        for ( int c=0; c<2; c++ )
+        {
+          const double tmp = data[ijk_1][c];
+          data[ijk_1][c] = s * data[ijk_2][c];
+          data[ijk_2][c] = s * tmp;
+        }
+      }
+}
+
+/**
+ * \brief Compares ft with SetFix(true) against the octant shift of the plain transform
+ *
+ * Even grids take the checkerboard modulation of ft_centered, grids with an odd dimension the row-wise fix().
+ *
+ * @return Largest deviation of the forward and the backward transform
+ */
+double check_fix( const int nx, const int ny, const int nz )
+{
+  generic_header header = {};
+  header.nDims = 3;
+  header.nDimX = nx;
+  header.nDimY = ny;
+  header.nDimZ = nz;
+  header.xMin = -10.0;
+  header.xMax = 10.0;
+  header.yMin = -8.0;
+  header.yMax = 8.0;
+  header.zMin = -6.0;
+  header.zMax = 6.0;
+  header.dx = 20.0/nx;
+  header.dy = 16.0/ny;
+  header.dz = 12.0/nz;
+  header.dkx = 2*M_PI/20.0;
+  header.dky = 2*M_PI/16.0;
+  header.dkz = 2*M_PI/12.0;
+
+  Fourier::cft_3d cft( header );
+  Fourier::cft_3d ref( header );
+  cft.SetFix( true );
+
+  const int64_t N = cft.Get_Dim_RS();
+  fftw_complex *data = cft.Getp2In();
+  fftw_complex *data_ref = ref.Getp2In();
+
+  for ( int64_t l=0; l<N; l++ )
+  {
+    data[l][0] = sin(0.37*l) + cos(0.011*l*l);
+    data[l][1] = cos(1.3*l) - 0.5*sin(0.07*l);
+  }
+
+  double err = 0;
+
+  // forward: centered spectrum vs octant shift of the spectrum
+  memcpy( data_ref, data, N*sizeof(fftw_complex) );
+  cft.ft(-1);
+  ref.ft(-1);
+  octant_shift( ref.Getp2Out(), nx, ny, nz );
+  for ( int64_t l=0; l<N; l++ )
+    err = std::max( err, hypot( cft.Getp2Out()[l][0]-ref.Getp2Out()[l][0], cft.Getp2Out()[l][1]-ref.Getp2Out()[l][1] ) );
+
+  // backward from the centered spectrum
+  memcpy( ref.Getp2Out(), cft.Getp2Out(), N*sizeof(fftw_complex) );
+  cft.ft(1);
+  ref.ft(1);
+  octant_shift( ref.Getp2In(), nx, ny, nz );
+  for ( int64_t l=0; l<N; l++ )
+    err = std::max( err, hypot( data[l][0]-data_ref[l][0], data[l][1]-data_ref[l][1] ) );
+
+  printf( "SetFix(true) vs octant shift %3d x %3d x %3d: max deviation %g\n", nx, ny, nz, err );
+  return err;
+}
+
+/**
+ * \brief Compares Derivatives with the Diff_* and Laplace members on complex data
+ *
+ * @return Largest deviation relative to the largest value of each derivative
+ */
+double check_derivatives( const int nx, const int ny, const int nz )
+{
+  generic_header header = {};
+  header.nDims = 3;
+  header.nDimX = nx;
+  header.nDimY = ny;
+  header.nDimZ = nz;
+  header.xMin = -10.0;
+  header.xMax = 10.0;
+  header.yMin = -8.0;
+  header.yMax = 8.0;
+  header.zMin = -6.0;
+  header.zMax = 6.0;
+  header.dx = 20.0/nx;
+  header.dkx = 2*M_PI/20.0;
+  header.dy = 16.0/ny;
+  header.dky = 2*M_PI/16.0;
+  header.dz = 12.0/nz;
+  header.dkz = 2*M_PI/12.0;
+
+  Fourier::cft_3d cft( header );
+  const int64_t N = cft.Get_Dim_RS();
+  fftw_complex *data = cft.Getp2In();
+
+  std::vector<double> src( 2*N );
+  for ( int64_t l=0; l<N; l++ )
+  {
+    src[2*l] = data[l][0] = sin(0.37*l) + cos(0.011*l*l);
+    src[2*l+1] = data[l][1] = cos(1.3*l) - 0.5*sin(0.07*l);
+  }
+
+  const std::vector<Fourier::DERIV> which = { Fourier::DX, Fourier::DY, Fourier::DZ, Fourier::DXX, Fourier::DYY, Fourier::DZZ, Fourier::LAPLACE };
+  void (Fourier::cft_3d::*diff[])() = { &Fourier::cft_3d::Diff_x, &Fourier::cft_3d::Diff_y, &Fourier::cft_3d::Diff_z, &Fourier::cft_3d::Diff_xx, &Fourier::cft_3d::Diff_yy, &Fourier::cft_3d::Diff_zz, &Fourier::cft_3d::Laplace };
+  std::vector<fftw_complex *> out( which.size() );
+  for ( auto &o : out ) o = fftw_alloc_complex( N );
+
+  cft.Derivatives( which, out.data() );
+
+  double err = 0;
+  for ( size_t d=0; d<which.size(); d++ )
+  {
+    memcpy( data, src.data(), N*sizeof(fftw_complex) );
+    (cft.*diff[d])();
+
+    double dev = 0, norm = 0;
+    for ( int64_t l=0; l<N; l++ )
+    {
+      dev = std::max( dev, hypot( data[l][0]-out[d][l][0], data[l][1]-out[d][l][1] ) );
+      norm = std::max( norm, hypot( data[l][0], data[l][1] ) );
+    }
+    err = std::max( err, dev/norm );
+  }
+  for ( auto o : out ) fftw_free( o );
+
+  printf( "Derivatives vs Diff_* %3d x %3d x %3d: max deviation %g\n", nx, ny, nz, err );
+  return err;
+}
+
 int main()
 {
   generic_header header = {};
+  header.nDims = 3;
   header.nDimX = 256;
   header.nDimY = 256;
   header.nDimZ = 256;
@@ -100,6 +254,29 @@ int main()
   printf( "dky                  == %g\n", header.dky );
   printf( "dkz                  == %g\n", header.dkz );
 
+  // even grids (checkerboard modulation) and grids with odd dimensions (row-wise fix)
+  const int sizes[][3] = { {16,12,20}, {32,32,32}, {15,9,21}, {16,9,20}, {7,12,5} };
+  bool bok = true;
+  for ( auto n : sizes )
+    bok = (check_fix( n[0], n[1], n[2] ) < 1e-12) && bok;
+  if ( !bok )
+  {
+    printf( "SetFix(true) differs from the octant shift\n" );
+    fftw_cleanup_threads();
+    return EXIT_FAILURE;
+  }
+
+  // even and odd grids
+  const int dv_sizes[][3] = { {16,12,20}, {15,9,21}, {16,9,20} };
+  bool bdv = true;
+  for ( auto n : dv_sizes )
+    bdv = (check_derivatives( n[0], n[1], n[2] ) < 1e-12) && bdv;
+  if ( !bdv )
+  {
+    printf( "Derivatives differs from the Diff_* members\n" );
+    return EXIT_FAILURE;
+  }
+
   Fourier::cft_3d cft( header );
   fkt1( cft );
   cft.save( "f0.bin" );
@@ -23,10 +23,15 @@
 #include <fstream>
 #include <cassert>
 #include <cstring>
+#include <string>
+#include <algorithm>
+#include <vector>
 #include "fftw3.h"
 #include <cmath>
 #include "CPoint.h"
 #include "my_structs.h"
+#include "fft_backend.h"
+#include "thread_setup.h"
 
 #pragma once
 
@@ -34,6 +39,9 @@ namespace Fourier
 {
   enum TYPE { REAL, COMPLEX };
 
+  /// Spatial derivatives of Derivatives(), DXY etc. are the mixed second derivatives
+  enum DERIV { DX, DY, DZ, DXX, DYY, DZZ, DXY, DXZ, DYZ, LAPLACE };
+
   template <int dim>
   class cft_base
   {
@@ -44,7 +52,7 @@ namespace Fourier
     * @param header Header information to construct cft_base object
     * @param b Whether inplace transformation is done
     */
-    cft_base( const generic_header& header, bool b=true, bool f=false, Fourier::TYPE t=Fourier::TYPE::COMPLEX ) : m_bInplace(b), m_bfix(f), m_type(t)
+    cft_base( const generic_header& header, bool b=true, bool f=false, Fourier::TYPE t=Fourier::TYPE::COMPLEX ) : m_bInplace(b), m_bfix(f), m_type(t), m_backend(fft_backend::Get()), m_deriv_tmp(nullptr)
     {
       if( header.nDims != dim )
       {
@@ -59,31 +67,31 @@ namespace Fourier
         if( b )
         {
           m_in_real = nullptr;
-          m_in  = fftw_alloc_complex( m_dim );
+          m_in  = m_backend->Alloc_Complex( m_dim );
           assert(m_in != nullptr);
           m_out = m_in;
-          std::memset( m_in, 0, m_dim*sizeof(fftw_complex));
+          First_Touch( m_in, m_dim );
         }
         else
         {
           m_in_real = nullptr;
-          m_in  = fftw_alloc_complex( m_dim );
+          m_in  = m_backend->Alloc_Complex( m_dim );
           assert(m_in != nullptr);
-          m_out = fftw_alloc_complex( m_dim );
+          m_out = m_backend->Alloc_Complex( m_dim );
           assert(m_out != nullptr);
-          std::memset( m_in, 0, m_dim*sizeof(fftw_complex));
-          std::memset( m_out, 0, m_dim*sizeof(fftw_complex));
+          First_Touch( m_in, m_dim );
+          First_Touch( m_out, m_dim );
         }
       }
       else
       {
-          m_in_real = fftw_alloc_real( m_dim );;
+          m_in_real = m_backend->Alloc_Real( m_dim );
           assert(m_in_real != nullptr);
           m_in  = nullptr;
-          m_out = fftw_alloc_complex( m_dim_fs );
+          m_out = m_backend->Alloc_Complex( m_dim_fs );
           assert(m_out != nullptr);
-          std::memset( m_in_real, 0, m_dim*sizeof(double));
-          std::memset( m_out, 0, m_dim_fs*sizeof(fftw_complex));
+          First_Touch( m_in_real, m_dim );
+          First_Touch( m_out, m_dim_fs );
       }
     }
 
@@ -92,26 +100,24 @@ namespace Fourier
     */
     virtual ~cft_base()
     {
-      fftw_destroy_plan( m_forwardPlan );
-      fftw_destroy_plan( m_backwardPlan );
-
       if ( m_type == Fourier::TYPE::COMPLEX )
       {
         if( !m_bInplace )
         {
-          fftw_free( m_in );
-          fftw_free( m_out );
+          m_backend->Free( m_in );
+          m_backend->Free( m_out );
         }
         else
         {
-          fftw_free( m_in );
+          m_backend->Free( m_in );
         }
       }
       else
       {
-        fftw_free( m_in_real );
-        fftw_free( m_out );
+        m_backend->Free( m_in_real );
+        m_backend->Free( m_out );
       }
+      m_backend->Free( m_deriv_tmp );
     }
 
     void SetFix( bool bval ) { m_bfix = bval; };
@@ -168,9 +174,168 @@ namespace Fourier
     };
 
     virtual void ft(int)=0;
+
+    /**
+    * \brief Unnormalized transform of arbitrary arrays with the geometry of this object
+    *
+    * Uses the new-array execute interface of the backend. in and out may be equal, out-of-place transforms
+    * keep the input intact. Arrays with another alignment than the planning arrays are handled
+    * by a plan without SIMD alignment assumptions.
+    * The data is neither scaled nor reordered (raw FFTW order), a forward and backward transform
+    * multiplies the data by Get_Dim_RS().
+    *
+    * @param isign Whether to perform forward [-1] or backward [1] fourier transformation
+    * @param in Input array
+    * @param out Output array
+    */
+    void ft_raw( int isign, fftw_complex *in, fftw_complex *out )
+    {
+      assert( m_type == Fourier::TYPE::COMPLEX );
+      int p = ((isign == -1) ? 0 : 2) + ((in == out) ? 0 : 1);
+      if ( !m_raw_plans[p] ) Setup_Raw_Plan(p);
+
+      if ( m_backend->Alignment_Of( in[0] ) != m_raw_align[p][0] || m_backend->Alignment_Of( out[0] ) != m_raw_align[p][1] )
+      {
+        p += 4;
+        if ( !m_raw_plans[p] ) Setup_Raw_Plan(p);
+      }
+      m_raw_plans[p]->Execute( in, out );
+    }
+
+    /**
+    * \brief Unnormalized forward transform (r2c) of an arbitrary real array, see ft_raw above
+    *
+    * @param isign Has to be -1
+    * @param in Real input array with Get_Dim_RS() entries
+    * @param out Output array with Get_Dim_FS() entries
+    */
+    void ft_raw( int isign, double *in, fftw_complex *out )
+    {
+      assert( m_type == Fourier::TYPE::REAL && isign == -1 );
+      int p = 1;
+      if ( !m_raw_plans[p] ) Setup_Raw_Plan(p);
+
+      if ( m_backend->Alignment_Of( in ) != m_raw_align[p][0] || m_backend->Alignment_Of( out[0] ) != m_raw_align[p][1] )
+      {
+        p += 4;
+        if ( !m_raw_plans[p] ) Setup_Raw_Plan(p);
+      }
+      m_raw_plans[p]->Execute( in, out );
+    }
+
+    /**
+    * \brief Unnormalized backward transform (c2r) of an arbitrary array, see ft_raw above
+    *
+    * The input array is destroyed by the transform.
+    *
+    * @param isign Has to be 1
+    * @param in Input array with Get_Dim_FS() entries
+    * @param out Real output array with Get_Dim_RS() entries
+    */
+    void ft_raw( int isign, fftw_complex *in, double *out )
+    {
+      assert( m_type == Fourier::TYPE::REAL && isign == 1 );
+      int p = 3;
+      if ( !m_raw_plans[p] ) Setup_Raw_Plan(p);
+
+      if ( m_backend->Alignment_Of( in[0] ) != m_raw_align[p][0] || m_backend->Alignment_Of( out ) != m_raw_align[p][1] )
+      {
+        p += 4;
+        if ( !m_raw_plans[p] ) Setup_Raw_Plan(p);
+      }
+      m_raw_plans[p]->Execute( in, out );
+    }
+
+    /**
+    * \brief Several derivatives of the complex data in m_in from a single forward transform
+    *
+    * The spectrum is computed once into the last output array, each derivative is formed while
+    * copying the spectrum into its output array and is transformed back in place with the ft_raw plans.
+    * m_in and m_out are not modified. The ordering flag (SetFix) has no influence.
+    *
+    * @param which Requested derivatives
+    * @param out which.size() output arrays with Get_Dim_RS() entries each, distinct from m_in and each other
+    */
+    void Derivatives( const std::vector<DERIV> &which, fftw_complex * const *out )
+    {
+      assert( m_type == Fourier::TYPE::COMPLEX );
+      Check_Derivatives( which );
+      if ( which.empty() ) return;
+
+      fftw_complex *spec = out[which.size()-1];
+      ft_raw( -1, m_in, spec );
+
+      for ( size_t d=0; d<which.size(); d++ )
+      {
+        Multiply_Deriv( which[d], spec, out[d] );
+        ft_raw( 1, out[d], out[d] );
+      }
+    }
+
+    /**
+    * \brief Several derivatives of the real data in m_in_real from a single forward transform
+    *
+    * The spectrum is kept in m_out, every derivative except the last one needs a copy of it because the
+    * c2r transform destroys its input. m_in_real is not modified. The Nyquist mode of the halved axis is
+    * dropped for all derivatives, as in Get_k.
+    *
+    * @param which Requested derivatives
+    * @param out which.size() output arrays with Get_Dim_RS() entries each, distinct from m_in_real
+    */
+    void Derivatives( const std::vector<DERIV> &which, double * const *out )
+    {
+      assert( m_type == Fourier::TYPE::REAL );
+      Check_Derivatives( which );
+      if ( which.empty() ) return;
+
+      ft_raw( -1, m_in_real, m_out );
+
+      if ( which.size() > 1 && m_deriv_tmp == nullptr ) m_deriv_tmp = m_backend->Alloc_Complex( m_dim_fs );
+
+      for ( size_t d=0; d<which.size(); d++ )
+      {
+        fftw_complex *tmp = ( d+1 == which.size() ) ? m_out : m_deriv_tmp;
+        Multiply_Deriv( which[d], m_out, tmp );
+        ft_raw( 1, tmp, out[d] );
+      }
+    }
+
     virtual CPoint<dim> Get_k(const int64_t)=0;
     virtual CPoint<dim> Get_x(const int64_t)=0;
 
+    /**
+    * \brief x component along axis a of every array index, Get_Dim_X() (Y, Z) entries
+    */
+    const double * Get_x_Axis( const int a ) const { return m_x_axis[a].data(); }
+
+    /**
+    * \brief k component along axis a of every array index in the ordering of Get_k
+    *
+    * The last axis of real data has Get_red_Dim() entries.
+    */
+    const double * Get_k_Axis( const int a ) const { return (m_bfix ? m_kc_axis : m_k_axis)[a].data(); }
+
+    /**
+    * \brief Calls f( l, x ) for all points of the real space array in storage order, x = Get_x(l)
+    *
+    * The loop is an orphaned omp for: inside a parallel region the rows are distributed over the threads
+    * (static schedule, implicit barrier at the end), outside of one the calling thread does all rows.
+    * The coordinates are taken from the axis tables, there is no division per point. x belongs to the
+    * calling thread and must not be changed by f.
+    *
+    * @param f Callable with the arguments (int64_t l, CPoint<dim> &x)
+    */
+    template <class F> void For_x( F f ) { For_Axes( m_x_axis, f ); }
+
+    /**
+    * \brief Calls f( l, k ) for all points of the fourier space array in storage order, k = Get_k(l)
+    *
+    * Work sharing as in For_x.
+    *
+    * @param f Callable with the arguments (int64_t l, CPoint<dim> &k)
+    */
+    template <class F> void For_k( F f ) { For_Axes( m_bfix ? m_kc_axis : m_k_axis, f ); }
+
     double * Getp2InReal() { return m_in_real; }
     fftw_complex * Getp2In() { return m_in; }
     fftw_complex * Getp2Out() { return m_out; }
@@ -182,6 +347,91 @@ namespace Fourier
     int64_t Get_Dim_RS() { return m_dim; }; /// total number of sampling points in real space
     int64_t Get_Dim_FS() { return m_dim_fs; }; /// total number of sampling points in fourier space
   protected:
+    /**
+    * \brief Multiplies data by (-1)^(i+j+k)
+    *
+    * For even grids the plain FFT of the modulated data, modulated once more, is the transform
+    * centered at (m_shift_x,m_shift_y,m_shift_z), i.e. the reordering of fix() without the octant swap.
+    *
+    * @param data Pointer to the data, Get_Dim_RS() entries
+    */
+    void Modulate( fftw_complex *data )
+    {
+      Modulate_and_Scale( data, nullptr, 1.0 );
+    }
+
+    /**
+    * \brief Checkerboard modulation and normalization of a centered transform in one streaming pass
+    *
+    * @param data Pointer to the transformed data, multiplied by fak*(-1)^(i+j+k)
+    * @param src Modulated input of an out-of-place transform, its modulation is undone, or nullptr
+    * @param fak Normalization factor
+    */
+    void Modulate_and_Scale( fftw_complex *data, fftw_complex *src, const double fak )
+    {
+      assert( m_beven );
+
+      // rows along the fastest index, a row starting at an even flat index in 1D
+      const int64_t nl = (dim == 1) ? 2 : ((dim == 2) ? m_dim_y : m_dim_z);
+      const int64_t nr = m_dim/nl;
+
+      // small (1D) grids stay serial like the old fix(), the team start up would dominate
+      #pragma omp parallel for if ( m_dim > 16384 )
+      for ( int64_t r=0; r<nr; r++ )
+      {
+        int64_t par = 0;
+        if ( dim == 2 ) par = r;
+        if ( dim == 3 ) par = r/m_dim_y + r;
+
+        const double f = (par % 2 == 0) ? fak : -fak;
+        fftw_complex *row = data + r*nl;
+
+        for ( int64_t l=0; l<nl; l+=2 )
+        {
+          row[l][0] *= f;
+          row[l][1] *= f;
+          row[l+1][0] *= -f;
+          row[l+1][1] *= -f;
+        }
+
+        if ( src != nullptr )
+        {
+          fftw_complex *srow = src + r*nl;
+          const double s = (par % 2 == 0) ? 1.0 : -1.0;
+          for ( int64_t l=0; l<nl; l+=2 )
+          {
+            srow[l][0] *= s;
+            srow[l][1] *= s;
+            srow[l+1][0] *= -s;
+            srow[l+1][1] *= -s;
+          }
+        }
+      }
+    }
+
+    /**
+    * \brief Centered transform of the complex data, see ft()
+    *
+    * For even grids m_in (forward) resp. m_out (backward) is modulated before the FFT and the result
+    * is modulated and normalized afterwards. The input of an out-of-place transform is restored.
+    * Odd grids fall back to the reordering of the derived class.
+    *
+    * @param isign Whether to perform forward [-1] or backward [1] fourier transformation
+    * @param fak Normalization factor
+    * @return false if the grid is odd and nothing was done
+    */
+    bool ft_centered( const int isign, const double fak )
+    {
+      if ( !m_beven ) return false;
+
+      fftw_complex *in  = (isign == -1) ? m_in : m_out;
+      fftw_complex *out = (isign == -1) ? m_out : m_in;
+
+      Modulate( in );
+      ((isign == -1) ? m_forwardPlan : m_backwardPlan)->Execute( in, out );
+      Modulate_and_Scale( out, (in == out) ? nullptr : in, fak );
+      return true;
+    }
 
     int m_dim_x; /// Number of sampling points in x-dimension
     int m_dim_y; /// Number of sampling points in y-dimension
@@ -196,6 +446,7 @@ namespace Fourier
 
     bool m_bInplace; /// Whether inplace transformation is performed
     bool m_bfix; /// Whether Ordering is fixed
+    bool m_beven; /// Whether all grid dimensions are even, centered transforms by modulation
     Fourier::TYPE m_type; /// decides if we deal with r2c or c2c
 
     double m_dx; /// Stepsize in x-direction
@@ -209,11 +460,232 @@ namespace Fourier
     fftw_complex * m_in; /// Input array in real space
     fftw_complex * m_out; /// Output array in fourier space
 
-    fftw_plan m_forwardPlan; /// Plan for forward transformation
-    fftw_plan m_backwardPlan; /// Plan for backward transformation
+    fft_backend * m_backend; /// FFT engine, the default backend at construction
+    std::shared_ptr<fft_plan> m_forwardPlan; /// Plan for forward transformation, from the plan pool of m_backend
+    std::shared_ptr<fft_plan> m_backwardPlan; /// Plan for backward transformation, from the plan pool of m_backend
+    std::shared_ptr<fft_plan> m_raw_plans[8]; /// Plans for ft_raw: forward/backward, in-place/out-of-place, aligned/unaligned
+    int m_raw_align[4][2]; /// Alignment of the in and out arrays the aligned ft_raw plans were created with
+    fftw_complex * m_deriv_tmp; /// Spectrum copy for Derivatives() of real data, allocated on first use
+    std::vector<double> m_x_axis[3]; /// x of every index along each axis, a single 0 for the missing axes
+    std::vector<double> m_k_axis[3]; /// k of every index along each axis in FFTW order
+    std::vector<double> m_kc_axis[3]; /// k of every index along each axis in centered order (m_bfix), FFTW order for real data
 
     generic_header m_header;
   private:
+    /**
+    * \brief Loop of For_x and For_k over the axis tables ax
+    */
+    template <class F> void For_Axes( const std::vector<double> *ax, F &f )
+    {
+      // axis of each of the three loops, -1 for a loop of length 1; 1d grids are shared via the middle loop
+      const int a0 = (dim == 3) ? 0 : -1;
+      const int a1 = (dim == 1) ? 0 : dim-2;
+      const int a2 = (dim == 1) ? -1 : dim-1;
+      const int64_t n0 = (a0 < 0) ? 1 : ax[a0].size();
+      const int64_t n1 = ax[a1].size();
+      const int64_t n2 = (a2 < 0) ? 1 : ax[a2].size();
+
+      #pragma omp for collapse(2) schedule(static)
+      for ( int64_t i=0; i<n0; i++ )
+      {
+        for ( int64_t j=0; j<n1; j++ )
+        {
+          CPoint<dim> p;
+          if ( a0 >= 0 ) p[a0] = ax[a0][i];
+          p[a1] = ax[a1][j];
+
+          const int64_t l0 = n2*(j+n1*i);
+          if ( a2 < 0 )
+          {
+            f( l0, p );
+            continue;
+          }
+          for ( int64_t k=0; k<n2; k++ )
+          {
+            p[a2] = ax[a2][k];
+            f( l0+k, p );
+          }
+        }
+      }
+    }
+
+    /**
+    * \brief Fills the coordinate tables of Get_x_Axis and Get_k_Axis
+    */
+    void Setup_Axis_Tables()
+    {
+      const int n[] = {m_dim_x, m_dim_y, m_dim_z};
+      const int shift[] = {m_shift_x, m_shift_y, m_shift_z};
+      const double dx[] = {m_dx, m_dy, m_dz};
+      const double dk[] = {m_dkx, m_dky, m_dkz};
+      const bool real = (m_type == Fourier::TYPE::REAL);
+
+      for ( int a=0; a<3; a++ )
+      {
+        if ( a >= dim )
+        {
+          m_x_axis[a].assign( 1, 0.0 );
+          m_k_axis[a].assign( 1, 0.0 );
+          m_kc_axis[a].assign( 1, 0.0 );
+          continue;
+        }
+
+        const bool halved = real && (a == dim-1);
+        const int len = halved ? int(m_red_dim) : n[a];
+        m_x_axis[a].resize( n[a] );
+        m_k_axis[a].resize( len );
+        m_kc_axis[a].resize( len );
+        for ( int t=0; t<n[a]; t++ ) m_x_axis[a][t] = dx[a]*double(t-shift[a]);
+        for ( int t=0; t<len; t++ )
+        {
+          if ( halved ) // as in Get_k, the Nyquist mode of an even grid is dropped
+            m_k_axis[a][t] = (n[a] % 2 == 0 && t == n[a]/2) ? 0.0 : dk[a]*double(t);
+          else
+            m_k_axis[a][t] = dk[a]*double((t+shift[a])%n[a]-shift[a]);
+          m_kc_axis[a][t] = real ? m_k_axis[a][t] : dk[a]*double(t-shift[a]);
+        }
+      }
+    }
+
+    /**
+    * \brief Throws if a derivative does not exist in dim dimensions
+    */
+    void Check_Derivatives( const std::vector<DERIV> &which )
+    {
+      for ( const DERIV d : which )
+      {
+        const bool needs_y = (d == DY || d == DYY || d == DXY || d == DYZ);
+        const bool needs_z = (d == DZ || d == DZZ || d == DXZ || d == DYZ);
+        if ( (needs_y && dim < 2) || (needs_z && dim < 3) ) throw std::string("Error in cft_base::Derivatives: derivative does not exist in this dimension\n");
+      }
+    }
+
+    /**
+    * \brief dst = D(k) src / Get_Dim_RS() for the raw spectrum src, dst may be src
+    *
+    * The threads get static blocks of rows along the last (contiguous) axis.
+    *
+    * @param which Derivative, first derivatives multiply by i k, second ones by -k k'
+    * @param src Spectrum in FFTW order
+    * @param dst Output spectrum
+    */
+    void Multiply_Deriv( const DERIV which, const fftw_complex *src, fftw_complex *dst )
+    {
+      const int n[] = {m_dim_x, m_dim_y, m_dim_z};
+      const int shift[] = {m_shift_x, m_shift_y, m_shift_z};
+      const double dk[] = {m_dkx, m_dky, m_dkz};
+      const bool real = (m_type == Fourier::TYPE::REAL);
+
+      // k components in FFTW order, the halved axis of r2c data has only non-negative k
+      std::vector<double> kl[3];
+      for ( int a=0; a<3; a++ )
+      {
+        const bool halved = real && (a == dim-1);
+        const int len = (a >= dim) ? 1 : (halved ? int(m_red_dim) : n[a]);
+        kl[a].assign( len, 0.0 );
+        if ( a >= dim ) continue;
+        for ( int t=0; t<len; t++ )
+        {
+          if ( halved )
+            kl[a][t] = (n[a] % 2 == 0 && t == n[a]/2) ? 0.0 : dk[a]*double(t);
+          else
+            kl[a][t] = dk[a]*double((t+shift[a])%n[a]-shift[a]);
+        }
+      }
+
+      const bool first = (which == DX || which == DY || which == DZ);
+      const double fak = 1.0/double(m_dim);
+      const int64_t nl = kl[dim-1].size();
+      const int64_t nr = m_dim_fs/nl;
+
+      #pragma omp parallel for schedule(static) if ( m_dim_fs > 16384 )
+      for ( int64_t r=0; r<nr; r++ )
+      {
+        double k[3] = {0.0, 0.0, 0.0};
+        if ( dim == 2 ) k[0] = kl[0][r];
+        if ( dim == 3 )
+        {
+          k[0] = kl[0][r/m_dim_y];
+          k[1] = kl[1][r%m_dim_y];
+        }
+        const fftw_complex *s = src + r*nl;
+        fftw_complex *o = dst + r*nl;
+
+        for ( int64_t t=0; t<nl; t++ )
+        {
+          k[dim-1] = kl[dim-1][t];
+
+          double f;
+          switch ( which )
+          {
+            case DX:  f = k[0]; break;
+            case DY:  f = k[1]; break;
+            case DZ:  f = k[2]; break;
+            case DXX: f = -k[0]*k[0]; break;
+            case DYY: f = -k[1]*k[1]; break;
+            case DZZ: f = -k[2]*k[2]; break;
+            case DXY: f = -k[0]*k[1]; break;
+            case DXZ: f = -k[0]*k[2]; break;
+            case DYZ: f = -k[1]*k[2]; break;
+            default:  f = -k[0]*k[0]-k[1]*k[1]-k[2]*k[2];
+          }
+          f *= fak;
+
+          if ( first )
+          {
+            const double tmp = s[t][0];
+            o[t][0] = -f*s[t][1];
+            o[t][1] = f*tmp;
+          }
+          else
+          {
+            o[t][0] = f*s[t][0];
+            o[t][1] = f*s[t][1];
+          }
+        }
+      }
+    }
+
+    /**
+    * \brief Creates the plan p of ft_raw on first use
+    *
+    * @param p 0,1 forward and 2,3 backward, even in-place and odd out-of-place, +4 unaligned
+    */
+    void Setup_Raw_Plan( const int p )
+    {
+      const int n[] = {m_dim_x, m_dim_y, m_dim_z};
+      const int sign = (p % 4 < 2) ? FFTW_FORWARD : FFTW_BACKWARD;
+      const bool unaligned = (p >= 4);
+
+      if ( m_type == Fourier::TYPE::REAL )
+      {
+        // r2c and c2r transforms are always out-of-place between m_in_real and m_out
+        if ( sign == FFTW_FORWARD )
+          m_raw_plans[p] = m_backend->Shared_r2c( dim, n, m_in_real, m_out, unaligned );
+        else
+          m_raw_plans[p] = m_backend->Shared_c2r( dim, n, m_out, m_in_real, unaligned );
+        if ( p < 4 )
+        {
+          m_raw_align[p][0] = (sign == FFTW_FORWARD) ? m_backend->Alignment_Of( m_in_real ) : m_backend->Alignment_Of( m_out[0] );
+          m_raw_align[p][1] = (sign == FFTW_FORWARD) ? m_backend->Alignment_Of( m_out[0] ) : m_backend->Alignment_Of( m_in_real );
+        }
+        return;
+      }
+
+      fftw_complex * out = m_in;
+      fftw_complex * tmp = nullptr;
+
+      // planning does not touch the arrays, a scratch array only fixes the alignment and placement
+      if ( p % 2 == 1 ) out = tmp = m_backend->Alloc_Complex( m_dim );
+      m_raw_plans[p] = m_backend->Shared_c2c( dim, n, m_in, out, sign, unaligned );
+      if ( p < 4 )
+      {
+        m_raw_align[p][0] = m_backend->Alignment_Of( m_in[0] );
+        m_raw_align[p][1] = m_backend->Alignment_Of( out[0] );
+      }
+      m_backend->Free( tmp );
+    }
+
     /**
     * \brief Helper routine for setting up cft_base
     *
@@ -238,6 +710,7 @@ namespace Fourier
       m_dkz      = header.dkz;
       m_dim_fs   = m_dim;
       m_red_dim  = 0;
+      m_beven    = (m_dim_x % 2 == 0) && (dim < 2 || m_dim_y % 2 == 0) && (dim < 3 || m_dim_z % 2 == 0);
 
       assert( m_dim_x > 0 );
       assert( m_dim_y >= 0 );
@@ -258,6 +731,8 @@ namespace Fourier
           break;
         }
       }
+
+      Setup_Axis_Tables();
     }
   };
 } // end of namespace
@@ -0,0 +1,193 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/** Timings of the cft_3d kernels
+  *
+  * Times ft (plain and centered), fix, scale, Laplace and Diff_* for a list of cubic grid sizes,
+  * thread counts and FFT backends. One CSV record per kernel, grid, thread count and backend is written
+  * to stdout: backend,kernel,nx,ny,nz,threads,calls,ms_per_call,ns_per_point
+  *
+  * cft_bench [sizes (default 64,128,256)] [threads (default 1,2,4,...,omp_get_max_threads())] [calls (default 10)]
+  *           [backends (default fftw,native)]
+  */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <omp.h>
+#include "cft_3d.h"
+
+namespace Fourier
+{
+  /// exposes the post processing kernels of cft_3d
+  class cft_3d_bench : public cft_3d
+  {
+  public:
+    cft_3d_bench( const generic_header &header ) : cft_3d( header ) {}
+
+    void Fix() { fix( m_out, m_dx, m_dy, m_dz ); }
+    void Scale() { scale( m_out, m_dx, m_dy, m_dz ); }
+  };
+}
+
+std::vector<std::string> Parse_List( const char *str )
+{
+  std::vector<std::string> retval;
+  std::string s(str);
+  size_t pos = 0;
+  while ( pos < s.size() )
+  {
+    size_t next = s.find( ',', pos );
+    if ( next == std::string::npos ) next = s.size();
+    retval.push_back( s.substr( pos, next-pos ) );
+    pos = next+1;
+  }
+  return retval;
+}
+
+std::vector<int> Parse_Int_List( const char *str )
+{
+  std::vector<int> retval;
+  for ( auto &s : Parse_List( str ) )
+    retval.push_back( std::stoi( s ) );
+  return retval;
+}
+
+void Time_Kernel( const char *name, Fourier::cft_3d &cft, const std::string &backend, const int threads, const int calls, std::function<void()> kernel )
+{
+  kernel(); // warm up, first touch
+
+  auto t0 = std::chrono::steady_clock::now();
+  for ( int c=0; c<calls; c++ )
+    kernel();
+  auto t1 = std::chrono::steady_clock::now();
+
+  const double ms = std::chrono::duration<double,std::milli>(t1-t0).count()/calls;
+  printf( "%s,%s,%d,%d,%d,%d,%d,%.6g,%.6g\n", backend.c_str(), name, cft.Get_Dim_X(), cft.Get_Dim_Y(), cft.Get_Dim_Z(), threads, calls, ms, 1e6*ms/double(cft.Get_Dim_RS()) );
+  fflush( stdout );
+}
+
+int main( int argc, char *argv[] )
+{
+  std::vector<int> sizes = {64,128,256};
+  std::vector<int> threads;
+  std::vector<std::string> backends = {"fftw","native"};
+  int calls = 10;
+
+  for ( int t=1; t<omp_get_max_threads(); t*=2 )
+    threads.push_back(t);
+  threads.push_back(omp_get_max_threads());
+
+  try
+  {
+    if ( argc > 1 ) sizes = Parse_Int_List( argv[1] );
+    if ( argc > 2 ) threads = Parse_Int_List( argv[2] );
+    if ( argc > 3 ) calls = atoi( argv[3] );
+    if ( argc > 4 ) backends = Parse_List( argv[4] );
+  }
+  catch ( std::exception & )
+  {
+    printf( "usage: cft_bench [n1,n2,...] [t1,t2,...] [calls] [backend1,backend2,...]\n" );
+    return EXIT_FAILURE;
+  }
+
+  fftw_init_threads();
+
+  printf( "backend,kernel,nx,ny,nz,threads,calls,ms_per_call,ns_per_point\n" );
+
+  for ( int n : sizes )
+  {
+    generic_header header = {};
+    header.nDims = 3;
+    header.nDimX = n;
+    header.nDimY = n;
+    header.nDimZ = n;
+    header.xMin = -10.0;
+    header.xMax = -header.xMin;
+    header.yMin = -10.0;
+    header.yMax = -header.yMin;
+    header.zMin = -10.0;
+    header.zMax = -header.zMin;
+    header.dkx = 2*M_PI/(header.xMax-header.xMin);
+    header.dky = 2*M_PI/(header.yMax-header.yMin);
+    header.dkz = 2*M_PI/(header.zMax-header.zMin);
+    header.dx = (header.xMax-header.xMin)/n;
+    header.dy = (header.yMax-header.yMin)/n;
+    header.dz = (header.zMax-header.zMin)/n;
+
+    for ( auto &backend : backends )
+    {
+      for ( int t : threads )
+      {
+        // the plans pick up the thread count on construction
+        fftw_plan_with_nthreads( t );
+        omp_set_num_threads( t );
+
+        Fourier::cft_3d_bench *pcft = nullptr;
+        try
+        {
+          Fourier::fft_backend::Set_Default( backend );
+          pcft = new Fourier::cft_3d_bench( header );
+        }
+        catch ( std::string &str )
+        {
+          fprintf( stderr, "%s", str.c_str() );
+          continue;
+        }
+        Fourier::cft_3d_bench &cft = *pcft;
+
+        fftw_complex *data = cft.Getp2In();
+        #pragma omp parallel for
+        for ( int64_t l=0; l<cft.Get_Dim_RS(); l++ )
+        {
+          CPoint<3> x = cft.Get_x(l);
+          data[l][0] = exp(-(x*x));
+          data[l][1] = 0.0;
+        }
+
+        // a forward and a backward transform keep the data bounded
+        Time_Kernel( "ft", cft, backend, t, calls, [&](){ cft.SetFix(false); cft.ft(-1); cft.ft(1); } );
+        Time_Kernel( "ft_centered", cft, backend, t, calls, [&](){ cft.SetFix(true); cft.ft(-1); cft.ft(1); cft.SetFix(false); } );
+        Time_Kernel( "fix", cft, backend, t, calls, [&](){ cft.Fix(); } );
+        Time_Kernel( "scale", cft, backend, t, calls, [&](){ cft.Scale(); } );
+        Time_Kernel( "Laplace", cft, backend, t, calls, [&](){ cft.Laplace(); } );
+        Time_Kernel( "Diff_x", cft, backend, t, calls, [&](){ cft.Diff_x(); } );
+        Time_Kernel( "Diff_y", cft, backend, t, calls, [&](){ cft.Diff_y(); } );
+        Time_Kernel( "Diff_z", cft, backend, t, calls, [&](){ cft.Diff_z(); } );
+        Time_Kernel( "Diff_xx", cft, backend, t, calls, [&](){ cft.Diff_xx(); } );
+        Time_Kernel( "Diff_yy", cft, backend, t, calls, [&](){ cft.Diff_yy(); } );
+        Time_Kernel( "Diff_zz", cft, backend, t, calls, [&](){ cft.Diff_zz(); } );
+
+        delete pcft;
+      }
+    }
+  }
+
+  fftw_cleanup_threads();
+  return EXIT_SUCCESS;
+}
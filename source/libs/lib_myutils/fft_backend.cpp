@@ -0,0 +1,189 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "fft_backend.h"
+#include "huge_alloc.h"
+
+#ifndef FFT_BACKEND_DEFAULT
+#define FFT_BACKEND_DEFAULT "fftw"
+#endif
+
+namespace Fourier
+{
+  fft_backend * Native_Backend(); // fft_native.cpp
+
+  namespace
+  {
+    /// plan of the FFTW backend
+    class fftw_backend_plan : public fft_plan
+    {
+    public:
+      fftw_backend_plan( fftw_plan p ) : m_plan(p)
+      {
+        if ( m_plan == nullptr ) throw std::string("Error in fftw_backend_plan: FFTW planning failed\n");
+      }
+      ~fftw_backend_plan() { fftw_destroy_plan( m_plan ); }
+
+      void Execute() { fftw_execute( m_plan ); }
+      void Execute( fftw_complex *in, fftw_complex *out ) { fftw_execute_dft( m_plan, in, out ); }
+      void Execute( double *in, fftw_complex *out ) { fftw_execute_dft_r2c( m_plan, in, out ); }
+      void Execute( fftw_complex *in, double *out ) { fftw_execute_dft_c2r( m_plan, in, out ); }
+    protected:
+      fftw_plan m_plan;
+    };
+
+    /// FFTW, all plans FFTW_ESTIMATE, the arrays come from Huge_Alloc
+    class fftw_backend : public fft_backend
+    {
+    public:
+      std::string Name() const { return "fftw"; }
+
+      std::unique_ptr<fft_plan> Plan_c2c( const int rank, const int *n, fftw_complex *in, fftw_complex *out, const int sign, const bool unaligned )
+      {
+        return std::unique_ptr<fft_plan>( new fftw_backend_plan( fftw_plan_dft( rank, n, in, out, sign, Flags(unaligned) ) ) );
+      }
+
+      std::unique_ptr<fft_plan> Plan_r2c( const int rank, const int *n, double *in, fftw_complex *out, const bool unaligned )
+      {
+        return std::unique_ptr<fft_plan>( new fftw_backend_plan( fftw_plan_dft_r2c( rank, n, in, out, Flags(unaligned) ) ) );
+      }
+
+      std::unique_ptr<fft_plan> Plan_c2r( const int rank, const int *n, fftw_complex *in, double *out, const bool unaligned )
+      {
+        return std::unique_ptr<fft_plan>( new fftw_backend_plan( fftw_plan_dft_c2r( rank, n, in, out, Flags(unaligned) ) ) );
+      }
+
+      int Alignment_Of( const double *p ) const { return fftw_alignment_of( const_cast<double *>(p) ); }
+
+      fftw_complex * Alloc_Complex( const int64_t n ) { return Huge_Alloc_Complex( n ); }
+      double * Alloc_Real( const int64_t n ) { return Huge_Alloc_Real( n ); }
+      void Free( void *p ) { Huge_Free( p ); }
+    protected:
+      static unsigned Flags( const bool unaligned ) { return unaligned ? (FFTW_ESTIMATE | FFTW_UNALIGNED) : FFTW_ESTIMATE; }
+    };
+
+    /// pool key: backend, then transform kind, placement, alignment classes and grid
+    typedef std::pair<const fft_backend *, std::vector<int>> pool_key;
+
+    std::mutex & Pool_Mutex()
+    {
+      static std::mutex mutex;
+      return mutex;
+    }
+
+    std::map<pool_key, std::weak_ptr<fft_plan>> & Plan_Pool()
+    {
+      static std::map<pool_key, std::weak_ptr<fft_plan>> pool;
+      return pool;
+    }
+
+    /**
+    * \brief Plan of the pool entry key, created by plan() if no user of it is left
+    *
+    * @param kind FFTW_FORWARD, FFTW_BACKWARD for c2c, 2 for r2c and 3 for c2r
+    */
+    template <class P> std::shared_ptr<fft_plan> Pooled( fft_backend *b, const int kind, const int rank, const int *n, const void *in, const void *out, const bool unaligned, P plan )
+    {
+      // unaligned plans run on arrays of any alignment
+      const int ain  = unaligned ? -1 : b->Alignment_Of( static_cast<const double *>(in) );
+      const int aout = unaligned ? -1 : b->Alignment_Of( static_cast<const double *>(out) );
+
+      pool_key key( b, {kind, int(in == out), ain, aout, rank} );
+      key.second.insert( key.second.end(), n, n+rank );
+
+      std::lock_guard<std::mutex> lock( Pool_Mutex() );
+      auto &pool = Plan_Pool();
+
+      std::shared_ptr<fft_plan> retval = pool[key].lock();
+      if ( retval ) return retval;
+
+      for ( auto it = pool.begin(); it != pool.end(); )
+      {
+        if ( it->second.expired() ) it = pool.erase( it );
+        else ++it;
+      }
+      retval = plan();
+      pool[key] = retval;
+      return retval;
+    }
+
+    std::string & Default_Name()
+    {
+      static std::string name = []()
+      {
+        char *envstr = getenv( "MY_FFT_BACKEND" );
+        return std::string( (envstr != nullptr) ? envstr : FFT_BACKEND_DEFAULT );
+      }();
+      return name;
+    }
+  }
+
+  /**
+  * \brief Backend by name, "fftw" or "native"
+  */
+  fft_backend * fft_backend::Get( const std::string &name )
+  {
+    static fftw_backend fftw;
+
+    if ( name == "fftw" ) return &fftw;
+    if ( name == "native" ) return Native_Backend();
+    throw std::string("Error in fft_backend::Get: unknown FFT backend " + name + "\n");
+  }
+
+  /**
+  * \brief Current process wide default backend
+  */
+  fft_backend * fft_backend::Get()
+  {
+    return Get( Default_Name() );
+  }
+
+  /**
+  * \brief Sets the default backend for cft_base objects constructed from now on
+  */
+  void fft_backend::Set_Default( const std::string &name )
+  {
+    Get( name );
+    Default_Name() = name;
+  }
+
+  std::shared_ptr<fft_plan> fft_backend::Shared_c2c( const int rank, const int *n, fftw_complex *in, fftw_complex *out, const int sign, const bool unaligned )
+  {
+    return Pooled( this, sign, rank, n, in, out, unaligned, [&]() { return Plan_c2c( rank, n, in, out, sign, unaligned ); } );
+  }
+
+  std::shared_ptr<fft_plan> fft_backend::Shared_r2c( const int rank, const int *n, double *in, fftw_complex *out, const bool unaligned )
+  {
+    return Pooled( this, 2, rank, n, in, out, unaligned, [&]() { return Plan_r2c( rank, n, in, out, unaligned ); } );
+  }
+
+  std::shared_ptr<fft_plan> fft_backend::Shared_c2r( const int rank, const int *n, fftw_complex *in, double *out, const bool unaligned )
+  {
+    return Pooled( this, 3, rank, n, in, out, unaligned, [&]() { return Plan_c2r( rank, n, in, out, unaligned ); } );
+  }
+}
@@ -0,0 +1,122 @@
+/* * ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+ * (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+ * founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+ * 50WM0942, 50WM1042, 50WM1342.
+ * Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+ *
+ * This file is part of ATUS2.
+ *
+ * ATUS2 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ATUS2 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <memory>
+#include "fftw3.h"
+
+#pragma once
+
+namespace Fourier
+{
+  /**
+  * \brief Transform plan of an fft_backend
+  *
+  * All transforms are unnormalized. The data type is fftw_complex for every backend.
+  */
+  class fft_plan
+  {
+  public:
+    virtual ~fft_plan() {}
+
+    /// transform of the arrays the plan was created with
+    virtual void Execute() = 0;
+    /// c2c transform of other arrays, in and out may be equal
+    virtual void Execute( fftw_complex *in, fftw_complex *out ) = 0;
+    /// r2c transform of other arrays
+    virtual void Execute( double *in, fftw_complex *out ) = 0;
+    /// c2r transform of other arrays, the input may be destroyed
+    virtual void Execute( fftw_complex *in, double *out ) = 0;
+
+    /**
+    * \brief c2c transforms of howmany arrays in+b*idist -> out+b*odist
+    *
+    * @param howmany Number of transforms
+    * @param in First input array
+    * @param idist Distance of the input arrays in units of fftw_complex
+    * @param out First output array
+    * @param odist Distance of the output arrays in units of fftw_complex
+    */
+    virtual void Execute_Batch( const int howmany, fftw_complex *in, const int64_t idist, fftw_complex *out, const int64_t odist )
+    {
+      for ( int b=0; b<howmany; b++ )
+        Execute( in+b*idist, out+b*odist );
+    }
+  };
+
+  /**
+  * \brief FFT engine behind cft_base
+  *
+  * Creates plans and allocates the arrays. "fftw" (default) uses FFTW, "native" is the in-tree radix-2
+  * transform for power of two grids (fft_native.cpp). The process wide default is set at configure time
+  * (cmake -DFFT_BACKEND=native), the environment variable MY_FFT_BACKEND or Set_Default(). Every cft_base
+  * object keeps the backend that was the default at its construction.
+  */
+  class fft_backend
+  {
+  public:
+    virtual ~fft_backend() {}
+
+    virtual std::string Name() const = 0;
+
+    /**
+    * \brief Plan of a c2c transform on a row major grid
+    *
+    * @param rank Number of dimensions
+    * @param n Grid size per dimension
+    * @param in Input array
+    * @param out Output array, may be equal to in
+    * @param sign FFTW_FORWARD or FFTW_BACKWARD
+    * @param unaligned Whether the plan is executed on arrays with another alignment than in and out
+    */
+    virtual std::unique_ptr<fft_plan> Plan_c2c( const int rank, const int *n, fftw_complex *in, fftw_complex *out, const int sign, const bool unaligned=false ) = 0;
+    /// Plan of an r2c transform, out has n[rank-1]/2+1 entries in the last dimension
+    virtual std::unique_ptr<fft_plan> Plan_r2c( const int rank, const int *n, double *in, fftw_complex *out, const bool unaligned=false ) = 0;
+    /// Plan of a c2r transform, see Plan_r2c
+    virtual std::unique_ptr<fft_plan> Plan_c2r( const int rank, const int *n, fftw_complex *in, double *out, const bool unaligned=false ) = 0;
+
+    /**
+    * \brief Plan of a c2c transform from the process wide plan pool
+    *
+    * Requests with the same backend, grid, direction, placement (in == out) and alignment classes get the same
+    * plan, which lives as long as one of its users holds it. A pooled plan may only be run with the new-array
+    * Execute overloads, the arrays it was created with belong to the first user. Plans of the native backend
+    * must not be executed by two threads at once.
+    */
+    std::shared_ptr<fft_plan> Shared_c2c( const int rank, const int *n, fftw_complex *in, fftw_complex *out, const int sign, const bool unaligned=false );
+    /// Pooled r2c plan, see Shared_c2c
+    std::shared_ptr<fft_plan> Shared_r2c( const int rank, const int *n, double *in, fftw_complex *out, const bool unaligned=false );
+    /// Pooled c2r plan, see Shared_c2c
+    std::shared_ptr<fft_plan> Shared_c2r( const int rank, const int *n, fftw_complex *in, double *out, const bool unaligned=false );
+
+    /// alignment class of an array, plans with unaligned=false are only valid for arrays of the same class
+    virtual int Alignment_Of( const double *p ) const = 0;
+
+    virtual fftw_complex * Alloc_Complex( const int64_t n ) = 0;
+    virtual double * Alloc_Real( const int64_t n ) = 0;
+    virtual void Free( void *p ) = 0;
+
+    static fft_backend * Get();
+    static fft_backend * Get( const std::string & );
+    static void Set_Default( const std::string & );
+  };
+}
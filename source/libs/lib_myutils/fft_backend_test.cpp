@@ -0,0 +1,180 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/** Compares the native FFT backend with FFTW
+ *
+ * c2c (forward and backward, in and out of place), r2c and c2r transforms on power of two grids in 1, 2 and 3
+ * dimensions. Returns EXIT_FAILURE if a result of the native backend deviates by more than tol relative to the
+ * largest FFTW value.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include "fftw3.h"
+#include "fft_backend.h"
+
+using namespace Fourier;
+
+const double tol = 1e-12;
+
+double max_dev( const double *a, const double *b, const int64_t n )
+{
+  double dev = 0, norm = 0;
+  for ( int64_t l=0; l<n; l++ )
+  {
+    dev = std::max( dev, fabs(a[l]-b[l]) );
+    norm = std::max( norm, fabs(b[l]) );
+  }
+  return dev / norm;
+}
+
+bool report( const char *what, const int rank, const int *n, const double dev )
+{
+  printf( "%-26s", what );
+  for ( int d=0; d<rank; d++ ) printf( (d == 0) ? " %4d" : " x %4d", n[d] );
+  printf( "%*s: %.3e %s\n", 7*(3-rank), "", dev, (dev < tol) ? "" : "FAILED" );
+  return dev < tol;
+}
+
+/**
+ * \brief c2c transforms of both backends on the same data
+ */
+bool check_c2c( fft_backend *native, fft_backend *fftw, const int rank, const int *n, const int sign, const bool inplace )
+{
+  int64_t N = 1;
+  for ( int d=0; d<rank; d++ ) N *= n[d];
+
+  fftw_complex *in_1 = fftw->Alloc_Complex(N);
+  fftw_complex *in_2 = fftw->Alloc_Complex(N);
+  fftw_complex *out_1 = inplace ? in_1 : fftw->Alloc_Complex(N);
+  fftw_complex *out_2 = inplace ? in_2 : fftw->Alloc_Complex(N);
+
+  auto plan_1 = native->Plan_c2c( rank, n, in_1, out_1, sign );
+  auto plan_2 = fftw->Plan_c2c( rank, n, in_2, out_2, sign );
+
+  for ( int64_t l=0; l<N; l++ )
+  {
+    in_1[l][0] = sin(0.37*l) + cos(0.011*l*l);
+    in_1[l][1] = cos(1.3*l) - 0.5*sin(0.07*l);
+  }
+  memcpy( in_2, in_1, N*sizeof(fftw_complex) );
+
+  plan_1->Execute();
+  plan_2->Execute();
+
+  char what[64];
+  sprintf( what, "c2c %s %s", (sign == FFTW_FORWARD) ? "forward" : "backward", inplace ? "in-place" : "out-of-place" );
+  const bool ok = report( what, rank, n, max_dev( &out_1[0][0], &out_2[0][0], 2*N ) );
+
+  if ( !inplace )
+  {
+    fftw->Free( out_1 );
+    fftw->Free( out_2 );
+  }
+  fftw->Free( in_1 );
+  fftw->Free( in_2 );
+  return ok;
+}
+
+/**
+ * \brief r2c and c2r transforms of both backends on the same data
+ */
+bool check_r2c_c2r( fft_backend *native, fft_backend *fftw, const int rank, const int *n )
+{
+  int64_t N = 1, N_fs = 1;
+  for ( int d=0; d<rank; d++ )
+  {
+    N *= n[d];
+    N_fs *= (d == rank-1) ? n[d]/2+1 : n[d];
+  }
+
+  double *real_1 = fftw->Alloc_Real(N);
+  double *real_2 = fftw->Alloc_Real(N);
+  fftw_complex *cplx_1 = fftw->Alloc_Complex(N_fs);
+  fftw_complex *cplx_2 = fftw->Alloc_Complex(N_fs);
+
+  auto r2c_1 = native->Plan_r2c( rank, n, real_1, cplx_1 );
+  auto r2c_2 = fftw->Plan_r2c( rank, n, real_2, cplx_2 );
+  auto c2r_1 = native->Plan_c2r( rank, n, cplx_1, real_1 );
+  auto c2r_2 = fftw->Plan_c2r( rank, n, cplx_2, real_2 );
+
+  for ( int64_t l=0; l<N; l++ )
+    real_1[l] = sin(0.37*l) + cos(0.011*l*l);
+  memcpy( real_2, real_1, N*sizeof(double) );
+
+  r2c_1->Execute();
+  r2c_2->Execute();
+  bool ok = report( "r2c", rank, n, max_dev( &cplx_1[0][0], &cplx_2[0][0], 2*N_fs ) );
+
+  // c2r from the same (hermitian) spectrum, c2r may destroy its input
+  memcpy( cplx_1, cplx_2, N_fs*sizeof(fftw_complex) );
+  c2r_1->Execute();
+  c2r_2->Execute();
+  ok = report( "c2r", rank, n, max_dev( real_1, real_2, N ) ) && ok;
+
+  fftw->Free( real_1 );
+  fftw->Free( real_2 );
+  fftw->Free( cplx_1 );
+  fftw->Free( cplx_2 );
+  return ok;
+}
+
+int main()
+{
+  fft_backend *native = fft_backend::Get( "native" );
+  fft_backend *fftw = fft_backend::Get( "fftw" );
+
+  const int sizes[][3] = { {1,1,512}, {1,2,1024}, {1,64,32}, {1,8,128}, {16,32,8}, {4,2,64} };
+  const int ranks[] = { 1, 1, 2, 2, 3, 3 };
+
+  bool ok = true;
+  try
+  {
+    for ( int s=0; s<6; s++ )
+    {
+      const int rank = ranks[s];
+      const int *n = sizes[s] + 3-rank;
+
+      for ( int inplace=0; inplace<2; inplace++ )
+      {
+        ok = check_c2c( native, fftw, rank, n, FFTW_FORWARD, inplace ) && ok;
+        ok = check_c2c( native, fftw, rank, n, FFTW_BACKWARD, inplace ) && ok;
+      }
+      ok = check_r2c_c2r( native, fftw, rank, n ) && ok;
+    }
+  }
+  catch ( const std::string &str )
+  {
+    printf( "%s", str.c_str() );
+    return EXIT_FAILURE;
+  }
+
+  fftw_cleanup();
+  printf( ok ? "native backend matches FFTW\n" : "native backend deviates from FFTW\n" );
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,328 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <cstdlib>
+#include <cmath>
+#include <array>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "fft_backend.h"
+
+/** In-tree FFT backend
+  *
+  * Iterative radix-2 transforms of power of two lengths. A grid is transformed dimension by dimension,
+  * the contiguous last dimension in place and the others through a buffer that holds a block of
+  * adjacent lines, so every cache line of a strided pass is used. Lines are distributed statically
+  * over the OpenMP threads. r2c and c2r go through a complex scratch array of the full grid.
+  */
+
+namespace Fourier
+{
+  namespace
+  {
+    const int block = 8; /// adjacent lines per buffer of a strided pass
+
+    /// radix-2 transform of contiguous lines of one length and sign
+    class fft_line
+    {
+    public:
+      fft_line( const int n, const int sign ) : m_n(n), m_w(std::max(n-1,1)), m_rev(n)
+      {
+        if ( n < 1 || (n & (n-1)) != 0 )
+          throw std::string("Error in fft_line: the native FFT backend supports powers of two only, got " + std::to_string(n) + "\n");
+
+        // twiddle factors of the stage with butterflies of length len at m_w[len/2-1], contiguous per stage
+        for ( int len=2; len<=n; len<<=1 )
+          for ( int k=0; k<len/2; k++ )
+          {
+            m_w[len/2-1+k][0] = cos(2*M_PI*k/len);
+            m_w[len/2-1+k][1] = sign*sin(2*M_PI*k/len);
+          }
+
+        int bits = 0;
+        while ( (1 << bits) < n ) bits++;
+        for ( int i=0; i<n; i++ )
+        {
+          int r = 0;
+          for ( int b=0; b<bits; b++ )
+            if ( i & (1 << b) ) r |= 1 << (bits-1-b);
+          m_rev[i] = r;
+        }
+      }
+
+      void Transform( fftw_complex *x ) const
+      {
+        for ( int i=0; i<m_n; i++ )
+        {
+          const int j = m_rev[i];
+          if ( i < j )
+          {
+            std::swap( x[i][0], x[j][0] );
+            std::swap( x[i][1], x[j][1] );
+          }
+        }
+
+        for ( int len=2; len<=m_n; len<<=1 )
+        {
+          const int half = len/2;
+          const std::array<double,2> *w = m_w.data()+half-1;
+          for ( int s=0; s<m_n; s+=len )
+          {
+            fftw_complex *a = x+s;
+            fftw_complex *b = x+s+half;
+            for ( int k=0; k<half; k++ )
+            {
+              const double wr = w[k][0];
+              const double wi = w[k][1];
+              const double tr = wr*b[k][0] - wi*b[k][1];
+              const double ti = wr*b[k][1] + wi*b[k][0];
+              b[k][0] = a[k][0] - tr;
+              b[k][1] = a[k][1] - ti;
+              a[k][0] += tr;
+              a[k][1] += ti;
+            }
+          }
+        }
+      }
+
+      int Get_N() const { return m_n; }
+    protected:
+      int m_n;
+      std::vector<std::array<double,2>> m_w;
+      std::vector<int> m_rev;
+    };
+
+    enum PLAN_TYPE { C2C, R2C, C2R };
+
+    /// plan of the native backend
+    class native_plan : public fft_plan
+    {
+    public:
+      native_plan( const PLAN_TYPE type, const int rank, const int *n, void *in, void *out, const int sign ) : m_type(type), m_in(in), m_out(out), m_N(1)
+      {
+        for ( int d=0; d<rank; d++ )
+        {
+          m_n.push_back(n[d]);
+          m_lines.emplace_back( n[d], sign );
+          m_N *= n[d];
+        }
+        if ( m_type != C2C ) m_scratch.resize( 2*m_N );
+      }
+
+      void Execute()
+      {
+        switch ( m_type )
+        {
+          case C2C: Execute( static_cast<fftw_complex *>(m_in), static_cast<fftw_complex *>(m_out) );
+          break;
+          case R2C: Execute( static_cast<double *>(m_in), static_cast<fftw_complex *>(m_out) );
+          break;
+          case C2R: Execute( static_cast<fftw_complex *>(m_in), static_cast<double *>(m_out) );
+          break;
+        }
+      }
+
+      void Execute( fftw_complex *in, fftw_complex *out )
+      {
+        if ( in != out )
+        {
+          #pragma omp parallel for
+          for ( int64_t l=0; l<m_N; l++ )
+          {
+            out[l][0] = in[l][0];
+            out[l][1] = in[l][1];
+          }
+        }
+        Transform( out );
+      }
+
+      void Execute( double *in, fftw_complex *out )
+      {
+        fftw_complex *x = reinterpret_cast<fftw_complex *>(m_scratch.data());
+        const int64_t nl = m_n.back();
+        const int64_t nh = nl/2+1;
+        const int64_t nr = m_N/nl;
+
+        #pragma omp parallel for
+        for ( int64_t l=0; l<m_N; l++ )
+        {
+          x[l][0] = in[l];
+          x[l][1] = 0;
+        }
+
+        Transform( x );
+
+        #pragma omp parallel for
+        for ( int64_t r=0; r<nr; r++ )
+          for ( int64_t k=0; k<nh; k++ )
+          {
+            out[r*nh+k][0] = x[r*nl+k][0];
+            out[r*nh+k][1] = x[r*nl+k][1];
+          }
+      }
+
+      void Execute( fftw_complex *in, double *out )
+      {
+        fftw_complex *x = reinterpret_cast<fftw_complex *>(m_scratch.data());
+        const int64_t nl = m_n.back();
+        const int64_t nh = nl/2+1;
+        const int64_t nr = m_N/nl;
+        const int nx = (m_n.size() > 1) ? m_n[0] : 1;
+        const int ny = (m_n.size() > 2) ? m_n[1] : 1;
+
+        // the missing half from the hermitian symmetry X(-k) = conj(X(k))
+        #pragma omp parallel for
+        for ( int64_t r=0; r<nr; r++ )
+        {
+          const int64_t i = r / ny;
+          const int64_t j = r - i*ny;
+          const int64_t rm = ((nx-i)%nx)*ny + (ny-j)%ny;
+          for ( int64_t k=0; k<nh; k++ )
+          {
+            x[r*nl+k][0] = in[r*nh+k][0];
+            x[r*nl+k][1] = in[r*nh+k][1];
+          }
+          for ( int64_t k=nh; k<nl; k++ )
+          {
+            x[r*nl+k][0] = in[rm*nh+nl-k][0];
+            x[r*nl+k][1] = -in[rm*nh+nl-k][1];
+          }
+        }
+
+        Transform( x );
+
+        #pragma omp parallel for
+        for ( int64_t l=0; l<m_N; l++ )
+          out[l] = x[l][0];
+      }
+
+    protected:
+      /// in place transform of all dimensions
+      void Transform( fftw_complex *x )
+      {
+        int64_t stride = m_N;
+        for ( size_t d=0; d<m_n.size(); d++ )
+        {
+          const int64_t len = m_n[d];
+          stride /= len;
+          if ( len == 1 ) continue;
+
+          const fft_line &line = m_lines[d];
+          const int64_t outer = m_N/(len*stride);
+
+          if ( stride == 1 )
+          {
+            #pragma omp parallel for schedule(static)
+            for ( int64_t o=0; o<outer; o++ )
+              line.Transform( x+o*len );
+            continue;
+          }
+
+          const int64_t nblocks = (stride+block-1)/block;
+
+          #pragma omp parallel
+          {
+            std::vector<double> buf( 2*block*len );
+            fftw_complex *b = reinterpret_cast<fftw_complex *>(buf.data());
+
+            #pragma omp for schedule(static)
+            for ( int64_t ob=0; ob<outer*nblocks; ob++ )
+            {
+              const int64_t o = ob / nblocks;
+              const int64_t i0 = (ob - o*nblocks)*block;
+              const int nb = int(std::min<int64_t>( block, stride-i0 ));
+              fftw_complex *base = x + o*len*stride + i0;
+
+              for ( int64_t m=0; m<len; m++ )
+                for ( int c=0; c<nb; c++ )
+                {
+                  b[c*len+m][0] = base[m*stride+c][0];
+                  b[c*len+m][1] = base[m*stride+c][1];
+                }
+
+              for ( int c=0; c<nb; c++ )
+                line.Transform( b+c*len );
+
+              for ( int64_t m=0; m<len; m++ )
+                for ( int c=0; c<nb; c++ )
+                {
+                  base[m*stride+c][0] = b[c*len+m][0];
+                  base[m*stride+c][1] = b[c*len+m][1];
+                }
+            }
+          }
+        }
+      }
+
+      PLAN_TYPE m_type;
+      void *m_in;
+      void *m_out;
+      int64_t m_N;
+      std::vector<int> m_n;
+      std::vector<fft_line> m_lines;
+      std::vector<double> m_scratch;
+    };
+
+    /// in-tree radix-2 backend
+    class native_backend : public fft_backend
+    {
+    public:
+      std::string Name() const { return "native"; }
+
+      std::unique_ptr<fft_plan> Plan_c2c( const int rank, const int *n, fftw_complex *in, fftw_complex *out, const int sign, const bool )
+      {
+        return std::unique_ptr<fft_plan>( new native_plan( C2C, rank, n, in, out, sign ) );
+      }
+
+      std::unique_ptr<fft_plan> Plan_r2c( const int rank, const int *n, double *in, fftw_complex *out, const bool )
+      {
+        return std::unique_ptr<fft_plan>( new native_plan( R2C, rank, n, in, out, FFTW_FORWARD ) );
+      }
+
+      std::unique_ptr<fft_plan> Plan_c2r( const int rank, const int *n, fftw_complex *in, double *out, const bool )
+      {
+        return std::unique_ptr<fft_plan>( new native_plan( C2R, rank, n, in, out, FFTW_BACKWARD ) );
+      }
+
+      int Alignment_Of( const double * ) const { return 0; }
+
+      fftw_complex * Alloc_Complex( const int64_t n ) { return static_cast<fftw_complex *>( Alloc( n*sizeof(fftw_complex) ) ); }
+      double * Alloc_Real( const int64_t n ) { return static_cast<double *>( Alloc( n*sizeof(double) ) ); }
+      void Free( void *p ) { free( p ); }
+    protected:
+      static void * Alloc( const size_t bytes )
+      {
+        // cache line aligned, aligned_alloc needs a multiple of the alignment
+        return aligned_alloc( 64, ((bytes+63)/64)*64 );
+      }
+    };
+  }
+
+  fft_backend * Native_Backend()
+  {
+    static native_backend native;
+    return &native;
+  }
+}
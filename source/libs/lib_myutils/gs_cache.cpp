@@ -0,0 +1,309 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "gs_cache.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <functional>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace
+{
+  /// tags which only control the numerics, they do not distinguish ground states
+  const char * numerical_constants[] = { "epsilon", "stepsize", "levels", "anderson_depth", "epsilon_levels" };
+
+  /// periodic index
+  inline int64_t Wrap( const int64_t i, const int64_t n )
+  {
+    return (i+n) % n;
+  }
+
+  bool Is_Numerical( const std::string &key )
+  {
+    for ( auto s : numerical_constants )
+      if ( key == s ) return true;
+    return false;
+  }
+}
+
+/** Constructor
+  * @param dir Cache directory, created if necessary
+  * @param params Parameters of the current run
+  * @param dim Dimension
+  * @param no_wf Number of components
+  */
+CGS_Cache::CGS_Cache( const std::string &dir, ParameterHandler *params, const int dim, const int no_wf ) : m_dir(dir)
+{
+  mkdir( m_dir.c_str(), 0755 );
+
+  m_this.dim = dim;
+  m_this.no_wf = no_wf;
+
+  const std::string potstr = "POTENTIAL_" + to_string(dim) + "D";
+  m_this.potentials.push_back( params->Get_simulation( potstr ) );
+  for ( int i=1; i<no_wf; i++ )
+  {
+    try
+    {
+      m_this.potentials.push_back( params->Get_simulation( potstr + "_" + to_string(i+1) ) );
+    }
+    catch (std::string &)
+    {
+      m_this.potentials.push_back( m_this.potentials[0] );
+    }
+  }
+
+  for ( auto it : params->Get_Constants() )
+    if ( !Is_Numerical(it.first) ) m_this.constants[it.first] = std::vector<double>(1,it.second);
+  for ( auto it : params->Get_VConstants() )
+    if ( !Is_Numerical(it.first) ) m_this.constants["V:" + it.first] = it.second;
+}
+
+/// Name of the entry of the current parameters, equal parameters overwrite each other
+std::string CGS_Cache::Key() const
+{
+  ostringstream str;
+  str.precision(17);
+  str << m_this.dim << " " << m_this.no_wf;
+  for ( auto &p : m_this.potentials )
+    str << " " << p;
+  for ( auto &it : m_this.constants )
+  {
+    str << " " << it.first;
+    for ( auto v : it.second ) str << " " << v;
+  }
+  char buf[32];
+  sprintf( buf, "%016zx", std::hash<std::string>()( str.str() ) );
+  return std::string(buf);
+}
+
+/// File names of the components of the current entry
+std::vector<std::string> CGS_Cache::Entry_Files() const
+{
+  std::vector<std::string> retval;
+  const std::string base = m_dir + "/gs_" + Key();
+  for ( int i=0; i<m_this.no_wf; i++ )
+    retval.push_back( base + "_" + to_string(i) + ".bin" );
+  return retval;
+}
+
+/// Writes the index file of the current entry, call after the files Entry_Files() are written
+void CGS_Cache::Commit() const
+{
+  ofstream out( m_dir + "/gs_" + Key() + ".txt" );
+  out.precision(17);
+  out << "dim " << m_this.dim << "\n";
+  out << "no_wf " << m_this.no_wf << "\n";
+  for ( auto &p : m_this.potentials )
+    out << "potential " << p << "\n";
+  for ( auto &it : m_this.constants )
+  {
+    out << "const " << it.first;
+    for ( auto v : it.second ) out << " " << v;
+    out << "\n";
+  }
+}
+
+bool CGS_Cache::Read_Entry( const std::string &filename, entry &e ) const
+{
+  ifstream in( filename );
+  if ( !in.is_open() ) return false;
+
+  e.dim = 0;
+  e.no_wf = 0;
+  std::string line;
+  while ( getline( in, line ) )
+  {
+    istringstream str(line);
+    std::string tag;
+    str >> tag;
+    if ( tag == "dim" ) str >> e.dim;
+    else if ( tag == "no_wf" ) str >> e.no_wf;
+    else if ( tag == "potential" ) e.potentials.push_back( line.substr(10) );
+    else if ( tag == "const" )
+    {
+      std::string key;
+      double val;
+      str >> key;
+      std::vector<double> &vec = e.constants[key];
+      while ( str >> val ) vec.push_back(val);
+    }
+  }
+  return e.dim > 0;
+}
+
+/// Relative distance of the constants, infinite for incompatible entries
+double CGS_Cache::Distance( const entry &e ) const
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  if ( e.dim != m_this.dim || e.no_wf != m_this.no_wf || e.potentials != m_this.potentials ) return inf;
+  if ( e.constants.size() != m_this.constants.size() ) return inf;
+
+  double retval=0;
+  for ( auto &it : m_this.constants )
+  {
+    auto it2 = e.constants.find(it.first);
+    if ( it2 == e.constants.end() || it2->second.size() != it.second.size() ) return inf;
+
+    for ( size_t j=0; j<it.second.size(); j++ )
+    {
+      const double a = it.second[j];
+      const double b = it2->second[j];
+      const double s = std::max( std::max(fabs(a),fabs(b)), 1e-300 );
+      retval += (a-b)*(a-b)/(s*s);
+    }
+  }
+  return sqrt(retval);
+}
+
+/** Searches the nearest compatible entry
+  * @param files Returns the component files of the entry
+  * @return false if there is no compatible entry
+  */
+bool CGS_Cache::Find( std::vector<std::string> &files )
+{
+  DIR *pDir = opendir( m_dir.c_str() );
+  if ( pDir == nullptr ) return false;
+
+  double dist_min = std::numeric_limits<double>::infinity();
+  std::string best;
+
+  struct dirent *pDirEnt;
+  while ( (pDirEnt = readdir( pDir )) != nullptr )
+  {
+    const std::string name = pDirEnt->d_name;
+    if ( name.size() < 8 || name.compare(0,3,"gs_") != 0 || name.compare(name.size()-4,4,".txt") != 0 ) continue;
+
+    entry e;
+    if ( !Read_Entry( m_dir + "/" + name, e ) ) continue;
+    const double dist = Distance(e);
+    if ( dist < dist_min )
+    {
+      dist_min = dist;
+      best = name.substr( 0, name.size()-4 );
+    }
+  }
+  closedir( pDir );
+
+  if ( best.empty() ) return false;
+
+  files.clear();
+  for ( int i=0; i<m_this.no_wf; i++ )
+    files.push_back( m_dir + "/" + best + "_" + to_string(i) + ".bin" );
+
+  std::cout << "FYI: warm start from " << best << ", relative parameter distance " << dist_min << std::endl;
+  return true;
+}
+
+/** Interpolates a complex wave function file onto a grid
+  *
+  * Cubic (four point Lagrange) interpolation in real space with the coordinates x_i = (i-n/2) dx of the
+  * transforms, the stencils wrap around periodically. Points outside of the domain of the file are set to zero.
+  * @param filename File with generic_header and complex data
+  * @param header Target grid
+  * @param out Target array
+  */
+void CGS_Cache::Interpolate( const std::string &filename, const generic_header &header, fftw_complex *out )
+{
+  generic_header src;
+  ifstream in( filename, ifstream::binary );
+  if ( !in.is_open() ) throw std::string( "Could not open file " + filename + ".\n" );
+  in.read( (char *)&src, sizeof(generic_header) );
+
+  if ( src.nDims != header.nDims || src.bComplex != 1 ) throw std::string( "Error in " + std::string(__func__) + ": incompatible file " + filename + "\n" );
+
+  const int64_t n[] = {src.nDimX, src.nDimY, src.nDimZ};
+  const int64_t N[] = {header.nDimX, header.nDimY, header.nDimZ};
+  const double d[] = {src.dx, src.dy, src.dz};
+  const double D[] = {header.dx, header.dy, header.dz};
+  const int64_t no_of_pts = n[0]*n[1]*n[2];
+
+  fftw_complex *data = fftw_alloc_complex( no_of_pts );
+  in.read( (char *)data, no_of_pts*sizeof(fftw_complex) );
+  in.close();
+
+  bool same = true;
+  for ( int k=0; k<3; k++ )
+    if ( n[k] != N[k] || (N[k] > 1 && fabs(d[k]-D[k]) > 1e-12*D[k]) ) same = false;
+
+  if ( same )
+  {
+    memcpy( out, data, no_of_pts*sizeof(fftw_complex) );
+    fftw_free( data );
+    return;
+  }
+
+  #pragma omp parallel for
+  for ( int64_t l=0; l<N[0]*N[1]*N[2]; l++ )
+  {
+    const int64_t idx[] = { l/(N[1]*N[2]), (l/N[2])%N[1], l%N[2] };
+
+    // four point Lagrange weights per axis, the stencil starts at i0
+    int64_t i0[3];
+    double w[3][4];
+    int np[3];
+    bool inside = true;
+    for ( int k=0; k<3; k++ )
+    {
+      i0[k] = 0;
+      np[k] = 1;
+      w[k][0] = 1;
+      if ( n[k] == 1 ) continue;
+      const double s = double(idx[k]-N[k]/2)*D[k]/d[k] + double(n[k]/2);
+      if ( s < 0 || s >= double(n[k]) )
+      {
+        inside = false;
+        break;
+      }
+      np[k] = 4;
+      i0[k] = int64_t(s)-1;
+      const double t = s - double(i0[k]);
+      w[k][0] = -(t-1)*(t-2)*(t-3)/6;
+      w[k][1] = t*(t-2)*(t-3)/2;
+      w[k][2] = -t*(t-1)*(t-3)/2;
+      w[k][3] = t*(t-1)*(t-2)/6;
+    }
+
+    out[l][0] = 0;
+    out[l][1] = 0;
+    if ( !inside ) continue;
+
+    for ( int a=0; a<np[0]; a++ )
+      for ( int b=0; b<np[1]; b++ )
+        for ( int c=0; c<np[2]; c++ )
+        {
+          const double fak = w[0][a]*w[1][b]*w[2][c];
+          const int64_t L = Wrap(i0[2]+c,n[2]) + n[2]*(Wrap(i0[1]+b,n[1]) + n[1]*Wrap(i0[0]+a,n[0]));
+          out[l][0] += fak*data[L][0];
+          out[l][1] += fak*data[L][1];
+        }
+  }
+  fftw_free( data );
+}
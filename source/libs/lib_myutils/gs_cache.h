@@ -0,0 +1,70 @@
+/* * ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+ * (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+ * founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+ * 50WM0942, 50WM1042, 50WM1342.
+ * Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+ *
+ * This file is part of ATUS2.
+ *
+ * ATUS2 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ATUS2 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+#include <map>
+#include "fftw3.h"
+#include "my_structs.h"
+#include "ParameterHandler.h"
+
+#ifndef GS_CACHE_H
+#define GS_CACHE_H
+
+/** Directory of converged ground states for warm starts of parameter sweeps
+  *
+  * An entry consists of one complex wave function file per component (gs_<key>_<i>.bin) and
+  * an index file gs_<key>.txt with the dimension, the number of components, the potentials and
+  * the physical constants of the run. Entries with the same dimension, number of components,
+  * potential expressions and constant names are compatible, the nearest one (relative distance
+  * of all constants) serves as starting point. Numerical parameters (epsilon, stepsize, levels,
+  * anderson_depth, epsilon_levels) and the grid do not enter the key, other grids are interpolated.
+  */
+class CGS_Cache
+{
+public:
+  CGS_Cache( const std::string &, ParameterHandler *, const int, const int );
+
+  bool Find( std::vector<std::string> & );
+  std::vector<std::string> Entry_Files() const;
+  void Commit() const;
+
+  static void Interpolate( const std::string &, const generic_header &, fftw_complex * );
+
+protected:
+  struct entry
+  {
+    int dim;
+    int no_wf;
+    std::vector<std::string> potentials;
+    std::map<std::string,std::vector<double>> constants;
+  };
+
+  bool Read_Entry( const std::string &, entry & ) const;
+  double Distance( const entry & ) const;
+  std::string Key() const;
+
+  std::string m_dir;
+  entry m_this;
+};
+
+#endif
@@ -0,0 +1,193 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <sys/mman.h>
+#include "huge_alloc.h"
+
+namespace
+{
+  const size_t huge_page = size_t(2) << 20;
+
+  /// mapping of Huge_Alloc
+  struct region
+  {
+    size_t len; /// mapped bytes, a multiple of huge_page
+    bool hugetlb; /// reserved huge pages (MAP_HUGETLB)
+  };
+
+  std::mutex & Region_Mutex()
+  {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  std::map<char *, region> & Regions()
+  {
+    static std::map<char *, region> regions;
+    return regions;
+  }
+
+  std::string Mode()
+  {
+    const char *envstr = getenv( "MY_HUGE_PAGES" );
+    return (envstr != nullptr) ? std::string(envstr) : std::string("thp");
+  }
+
+  /**
+  * \brief Anonymous mapping of len bytes aligned to huge_page and marked for transparent huge pages
+  *
+  * @return nullptr if the mapping failed
+  */
+  char * Map_THP( const size_t len )
+  {
+    // one huge page more than needed, the unaligned head and the tail are unmapped again
+    char *raw = static_cast<char *>( mmap( nullptr, len+huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) );
+    if ( raw == MAP_FAILED ) return nullptr;
+
+    char *p = reinterpret_cast<char *>( (reinterpret_cast<uintptr_t>(raw) + huge_page-1) & ~uintptr_t(huge_page-1) );
+    if ( p > raw ) munmap( raw, p-raw );
+    if ( raw+huge_page > p ) munmap( p+len, raw+huge_page-p );
+#ifdef MADV_HUGEPAGE
+    madvise( p, len, MADV_HUGEPAGE );
+#endif
+    return p;
+  }
+
+  /// bytes of [start,end) inside the mappings of Huge_Alloc
+  size_t Overlap( const uintptr_t start, const uintptr_t end )
+  {
+    size_t retval = 0;
+    for ( const auto &it : Regions() )
+    {
+      const uintptr_t a = std::max( start, reinterpret_cast<uintptr_t>(it.first) );
+      const uintptr_t b = std::min( end, reinterpret_cast<uintptr_t>(it.first)+it.second.len );
+      if ( b > a ) retval += b-a;
+    }
+    return retval;
+  }
+}
+
+void * Huge_Alloc( const size_t bytes )
+{
+  const std::string mode = Mode();
+  if ( bytes < huge_page || mode == "off" || mode == "0" ) return fftw_malloc( bytes );
+
+  const size_t len = ((bytes+huge_page-1)/huge_page)*huge_page;
+  char *p = nullptr;
+  bool hugetlb = false;
+
+#ifdef MAP_HUGETLB
+  // private hugetlb mappings reserve their pages at mmap, so an empty pool fails here and not at first touch
+  if ( mode == "explicit" )
+  {
+    void *q = mmap( nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+    if ( q != MAP_FAILED )
+    {
+      p = static_cast<char *>(q);
+      hugetlb = true;
+    }
+  }
+#endif
+  if ( p == nullptr ) p = Map_THP( len );
+  if ( p == nullptr ) return fftw_malloc( bytes );
+
+  std::lock_guard<std::mutex> lock( Region_Mutex() );
+  Regions()[p] = {len, hugetlb};
+  return p;
+}
+
+fftw_complex * Huge_Alloc_Complex( const int64_t n )
+{
+  return static_cast<fftw_complex *>( Huge_Alloc( n*sizeof(fftw_complex) ) );
+}
+
+double * Huge_Alloc_Real( const int64_t n )
+{
+  return static_cast<double *>( Huge_Alloc( n*sizeof(double) ) );
+}
+
+void Huge_Free( void *p )
+{
+  if ( p == nullptr ) return;
+  {
+    std::lock_guard<std::mutex> lock( Region_Mutex() );
+    auto it = Regions().find( static_cast<char *>(p) );
+    if ( it != Regions().end() )
+    {
+      munmap( p, it->second.len );
+      Regions().erase( it );
+      return;
+    }
+  }
+  fftw_free( p );
+}
+
+void Huge_Pages_Report()
+{
+  const char *envstr = getenv( "MY_HUGE_PAGES_INFO" );
+  if ( envstr == nullptr || std::string(envstr) == "0" ) return;
+
+  std::lock_guard<std::mutex> lock( Region_Mutex() );
+
+  size_t total = 0, hugetlb = 0;
+  for ( const auto &it : Regions() )
+  {
+    total += it.second.len;
+    if ( it.second.hugetlb ) hugetlb += it.second.len;
+  }
+
+  // AnonHugePages (transparent) and *_Hugetlb (reserved) of the mappings holding the arrays
+  size_t huge = 0, overlap = 0;
+  std::ifstream smaps( "/proc/self/smaps" );
+  std::string line;
+  while ( std::getline( smaps, line ) )
+  {
+    unsigned long long start, end, kb;
+    if ( sscanf( line.c_str(), "%llx-%llx ", &start, &end ) == 2 )
+    {
+      overlap = Overlap( start, end );
+      continue;
+    }
+    if ( overlap == 0 ) continue;
+    if ( sscanf( line.c_str(), "AnonHugePages: %llu kB", &kb ) == 1 ||
+         sscanf( line.c_str(), "Private_Hugetlb: %llu kB", &kb ) == 1 ||
+         sscanf( line.c_str(), "Shared_Hugetlb: %llu kB", &kb ) == 1 )
+      huge += std::min( size_t(kb)*1024, overlap );
+  }
+
+  std::string thp = "unknown";
+  std::ifstream thp_file( "/sys/kernel/mm/transparent_hugepage/enabled" );
+  if ( thp_file ) std::getline( thp_file, thp );
+
+  const double MiB = 1024.0*1024.0;
+  printf( "huge pages (MY_HUGE_PAGES=%s, transparent: %s): %.1f of %.1f MiB in %d arrays, %.1f MiB reserved\n",
+          Mode().c_str(), thp.c_str(), huge/MiB, total/MiB, int(Regions().size()), hugetlb/MiB );
+}
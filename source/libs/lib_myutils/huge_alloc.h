@@ -0,0 +1,75 @@
+/* * ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+ * (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+ * founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+ * 50WM0942, 50WM1042, 50WM1342.
+ * Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+ *
+ * This file is part of ATUS2.
+ *
+ * ATUS2 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ATUS2 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <new>
+#include "fftw3.h"
+
+#pragma once
+
+/**
+* \brief Allocation of large arrays on huge pages
+*
+* Arrays of at least one huge page (2 MiB) are mapped separately, aligned to 2 MiB and marked for transparent
+* huge pages (madvise MADV_HUGEPAGE). MY_HUGE_PAGES=explicit first tries reserved huge pages (MAP_HUGETLB),
+* MY_HUGE_PAGES=off uses fftw_malloc for all arrays. Smaller arrays and failed mappings also fall back to
+* fftw_malloc, so every array is at least as aligned as FFTW requires. Memory of Huge_Alloc must be released
+* with Huge_Free.
+*
+* @param bytes Size in bytes
+*/
+void * Huge_Alloc( const size_t bytes );
+fftw_complex * Huge_Alloc_Complex( const int64_t n );
+double * Huge_Alloc_Real( const int64_t n );
+void Huge_Free( void *p );
+
+/**
+* \brief Prints how much of the memory of Huge_Alloc is backed by huge pages, if MY_HUGE_PAGES_INFO=1
+*
+* Pages are only assigned when they are touched, call it after the arrays were initialized.
+*/
+void Huge_Pages_Report();
+
+/// std::vector allocator on Huge_Alloc
+template <class T> class huge_allocator
+{
+public:
+  typedef T value_type;
+
+  huge_allocator() = default;
+  template <class U> huge_allocator( const huge_allocator<U> & ) {}
+
+  T * allocate( const size_t n )
+  {
+    T *retval = static_cast<T *>( Huge_Alloc( n*sizeof(T) ) );
+    if ( retval == nullptr && n > 0 ) throw std::bad_alloc();
+    return retval;
+  }
+  void deallocate( T *p, const size_t ) { Huge_Free( p ); }
+
+  template <class U> bool operator==( const huge_allocator<U> & ) const { return true; }
+  template <class U> bool operator!=( const huge_allocator<U> & ) const { return false; }
+};
+
+template <class T> using huge_vector = std::vector<T,huge_allocator<T>>;
@@ -0,0 +1,321 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include "resample.h"
+
+namespace Fourier
+{
+  void Pad_Domain( const int rank, const int64_t *n_old, const int64_t *n_new, const fftw_complex *in, fftw_complex *out )
+  {
+    if ( rank < 1 || rank > 3 ) throw std::string( "Error in Pad_Domain: rank must be 1, 2 or 3.\n" );
+
+    // leading dimensions of size 1 for rank < 3
+    int64_t a[] = {1,1,1}, b[] = {1,1,1};
+    for ( int i=0; i<rank; i++ )
+    {
+      a[3-rank+i] = n_old[i];
+      b[3-rank+i] = n_new[i];
+    }
+
+    int64_t c[3], od[3], os[3];
+    bool grow = true, shrink = true;
+    for ( int i=0; i<3; i++ )
+    {
+      c[i] = std::min( a[i], b[i] );
+      od[i] = std::max( int64_t(0), (b[i]-a[i])/2 );
+      os[i] = std::max( int64_t(0), (a[i]-b[i])/2 );
+      if ( b[i] < a[i] ) grow = false;
+      if ( b[i] > a[i] ) shrink = false;
+    }
+
+    // one row of out along the last dimension
+    auto row = [&]( const int64_t i, const int64_t j )
+    {
+      fftw_complex *y = out + (i*b[1]+j)*b[2];
+      const int64_t si = i-od[0], sj = j-od[1];
+      if ( si < 0 || si >= c[0] || sj < 0 || sj >= c[1] )
+      {
+        memset( y, 0, b[2]*sizeof(fftw_complex) );
+        return;
+      }
+      const fftw_complex *x = in + ((si+os[0])*a[1]+sj+os[1])*a[2]+os[2];
+      memmove( y+od[2], x, c[2]*sizeof(fftw_complex) );
+      memset( y, 0, od[2]*sizeof(fftw_complex) );
+      memset( y+od[2]+c[2], 0, (b[2]-od[2]-c[2])*sizeof(fftw_complex) );
+    };
+
+    if ( in != out )
+    {
+      #pragma omp parallel for collapse(2)
+      for ( int64_t i=0; i<b[0]; i++ )
+        for ( int64_t j=0; j<b[1]; j++ )
+          row( i, j );
+    }
+    else if ( grow ) // every entry moves up, start at the end
+    {
+      for ( int64_t l=b[0]*b[1]-1; l>=0; l-- )
+        row( l/b[1], l%b[1] );
+    }
+    else if ( shrink )
+    {
+      for ( int64_t l=0; l<b[0]*b[1]; l++ )
+        row( l/b[1], l%b[1] );
+    }
+    else
+      throw std::string( "Error in Pad_Domain: in place padding requires a grid growing or shrinking in all dimensions.\n" );
+  }
+
+  /**
+  * \brief Constructor
+  *
+  * @param rank Number of dimensions (1 to 3)
+  * @param n_old Grid size of the input per dimension
+  * @param n_new Grid size of the output per dimension
+  * @param breal Whether Execute is called with real data
+  */
+  resample::resample( const int rank, const int64_t *n_old, const int64_t *n_new, const bool breal ) : m_breal(breal)
+  {
+    Setup( rank, n_old, n_new );
+  }
+
+  /**
+  * \brief Constructor for the rational factor p/q in every dimension
+  *
+  * The grid sizes have to be divisible by q.
+  */
+  resample::resample( const int rank, const int64_t *n_old, const int p, const int q, const bool breal ) : m_breal(breal)
+  {
+    if ( rank < 1 || rank > 3 ) throw std::string( "Error in resample::resample: rank must be 1, 2 or 3.\n" );
+
+    int64_t n_new[3];
+    for ( int i=0; i<rank; i++ )
+      n_new[i] = Scaled_Dim( n_old[i], p, q );
+    Setup( rank, n_old, n_new );
+  }
+
+  resample::~resample()
+  {
+    for ( auto &s : m_steps )
+    {
+      fftw_destroy_plan( s.forward );
+      fftw_destroy_plan( s.backward );
+    }
+    fftw_free( m_tmp );
+    fftw_free( m_tmp2 );
+  }
+
+  /// n*p/q, throws if this is not an integer
+  int64_t resample::Scaled_Dim( const int64_t n, const int p, const int q )
+  {
+    if ( p < 1 || q < 1 || (n*p) % q != 0 )
+      throw std::string( "Error in resample::Scaled_Dim: " + std::to_string(n) + "*" + std::to_string(p) + "/" + std::to_string(q) + " is not an integer.\n" );
+    return n*p/q;
+  }
+
+  void resample::Setup( const int rank, const int64_t *n_old, const int64_t *n_new )
+  {
+    if ( rank < 1 || rank > 3 ) throw std::string( "Error in resample::Setup: rank must be 1, 2 or 3.\n" );
+
+    int64_t cur[] = {1,1,1};
+    int64_t size_old = 1, size_new = 1;
+    std::vector<int> order;
+    for ( int i=0; i<3; i++ )
+    {
+      m_n_new[i] = 1;
+      if ( i >= rank ) continue;
+      if ( n_old[i] < 1 || n_new[i] < 1 ) throw std::string( "Error in resample::Setup: invalid grid size.\n" );
+      cur[i] = n_old[i];
+      m_n_new[i] = n_new[i];
+      size_old *= n_old[i];
+      size_new *= n_new[i];
+      if ( n_old[i] != n_new[i] ) order.push_back(i);
+    }
+    m_capacity = std::max( size_old, size_new );
+
+    // smallest factor first
+    std::stable_sort( order.begin(), order.end(), [&]( const int a, const int b )
+    {
+      return n_new[a]*n_old[b] < n_new[b]*n_old[a];
+    } );
+
+    int64_t spec = 1;
+    m_steps.resize( order.size() );
+    for ( size_t l=0; l<order.size(); l++ )
+    {
+      const int d = order[l];
+      step &s = m_steps[l];
+      s.outer = 1;
+      s.inner = 1;
+      for ( int i=0; i<d; i++ ) s.outer *= cur[i];
+      for ( int i=d+1; i<rank; i++ ) s.inner *= cur[i];
+      s.n = n_old[d];
+      s.m = n_new[d];
+      s.len_in  = m_breal ? s.n/2+1 : s.n;
+      s.len_out = m_breal ? s.m/2+1 : s.m;
+      cur[d] = s.m;
+
+      // frequencies -(h-1)/2 ... (h-1)/2 are common to both grids
+      const int64_t n = s.n, m = s.m, h = std::min( n, m );
+      s.src.assign( s.len_out, -1 );
+      s.src2.assign( s.len_out, -1 );
+      s.w.assign( s.len_out, 1.0/double(n) );
+      for ( int64_t f=0; f<=(h-1)/2; f++ )
+      {
+        s.src[f] = f;
+        if ( !m_breal && f > 0 ) s.src[m-f] = n-f;
+      }
+      if ( h % 2 == 0 )
+      {
+        if ( m > n ) // split the old Nyquist frequency
+        {
+          s.src[n/2] = n/2;
+          s.w[n/2] = 0.5/double(n);
+          if ( !m_breal )
+          {
+            s.src[m-n/2] = n/2;
+            s.w[m-n/2] = 0.5/double(n);
+          }
+        }
+        else // both old frequencies +-m/2 alias to the new Nyquist frequency
+        {
+          s.src[m/2] = m/2;
+          s.src2[m/2] = m_breal ? m/2 : n-m/2;
+        }
+      }
+      spec = std::max( spec, s.outer*std::max( s.len_in, s.len_out )*s.inner );
+    }
+
+    m_tmp = fftw_alloc_complex( m_breal ? spec : m_capacity );
+    m_tmp2 = m_breal ? fftw_alloc_complex( spec ) : nullptr;
+
+    const unsigned flags = FFTW_ESTIMATE | FFTW_UNALIGNED;
+    for ( auto &s : m_steps )
+    {
+      fftw_iodim64 dim_in = { s.n, s.inner, s.inner };
+      fftw_iodim64 dim_out = { s.m, s.inner, s.inner };
+      fftw_iodim64 many_in[] = { { s.outer, s.n*s.inner, s.len_in*s.inner }, { s.inner, 1, 1 } };
+      fftw_iodim64 many_out[] = { { s.outer, s.len_out*s.inner, s.m*s.inner }, { s.inner, 1, 1 } };
+
+      if ( m_breal )
+      {
+        s.forward = fftw_plan_guru64_dft_r2c( 1, &dim_in, 2, many_in, reinterpret_cast<double *>(m_tmp2), m_tmp, flags );
+        s.backward = fftw_plan_guru64_dft_c2r( 1, &dim_out, 2, many_out, m_tmp2, reinterpret_cast<double *>(m_tmp), flags );
+      }
+      else
+      {
+        many_in[0].os = many_in[0].is;
+        many_out[0].is = many_out[0].os;
+        s.forward = fftw_plan_guru64_dft( 1, &dim_in, 2, many_in, m_tmp, m_tmp, FFTW_FORWARD, flags );
+        s.backward = fftw_plan_guru64_dft( 1, &dim_out, 2, many_out, m_tmp, m_tmp, FFTW_BACKWARD, flags );
+      }
+      if ( s.forward == nullptr || s.backward == nullptr ) throw std::string( "Error in resample::Setup: FFTW planning failed.\n" );
+    }
+  }
+
+  /// new frequencies of one step from the old ones, including the normalisation
+  void resample::Copy_Spectrum( const step &s, const fftw_complex *in, fftw_complex *out ) const
+  {
+    const int64_t inner = s.inner;
+
+    #pragma omp parallel for collapse(2)
+    for ( int64_t o=0; o<s.outer; o++ )
+    {
+      for ( int64_t k=0; k<s.len_out; k++ )
+      {
+        fftw_complex *y = out + (o*s.len_out+k)*inner;
+        if ( s.src[k] < 0 )
+        {
+          memset( y, 0, inner*sizeof(fftw_complex) );
+          continue;
+        }
+        const double w = s.w[k];
+        const fftw_complex *x = in + (o*s.len_in+s.src[k])*inner;
+        if ( s.src2[k] < 0 )
+        {
+          for ( int64_t i=0; i<inner; i++ )
+          {
+            y[i][0] = w*x[i][0];
+            y[i][1] = w*x[i][1];
+          }
+        }
+        else
+        {
+          // the partner of a real transform is the complex conjugate
+          const double sg = m_breal ? -1 : 1;
+          const fftw_complex *x2 = in + (o*s.len_in+s.src2[k])*inner;
+          for ( int64_t i=0; i<inner; i++ )
+          {
+            y[i][0] = w*(x[i][0]+x2[i][0]);
+            y[i][1] = w*(x[i][1]+sg*x2[i][1]);
+          }
+        }
+      }
+    }
+  }
+
+  /**
+  * \brief Resamples complex data
+  *
+  * The steps alternate between data and the scratch array m_tmp of Get_Capacity() entries, the result is
+  * copied back to data after an odd number of steps.
+  *
+  * @param data Array with Get_Capacity() entries, the first prod(n_old) entries are the input
+  */
+  void resample::Execute( fftw_complex *data )
+  {
+    if ( m_breal ) throw std::string( "Error in resample::Execute: object was created for real data.\n" );
+
+    fftw_complex *cur = data, *other = m_tmp;
+    for ( const auto &s : m_steps )
+    {
+      fftw_execute_dft( s.forward, cur, cur );
+      Copy_Spectrum( s, cur, other );
+      fftw_execute_dft( s.backward, other, other );
+      std::swap( cur, other );
+    }
+    if ( cur != data ) memcpy( data, cur, m_n_new[0]*m_n_new[1]*m_n_new[2]*sizeof(fftw_complex) );
+  }
+
+  /**
+  * \brief Resamples real data
+  *
+  * Every step transforms from data to m_tmp and back, m_tmp and m_tmp2 hold the spectra of one step.
+  *
+  * @param data Array with Get_Capacity() entries, the first prod(n_old) entries are the input
+  */
+  void resample::Execute( double *data )
+  {
+    if ( !m_breal ) throw std::string( "Error in resample::Execute: object was created for complex data.\n" );
+
+    for ( const auto &s : m_steps )
+    {
+      fftw_execute_dft_r2c( s.forward, data, m_tmp );
+      Copy_Spectrum( s, m_tmp, m_tmp2 );
+      fftw_execute_dft_c2r( s.backward, m_tmp2, data );
+    }
+  }
+}
@@ -0,0 +1,98 @@
+/* * ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+ * (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+ * founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+ * 50WM0942, 50WM1042, 50WM1342.
+ * Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+ *
+ * This file is part of ATUS2.
+ *
+ * ATUS2 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ATUS2 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <cstdint>
+#include "fftw3.h"
+
+#pragma once
+
+namespace Fourier
+{
+  /**
+  * \brief Centered zero padding or cropping of a row major grid
+  *
+  * The overlap of both grids is copied row by row, only the margins of out are zeroed. The offset per
+  * dimension is (n_new-n_old)/2 like in inflate_domain. in and out may be equal if the grid grows or
+  * shrinks in all dimensions, out must then hold max(prod(n_old),prod(n_new)) entries.
+  *
+  * @param rank Number of dimensions (1 to 3)
+  * @param n_old Grid size of in per dimension
+  * @param n_new Grid size of out per dimension
+  * @param in Input array
+  * @param out Output array
+  */
+  void Pad_Domain( const int rank, const int64_t *n_old, const int64_t *n_new, const fftw_complex *in, fftw_complex *out );
+
+  /**
+  * \brief Spectral up- and down-sampling of periodic data on the same domain
+  *
+  * The grid is changed one dimension at a time by a forward transform of length n_old, a copy of the common
+  * frequencies and a backward transform of length n_new along this dimension only. Lines in other dimensions
+  * are never transformed, in particular the zeros of the padded spectrum. Dimensions with equal size are skipped
+  * and shrinking dimensions are processed first, so the intermediate grids never exceed the larger one of both grids.
+  * A Nyquist frequency of the smaller grid is split symmetrically (upsampling) or folded (downsampling), real data
+  * stays real. The result replaces the input in the data array, which has to provide Get_Capacity() entries.
+  * Complex data needs a scratch array of another Get_Capacity() entries, the peak memory is twice the capacity.
+  * Real data needs two spectra of one step, about the capacity in complex entries.
+  */
+  class resample
+  {
+  public:
+    resample( const int rank, const int64_t *n_old, const int64_t *n_new, const bool breal=false );
+    resample( const int rank, const int64_t *n_old, const int p, const int q, const bool breal=false );
+    ~resample();
+
+    void Execute( fftw_complex *data );
+    void Execute( double *data );
+
+    /// number of entries the data array of Execute needs
+    int64_t Get_Capacity() const { return m_capacity; }
+    int64_t Get_Dim( const int i ) const { return m_n_new[i]; }
+
+    static int64_t Scaled_Dim( const int64_t n, const int p, const int q );
+
+  protected:
+    /// resampling of one dimension
+    struct step
+    {
+      int64_t outer; // number of lines before the dimension
+      int64_t inner; // stride of the dimension
+      int64_t n, m;  // old and new length
+      int64_t len_in, len_out;  // number of frequencies stored, n/2+1 and m/2+1 for real data
+      std::vector<int64_t> src, src2; // source frequencies of every new frequency, -1 for none
+      std::vector<double> w;
+      fftw_plan forward;
+      fftw_plan backward;
+    };
+
+    void Setup( const int rank, const int64_t *n_old, const int64_t *n_new );
+    void Copy_Spectrum( const step &, const fftw_complex *in, fftw_complex *out ) const;
+
+    bool m_breal;
+    int64_t m_capacity;
+    int64_t m_n_new[3];
+    std::vector<step> m_steps;
+    fftw_complex *m_tmp;
+    fftw_complex *m_tmp2;
+  };
+}
@@ -0,0 +1,221 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/** Checks of resample and Pad_Domain
+ *
+ * Periodic data that is band limited to the smaller grid is resampled and compared with the same function sampled
+ * on the new grid, for real and complex data, up- and down-sampling, even and odd grid sizes. A cosine at the
+ * Nyquist frequency of an even smaller grid is included, it has to be split (upsampling) or folded (downsampling)
+ * exactly. In place Pad_Domain is compared with the out of place result. Returns EXIT_FAILURE on a deviation.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "fftw3.h"
+#include "resample.h"
+
+using namespace Fourier;
+
+const double tol = 1e-12;
+
+/**
+ * \brief Band limited periodic function of one coordinate x in [0,1)
+ *
+ * Frequencies below h/2 with coefficients depending on seed, plus cos(pi*h*x) if h is even.
+ */
+double g( const double x, const int64_t h, const int seed )
+{
+  double retval = 1.0 + 0.1*seed;
+  for ( int64_t k=1; k<=(h-1)/2; k++ )
+    retval += cos(0.7*k+seed)/k * cos(2*M_PI*k*x) + sin(1.3*k-seed)/k * sin(2*M_PI*k*x);
+  if ( h % 2 == 0 ) retval += 0.75 * cos(M_PI*h*x);
+  return retval;
+}
+
+/**
+ * \brief Samples of the product of g over all dimensions on the grid n
+ *
+ * @param h Band limit per dimension, the smaller grid size
+ */
+std::vector<double> sample( const int rank, const int64_t *n, const int64_t *h, const int seed )
+{
+  int64_t m[] = {1,1,1}, hh[] = {1,1,1};
+  for ( int i=0; i<rank; i++ )
+  {
+    m[i] = n[i];
+    hh[i] = h[i];
+  }
+
+  std::vector<double> retval( m[0]*m[1]*m[2] );
+  for ( int64_t i=0; i<m[0]; i++ )
+    for ( int64_t j=0; j<m[1]; j++ )
+      for ( int64_t k=0; k<m[2]; k++ )
+      {
+        double f = g( double(i)/m[0], hh[0], seed );
+        if ( rank > 1 ) f *= g( double(j)/m[1], hh[1], seed+1 );
+        if ( rank > 2 ) f *= g( double(k)/m[2], hh[2], seed+2 );
+        retval[k+m[2]*(j+m[1]*i)] = f;
+      }
+  return retval;
+}
+
+double max_dev( const double *a, const double *b, const int64_t n )
+{
+  double dev = 0, norm = 0;
+  for ( int64_t l=0; l<n; l++ )
+  {
+    dev = std::max( dev, fabs(a[l]-b[l]) );
+    norm = std::max( norm, fabs(b[l]) );
+  }
+  return dev / norm;
+}
+
+bool report( const char *what, const int rank, const int64_t *n_old, const int64_t *n_new, const double dev )
+{
+  char grid[64] = "", *p = grid;
+  for ( int i=0; i<rank; i++ ) p += sprintf( p, (i == 0) ? "%lld" : "x%lld", (long long) n_old[i] );
+  p += sprintf( p, " -> " );
+  for ( int i=0; i<rank; i++ ) p += sprintf( p, (i == 0) ? "%lld" : "x%lld", (long long) n_new[i] );
+  printf( "%-12s %-24s: %.3e %s\n", what, grid, dev, (dev < tol) ? "" : "FAILED" );
+  return dev < tol;
+}
+
+/**
+ * \brief Resampling of real and complex data from n_old to n_new
+ */
+bool check_resample( const int rank, const int64_t *n_old, const int64_t *n_new )
+{
+  int64_t h[3];
+  for ( int i=0; i<rank; i++ ) h[i] = std::min( n_old[i], n_new[i] );
+
+  const std::vector<double> re_old = sample( rank, n_old, h, 0 ), im_old = sample( rank, n_old, h, 3 );
+  const std::vector<double> re_new = sample( rank, n_new, h, 0 ), im_new = sample( rank, n_new, h, 3 );
+  const int64_t N_old = re_old.size(), N_new = re_new.size();
+
+  // real data
+  resample rs_real( rank, n_old, n_new, true );
+  std::vector<double> data( rs_real.Get_Capacity() );
+  std::copy( re_old.begin(), re_old.end(), data.begin() );
+  rs_real.Execute( data.data() );
+  bool ok = report( "real", rank, n_old, n_new, max_dev( data.data(), re_new.data(), N_new ) );
+
+  // complex data
+  resample rs_cplx( rank, n_old, n_new );
+  fftw_complex *cdata = fftw_alloc_complex( rs_cplx.Get_Capacity() );
+  for ( int64_t l=0; l<N_old; l++ )
+  {
+    cdata[l][0] = re_old[l];
+    cdata[l][1] = im_old[l];
+  }
+  rs_cplx.Execute( cdata );
+
+  std::vector<double> re( N_new ), im( N_new );
+  for ( int64_t l=0; l<N_new; l++ )
+  {
+    re[l] = cdata[l][0];
+    im[l] = cdata[l][1];
+  }
+  fftw_free( cdata );
+  ok = report( "complex", rank, n_old, n_new, std::max( max_dev( re.data(), re_new.data(), N_new ), max_dev( im.data(), im_new.data(), N_new ) ) ) && ok;
+  return ok;
+}
+
+/**
+ * \brief In place Pad_Domain against the out of place result
+ */
+bool check_pad( const int rank, const int64_t *n_old, const int64_t *n_new )
+{
+  int64_t N_old = 1, N_new = 1;
+  for ( int i=0; i<rank; i++ )
+  {
+    N_old *= n_old[i];
+    N_new *= n_new[i];
+  }
+
+  std::vector<double> in( 2*N_old ), out( 2*N_new ), inplace( 2*std::max( N_old, N_new ) );
+  for ( int64_t l=0; l<2*N_old; l++ )
+    in[l] = inplace[l] = 1.0 + sin(0.37*l);
+
+  Pad_Domain( rank, n_old, n_new, reinterpret_cast<fftw_complex *>(in.data()), reinterpret_cast<fftw_complex *>(out.data()) );
+  Pad_Domain( rank, n_old, n_new, reinterpret_cast<fftw_complex *>(inplace.data()), reinterpret_cast<fftw_complex *>(inplace.data()) );
+  return report( "Pad_Domain", rank, n_old, n_new, max_dev( inplace.data(), out.data(), 2*N_new ) );
+}
+
+int main()
+{
+  // even and odd sizes, the Nyquist cosine is present whenever the smaller size of a dimension is even
+  const int64_t grids[][2][3] = {
+    { {16}, {24} },             // up, even -> even, split Nyquist
+    { {15}, {20} },             // up, odd -> even
+    { {16}, {25} },             // up, even -> odd, split Nyquist
+    { {24}, {16} },             // down, even -> even, folded Nyquist
+    { {20}, {15} },             // down, even -> odd
+    { {25}, {16} },             // down, odd -> even, folded Nyquist
+    { {16,15}, {24,10} },       // up and down
+    { {9,12}, {12,9} },
+    { {16,15,12}, {24,20,8} },
+    { {12,10,14}, {8,15,21} },
+  };
+  const int ranks[] = { 1, 1, 1, 1, 1, 1, 2, 2, 3, 3 };
+
+  bool ok = true;
+  try
+  {
+    for ( int s=0; s<10; s++ )
+      ok = check_resample( ranks[s], grids[s][0], grids[s][1] ) && ok;
+
+    // rational factor constructor, 3/2 in all dimensions
+    const int64_t n_old[] = {8,12}, n_new[] = {12,18};
+    resample rs( 2, n_old, 3, 2 );
+    if ( rs.Get_Dim(0) != n_new[0] || rs.Get_Dim(1) != n_new[1] )
+    {
+      printf( "resample( rank, n_old, p, q ) has the wrong grid size\n" );
+      ok = false;
+    }
+    ok = check_resample( 2, n_old, n_new ) && ok;
+
+    // in place padding and cropping, growing or shrinking in all dimensions
+    const int64_t pads[][2][3] = {
+      { {10}, {17} }, { {17}, {10} }, { {6,7}, {11,12} }, { {11,12}, {6,7} },
+      { {5,6,7}, {8,9,10} }, { {8,9,10}, {5,6,7} }, { {5,6,7}, {5,9,7} },
+    };
+    const int pad_ranks[] = { 1, 1, 2, 2, 3, 3, 3 };
+    for ( int s=0; s<7; s++ )
+      ok = check_pad( pad_ranks[s], pads[s][0], pads[s][1] ) && ok;
+  }
+  catch ( const std::string &str )
+  {
+    printf( "%s", str.c_str() );
+    return EXIT_FAILURE;
+  }
+
+  fftw_cleanup();
+  printf( ok ? "all resample checks passed\n" : "resample checks failed\n" );
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
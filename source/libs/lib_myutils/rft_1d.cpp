@@ -34,8 +34,9 @@ namespace Fourier
    */
   rft_1d::rft_1d( const generic_header &header, bool b, bool f, Fourier::TYPE t ) : cft_base( header, b, f, t )
   {
-    m_forwardPlan  = fftw_plan_dft_r2c_1d( m_dim, m_in_real, m_out, FFTW_ESTIMATE );
-    m_backwardPlan = fftw_plan_dft_c2r_1d( m_dim, m_out, m_in_real, FFTW_ESTIMATE );
+    const int n[] = {m_dim_x};
+    m_forwardPlan  = m_backend->Shared_r2c( 1, n, m_in_real, m_out );
+    m_backwardPlan = m_backend->Shared_c2r( 1, n, m_out, m_in_real );
   }
 
   /**
@@ -58,7 +59,7 @@ namespace Fourier
     if ( isign == -1 )
     {
       faktor = m_dx / sqrt(2.0*M_PI);
-      fftw_execute( m_forwardPlan );
+      m_forwardPlan->Execute( m_in_real, m_out );
 
       for ( i=1; i<m_red_dim; i +=2 )
       {
@@ -86,14 +87,15 @@ namespace Fourier
         m_out[i][1] *= -1;
       };
 
-      fftw_execute( m_backwardPlan );
+      m_backwardPlan->Execute( m_out, m_in_real );
     }
   }
 
   CPoint<1> rft_1d::Get_k(const int64_t l)
   {
     CPoint<1> retval;
-    retval[0] = m_dkx*double(l%(m_red_dim-1));
+    // the Nyquist mode of an even grid is dropped, an odd grid has none
+    retval[0] = m_dkx*double( (m_dim_x % 2 == 0 && l == m_red_dim-1) ? 0 : l );
     return retval;
   }
 
@@ -20,6 +20,9 @@
  * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifndef RFT_1D_H
+#define RFT_1D_H
+
 #include "cft_base.h"
 
 namespace Fourier
@@ -38,3 +41,4 @@ namespace Fourier
     CPoint<1> Get_x(const int64_t) final;
   };
 }
+#endif
@@ -24,6 +24,8 @@
 #include <iostream>
 #include <cstdio>
 #include <cmath>
+#include <vector>
+#include <algorithm>
 #include "CPoint.h"
 #include "rft_1d.h"
 
@@ -49,6 +51,60 @@ void fkt1( Fourier::rft_1d &rft )
   }
 }
 
+/**
+ * \brief Compares Derivatives with the Diff_* members on real data
+ *
+ * The Nyquist mode of the halved last axis is dropped by both.
+ *
+ * @return Largest deviation relative to the largest value of each derivative
+ */
+double check_derivatives( const int nx )
+{
+  generic_header header = {};
+  header.nDims = 1;
+  header.nDimX = nx;
+  header.nDimY = 1;
+  header.nDimZ = 1;
+  header.xMin = -10.0;
+  header.xMax = 10.0;
+  header.dx = 20.0/nx;
+  header.dkx = 2*M_PI/20.0;
+
+  Fourier::rft_1d rft( header );
+  const int64_t N = rft.Get_Dim_RS();
+  double *data = rft.Getp2InReal();
+
+  for ( int64_t l=0; l<N; l++ )
+    data[l] = sin(0.37*l) + cos(0.011*l*l);
+  const std::vector<double> src( data, data+N );
+
+  const std::vector<Fourier::DERIV> which = { Fourier::DX, Fourier::DXX };
+  void (Fourier::rft_1d::*diff[])() = { &Fourier::rft_1d::Diff_x, &Fourier::rft_1d::Diff_xx };
+  std::vector<std::vector<double>> out( which.size(), std::vector<double>(N) );
+  std::vector<double *> p2out;
+  for ( auto &o : out ) p2out.push_back( o.data() );
+
+  rft.Derivatives( which, p2out.data() );
+
+  double err = 0;
+  for ( size_t d=0; d<which.size(); d++ )
+  {
+    std::copy( src.begin(), src.end(), data );
+    (rft.*diff[d])();
+
+    double dev = 0, norm = 0;
+    for ( int64_t l=0; l<N; l++ )
+    {
+      dev = std::max( dev, fabs(data[l]-out[d][l]) );
+      norm = std::max( norm, fabs(data[l]) );
+    }
+    err = std::max( err, dev/norm );
+  }
+
+  printf( "Derivatives vs Diff_* %3d: max deviation %g\n", nx, err );
+  return err;
+}
+
 int main(int argc, char *argv[])
 {
   generic_header header = {};
@@ -66,6 +122,17 @@ int main(int argc, char *argv[])
   printf( "dx  = %g\n", header.dx );
   printf( "dkx = %g\n", header.dkx );
 
+  // even and odd grids, odd sizes along the halved axis
+  const int dv_sizes[][1] = { {64}, {63} };
+  bool bdv = true;
+  for ( auto n : dv_sizes )
+    bdv = (check_derivatives( n[0] ) < 1e-12) && bdv;
+  if ( !bdv )
+  {
+    printf( "Derivatives differs from the Diff_* members\n" );
+    return EXIT_FAILURE;
+  }
+
   Fourier::rft_1d rft( header );
 
   fkt1( rft );
@@ -40,8 +40,9 @@ namespace Fourier
    */
   rft_2d::rft_2d( const generic_header &header, bool b, bool f, Fourier::TYPE t ) : cft_base( header, b, f, t )
   {
-    m_forwardPlan  = fftw_plan_dft_r2c_2d( m_dim_x, m_dim_y, m_in_real, m_out, FFTW_ESTIMATE );
-    m_backwardPlan = fftw_plan_dft_c2r_2d( m_dim_x, m_dim_y, m_out, m_in_real, FFTW_ESTIMATE );
+    const int n[] = {m_dim_x, m_dim_y};
+    m_forwardPlan  = m_backend->Shared_r2c( 2, n, m_in_real, m_out );
+    m_backwardPlan = m_backend->Shared_c2r( 2, n, m_out, m_in_real );
   }
 
   /**
@@ -61,12 +62,12 @@ namespace Fourier
 
     if ( isign == -1 )
     {
-      fftw_execute( m_forwardPlan );
+      m_forwardPlan->Execute( m_in_real, m_out );
       scale( m_dx*m_dy/(2*M_PI) );
     }
     else
     {
-      fftw_execute( m_backwardPlan );
+      m_backwardPlan->Execute( m_out, m_in_real );
       scale( m_dkx*m_dky/(2*M_PI) );
     }
   }
@@ -77,7 +78,8 @@ namespace Fourier
     int64_t i = l / m_red_dim;
     int64_t j = l - i*m_red_dim;
     retval[0] = m_dkx*double((i+m_shift_x)%m_dim_x-m_shift_x);
-    retval[1] = m_dky*double(j%(m_red_dim-1));
+    // the Nyquist mode of an even grid is dropped, an odd grid has none
+    retval[1] = m_dky*double( (m_dim_y % 2 == 0 && j == m_red_dim-1) ? 0 : j );
     return retval;
   }
 
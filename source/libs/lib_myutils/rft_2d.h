@@ -20,6 +20,9 @@
  * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifndef RFT_2D_H
+#define RFT_2D_H
+
 #include "cft_base.h"
 
 namespace Fourier
@@ -44,3 +47,4 @@ namespace Fourier
     void scale( const double );
   };
 }
+#endif
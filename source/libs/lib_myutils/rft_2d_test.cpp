@@ -24,6 +24,8 @@
 #include <iostream>
 #include <cstdio>
 #include <cmath>
+#include <vector>
+#include <algorithm>
 #include "CPoint.h"
 #include "rft_2d.h"
 
@@ -49,6 +51,64 @@ void fkt1( Fourier::rft_2d &rft )
   }
 }
 
+/**
+ * \brief Compares Derivatives with the Diff_* and Laplace members on real data
+ *
+ * The Nyquist mode of the halved last axis is dropped by both.
+ *
+ * @return Largest deviation relative to the largest value of each derivative
+ */
+double check_derivatives( const int nx, const int ny )
+{
+  generic_header header = {};
+  header.nDims = 2;
+  header.nDimX = nx;
+  header.nDimY = ny;
+  header.nDimZ = 1;
+  header.xMin = -10.0;
+  header.xMax = 10.0;
+  header.yMin = -8.0;
+  header.yMax = 8.0;
+  header.dx = 20.0/nx;
+  header.dkx = 2*M_PI/20.0;
+  header.dy = 16.0/ny;
+  header.dky = 2*M_PI/16.0;
+
+  Fourier::rft_2d rft( header );
+  const int64_t N = rft.Get_Dim_RS();
+  double *data = rft.Getp2InReal();
+
+  for ( int64_t l=0; l<N; l++ )
+    data[l] = sin(0.37*l) + cos(0.011*l*l);
+  const std::vector<double> src( data, data+N );
+
+  const std::vector<Fourier::DERIV> which = { Fourier::DX, Fourier::DY, Fourier::DXX, Fourier::DYY, Fourier::LAPLACE };
+  void (Fourier::rft_2d::*diff[])() = { &Fourier::rft_2d::Diff_x, &Fourier::rft_2d::Diff_y, &Fourier::rft_2d::Diff_xx, &Fourier::rft_2d::Diff_yy, &Fourier::rft_2d::Laplace };
+  std::vector<std::vector<double>> out( which.size(), std::vector<double>(N) );
+  std::vector<double *> p2out;
+  for ( auto &o : out ) p2out.push_back( o.data() );
+
+  rft.Derivatives( which, p2out.data() );
+
+  double err = 0;
+  for ( size_t d=0; d<which.size(); d++ )
+  {
+    std::copy( src.begin(), src.end(), data );
+    (rft.*diff[d])();
+
+    double dev = 0, norm = 0;
+    for ( int64_t l=0; l<N; l++ )
+    {
+      dev = std::max( dev, fabs(data[l]-out[d][l]) );
+      norm = std::max( norm, fabs(data[l]) );
+    }
+    err = std::max( err, dev/norm );
+  }
+
+  printf( "Derivatives vs Diff_* %3d x %3d: max deviation %g\n", nx, ny, err );
+  return err;
+}
+
 int main(int argc, char *argv[])
 {
   generic_header header = {};
@@ -73,6 +133,17 @@ int main(int argc, char *argv[])
   printf( "dkx = %g\n", header.dkx );
   printf( "dky = %g\n", header.dky );
 
+  // even and odd grids, odd sizes along the halved axis
+  const int dv_sizes[][2] = { {32,24}, {31,25}, {32,25} };
+  bool bdv = true;
+  for ( auto n : dv_sizes )
+    bdv = (check_derivatives( n[0], n[1] ) < 1e-12) && bdv;
+  if ( !bdv )
+  {
+    printf( "Derivatives differs from the Diff_* members\n" );
+    return EXIT_FAILURE;
+  }
+
   Fourier::rft_2d rft( header );
 
   fkt1( rft );
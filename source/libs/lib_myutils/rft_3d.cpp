@@ -38,8 +38,9 @@ namespace Fourier
    */
   rft_3d::rft_3d( const generic_header &header, bool b, bool f, Fourier::TYPE t ) : cft_base( header, b, f, t )
   {
-    m_forwardPlan  = fftw_plan_dft_r2c_3d( m_dim_x, m_dim_y, m_dim_z, m_in_real, m_out, FFTW_ESTIMATE );
-    m_backwardPlan = fftw_plan_dft_c2r_3d( m_dim_x, m_dim_y, m_dim_z, m_out, m_in_real, FFTW_ESTIMATE );
+    const int n[] = {m_dim_x, m_dim_y, m_dim_z};
+    m_forwardPlan  = m_backend->Shared_r2c( 3, n, m_in_real, m_out );
+    m_backwardPlan = m_backend->Shared_c2r( 3, n, m_out, m_in_real );
   }
 
   /**
@@ -59,12 +60,12 @@ namespace Fourier
 
     if ( isign == -1 )
     {
-      fftw_execute( m_forwardPlan );
+      m_forwardPlan->Execute( m_in_real, m_out );
       scale( m_dx*m_dy*m_dz/pow(2*M_PI,1.5) );
     }
     else
     {
-      fftw_execute( m_backwardPlan );
+      m_backwardPlan->Execute( m_out, m_in_real );
       scale( m_dkx*m_dky*m_dkz/pow(2*M_PI,1.5) );
     }
   }
@@ -77,7 +78,8 @@ namespace Fourier
     int64_t k = l - i*m_dim_y*m_red_dim - j*m_red_dim;
     retval[0] = m_dkx*double((i+m_shift_x)%m_dim_x-m_shift_x);
     retval[1] = m_dky*double((j+m_shift_y)%m_dim_y-m_shift_y);
-    retval[2] = m_dkz*double(k%(m_red_dim-1));
+    // the Nyquist mode of an even grid is dropped, an odd grid has none
+    retval[2] = m_dkz*double( (m_dim_z % 2 == 0 && k == m_red_dim-1) ? 0 : k );
     return retval;
   }
 
@@ -33,6 +33,7 @@ Aufrufe:
 
 #include "fftw3.h"
 #include "my_structs.h"
+#include "thread_setup.h"
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
@@ -109,9 +110,7 @@ int main( int argc, const char *argv[])
 
   FILE *fh = nullptr;
 
-  int no_of_threads = 4;
-  char *envstr = getenv( "MY_NO_OF_THREADS" );
-  if ( envstr != nullptr ) no_of_threads = atoi( envstr );
+  int no_of_threads = Get_No_Of_Threads();
   omp_set_num_threads( no_of_threads );
 
   generic_header header_3d = {};
@@ -0,0 +1,160 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <sched.h>
+#include <dirent.h>
+#include <omp.h>
+#include "thread_setup.h"
+
+namespace
+{
+  /// cores of the affinity mask of the process at the first call, before any pinning
+  const std::vector<int> & Allowed_Cpus()
+  {
+    static const std::vector<int> cpus = []()
+    {
+      std::vector<int> retval;
+      cpu_set_t set;
+      CPU_ZERO( &set );
+      if ( sched_getaffinity( 0, sizeof(set), &set ) == 0 )
+        for ( int c=0; c<CPU_SETSIZE; c++ )
+          if ( CPU_ISSET( c, &set ) ) retval.push_back(c);
+      return retval;
+    }();
+    return cpus;
+  }
+
+  /// NUMA node of a core from sysfs, 0 if the kernel does not report one
+  int Node_Of( const int cpu )
+  {
+    int retval = 0;
+    const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR *dir = opendir( path.c_str() );
+    if ( dir == nullptr ) return retval;
+    struct dirent *entry;
+    while ( (entry = readdir( dir )) != nullptr )
+    {
+      int node;
+      if ( sscanf( entry->d_name, "node%d", &node ) == 1 )
+      {
+        retval = node;
+        break;
+      }
+    }
+    closedir( dir );
+    return retval;
+  }
+
+  bool Env_Set( const char *name )
+  {
+    const char *envstr = getenv( name );
+    return envstr != nullptr && std::string(envstr) != "0" && std::string(envstr) != "";
+  }
+}
+
+int Get_No_Of_Threads()
+{
+  const char *envstr = getenv( "MY_NO_OF_THREADS" );
+  if ( envstr != nullptr && atoi( envstr ) > 0 ) return atoi( envstr );
+  return std::max( int(Allowed_Cpus().size()), 1 );
+}
+
+void Place_Threads()
+{
+  // opt-in, nothing to do by default
+  const bool info = Env_Set( "MY_THREAD_INFO" );
+  if ( !Env_Set( "MY_PIN_THREADS" ) && !info ) return;
+
+  const std::vector<int> &cpus = Allowed_Cpus();
+  const char *envstr = getenv( "MY_PIN_THREADS" );
+  const std::string mode = (envstr != nullptr && std::string(envstr) == "compact") ? "compact" : "spread";
+  const bool pin = Env_Set( "MY_PIN_THREADS" ) && !cpus.empty();
+
+  // core of thread t is order[t % order.size()]
+  std::map<int,std::vector<int>> by_node;
+  std::vector<int> order;
+  if ( pin )
+  {
+    for ( const int c : cpus ) by_node[Node_Of(c)].push_back(c);
+
+    if ( mode == "compact" )
+    {
+      for ( const auto &it : by_node ) order.insert( order.end(), it.second.begin(), it.second.end() );
+    }
+    else
+    {
+      for ( size_t i=0; order.size()<cpus.size(); i++ )
+        for ( const auto &it : by_node )
+          if ( i < it.second.size() ) order.push_back( it.second[i] );
+    }
+  }
+
+  const int nthreads = omp_get_max_threads();
+  std::vector<int> cpu_of( nthreads, -1 );
+
+  #pragma omp parallel num_threads(nthreads)
+  {
+    const int t = omp_get_thread_num();
+    if ( pin )
+    {
+      cpu_set_t set;
+      CPU_ZERO( &set );
+      CPU_SET( order[t % order.size()], &set );
+      sched_setaffinity( 0, sizeof(set), &set );
+    }
+    if ( info ) cpu_of[t] = sched_getcpu();
+  }
+
+  if ( !info ) return;
+
+  // the node map of the report, already there if the threads were pinned
+  if ( by_node.empty() )
+    for ( const int c : cpus ) by_node[Node_Of(c)].push_back(c);
+
+  printf( "%d threads on %d available cores in %d NUMA nodes, %s\n", nthreads, int(cpus.size()), int(by_node.size()), pin ? ("pinned " + mode).c_str() : "not pinned" );
+  for ( int t=0; t<nthreads; t++ )
+    printf( "  thread %d: core %d, node %d\n", t, cpu_of[t], (cpu_of[t] < 0) ? -1 : Node_Of( cpu_of[t] ) );
+}
+
+void First_Touch( double *p, const int64_t n )
+{
+  #pragma omp parallel for schedule(static) if ( n > 16384 )
+  for ( int64_t l=0; l<n; l++ )
+    p[l] = 0;
+}
+
+void First_Touch( fftw_complex *p, const int64_t n )
+{
+  #pragma omp parallel for schedule(static) if ( n > 16384 )
+  for ( int64_t l=0; l<n; l++ )
+  {
+    p[l][0] = 0;
+    p[l][1] = 0;
+  }
+}
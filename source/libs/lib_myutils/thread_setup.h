@@ -0,0 +1,56 @@
+/* * ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+ * (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+ * founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+ * 50WM0942, 50WM1042, 50WM1342.
+ * Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+ *
+ * This file is part of ATUS2.
+ *
+ * ATUS2 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ATUS2 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include "fftw3.h"
+
+#pragma once
+
+/**
+* \brief Number of OpenMP and FFTW threads
+*
+* MY_NO_OF_THREADS if set, otherwise the number of cores available to the process (its affinity mask,
+* so a rank started with mpirun --bind-to socket gets the cores of its socket).
+*/
+int Get_No_Of_Threads();
+
+/**
+* \brief Pins the OpenMP threads and reports their placement, call after omp_set_num_threads
+*
+* MY_PIN_THREADS=spread (or 1) binds thread t to one core, the threads are dealt round robin over the
+* NUMA nodes; MY_PIN_THREADS=compact fills one node after the other. FFTW runs its threads on the
+* OpenMP thread pool (fftw3_omp), so its transforms use the same cores. MY_THREAD_INFO=1 prints the
+* core and NUMA node of every thread.
+*/
+void Place_Threads();
+
+/**
+* \brief Zeroes an array with the static schedule of the grid kernels
+*
+* Each page is first touched by the thread that works on it in the "omp for schedule(static)" loops
+* over the linear index, which places it on the NUMA node of that thread.
+*
+* @param p Array
+* @param n Number of entries
+*/
+void First_Touch( double *p, const int64_t n );
+void First_Touch( fftw_complex *p, const int64_t n );
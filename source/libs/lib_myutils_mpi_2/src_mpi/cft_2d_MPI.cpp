@@ -53,6 +53,8 @@ namespace MPI
       m_offset_fs = m_loc_start_dimY*m_dimX;
       m_loc_n_rs = m_loc_dimX*m_dimY;
       m_loc_n_fs = m_loc_dimY*m_dimX;
+      Set_Slab_Boxes();
+      Set_Axis_Tables();
     }
 
     /**
@@ -76,6 +78,7 @@ namespace MPI
         m_fs = true;
         fak = 0.5*m_dx*m_dy/M_PI;
 
+        #pragma omp parallel for
         for ( ptrdiff_t l=0; l<m_loc_n_fs; l++ )
         {
           m_data[l][0] *= fak;
@@ -89,6 +92,7 @@ namespace MPI
         m_fs = false;
         fak = 0.5*m_dkx*m_dky/M_PI;
 
+        #pragma omp parallel for
         for ( ptrdiff_t l=0; l<m_loc_n_rs; l++ )
         {
           m_data[l][0] *= fak;
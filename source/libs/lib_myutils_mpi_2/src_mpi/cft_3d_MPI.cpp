@@ -40,17 +40,89 @@ namespace MPI
      */
     cft_3d_MPI::cft_3d_MPI( generic_header *header ) : cft_base_MPI<3>(header)
     {
-      ptrdiff_t alloc_local = fftw_mpi_local_size_3d_transposed( m_dimX, m_dimY, m_dimZ, MPI_COMM_WORLD, &m_loc_dimX, &m_loc_start_dimX, &m_loc_dimY, &m_loc_start_dimY );
+      int p1, p2;
+      if ( pencil_fft_3d::Get_Grid( m_nprocs, p1, p2 ) )
+      {
+        m_pencil.reset( new pencil_fft_3d( m_dimX, m_dimY, m_dimZ, p1, p2, MPI_COMM_WORLD ) );
+        m_data = fftw_alloc_complex( m_pencil->Get_Alloc() );
+        m_pencil->Plan( m_data );
+
+        const pencil_fft_3d::box &rs = m_pencil->Get_rs_Box();
+        const pencil_fft_3d::box &fs = m_pencil->Get_fs_Box();
+        for ( int d=0; d<3; d++ )
+        {
+          m_rs_start[d] = rs.start[d];
+          m_rs_size[d] = rs.size[d];
+          m_fs_start[d] = fs.start[d];
+          m_fs_size[d] = fs.size[d];
+          m_fs_axes[d] = 2-d;
+        }
+        m_loc_dimX = rs.size[0];
+        m_loc_start_dimX = rs.start[0];
+        m_loc_dimY = fs.size[1];
+        m_loc_start_dimY = fs.start[1];
+        m_offset_rs = -1;
+        m_offset_fs = -1;
+        m_loc_n_rs = rs.Count();
+        m_loc_n_fs = fs.Count();
+      }
+      else
+      {
+        ptrdiff_t alloc_local = fftw_mpi_local_size_3d_transposed( m_dimX, m_dimY, m_dimZ, MPI_COMM_WORLD, &m_loc_dimX, &m_loc_start_dimX, &m_loc_dimY, &m_loc_start_dimY );
+
+        m_data = fftw_alloc_complex(alloc_local);
 
-      m_data = fftw_alloc_complex(alloc_local);
+        m_forwardPlan = fftw_mpi_plan_dft_3d( m_dimX, m_dimY, m_dimZ, m_data, m_data, MPI_COMM_WORLD, FFTW_FORWARD, FFTW_ESTIMATE|FFTW_MPI_TRANSPOSED_OUT);
+        m_backwardPlan = fftw_mpi_plan_dft_3d( m_dimX, m_dimY, m_dimZ, m_data, m_data, MPI_COMM_WORLD, FFTW_BACKWARD, FFTW_ESTIMATE|FFTW_MPI_TRANSPOSED_IN);
+
+        m_offset_rs = m_loc_start_dimX*m_dimY*m_dimZ;
+        m_offset_fs = m_loc_start_dimY*m_dimX*m_dimZ;
+        m_loc_n_rs = m_loc_dimX*m_dimY*m_dimZ;
+        m_loc_n_fs = m_loc_dimY*m_dimX*m_dimZ;
+        Set_Slab_Boxes();
+      }
 
-      m_forwardPlan = fftw_mpi_plan_dft_3d( m_dimX, m_dimY, m_dimZ, m_data, m_data, MPI_COMM_WORLD, FFTW_FORWARD, FFTW_ESTIMATE|FFTW_MPI_TRANSPOSED_OUT);
-      m_backwardPlan = fftw_mpi_plan_dft_3d( m_dimX, m_dimY, m_dimZ, m_data, m_data, MPI_COMM_WORLD, FFTW_BACKWARD, FFTW_ESTIMATE|FFTW_MPI_TRANSPOSED_IN);
+      Set_Axis_Tables();
+    }
+
+    /**
+     * \brief Local data size of the decomposition a cft_3d_MPI object would use
+     *
+     * @param nx Global number of sampling points in x direction
+     * @param ny Global number of sampling points in y direction
+     * @param nz Global number of sampling points in z direction
+     * @param loc_n_rs Local number of elements in real space
+     * @param loc_n_fs Local number of elements in fourier space
+     * @param loc_dimX Local number of sampling points in x direction
+     * @param loc_start_dimX Local Index Offset in x direction
+     * @param loc_dimY Local number of sampling points in ky direction
+     * @param loc_start_dimY Local Index Offset in ky direction
+     * @return Number of fftw_complex of the data array
+     */
+    ptrdiff_t cft_3d_MPI::Local_Size( const ptrdiff_t nx, const ptrdiff_t ny, const ptrdiff_t nz, ptrdiff_t &loc_n_rs, ptrdiff_t &loc_n_fs,
+                                      ptrdiff_t &loc_dimX, ptrdiff_t &loc_start_dimX, ptrdiff_t &loc_dimY, ptrdiff_t &loc_start_dimY )
+    {
+      int nprocs, rank, p1, p2;
+      MPI_Comm_size( MPI_COMM_WORLD, &nprocs );
+      MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+
+      if ( pencil_fft_3d::Get_Grid( nprocs, p1, p2 ) )
+      {
+        pencil_fft_3d::box rs, fs;
+        ptrdiff_t alloc_local = pencil_fft_3d::Local_Size( nx, ny, nz, p1, p2, rank, rs, fs );
+        loc_n_rs = rs.Count();
+        loc_n_fs = fs.Count();
+        loc_dimX = rs.size[0];
+        loc_start_dimX = rs.start[0];
+        loc_dimY = fs.size[1];
+        loc_start_dimY = fs.start[1];
+        return alloc_local;
+      }
 
-      m_offset_rs = m_loc_start_dimX*m_dimY*m_dimZ;
-      m_offset_fs = m_loc_start_dimY*m_dimX*m_dimZ;
-      m_loc_n_rs = m_loc_dimX*m_dimY*m_dimZ;
-      m_loc_n_fs = m_loc_dimY*m_dimX*m_dimZ;
+      ptrdiff_t alloc_local = fftw_mpi_local_size_3d_transposed( nx, ny, nz, MPI_COMM_WORLD, &loc_dimX, &loc_start_dimX, &loc_dimY, &loc_start_dimY );
+      loc_n_rs = loc_dimX*ny*nz;
+      loc_n_fs = loc_dimY*nx*nz;
+      return alloc_local;
     }
 
     /**
@@ -69,11 +141,15 @@ namespace MPI
 
       if ( isign == -1 )
       {
-        fftw_execute( m_forwardPlan );
+        if ( m_pencil )
+          m_pencil->Forward();
+        else
+          fftw_execute( m_forwardPlan );
 
         m_fs = true;
         fak = m_dx*m_dy*m_dz/pow( 2.0*M_PI, 1.5 );
 
+        #pragma omp parallel for
         for ( ptrdiff_t l=0; l<m_loc_n_fs; l++ )
         {
           m_data[l][0] *= fak;
@@ -82,11 +158,15 @@ namespace MPI
       }
       else
       {
-        fftw_execute( m_backwardPlan );
+        if ( m_pencil )
+          m_pencil->Backward();
+        else
+          fftw_execute( m_backwardPlan );
 
         m_fs = false;
         fak = m_dkx*m_dky*m_dkz/pow( 2.0*M_PI, 1.5 );
 
+        #pragma omp parallel for
         for ( ptrdiff_t l=0; l<m_loc_n_rs; l++ )
         {
           m_data[l][0] *= fak;
@@ -103,10 +183,8 @@ namespace MPI
     CPoint<3> cft_3d_MPI::Get_x( const ptrdiff_t loc )
     {
       CPoint<3> retval;
-      ptrdiff_t L = m_offset_rs+loc;
-      ptrdiff_t i = L / m_dimYZ;
-      ptrdiff_t j = L / m_dimZ - i*m_dimY;
-      ptrdiff_t k = L - i*m_dimYZ - j*m_dimZ;
+      ptrdiff_t i, j, k;
+      local_to_global_rs( loc, i, j, k );
 
       retval[0] = double(i-m_shift_x)*m_dx;
       retval[1] = double(j-m_shift_y)*m_dy;
@@ -122,19 +200,18 @@ namespace MPI
     CPoint<3> cft_3d_MPI::Get_k( const ptrdiff_t loc )
     {
       CPoint<3> retval;
-      ptrdiff_t L = m_offset_fs+loc;
-      ptrdiff_t i = L / m_dimXZ;
-      ptrdiff_t j = L / m_dimZ - i*m_dimX;
-      ptrdiff_t k = L - i*m_dimXZ - j*m_dimZ;
-
-      retval[0] = m_dkx*double(((j+m_shift_x)%m_dimX)-m_shift_x);
-      retval[1] = m_dky*double(((i+m_shift_y)%m_dimY)-m_shift_y);
-      retval[2] = m_dkz*double(((k+m_shift_z)%m_dimZ)-m_shift_z);
+      const ptrdiff_t a = loc / (m_fs_size[1]*m_fs_size[2]);
+      const ptrdiff_t b = loc / m_fs_size[2] - a*m_fs_size[1];
+      const ptrdiff_t c = loc - (a*m_fs_size[1]+b)*m_fs_size[2];
+
+      retval[m_fs_axes[0]] = m_k_loc[0][a];
+      retval[m_fs_axes[1]] = m_k_loc[1][b];
+      retval[m_fs_axes[2]] = m_k_loc[2][c];
       return retval;
     }
 
     /**
-     * \brief Get k
+     * \brief Get k (slab decomposition)
      *
      * @param[in] i Array Index in x direction
      * @param[in] j Array Index in y direction
@@ -199,44 +276,44 @@ namespace MPI
      * @param loc Local linear Array Index
      * @param i Global Array Index of x dimension
      * @param j Global Array Index of y dimension
+     * @param k Global Array Index of z dimension
      */
     void cft_3d_MPI::local_to_global_rs( const ptrdiff_t loc, ptrdiff_t &i, ptrdiff_t &j, ptrdiff_t &k )
     {
-      ptrdiff_t L = m_offset_rs+loc;
-      i = L / m_dimYZ;
-      j = L / m_dimZ - i*m_dimY;
-      k = L - i*m_dimYZ - j*m_dimZ;
+      const ptrdiff_t a = loc / (m_rs_size[1]*m_rs_size[2]);
+      const ptrdiff_t b = loc / m_rs_size[2] - a*m_rs_size[1];
+      i = m_rs_start[0] + a;
+      j = m_rs_start[1] + b;
+      k = loc - (a*m_rs_size[1]+b)*m_rs_size[2];
     }
 
     void cft_3d_MPI::local_to_global_rs( const ptrdiff_t loc, std::vector<ptrdiff_t> &retval )
     {
-      ptrdiff_t L = m_offset_rs+loc;
-      retval[0] = L / m_dimYZ;
-      retval[1] = L / m_dimZ -  retval[0]*m_dimY;
-      retval[2] = L -  retval[0]*m_dimYZ -  retval[1]*m_dimZ;
+      local_to_global_rs( loc, retval[0], retval[1], retval[2] );
     }
 
     /**
      * \brief Get array indices of global matrix in fourier space
      *
+     * The indices are in the order of the local array, [ky][kx][kz] for slabs and [kz][ky][kx] for pencils.
+     *
      * @param loc Local linear Array Index
-     * @param i Global Array Index of x dimension
-     * @param j Global Array Index of y dimension
+     * @param i Global Array Index of the first dimension
+     * @param j Global Array Index of the second dimension
+     * @param k Global Array Index of the third dimension
      */
     void cft_3d_MPI::local_to_global_fs( const ptrdiff_t loc, ptrdiff_t &i, ptrdiff_t &j, ptrdiff_t &k )
     {
-      ptrdiff_t L = m_offset_fs+loc;
-      i = L / m_dimXZ;
-      j = L / m_dimZ - i*m_dimX;
-      k = L - i*m_dimXZ - j*m_dimZ;
+      const ptrdiff_t a = loc / (m_fs_size[1]*m_fs_size[2]);
+      const ptrdiff_t b = loc / m_fs_size[2] - a*m_fs_size[1];
+      i = m_fs_start[0] + a;
+      j = m_fs_start[1] + b;
+      k = m_fs_start[2] + loc - (a*m_fs_size[1]+b)*m_fs_size[2];
     }
 
     void cft_3d_MPI::local_to_global_fs( const ptrdiff_t loc, std::vector<ptrdiff_t> &retval )
     {
-      ptrdiff_t L = m_offset_fs+loc;
-      retval[0] = L / m_dimXZ;
-      retval[1] = L / m_dimZ - retval[0]*m_dimX;
-      retval[2] = L - retval[0]*m_dimXZ - retval[1]*m_dimZ;
+      local_to_global_fs( loc, retval[0], retval[1], retval[2] );
     }
 
     /**
@@ -246,14 +323,7 @@ namespace MPI
      */
     void cft_3d_MPI::local_to_x( const ptrdiff_t loc, CPoint<3> &x )
     {
-      ptrdiff_t L = m_offset_rs+loc;
-      ptrdiff_t i = L / m_dimYZ;
-      ptrdiff_t j = L / m_dimZ - i*m_dimY;
-      ptrdiff_t k = L - i*m_dimYZ - j*m_dimZ;
-
-      x[0] = double(i-m_shift_x)*m_dx;
-      x[1] = double(j-m_shift_y)*m_dy;
-      x[2] = double(k-m_shift_z)*m_dz;
+      x = Get_x( loc );
     }
 
     /**
@@ -263,14 +333,7 @@ namespace MPI
      */
     void cft_3d_MPI::local_to_k( const ptrdiff_t loc, CPoint<3> &x )
     {
-      ptrdiff_t L = m_offset_fs+loc;
-      ptrdiff_t i = L / m_dimXZ;
-      ptrdiff_t j = L / m_dimZ - i*m_dimX;
-      ptrdiff_t k = L - i*m_dimXZ - j*m_dimZ;
-
-      x[0] = m_dkx*double(((j+m_shift_x)%m_dimX)-m_shift_x);
-      x[1] = m_dky*double(((i+m_shift_y)%m_dimY)-m_shift_y);
-      x[2] = m_dkz*double(((k+m_shift_z)%m_dimZ)-m_shift_z);
+      x = Get_k( loc );
     }
 
     /**
@@ -281,30 +344,14 @@ namespace MPI
     void cft_3d_MPI::Laplace()
     {
       ft(-1);
-
-      ptrdiff_t i, j, k, ijk, ti, tj, tk;
-      double kx, ky, kz, fak;
-
-      for ( j=0; j<m_loc_dimY; j++ )
+      #pragma omp parallel
+      For_k( [this]( const ptrdiff_t l, CPoint<3> &k )
       {
-        Get_ky(j, tj, ky);
-        for ( i=0; i<m_dimX; i++ )
-        {
-          Get_kx(i, ti, kx);
-
-          for ( k=0; k<m_dimZ; k++ )
-          {
-            Get_kz(k, tk, kz);
-
-            ijk = k+m_dimZ*(i+m_dimX*j);
-
-            fak = -kx*kx-ky*ky-kz*kz;
-            m_data[ijk][0] *= fak;
-            m_data[ijk][1] *= fak;
-          }
-        }
-      }
-
+        fftw_complex &v = m_data[l];
+        const double fak = -k[0]*k[0]-k[1]*k[1]-k[2]*k[2];
+        v[0] *= fak;
+        v[1] *= fak;
+      } );
       ft(1);
     }
 
@@ -316,26 +363,14 @@ namespace MPI
     void cft_3d_MPI::D_x()
     {
       ft(-1);
-
-      ptrdiff_t i, j, k, ijk, ti;
-      double kx, tmp1;
-
-      for ( j=0; j<m_loc_dimY; j++ )
+      #pragma omp parallel
+      For_k( [this]( const ptrdiff_t l, CPoint<3> &k )
       {
-        for ( i=0; i<m_dimX; i++ )
-        {
-          Get_kx(i, ti, kx);
-          for ( k=0; k<m_dimZ; k++ )
-          {
-            ijk = k+m_dimZ*(i+m_dimX*j);
-
-            tmp1 = m_data[ijk][0];
-            m_data[ijk][0] = -kx*m_data[ijk][1];
-            m_data[ijk][1] = kx*tmp1;
-          }
-        }
-      }
-
+        fftw_complex &v = m_data[l];
+        const double tmp1 = v[0];
+        v[0] = -k[0]*v[1];
+        v[1] = k[0]*tmp1;
+      } );
       ft(1);
     }
 
@@ -347,26 +382,14 @@ namespace MPI
     void cft_3d_MPI::D_y()
     {
       ft(-1);
-
-      ptrdiff_t i, j, k, ijk, tj;
-      double ky, tmp1;
-
-      for ( j=0; j<m_loc_dimY; j++ )
+      #pragma omp parallel
+      For_k( [this]( const ptrdiff_t l, CPoint<3> &k )
       {
-        Get_ky(j, tj, ky);
-        for ( i=0; i<m_dimX; i++ )
-        {
-          for ( k=0; k<m_dimZ; k++ )
-          {
-            ijk = k+m_dimZ*(i+m_dimX*j);
-
-            tmp1 = m_data[ijk][0];
-            m_data[ijk][0] = -ky*m_data[ijk][1];
-            m_data[ijk][1] = ky*tmp1;
-          }
-        }
-      }
-
+        fftw_complex &v = m_data[l];
+        const double tmp1 = v[0];
+        v[0] = -k[1]*v[1];
+        v[1] = k[1]*tmp1;
+      } );
       ft(1);
     }
 
@@ -378,27 +401,14 @@ namespace MPI
     void cft_3d_MPI::D_z()
     {
       ft(-1);
-
-      ptrdiff_t i, j, k, ijk, tk;
-      double kz, tmp1;
-
-      for ( j=0; j<m_loc_dimY; j++ )
+      #pragma omp parallel
+      For_k( [this]( const ptrdiff_t l, CPoint<3> &k )
       {
-        for ( i=0; i<m_dimX; i++ )
-        {
-          for ( k=0; k<m_dimZ; k++ )
-          {
-            Get_kz(k, tk, kz);
-
-            ijk = k+m_dimZ*(i+m_dimX*j);
-
-            tmp1 = m_data[ijk][0];
-            m_data[ijk][0] = -kz*m_data[ijk][1];
-            m_data[ijk][1] = kz*tmp1;
-          }
-        }
-      }
-
+        fftw_complex &v = m_data[l];
+        const double tmp1 = v[0];
+        v[0] = -k[2]*v[1];
+        v[1] = k[2]*tmp1;
+      } );
       ft(1);
     }
 
@@ -410,27 +420,13 @@ namespace MPI
     void cft_3d_MPI::D_xx()
     {
       ft(-1);
-
-      ptrdiff_t i, j, k, ijk, ti;
-      double kx, fak;
-
-      for ( j=0; j<m_loc_dimY; j++ )
+      #pragma omp parallel
+      For_k( [this]( const ptrdiff_t l, CPoint<3> &k )
       {
-        for ( i=0; i<m_dimX; i++ )
-        {
-          Get_kx(i, ti, kx);
-
-          for ( k=0; k<m_dimZ; k++ )
-          {
-            ijk = k+m_dimZ*(i+m_dimX*j);
-
-            fak = -kx*kx;
-            m_data[ijk][0] *= fak;
-            m_data[ijk][1] *= fak;
-          }
-        }
-      }
-
+        fftw_complex &v = m_data[l];
+        v[0] *= -k[0]*k[0];
+        v[1] *= -k[0]*k[0];
+      } );
       ft(1);
     }
 
@@ -442,26 +438,13 @@ namespace MPI
     void cft_3d_MPI::D_yy()
     {
       ft(-1);
-
-      ptrdiff_t i, j, k, ijk, tj;
-      double ky, fak;
-
-      for ( j=0; j<m_loc_dimY; j++ )
+      #pragma omp parallel
+      For_k( [this]( const ptrdiff_t l, CPoint<3> &k )
       {
-        Get_ky(j, tj, ky);
-        for ( i=0; i<m_dimX; i++ )
-        {
-          for ( k=0; k<m_dimZ; k++ )
-          {
-            ijk = k+m_dimZ*(i+m_dimX*j);
-
-            fak = -ky*ky;
-            m_data[ijk][0] *= fak;
-            m_data[ijk][1] *= fak;
-          }
-        }
-      }
-
+        fftw_complex &v = m_data[l];
+        v[0] *= -k[1]*k[1];
+        v[1] *= -k[1]*k[1];
+      } );
       ft(1);
     }
 
@@ -473,29 +456,14 @@ namespace MPI
     void cft_3d_MPI::D_zz()
     {
       ft(-1);
-
-      ptrdiff_t i, j, k, ijk, tk;
-      double kz, fak;
-
-      for ( j=0; j<m_loc_dimY; j++ )
+      #pragma omp parallel
+      For_k( [this]( const ptrdiff_t l, CPoint<3> &k )
       {
-        for ( i=0; i<m_dimX; i++ )
-        {
-          for ( k=0; k<m_dimZ; k++ )
-          {
-            Get_kz(k, tk, kz);
-
-            ijk = k+m_dimZ*(i+m_dimX*j);
-
-            fak = -kz*kz;
-            m_data[ijk][0] *= fak;
-            m_data[ijk][1] *= fak;
-          }
-        }
-      }
-
+        fftw_complex &v = m_data[l];
+        v[0] *= -k[2]*k[2];
+        v[1] *= -k[2]*k[2];
+      } );
       ft(1);
     }
   }
 }
-
@@ -24,11 +24,21 @@
 #ifndef __class_cft_3d_MPI__
 #define __class_cft_3d_MPI__
 
+#include <memory>
+#include <vector>
 #include "fftw3-mpi.h"
 #include "cft_base_mpi.h"
+#include "pencil_fft_3d.h"
 
 namespace MPI { namespace Fourier
 {
+  /**
+  * \brief Distributed 3D c2c transform
+  *
+  * Uses the slab decomposition of FFTW-MPI (local arrays [x][y][z] and [ky][kx][kz]) or, if MY_MPI_PGRID is set,
+  * the pencil decomposition of pencil_fft_3d (local arrays [x][y][z] and [kz][ky][kx]). Loops over the local
+  * points with Get_x() and Get_k() work for both.
+  */
   class cft_3d_MPI : public cft_base_MPI<3>
   {
   public:
@@ -59,6 +69,10 @@ namespace MPI { namespace Fourier
     
     CPoint<3> Get_k(const ptrdiff_t);
     CPoint<3> Get_x(const ptrdiff_t);
+
+    static ptrdiff_t Local_Size( const ptrdiff_t, const ptrdiff_t, const ptrdiff_t, ptrdiff_t&, ptrdiff_t&, ptrdiff_t&, ptrdiff_t&, ptrdiff_t&, ptrdiff_t& );
+  protected:
+    std::unique_ptr<pencil_fft_3d> m_pencil; /// Pencil transform, nullptr for the slab decomposition
   };
 } }
 #endif
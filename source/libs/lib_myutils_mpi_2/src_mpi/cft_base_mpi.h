@@ -21,6 +21,7 @@
  */
 #include "fftw3.h"
 #include <cmath>
+#include <vector>
 #include "CPoint.h"
 #include "my_structs.h"
 #include "CPoint.h"
@@ -44,7 +45,9 @@ namespace MPI { namespace Fourier
       m_offset_rs(0),
       m_offset_fs(0),
       m_loc_n_rs(0),
-      m_loc_n_fs(0)
+      m_loc_n_fs(0),
+      m_forwardPlan(nullptr),
+      m_backwardPlan(nullptr)
     {
       m_header = *header;
       m_time = &header->t;
@@ -79,8 +82,8 @@ namespace MPI { namespace Fourier
     */
     virtual ~cft_base_MPI()
     {
-      fftw_destroy_plan( m_forwardPlan );
-      fftw_destroy_plan( m_backwardPlan );
+      if ( m_forwardPlan != nullptr ) fftw_destroy_plan( m_forwardPlan );
+      if ( m_backwardPlan != nullptr ) fftw_destroy_plan( m_backwardPlan );
       fftw_free( m_data );
     }
 
@@ -136,15 +139,55 @@ namespace MPI { namespace Fourier
     ptrdiff_t Get_dimZ() { return m_dimZ; };
 
     /**
-    * \brief Get offset in real-space
+    * \brief Get offset in real-space (slab decomposition only, -1 otherwise)
     */
     ptrdiff_t Get_offset_rs() { return m_offset_rs; };
 
     /**
-    * \brief Get offset in fourier-space
+    * \brief Get offset in fourier-space (slab decomposition only, -1 otherwise)
     */
     ptrdiff_t Get_offset_fs() { return m_offset_fs; };
 
+    /**
+    * \brief True if the data is distributed in pencils instead of slabs
+    */
+    bool Is_Pencil() const { return m_offset_rs < 0; };
+
+    /**
+    * \brief x component of every index along dimension d of the local array in real space
+    */
+    const double * Get_x_Axis( const int d ) const { return m_x_loc[d].data(); };
+
+    /**
+    * \brief k component of every index along dimension d of the local array in fourier space, the axis is m_fs_axes[d]
+    */
+    const double * Get_k_Axis( const int d ) const { return m_k_loc[d].data(); };
+
+    /**
+    * \brief Calls f( l, x ) for all local points in real space in storage order, x = Get_x(l)
+    *
+    * The loop is an orphaned omp for: inside a parallel region the rows are distributed over the threads
+    * (static schedule, implicit barrier at the end), outside of one the calling thread does all rows.
+    * The coordinates are taken from the axis tables, there is no division per point. x belongs to the
+    * calling thread and must not be changed by f.
+    *
+    * @param f Callable with the arguments (ptrdiff_t l, CPoint<dim> &x)
+    */
+    template <class F> void For_x( F f )
+    {
+      const int axes[] = {0, 1, 2};
+      For_Box( m_x_loc, axes, f );
+    }
+
+    /**
+    * \brief Calls f( l, k ) for all local points in fourier space in storage order, k = Get_k(l)
+    *
+    * Work sharing as in For_x.
+    *
+    * @param f Callable with the arguments (ptrdiff_t l, CPoint<dim> &k)
+    */
+    template <class F> void For_k( F f ) { For_Box( m_k_loc, m_fs_axes, f ); }
+
     /**
     * \brief Get local number of elements in real space
     */
@@ -234,73 +277,137 @@ namespace MPI { namespace Fourier
     /**
     * \brief Read Data from file
     *
+    * Every process reads its box of the global array through an MPI file view.
+    *
     * @param filename Filename
     */
     void Read_File( std::string filename )
     {
-      MPI_File   fh;
-      ptrdiff_t  loc_offset;
-      ptrdiff_t  loc_n;
+      MPI_File     fh;
+      MPI_Datatype filetype;
 
-      if( m_fs )
-      {
-        loc_offset = m_loc_start_dimY*m_dimX*m_dimZ;
-        loc_n = m_loc_dimY*m_dimX*m_dimZ;
-      }
-      else
-      {
-        loc_offset = m_loc_start_dimX*m_dimY*m_dimZ;
-        loc_n = m_loc_dimX*m_dimY*m_dimZ;
-      }
+      const ptrdiff_t loc_n = Create_Filetype( filetype );
 
-      MPI_Offset offset = sizeof(generic_header) + sizeof(fftw_complex)*loc_offset;
       MPI_File_open( MPI_COMM_WORLD, const_cast<char*>(filename.c_str()), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh );
-
-      MPI_File_read_at( fh, offset, (double*)m_data, 2*loc_n, MPI_DOUBLE, MPI_STATUS_IGNORE );
+      MPI_File_set_view( fh, sizeof(generic_header), MPI_DOUBLE, filetype, const_cast<char*>("native"), MPI_INFO_NULL );
+      MPI_File_read_all( fh, (double*)m_data, 2*loc_n, MPI_DOUBLE, MPI_STATUS_IGNORE );
       MPI_File_close( &fh );
+      MPI_Type_free( &filetype );
     }
 
     /**
     * \brief Write Data to file
     *
+    * In fourier space the file has the order of the local array, the header lists the permuted axes.
+    *
     * @param filename Filename
     */
     void Write_File( std::string filename )
     {
-      MPI_Status status;
-      MPI_File   fh;
-      ptrdiff_t  loc_offset;
-      ptrdiff_t  loc_n;
+      MPI_Status   status;
+      MPI_File     fh;
+      MPI_Datatype filetype;
 
       generic_header header=m_header;
       header.t = *m_time;
 
       if( m_fs )
       {
-        loc_offset = m_loc_start_dimY*m_dimX*m_dimZ;
-        loc_n = m_loc_dimY*m_dimX*m_dimZ;
-        header.nDimX = m_header.nDimY;
-        header.nDimY = m_header.nDimX;
-        header.dx = m_header.dky;
-        header.dy = m_header.dkx;
-      }
-      else
-      {
-        loc_offset = m_loc_start_dimX*m_dimY*m_dimZ;
-        loc_n = m_loc_dimX*m_dimY*m_dimZ;
+        const long long n[] = {m_header.nDimX, m_header.nDimY, m_header.nDimZ};
+        const double dk[] = {m_header.dkx, m_header.dky, m_header.dkz};
+        long long * hn[] = {&header.nDimX, &header.nDimY, &header.nDimZ};
+        double * hd[] = {&header.dx, &header.dy, &header.dz};
+        for ( int d=0; d<3; d++ )
+        {
+          if ( m_fs_axes[d] == d ) continue;
+          *hn[d] = n[m_fs_axes[d]];
+          *hd[d] = dk[m_fs_axes[d]];
+        }
       }
 
-      MPI_Offset offset = sizeof(generic_header) + sizeof(fftw_complex)*loc_offset;
+      const ptrdiff_t loc_n = Create_Filetype( filetype );
 
       MPI_File_open( MPI_COMM_WORLD, const_cast<char*>(filename.c_str()), MPI_MODE_CREATE|MPI_MODE_WRONLY, MPI_INFO_NULL, &fh );
 
       if( m_rank == 0 )
         MPI_File_write( fh, &header, sizeof(generic_header), MPI_BYTE, &status );
 
-      MPI_File_write_at( fh, offset, (double*)m_data, 2*loc_n, MPI_DOUBLE, MPI_STATUS_IGNORE );
+      MPI_File_set_view( fh, sizeof(generic_header), MPI_DOUBLE, filetype, const_cast<char*>("native"), MPI_INFO_NULL );
+      MPI_File_write_all( fh, (double*)m_data, 2*loc_n, MPI_DOUBLE, MPI_STATUS_IGNORE );
       MPI_File_close( &fh );
+      MPI_Type_free( &filetype );
     }
   protected:
+    /**
+    * \brief Box of a slab decomposition, [x][y][z] in real space and [ky][kx][kz] in fourier space
+    */
+    void Set_Slab_Boxes()
+    {
+      const ptrdiff_t rs_start[] = {m_loc_start_dimX, 0, 0}, rs_size[] = {m_loc_dimX, m_dimY, m_dimZ};
+      const ptrdiff_t fs_start[] = {m_loc_start_dimY, 0, 0}, fs_size[] = {m_loc_dimY, m_dimX, m_dimZ};
+      const int fs_axes[] = {1, 0, 2};
+      for ( int d=0; d<3; d++ )
+      {
+        m_rs_start[d] = rs_start[d];
+        m_rs_size[d] = rs_size[d];
+        m_fs_start[d] = fs_start[d];
+        m_fs_size[d] = fs_size[d];
+        m_fs_axes[d] = fs_axes[d];
+      }
+    }
+
+    /**
+    * \brief Fills the coordinate tables of the local boxes, call after the boxes are set
+    */
+    void Set_Axis_Tables()
+    {
+      const ptrdiff_t n[] = {m_dimX, m_dimY, m_dimZ};
+      const ptrdiff_t shift[] = {m_shift_x, m_shift_y, m_shift_z};
+      const double dx[] = {m_dx, m_dy, m_dz};
+      const double dk[] = {m_dkx, m_dky, m_dkz};
+
+      for ( int d=0; d<3; d++ )
+      {
+        const int ax = m_fs_axes[d];
+        m_x_loc[d].assign( m_rs_size[d], 0.0 );
+        m_k_loc[d].assign( m_fs_size[d], 0.0 );
+        if ( d < dim )
+          for ( ptrdiff_t i=0; i<m_rs_size[d]; i++ )
+            m_x_loc[d][i] = dx[d]*double(m_rs_start[d]+i-shift[d]);
+        if ( ax < dim )
+          for ( ptrdiff_t i=0; i<m_fs_size[d]; i++ )
+            m_k_loc[d][i] = dk[ax]*double(((m_fs_start[d]+i+shift[ax])%n[ax])-shift[ax]);
+      }
+    }
+
+    /**
+    * \brief File view of the local box in the current space
+    *
+    * @param filetype Subarray of doubles, free with MPI_Type_free
+    * @return Local number of elements
+    */
+    ptrdiff_t Create_Filetype( MPI_Datatype &filetype )
+    {
+      const ptrdiff_t n[] = {m_dimX, m_dimY, m_dimZ};
+      int gsizes[3], subsizes[3], starts[3];
+      ptrdiff_t loc_n = 1;
+      for ( int d=0; d<3; d++ )
+      {
+        const int f = (d == 2) ? 2 : 1; // re and im
+        gsizes[d]   = f*(m_fs ? n[m_fs_axes[d]] : n[d]);
+        subsizes[d] = f*(m_fs ? m_fs_size[d] : m_rs_size[d]);
+        starts[d]   = f*(m_fs ? m_fs_start[d] : m_rs_start[d]);
+        loc_n *= (m_fs ? m_fs_size[d] : m_rs_size[d]);
+      }
+
+      if ( loc_n == 0 )
+        MPI_Type_dup( MPI_DOUBLE, &filetype );
+      else
+        MPI_Type_create_subarray( 3, gsizes, subsizes, starts, MPI_ORDER_C, MPI_DOUBLE, &filetype );
+      MPI_Type_commit( &filetype );
+      return loc_n;
+    }
+
     generic_header m_header; /// Header
 
     ptrdiff_t m_dimX; /// Global number of sampling points in x-direction
@@ -319,6 +426,13 @@ namespace MPI { namespace Fourier
     ptrdiff_t m_loc_n_fs; // Local number of elements in fourier space
     ptrdiff_t m_dimXZ; /// Product m_dimX * m_dimZ
     ptrdiff_t m_dimYZ; /// Product m_dimY * m_dimZ
+    ptrdiff_t m_rs_start[3]; /// Global start of the local array in real space, [x][y][z]
+    ptrdiff_t m_rs_size[3]; /// Size of the local array in real space
+    ptrdiff_t m_fs_start[3]; /// Global start of the local array in fourier space, order m_fs_axes
+    ptrdiff_t m_fs_size[3]; /// Size of the local array in fourier space
+    int m_fs_axes[3]; /// Axis (0 = kx, 1 = ky, 2 = kz) of each dimension of the local array in fourier space
+    std::vector<double> m_x_loc[3]; /// x of each index of the local array in real space
+    std::vector<double> m_k_loc[3]; /// k of each index of the local array in fourier space
 
     int m_rank; /// rank of the calling process in the group of comm
     int m_nprocs; /// number of processes in the group of comm
@@ -338,5 +452,32 @@ namespace MPI { namespace Fourier
 
     fftw_plan m_forwardPlan; /// FFTW Plan for forward fourier transformation
     fftw_plan m_backwardPlan; /// FFTW Plan for backward fourier transformation
+  private:
+    /**
+    * \brief Loop of For_x and For_k over the local box with the tables tab, dimension d of the box is axis axes[d]
+    */
+    template <class F> void For_Box( const std::vector<double> *tab, const int *axes, F &f )
+    {
+      const ptrdiff_t n0 = tab[0].size(), n1 = tab[1].size(), n2 = tab[2].size();
+      const bool last = (axes[2] < dim);
+
+      #pragma omp for collapse(2) schedule(static)
+      for ( ptrdiff_t a=0; a<n0; a++ )
+      {
+        for ( ptrdiff_t b=0; b<n1; b++ )
+        {
+          CPoint<dim> p;
+          if ( axes[0] < dim ) p[axes[0]] = tab[0][a];
+          if ( axes[1] < dim ) p[axes[1]] = tab[1][b];
+
+          const ptrdiff_t l0 = n2*(b+n1*a);
+          for ( ptrdiff_t c=0; c<n2; c++ )
+          {
+            if ( last ) p[axes[2]] = tab[2][c];
+            f( l0+c, p );
+          }
+        }
+      }
+    }
   };
 }}
@@ -95,11 +95,12 @@ int main( int argc, char *argv[] )
   printf( "dky == %g\n", header.dky );
 
   ti = MPI_Wtime();
-  MPI::Fourier::cft_3d_MPI ft1 = MPI::Fourier::cft_3d_MPI( &header );
+  MPI::Fourier::cft_3d_MPI ft1( &header );
   tf = MPI_Wtime();
   fkt1( ft1 );
 
   printf( "(%d) init time %.10g\n", myrank, tf-ti );
+  printf( "(%d) %s decomposition, %td local points\n", myrank, ft1.Is_Pencil() ? "pencil" : "slab", ft1.Get_loc_n_rs() );
 
   tacc = 0.0;
   for ( int l=0; l<repno; l++ )
@@ -0,0 +1,204 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+
+/** Compares the pencil with the slab decomposition of cft_3d_MPI
+ *
+ * Both decompositions transform the same input. The spectra and the round trips are gathered on the global grid
+ * and compared. The process grid of the pencil transform is the first argument (P1xP2, default auto).
+ * Returns EXIT_FAILURE on a deviation.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "fftw3-mpi.h"
+#include "my_structs.h"
+#include "cft_3d_MPI.h"
+
+using namespace std;
+
+const double tol = 1e-12;
+
+generic_header Setup_Header( const int nx, const int ny, const int nz )
+{
+  generic_header header = {};
+
+  header.nself    = sizeof(generic_header);
+  header.nDatatyp = sizeof(fftw_complex);
+  header.nDims    = 3;
+  header.nDimX    = nx;
+  header.nDimY    = ny;
+  header.nDimZ    = nz;
+  header.bComplex = 1;
+  header.xMin     = -8.0;
+  header.xMax     = -header.xMin;
+  header.yMin     = -10.0;
+  header.yMax     = -header.yMin;
+  header.zMin     = -7.0;
+  header.zMax     = -header.zMin;
+  header.dx       = fabs( header.xMax-header.xMin )/double(header.nDimX);
+  header.dkx      = 2.0*M_PI/fabs(header.xMax-header.xMin);
+  header.dy       = fabs( header.yMax-header.yMin )/double(header.nDimY);
+  header.dky      = 2.0*M_PI/fabs(header.yMax-header.yMin);
+  header.dz       = fabs( header.zMax-header.zMin )/double(header.nDimZ);
+  header.dkz      = 2.0*M_PI/fabs(header.zMax-header.zMin);
+  header.nself_and_data = header.nself + (header.nDimX + header.nDimY + header.nDimZ)*header.nDatatyp;
+  return header;
+}
+
+/// input as a function of the global index, the same for both decompositions
+void fkt( MPI::Fourier::cft_3d_MPI &ft )
+{
+  fftw_complex *data = ft.Get_p2_Data();
+  ptrdiff_t i, j, k;
+
+  for ( ptrdiff_t l=0; l<ft.Get_loc_n_rs(); l++ )
+  {
+    ft.local_to_global_rs( l, i, j, k );
+    const double g = double(k+ft.Get_dimZ()*(j+ft.Get_dimY()*i));
+    data[l][0] = sin(0.37*g) + cos(0.011*g*g);
+    data[l][1] = cos(1.3*g) - 0.5*sin(0.07*g);
+  }
+}
+
+/**
+ * \brief Local data of ft on the global [x][y][z] or [kx][ky][kz] grid, summed over all ranks
+ *
+ * Fourier space indices follow from Get_k, which is valid for both decompositions.
+ */
+vector<double> Gather( MPI::Fourier::cft_3d_MPI &ft, const bool fs )
+{
+  const ptrdiff_t nx = ft.Get_dimX(), ny = ft.Get_dimY(), nz = ft.Get_dimZ();
+  const ptrdiff_t N = fs ? ft.Get_loc_n_fs() : ft.Get_loc_n_rs();
+  const double dk[] = { ft.Get_dkx(), ft.Get_dky(), ft.Get_dkz() };
+  const ptrdiff_t n[] = { nx, ny, nz };
+  fftw_complex *data = ft.Get_p2_Data();
+
+  vector<double> retval( 2*nx*ny*nz, 0.0 );
+  ptrdiff_t ijk[3];
+  for ( ptrdiff_t l=0; l<N; l++ )
+  {
+    if ( fs )
+    {
+      CPoint<3> k = ft.Get_k( l );
+      for ( int d=0; d<3; d++ )
+        ijk[d] = (ptrdiff_t(lround( k[d]/dk[d] )) + n[d]) % n[d];
+    }
+    else
+      ft.local_to_global_rs( l, ijk[0], ijk[1], ijk[2] );
+
+    const ptrdiff_t g = ijk[2]+nz*(ijk[1]+ny*ijk[0]);
+    retval[2*g] = data[l][0];
+    retval[2*g+1] = data[l][1];
+  }
+  MPI_Allreduce( MPI_IN_PLACE, retval.data(), retval.size(), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD );
+  return retval;
+}
+
+double max_dev( const vector<double> &a, const vector<double> &b )
+{
+  double dev = 0, norm = 0;
+  for ( size_t l=0; l<a.size(); l++ )
+  {
+    dev = max( dev, fabs(a[l]-b[l]) );
+    norm = max( norm, fabs(b[l]) );
+  }
+  return dev / norm;
+}
+
+/**
+ * \brief Slab against pencil transform of one grid
+ */
+bool check( const int nx, const int ny, const int nz, const string &pgrid, const int myrank )
+{
+  generic_header header = Setup_Header( nx, ny, nz );
+
+  // the decomposition is chosen at construction
+  setenv( "MY_MPI_PGRID", "slab", 1 );
+  MPI::Fourier::cft_3d_MPI slab( &header );
+  setenv( "MY_MPI_PGRID", pgrid.c_str(), 1 );
+  MPI::Fourier::cft_3d_MPI pencil( &header );
+
+  if ( slab.Is_Pencil() || !pencil.Is_Pencil() )
+  {
+    if ( myrank == 0 ) printf( "MY_MPI_PGRID did not select the decompositions\n" );
+    return false;
+  }
+
+  fkt( slab );
+  fkt( pencil );
+  const vector<double> input = Gather( slab, false );
+
+  slab.ft(-1);
+  pencil.ft(-1);
+  const double dev_fs = max_dev( Gather( pencil, true ), Gather( slab, true ) );
+
+  slab.ft(1);
+  pencil.ft(1);
+  const vector<double> rt_pencil = Gather( pencil, false );
+  const double dev_rs = max_dev( rt_pencil, Gather( slab, false ) );
+  const double dev_rt = max_dev( rt_pencil, input );
+
+  const bool ok = (dev_fs < tol) && (dev_rs < tol) && (dev_rt < tol);
+  if ( myrank == 0 )
+    printf( "%3d x %3d x %3d: spectrum %.3e  round trip vs slab %.3e  vs input %.3e %s\n", nx, ny, nz, dev_fs, dev_rs, dev_rt, ok ? "" : "FAILED" );
+  return ok;
+}
+
+//--------------------------------------------------------------------------------
+int main( int argc, char *argv[] )
+{
+  int nprocs, myrank;
+
+  MPI_Init( &argc, &argv );
+  fftw_mpi_init();
+
+  MPI_Comm_size( MPI_COMM_WORLD, &nprocs );
+  MPI_Comm_rank( MPI_COMM_WORLD, &myrank );
+
+  const string pgrid = (argc > 1) ? argv[1] : "auto";
+  if ( myrank == 0 ) printf( "%d processes, pencil grid %s\n", nprocs, pgrid.c_str() );
+
+  // even, odd and mixed sizes, not divisible by the process grid in general
+  const int sizes[][3] = { {24,20,18}, {16,16,16}, {15,9,21}, {12,25,8} };
+
+  bool ok = true;
+  try
+  {
+    for ( auto n : sizes )
+      ok = check( n[0], n[1], n[2], pgrid, myrank ) && ok;
+  }
+  catch ( const std::string &str )
+  {
+    if ( myrank == 0 ) printf( "%s", str.c_str() );
+    ok = false;
+  }
+
+  if ( myrank == 0 ) printf( ok ? "pencil and slab decomposition agree\n" : "pencil and slab decomposition differ\n" );
+
+  fftw_mpi_cleanup();
+  MPI_Finalize();
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
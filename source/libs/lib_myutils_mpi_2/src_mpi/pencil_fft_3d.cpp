@@ -0,0 +1,298 @@
+//
+// ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+// (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+// founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+// 50WM0942, 50WM1042, 50WM1342.
+// Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+//
+// This file is part of ATUS2.
+//
+// ATUS2 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ATUS2 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <cstdlib>
+#include <cstdio>
+#include <climits>
+#include <string>
+#include <algorithm>
+#include "pencil_fft_3d.h"
+
+using namespace std;
+
+namespace MPI
+{
+  namespace Fourier
+  {
+    /**
+     * \brief Constructor, the transforms are planned by Plan()
+     *
+     * @param nx Global number of sampling points in x direction
+     * @param ny Global number of sampling points in y direction
+     * @param nz Global number of sampling points in z direction
+     * @param p1 Number of ranks splitting x (real space) and y (fourier space)
+     * @param p2 Number of ranks splitting y (real space) and z (fourier space)
+     * @param comm Communicator with p1*p2 ranks
+     */
+    pencil_fft_3d::pencil_fft_3d( const ptrdiff_t nx, const ptrdiff_t ny, const ptrdiff_t nz, const int p1, const int p2, MPI_Comm comm ) :
+      m_p1(p1), m_p2(p2), m_data(nullptr), m_send(nullptr), m_recv(nullptr)
+    {
+      int nprocs, rank;
+      MPI_Comm_size( comm, &nprocs );
+      MPI_Comm_rank( comm, &rank );
+
+      if ( p1*p2 != nprocs ) throw std::string( "Error in pencil_fft_3d::pencil_fft_3d: process grid does not match the number of processes.\n" );
+      if ( p1 > nx || p1 > ny || p2 > ny || p2 > nz )
+        throw std::string( "Error in pencil_fft_3d::pencil_fft_3d: process grid " + to_string(p1) + "x" + to_string(p2) + " too large for the grid.\n" );
+
+      m_n[0] = nx;
+      m_n[1] = ny;
+      m_n[2] = nz;
+      m_c1 = rank / p2;
+      m_c2 = rank % p2;
+
+      m_alloc = Local_Size( nx, ny, nz, p1, p2, rank, m_rs, m_fs );
+
+      m_mid.start[0] = m_rs.start[0];
+      m_mid.size[0] = m_rs.size[0];
+      m_mid.start[1] = m_fs.start[0];
+      m_mid.size[1] = m_fs.size[0];
+      m_mid.start[2] = 0;
+      m_mid.size[2] = ny;
+
+      MPI_Comm_split( comm, m_c1, m_c2, &m_row );
+      MPI_Comm_split( comm, m_c2, m_c1, &m_col );
+
+      const ptrdiff_t lx = m_rs.size[0], ly = m_rs.size[1], lz = m_fs.size[0], ly1 = m_fs.size[1];
+
+      // [x][y][z] -> [x][z][y] and [x][z][y] -> [z][y][x]
+      Setup_Exchange( m_fwd[0], m_row, lx, ny, nz, ly*nz, nz, 1, lz*ny, ny, 1 );
+      Setup_Exchange( m_fwd[1], m_col, lz, nx, ny, ny, lz*ny, 1, ly1*nx, nx, 1 );
+      // and back
+      Setup_Exchange( m_bwd[0], m_col, lz, ny, nx, ly1*nx, nx, 1, ny, lz*ny, 1 );
+      Setup_Exchange( m_bwd[1], m_row, lx, nz, ny, lz*ny, ny, 1, ly*nz, nz, 1 );
+    }
+
+    pencil_fft_3d::~pencil_fft_3d()
+    {
+      if ( m_data != nullptr )
+      {
+        for ( int i=0; i<3; i++ )
+        {
+          fftw_destroy_plan( m_plan_fwd[i] );
+          fftw_destroy_plan( m_plan_bwd[i] );
+        }
+      }
+      fftw_free( m_send );
+      fftw_free( m_recv );
+      // objects of the solver classes may outlive MPI_Finalize
+      int finalized;
+      MPI_Finalized( &finalized );
+      if ( !finalized )
+      {
+        MPI_Comm_free( &m_row );
+        MPI_Comm_free( &m_col );
+      }
+    }
+
+    /**
+     * \brief Balanced block of rank p if n points are distributed over P ranks
+     */
+    void pencil_fft_3d::Split( const ptrdiff_t n, const int P, const int p, ptrdiff_t &start, ptrdiff_t &count )
+    {
+      const ptrdiff_t q = n / P, r = n % P;
+      count = q + (p < r ? 1 : 0);
+      start = p*q + min( ptrdiff_t(p), r );
+    }
+
+    /**
+     * \brief Process grid from the environment variable MY_MPI_PGRID
+     *
+     * Unset or "slab" selects the slab decomposition of FFTW, "auto" a process grid from MPI_Dims_create and
+     * "P1xP2" the given grid.
+     *
+     * @return true for a pencil decomposition
+     */
+    bool pencil_fft_3d::Get_Grid( const int nprocs, int &p1, int &p2 )
+    {
+      const char *envstr = getenv( "MY_MPI_PGRID" );
+      if ( envstr == nullptr || string(envstr) == "" || string(envstr) == "slab" ) return false;
+
+      if ( string(envstr) == "auto" )
+      {
+        int dims[] = {0,0};
+        MPI_Dims_create( nprocs, 2, dims );
+        p1 = dims[0];
+        p2 = dims[1];
+        return true;
+      }
+
+      if ( sscanf( envstr, "%dx%d", &p1, &p2 ) != 2 || p1 < 1 || p2 < 1 || p1*p2 != nprocs )
+        throw std::string( "Error in pencil_fft_3d::Get_Grid: MY_MPI_PGRID=" + string(envstr) + " does not match " + to_string(nprocs) + " processes.\n" );
+      return true;
+    }
+
+    /**
+     * \brief Local boxes of a rank
+     *
+     * @param rs Real space box [x][y][z]
+     * @param fs Fourier space box [kz][ky][kx]
+     * @return Number of fftw_complex the data array needs
+     */
+    ptrdiff_t pencil_fft_3d::Local_Size( const ptrdiff_t nx, const ptrdiff_t ny, const ptrdiff_t nz, const int p1, const int p2, const int rank, box &rs, box &fs )
+    {
+      const int c1 = rank / p2, c2 = rank % p2;
+
+      Split( nx, p1, c1, rs.start[0], rs.size[0] );
+      Split( ny, p2, c2, rs.start[1], rs.size[1] );
+      rs.start[2] = 0;
+      rs.size[2] = nz;
+
+      Split( nz, p2, c2, fs.start[0], fs.size[0] );
+      Split( ny, p1, c1, fs.start[1], fs.size[1] );
+      fs.start[2] = 0;
+      fs.size[2] = nx;
+
+      return max( max( rs.Count(), fs.Count() ), rs.size[0]*fs.size[0]*ny );
+    }
+
+    void pencil_fft_3d::Setup_Exchange( exchange &e, MPI_Comm comm, const ptrdiff_t ns, const ptrdiff_t nu, const ptrdiff_t nv,
+                                        const ptrdiff_t bs, const ptrdiff_t bu, const ptrdiff_t bv, const ptrdiff_t as, const ptrdiff_t av, const ptrdiff_t au )
+    {
+      int P;
+      MPI_Comm_size( comm, &P );
+      MPI_Comm_rank( comm, &e.me );
+
+      e.comm = comm;
+      e.ns = ns;
+      e.bs = bs;
+      e.bu = bu;
+      e.bv = bv;
+      e.as = as;
+      e.av = av;
+      e.au = au;
+      e.u_start.resize(P);
+      e.u_size.resize(P);
+      e.v_start.resize(P);
+      e.v_size.resize(P);
+      for ( int q=0; q<P; q++ )
+      {
+        Split( nu, P, q, e.u_start[q], e.u_size[q] );
+        Split( nv, P, q, e.v_start[q], e.v_size[q] );
+      }
+
+      // counts in doubles
+      e.scounts.resize(P);
+      e.sdispls.resize(P);
+      e.rcounts.resize(P);
+      e.rdispls.resize(P);
+      ptrdiff_t soff = 0, roff = 0;
+      for ( int q=0; q<P; q++ )
+      {
+        const ptrdiff_t sc = 2*ns*e.u_size[e.me]*e.v_size[q];
+        const ptrdiff_t rc = 2*ns*e.u_size[q]*e.v_size[e.me];
+        if ( soff+sc > INT_MAX || roff+rc > INT_MAX ) throw std::string( "Error in pencil_fft_3d::Setup_Exchange: local grid too large, use more processes.\n" );
+        e.scounts[q] = int(sc);
+        e.sdispls[q] = int(soff);
+        e.rcounts[q] = int(rc);
+        e.rdispls[q] = int(roff);
+        soff += sc;
+        roff += rc;
+      }
+    }
+
+    void pencil_fft_3d::Exchange( const exchange &e )
+    {
+      const int P = e.u_size.size();
+      const ptrdiff_t lu = e.u_size[e.me], lv = e.v_size[e.me];
+
+      #pragma omp parallel for collapse(2)
+      for ( int q=0; q<P; q++ )
+      {
+        for ( ptrdiff_t s=0; s<e.ns; s++ )
+        {
+          const ptrdiff_t lvq = e.v_size[q];
+          fftw_complex *dst = m_send + e.sdispls[q]/2 + s*lu*lvq;
+          const fftw_complex *src = m_data + s*e.bs + e.v_start[q]*e.bv;
+          for ( ptrdiff_t u=0; u<lu; u++ )
+            for ( ptrdiff_t v=0; v<lvq; v++ )
+            {
+              dst[u*lvq+v][0] = src[u*e.bu+v*e.bv][0];
+              dst[u*lvq+v][1] = src[u*e.bu+v*e.bv][1];
+            }
+        }
+      }
+
+      MPI_Alltoallv( m_send, e.scounts.data(), e.sdispls.data(), MPI_DOUBLE, m_recv, e.rcounts.data(), e.rdispls.data(), MPI_DOUBLE, e.comm );
+
+      #pragma omp parallel for collapse(2)
+      for ( int q=0; q<P; q++ )
+      {
+        for ( ptrdiff_t s=0; s<e.ns; s++ )
+        {
+          const ptrdiff_t luq = e.u_size[q];
+          const fftw_complex *src = m_recv + e.rdispls[q]/2 + s*luq*lv;
+          fftw_complex *dst = m_data + s*e.as + e.u_start[q]*e.au;
+          for ( ptrdiff_t u=0; u<luq; u++ )
+            for ( ptrdiff_t v=0; v<lv; v++ )
+            {
+              dst[v*e.av+u*e.au][0] = src[u*lv+v][0];
+              dst[v*e.av+u*e.au][1] = src[u*lv+v][1];
+            }
+        }
+      }
+    }
+
+    /**
+     * \brief Plans the transforms in place on data
+     *
+     * @param data Array with Get_Alloc() entries
+     */
+    void pencil_fft_3d::Plan( fftw_complex *data )
+    {
+      m_data = data;
+      m_send = fftw_alloc_complex( m_alloc );
+      m_recv = fftw_alloc_complex( m_alloc );
+
+      const int n[] = { int(m_n[2]), int(m_n[1]), int(m_n[0]) };
+      const int howmany[] = { int(m_rs.size[0]*m_rs.size[1]), int(m_mid.size[0]*m_mid.size[1]), int(m_fs.size[0]*m_fs.size[1]) };
+
+      for ( int i=0; i<3; i++ )
+      {
+        m_plan_fwd[i] = fftw_plan_many_dft( 1, &n[i], howmany[i], data, nullptr, 1, n[i], data, nullptr, 1, n[i], FFTW_FORWARD, FFTW_ESTIMATE );
+        m_plan_bwd[2-i] = fftw_plan_many_dft( 1, &n[i], howmany[i], data, nullptr, 1, n[i], data, nullptr, 1, n[i], FFTW_BACKWARD, FFTW_ESTIMATE );
+      }
+    }
+
+    /// z, y and x transform, real space [x][y][z] -> fourier space [kz][ky][kx]
+    void pencil_fft_3d::Forward()
+    {
+      fftw_execute( m_plan_fwd[0] );
+      Exchange( m_fwd[0] );
+      fftw_execute( m_plan_fwd[1] );
+      Exchange( m_fwd[1] );
+      fftw_execute( m_plan_fwd[2] );
+    }
+
+    /// x, y and z transform, fourier space [kz][ky][kx] -> real space [x][y][z]
+    void pencil_fft_3d::Backward()
+    {
+      fftw_execute( m_plan_bwd[0] );
+      Exchange( m_bwd[0] );
+      fftw_execute( m_plan_bwd[1] );
+      Exchange( m_bwd[1] );
+      fftw_execute( m_plan_bwd[2] );
+    }
+  }
+}
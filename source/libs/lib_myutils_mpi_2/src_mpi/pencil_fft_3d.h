@@ -0,0 +1,110 @@
+/* * ATUS2 - The ATUS2 package is atom interferometer Toolbox developed at ZARM
+ * (CENTER OF APPLIED SPACE TECHNOLOGY AND MICROGRAVITY), Germany. This project is
+ * founded by the DLR Agentur (Deutsche Luft und Raumfahrt Agentur). Grant numbers:
+ * 50WM0942, 50WM1042, 50WM1342.
+ * Copyright (C) 2017 Želimir Marojević, Ertan Göklü, Claus Lämmerzahl
+ *
+ * This file is part of ATUS2.
+ *
+ * ATUS2 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ATUS2 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ATUS2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __class_pencil_fft_3d__
+#define __class_pencil_fft_3d__
+
+#include <mpi.h>
+#include <vector>
+#include "fftw3.h"
+
+namespace MPI { namespace Fourier
+{
+  /**
+  * \brief Distributed 3D c2c transform with a two dimensional (pencil) decomposition
+  *
+  * The P1 x P2 process grid splits x over P1 and y over P2 in real space (z pencils, local array [x][y][z]) and
+  * z over P2 and y over P1 in fourier space (x pencils, local array [kz][ky][kx]). Between the 1D transforms the
+  * data is redistributed with an all-to-all in the rows (P2 ranks) and in the columns (P1 ranks) of the process
+  * grid. Up to min(nx,ny)*min(ny,nz) ranks can be used, a slab decomposition is limited to nx ranks.
+  * The transforms are unnormalized and in place.
+  */
+  class pencil_fft_3d
+  {
+  public:
+    /// part of the global grid in the order of the local array
+    struct box
+    {
+      ptrdiff_t start[3];
+      ptrdiff_t size[3];
+      ptrdiff_t Count() const { return size[0]*size[1]*size[2]; }
+    };
+
+    pencil_fft_3d( const ptrdiff_t nx, const ptrdiff_t ny, const ptrdiff_t nz, const int p1, const int p2, MPI_Comm comm );
+    ~pencil_fft_3d();
+
+    void Plan( fftw_complex *data );
+    void Forward();
+    void Backward();
+
+    /// number of fftw_complex the data array needs
+    ptrdiff_t Get_Alloc() const { return m_alloc; }
+    const box & Get_rs_Box() const { return m_rs; }
+    const box & Get_fs_Box() const { return m_fs; }
+
+    static bool Get_Grid( const int nprocs, int &p1, int &p2 );
+    static ptrdiff_t Local_Size( const ptrdiff_t nx, const ptrdiff_t ny, const ptrdiff_t nz, const int p1, const int p2, const int rank, box &rs, box &fs );
+
+  protected:
+    /** Redistribution inside a row or column of the process grid
+      *
+      * Before the exchange the local array holds the block u_me of the distributed axis u and all of v,
+      * afterwards the block v_me of v and all of u. s is the third axis which is not exchanged.
+      */
+    struct exchange
+    {
+      MPI_Comm comm;
+      int me;
+      ptrdiff_t ns;
+      std::vector<ptrdiff_t> u_start, u_size, v_start, v_size;
+      ptrdiff_t bs, bu, bv; // strides of s, u and v before
+      ptrdiff_t as, av, au; // strides of s, v and u afterwards
+      std::vector<int> scounts, sdispls, rcounts, rdispls;
+    };
+
+    static void Split( const ptrdiff_t n, const int P, const int p, ptrdiff_t &start, ptrdiff_t &count );
+    void Setup_Exchange( exchange &, MPI_Comm, const ptrdiff_t ns, const ptrdiff_t nu, const ptrdiff_t nv,
+                         const ptrdiff_t bs, const ptrdiff_t bu, const ptrdiff_t bv, const ptrdiff_t as, const ptrdiff_t av, const ptrdiff_t au );
+    void Exchange( const exchange & );
+
+    ptrdiff_t m_n[3];
+    int m_p1, m_p2;
+    int m_c1, m_c2; // coordinates in the process grid
+    box m_rs;
+    box m_mid; // y pencils [x][z][y]
+    box m_fs;
+    ptrdiff_t m_alloc;
+
+    MPI_Comm m_row; // ranks with the same x block in real space
+    MPI_Comm m_col; // ranks with the same z block in fourier space
+
+    exchange m_fwd[2];
+    exchange m_bwd[2];
+
+    fftw_complex *m_data;
+    fftw_complex *m_send;
+    fftw_complex *m_recv;
+    fftw_plan m_plan_fwd[3]; // z, y, x
+    fftw_plan m_plan_bwd[3]; // x, y, z
+  };
+} }
+#endif
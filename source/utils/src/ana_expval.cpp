@@ -29,6 +29,7 @@
 #include "cft_2d.h"
 #include "cft_3d.h"
 #include "fftw3.h"
+#include "thread_setup.h"
 
 using namespace std;
 using namespace Fourier;
@@ -241,9 +242,7 @@ int main(int argc, char *argv[])
 
   double PN;
 
-  int no_of_threads = 4;
-  char *envstr = getenv( "MY_NO_OF_THREADS" );
-  if ( envstr != nullptr ) no_of_threads = atoi( envstr );
+  int no_of_threads = Get_No_Of_Threads();
   omp_set_num_threads( no_of_threads );
 
   generic_header header = {};
@@ -38,6 +38,7 @@
 #include "my_structs.h"
 #include "anyoption.h"
 #include "eigenfunctions_HO.h"
+#include "thread_setup.h"
 
 using namespace std;
 
@@ -233,9 +234,7 @@ int main(int argc, char *argv[])
   in.read( (char *)&header, sizeof(generic_header) );
 
   /*
-    int no_of_threads = 4;
-    char* envstr = getenv( "MY_NO_OF_THREADS" );
-    if( envstr != NULL ) no_of_threads = atoi( envstr );
+    int no_of_threads = Get_No_Of_Threads();
     omp_set_num_threads( no_of_threads );
   */
 
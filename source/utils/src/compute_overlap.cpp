@@ -27,6 +27,7 @@
 #include <omp.h>
 #include "fftw3.h"
 #include "my_structs.h"
+#include "thread_setup.h"
 
 using namespace std;
 
@@ -93,9 +94,7 @@ int main(int argc, char *argv[])
   FILE *fh = nullptr;
   FILE *fh_2 = nullptr;
 
-  int no_of_threads = 4;
-  char *envstr = getenv( "MY_NO_OF_THREADS" );
-  if ( envstr != nullptr ) no_of_threads = atoi( envstr );
+  int no_of_threads = Get_No_Of_Threads();
   omp_set_num_threads( no_of_threads );
 
   generic_header header = {};
@@ -29,13 +29,16 @@
 #include "cxxopts.hpp"
 #include "fftw3.h"
 #include "my_structs.h"
+#include "resample.h"
+#include "thread_setup.h"
 
 using namespace std;
 
 enum
 {
   O_FIX = 0x01,
-  O_FAK = 0x02
+  O_FAK = 0x02,
+  O_RES = 0x04
 };
 
 void inflate_3d_fix( fftw_complex *field_old, generic_header *header_old, fftw_complex *field_new, generic_header *header_new, const int fak )
@@ -103,33 +106,9 @@ void inflate_3d( fftw_complex *field_old, generic_header *header_old, fftw_compl
   header_new->dkz  /= double(fak);
   header_new->dt = 0.001;
 
-  const int dimX = header_old->nDimX;
-  const int dimY = header_old->nDimY;
-  const int dimZ = header_old->nDimZ;
-  const int dimY_new = header_new->nDimY;
-  const int dimZ_new = header_new->nDimZ;
-
-  memset( field_new, 0, fak*fak*fak*dimX*dimY*dimZ*sizeof(fftw_complex) );
-
-  int i, j, k, ijk, ijk2;
-
-  const int offsetx = (header_new->nDimX-header_old->nDimX)/2;
-  const int offsety = (header_new->nDimY-header_old->nDimY)/2;
-  const int offsetz = (header_new->nDimZ-header_old->nDimZ)/2;
-
-  #pragma omp parallel for private(j,k,ijk,ijk2)
-  for ( i=0; i<dimX; i++ )
-  {
-    for ( j=0; j<dimY; j++ )
-    {
-      for ( k=0; k<dimZ; k++ )
-      {
-        ijk  = k+dimZ*(j+dimY*i);
-        ijk2 = offsetz + k + dimZ_new*((offsety+j)+dimY_new*(offsetx+i));
-        memcpy( &field_new[ijk2], &field_old[ijk], sizeof(fftw_complex) );
-      }
-    }
-  }
+  const int64_t n_old[] = {header_old->nDimX, header_old->nDimY, header_old->nDimZ};
+  const int64_t n_new[] = {header_new->nDimX, header_new->nDimY, header_new->nDimZ};
+  Fourier::Pad_Domain( 3, n_old, n_new, field_old, field_new );
 }
 
 void inflate_2d_fix( fftw_complex *field_old, generic_header *header_old, fftw_complex *field_new, generic_header *header_new, const int fak )
@@ -183,27 +162,9 @@ void inflate_2d( fftw_complex *field_old, generic_header *header_old, fftw_compl
   header_new->dky  /= double(fak);
   header_new->dt = 0.001;
 
-  const int dimX = header_old->nDimX;
-  const int dimY = header_old->nDimY;
-  const int dimY_new = header_new->nDimY;
-
-  memset( field_new, 0, fak*fak*dimX*dimY*sizeof(fftw_complex) );
-
-  int i, j, ij, ij2;
-
-  const int offsetx = (header_new->nDimX-header_old->nDimX)/2;
-  const int offsety = (header_new->nDimY-header_old->nDimY)/2;
-
-  #pragma omp parallel for private(j,ij,ij2)
-  for ( i=0; i<dimX; i++ )
-  {
-    for ( j=0; j<dimY; j++ )
-    {
-      ij  = j+dimY*i;
-      ij2 = (offsety+j)+dimY_new*(offsetx+i);
-      memcpy( &field_new[ij2], &field_old[ij], sizeof(fftw_complex) );
-    }
-  }
+  const int64_t n_old[] = {header_old->nDimX, header_old->nDimY};
+  const int64_t n_new[] = {header_new->nDimX, header_new->nDimY};
+  Fourier::Pad_Domain( 2, n_old, n_new, field_old, field_new );
 }
 
 void inflate_1d( fftw_complex *field_old, generic_header *header_old, fftw_complex *field_new, generic_header *header_new, const int fak )
@@ -218,15 +179,47 @@ void inflate_1d( fftw_complex *field_old, generic_header *header_old, fftw_compl
   header_new->dkx  /= double(fak);
   header_new->dt = 0.001;
 
-  const int  offsetx = (header_new->nDimX-header_old->nDimX)/2;
+  const int64_t n_old[] = {header_old->nDimX};
+  const int64_t n_new[] = {header_new->nDimX};
+  Fourier::Pad_Domain( 1, n_old, n_new, field_old, field_new );
+}
+
+/**
+  * \brief Spectral refinement (p > q) or coarsening (p < q) of the grid by the factor p/q on the same domain
+  *
+  * Returns the new field, allocated with the capacity of the in place resampling.
+  */
+fftw_complex * resample_domain( fftw_complex *field_old, generic_header *header_old, generic_header *header_new, const int p, const int q )
+{
+  memcpy( header_new, header_old, sizeof(generic_header) );
+
+  const int rank = header_old->nDims;
+  const int64_t n_old[] = {header_old->nDimX, header_old->nDimY, header_old->nDimZ};
+
+  Fourier::resample res( rank, n_old, p, q );
+
+  header_new->nDimX = res.Get_Dim(0);
+  header_new->dx   *= double(q)/double(p);
+  if ( rank > 1 )
+  {
+    header_new->nDimY = res.Get_Dim(1);
+    header_new->dy   *= double(q)/double(p);
+  }
+  if ( rank > 2 )
+  {
+    header_new->nDimZ = res.Get_Dim(2);
+    header_new->dz   *= double(q)/double(p);
+  }
 
-  memset( field_new, 0, header_new->nDimX*sizeof(fftw_complex) );
-  memcpy( &field_new[offsetx], field_old, header_old->nDimX*sizeof(fftw_complex) );
+  fftw_complex *field_new = (fftw_complex *)fftw_malloc( sizeof(fftw_complex)*res.Get_Capacity() );
+  memcpy( field_new, field_old, n_old[0]*(rank > 1 ? n_old[1] : 1)*(rank > 2 ? n_old[2] : 1)*sizeof(fftw_complex) );
+  res.Execute( field_new );
+  return field_new;
 }
 
 int main(int argc, char *argv[])
 {
-  int fak=-1, flags=0;
+  int fak=-1, flags=0, res_p=1, res_q=1;
   string filename, filename2;
 
   cxxopts::Options options("inflate_domain", "\nInflate the domain of the wave function.\n");
@@ -234,6 +227,7 @@ int main(int argc, char *argv[])
   options.add_options()
   ("f,fak",  "Fix x coord. for slices at index i", cxxopts::value<int>()->default_value("-1") )
   ("g,fix",  "Fix y coord. for slices at index j", cxxopts::value<int>()->default_value("-1") )
+  ("r,resample",  "Spectral resampling of the grid by the factor p/q (or p) on the same domain", cxxopts::value<std::string>()->default_value("") )
   ("positional", "Positional arguments: these are the arguments that are entered without an option", cxxopts::value<std::vector<std::string>>())
   ("help","Print help")
   ;
@@ -243,7 +237,7 @@ int main(int argc, char *argv[])
 
   try
   {
-    if (result.count("") == 0)
+    if (result.arguments().size() == 0)
     {
       std::cout << options.help({""}) << std::endl;
       return EXIT_FAILURE;
@@ -269,7 +263,16 @@ int main(int argc, char *argv[])
       fak = result["fix"].as<int>();
       flags |= O_FIX;
     }
-    if( result["fak"].as<int>() == result["fix"].as<int>() )
+    if( result["resample"].as<std::string>() != "" )
+    {
+      if ( sscanf( result["resample"].as<std::string>().c_str(), "%d/%d", &res_p, &res_q ) < 1 || res_p < 1 || res_q < 1 )
+      {
+        std::cout << "error parsing options: resample factor must be p/q or p" << std::endl;
+        return EXIT_FAILURE;
+      }
+      flags |= O_RES;
+    }
+    if( !(flags & O_RES) && result["fak"].as<int>() == result["fix"].as<int>() )
     {
       cout << "Hmmm" << endl;
       return EXIT_FAILURE;
@@ -289,9 +292,7 @@ int main(int argc, char *argv[])
 
 */
 
-  int no_of_threads = 4;
-  char *envstr = getenv("MY_NO_OF_THREADS" );
-  if ( envstr != nullptr ) no_of_threads = atoi( envstr );
+  int no_of_threads = Get_No_Of_Threads();
   omp_set_num_threads( no_of_threads );
 
   generic_header header_old, header_new;
@@ -343,7 +344,12 @@ int main(int argc, char *argv[])
     in.read( (char *)field_old, header_old.nDatatyp*Nges );
     in.close();
 
-    if ( flags & O_FIX )
+    if ( flags & O_RES )
+    {
+      field_new = resample_domain( field_old, &header_old, &header_new, res_p, res_q );
+      Nges2 = header_new.nDimX*header_new.nDimY*header_new.nDimZ;
+    }
+    else if ( flags & O_FIX )
     {
       Nges2 = Nges;
       field_new = (fftw_complex *)fftw_malloc( header_old.nDatatyp*Nges2 );
@@ -377,7 +383,12 @@ int main(int argc, char *argv[])
     in.read( (char *)field_old, header_old.nDatatyp*Nges );
     in.close();
 
-    if ( flags & O_FIX )
+    if ( flags & O_RES )
+    {
+      field_new = resample_domain( field_old, &header_old, &header_new, res_p, res_q );
+      Nges2 = header_new.nDimX*header_new.nDimY*header_new.nDimZ;
+    }
+    else if ( flags & O_FIX )
     {
       Nges2 = Nges;
       field_new = (fftw_complex *)fftw_malloc( header_old.nDatatyp*Nges2 );
@@ -411,7 +422,12 @@ int main(int argc, char *argv[])
     in.read( (char *)field_old, header_old.nDatatyp*Nges );
     in.close();
 
-    if ( flags & O_FIX )
+    if ( flags & O_RES )
+    {
+      field_new = resample_domain( field_old, &header_old, &header_new, res_p, res_q );
+      Nges2 = header_new.nDimX*header_new.nDimY*header_new.nDimZ;
+    }
+    else if ( flags & O_FIX )
     {
       // Nges2 = Nges;
       // field_new = (fftw_complex*)fftw_malloc( header_old.nDatatyp*Nges2 );
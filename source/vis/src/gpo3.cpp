@@ -29,6 +29,7 @@
 #include "cxxopts.hpp"
 #include "fftw3.h"
 #include "my_structs.h"
+#include "thread_setup.h"
 
 extern double sign( const double val );
 
@@ -518,9 +519,7 @@ int main(int argc, char *argv[])
   if ( !in.is_open() ) return EXIT_FAILURE;
   in.read( (char *)&header, sizeof(generic_header) );
 
-  int no_of_threads = 4;
-  char *envstr = getenv( "MY_NO_OF_THREADS" );
-  if ( envstr != nullptr ) no_of_threads = atoi( envstr );
+  int no_of_threads = Get_No_Of_Threads();
   omp_set_num_threads( no_of_threads );
 
   printf( "### %s\n", filename.c_str() );
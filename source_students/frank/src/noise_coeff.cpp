@@ -82,6 +82,7 @@ int main(int argc, char *argv[])
   m_noise.resize(NX);
   m_dx_noise.resize(NX);
   m_dx2_noise.resize(NX);
+  double * const diff_noise[] = {m_dx_noise.data(), m_dx2_noise.data()};
   out.resize(NX);
 
   // Local functions inserting the prefactor term for 2nd, 1st, 0th derivative
@@ -115,14 +116,7 @@ int main(int argc, char *argv[])
     for (int64_t j = 0; j < NX; j++) {
       m_noise[j] = noise[j];
     }
-    noiseft.Diff_x();
-    for (int64_t j = 0; j < NX; j++) {
-      m_dx_noise[j] = noise[j];
-    }
-    noiseft.Diff_x();
-    for (int64_t j = 0; j < NX; j++) {
-      m_dx2_noise[j] = noise[j];
-    }
+    noiseft.Derivatives({Fourier::DX, Fourier::DXX}, diff_noise);
     for (int64_t j = 0; j < NX; j++) {
       out[j] = d2(j);
     }
@@ -36,6 +36,7 @@
 #include "cft_1d.h"
 #include "rft_1d.h"
 #include "rft_2d.h"
+#include "resample.h"
 #include "my_structs.h"
 #include "muParser.h"
 #include "ParameterHandler.h"
@@ -73,7 +74,7 @@ namespace RT_Solver
     double dt;
   protected:
   private:
-    Fourier::rft_2d *chunkft;
+    Fourier::resample *chunk_resample;
     Fourier::rft_2d *interpolft;
     generic_header source_header;
     generic_header chunk_header;
@@ -109,7 +110,6 @@ namespace RT_Solver
     chunk_header.xMax = chunk_header.xMin + chunk_size*chunk_header.dx;
     chunk_header.dkx = 2.0*M_PI/fabs( chunk_header.xMax-chunk_header.xMin );
     chunk_header.nself_and_data = chunk_header.nself + (chunk_header.nDimX*chunk_header.nDimY*chunk_header.nDimZ)*chunk_header.nDatatyp;
-    chunkft = new Fourier::rft_2d(chunk_header);
 
     chunk_bytes = chunk_header.nDimX*chunk_header.nDimY*sizeof(double);
 
@@ -121,6 +121,10 @@ namespace RT_Solver
     interpol_header.nself_and_data = interpol_header.nself + (interpol_header.nDimX*interpol_header.nDimY*interpol_header.nDimZ)*interpol_header.nDatatyp;
     interpolft = new Fourier::rft_2d(interpol_header);
 
+    const int64_t n_chunk[] = {chunk_header.nDimX, chunk_header.nDimY};
+    const int64_t n_interpol[] = {interpol_header.nDimX, interpol_header.nDimY};
+    chunk_resample = new Fourier::resample( 2, n_chunk, n_interpol, true );
+
     dt = interpol_header.dx;
     current_chunk = -1;
 
@@ -140,19 +144,12 @@ namespace RT_Solver
 
   Noise_Data::~Noise_Data() {
     fnoise.close();
-    delete chunkft;
+    delete chunk_resample;
     delete interpolft;
   }
 
   void Noise_Data::Get_Chunk(int64_t chunk) {
-    double * chunk_in = chunkft->Getp2InReal();
-    fftw_complex * chunk_out = chunkft->Getp2Out();
-    fftw_complex * interpolft_out = interpolft->Getp2Out();
-
-    const int64_t Nx = chunkft->Get_Dim_X();
-    const int64_t Nyred = chunkft->Get_red_Dim();
-    const int64_t shifti = interpolft->Get_Dim_X() - chunkft->Get_Dim_X();
-    const int64_t Nynew = interpolft->Get_red_Dim();
+    double * interpol_in = interpolft->Getp2InReal();
 
     cout << endl << "New Chunk " << chunk;
     cout << " Old Chunk: " << current_chunk << endl;
@@ -160,33 +157,10 @@ namespace RT_Solver
 
     // Read next chunk
     fnoise.seekg(sizeof(generic_header)+chunk*chunk_bytes);
-    fnoise.read( (char*)chunk_in, chunk_bytes);
-    // chunkft->save( "chunk_" + to_string(chunk) + ".bin" );
-
-    // Expand
-    chunkft->ft(-1);
-    memset( reinterpret_cast<void*>(interpolft_out), 0, sizeof(fftw_complex)*interpolft->Get_Dim_FS() );
-    #pragma omp parallel for collapse(2)
-    for( int i=0; i<Nx/2; i++ )
-    {
-      for( int j=0; j<Nyred; j++ )
-      {
-        interpolft_out[j+i*Nynew][0] = chunk_out[j+i*Nyred][0];
-        interpolft_out[j+i*Nynew][1] = chunk_out[j+i*Nyred][1];
-      }
-    }
+    fnoise.read( (char*)interpol_in, chunk_bytes);
 
-    #pragma omp parallel for collapse(2)
-    for( int i=Nx/2; i<Nx; i++ )
-    {
-      for( int j=0; j<Nyred; j++ )
-      {
-        interpolft_out[j+(i+shifti)*Nynew][0] = chunk_out[j+i*Nyred][0];
-        interpolft_out[j+(i+shifti)*Nynew][1] = chunk_out[j+i*Nyred][1];
-      }
-    }
-    // interpolft->save( "fichunk_" + to_string(chunk) + ".bin", false );
-    interpolft->ft(1);
+    // Expand in place, only the lines of the chunk are transformed
+    chunk_resample->Execute( interpol_in );
     // interpolft->save( "ichunk_" + to_string(chunk) + ".bin" );
 
     current_chunk = chunk;
@@ -800,18 +774,12 @@ namespace RT_Solver
         }
       }
 
-      double *diff_noise = noiseft->Getp2InReal();
-      for (int i = 0; i < m_no_of_pts; i++) {
-        diff_noise[i] = m_noise[i];
-      }
-      noiseft->Diff_x();
-      for (int i = 0; i < m_no_of_pts; i++) {
-        m_dx_noise[i] = diff_noise[i];
-      }
-      noiseft->Diff_x();
+      double *noise_in = noiseft->Getp2InReal();
       for (int i = 0; i < m_no_of_pts; i++) {
-        m_dx2_noise[i] = diff_noise[i];
+        noise_in[i] = m_noise[i];
       }
+      double * const diff_noise[] = {m_dx_noise.data(), m_dx2_noise.data()};
+      noiseft->Derivatives({Fourier::DX, Fourier::DXX}, diff_noise);
   }
 
   /** Half step with metric noise is performed on all wavefunctions.